@@ -0,0 +1,41 @@
+/-
+Copyright (c) 2026 agent. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+Author: agent
+-/
+prelude
+import init.data.list.basic init.data.to_string init.meta.format
+universe variables u v
+
+/- Random access arrays implemented by the VM.
+   Arrays are updated in place when they are not shared, and copied otherwise. -/
+meta constant array : Type u → Type u
+
+namespace array
+meta constant empty {α : Type u}             : array α
+/- (mk n v) is an array containing n copies of v. -/
+meta constant mk {α : Type u}                : nat → α → array α
+meta constant size {α : Type u}              : array α → nat
+/- Fails when the index is out of bounds -/
+meta constant read {α : Type u}              : array α → nat → α
+meta constant write {α : Type u}             : array α → nat → α → array α
+meta constant push_back {α : Type u}         : array α → α → array α
+/- Fails when the array is empty -/
+meta constant pop_back {α : Type u}          : array α → array α
+meta constant foldl {α : Type u} {β : Type v} : array α → β → (α → β → β) → β
+
+meta def of_list {α : Type u} (l : list α) : array α :=
+list.foldl push_back empty l
+
+meta def to_list {α : Type u} (a : array α) : list α :=
+list.reverse (foldl a [] list.cons)
+
+meta def map {α : Type u} {β : Type v} (f : α → β) (a : array α) : array β :=
+foldl a empty (λ v r, push_back r (f v))
+end array
+
+meta instance {α : Type u} [has_to_format α] : has_to_format (array α) :=
+⟨λ a, to_fmt "#" ++ to_fmt (array.to_list a)⟩
+
+meta instance {α : Type u} [has_to_string α] : has_to_string (array α) :=
+⟨λ a, "#" ++ to_string (array.to_list a)⟩
@@ -4,7 +4,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Authors: Leonardo de Moura, Jeremy Avigad
 -/
 prelude
-import init.data.ordering init.function init.meta.name init.meta.format
+import init.data.ordering init.function init.meta.name init.meta.format init.meta.expr
 
 meta constant {u₁ u₂} rb_map : Type u₁ → Type u₂ → Type (max u₁ u₂ 1)
 
@@ -71,6 +71,38 @@ meta instance : has_to_string (rb_map key data) :=
 ⟨λ m, "⟨" ++ (fst (fold m ("", tt) (λ k d p, (fst p ++ key_data_to_string k d (snd p), ff)))) ++ "⟩"⟩
 end
 
+/- Persistent hash maps. `mk_core data hash eq` creates an empty map where keys are compared using `eq`.
+   It assumes `eq a b = tt` implies `hash a = hash b`. -/
+meta constant {u₁ u₂} hash_map : Type u₁ → Type u₂ → Type (max u₁ u₂ 1)
+
+namespace hash_map
+meta constant mk_core {key : Type} (data : Type)        : (key → nat) → (key → key → bool) → hash_map key data
+meta constant size {key : Type} {data : Type}           : hash_map key data → nat
+meta constant insert {key : Type} {data : Type}         : hash_map key data → key → data → hash_map key data
+meta constant erase  {key : Type} {data : Type}         : hash_map key data → key → hash_map key data
+meta constant contains {key : Type} {data : Type}       : hash_map key data → key → bool
+meta constant find {key : Type} {data : Type}           : hash_map key data → key → option data
+meta constant fold {key : Type} {data : Type} {α :Type} : hash_map key data → α → (key → data → α → α) → α
+
+attribute [inline]
+meta def mk (key : Type) [decidable_eq key] (data : Type) (hash : key → nat) : hash_map key data :=
+mk_core data hash (λ a b, to_bool (a = b))
+
+meta def to_list {key : Type} {data : Type} (m : hash_map key data) : list (key × data) :=
+fold m [] (λ k d r, (k, d) :: r)
+end hash_map
+
+/- Hash maps indexed by expressions. The VM implements the hash and equality functions natively. -/
+attribute [reducible]
+meta def expr_map (data : Type) := hash_map expr data
+namespace expr_map
+  export hash_map (hiding mk)
+
+  attribute [inline]
+  meta def mk (data : Type) : expr_map data :=
+  hash_map.mk_core data expr.hash expr.alpha_eqv
+end expr_map
+
 /- a variant of rb_maps that stores a list of elements for each key.
    "find" returns the list of elements in the opposite order that they were inserted. -/
 
@@ -8,6 +8,8 @@ Author: Leonardo de Moura
 #include "util/lean_path.h"
 #include "library/module.h"
 #include "library/util.h"
+#include "library/st_task_queue.h"
+#include "library/message_buffer.h"
 #include "api/decl.h"
 #include "api/string.h"
 #include "api/exception.h"
@@ -21,6 +23,13 @@ lean_bool lean_env_import(lean_env env, lean_ios ios, lean_list_name modules, le
     check_nonnull(ios);
     check_nonnull(modules);
     auto new_env = to_env_ref(env);
+    /* Importing decodes the .olean files on the task queue */
+    st_task_queue tq;
+    scope_global_task_queue scope_tq(&tq);
+    stream_message_buffer msg_buf(to_io_state_ref(ios).get_regular_stream());
+    scoped_message_buffer scope_msg_buf(&msg_buf);
+    scope_message_context scope_msg_ctx(message_bucket_id { "_global", 1 });
+    scoped_task_context scope_task_ctx("importing", {1, 0});
     for (name const & n : to_list_name_ref(modules)) {
         new_env = import_module(new_env, "", {n, optional<unsigned>()}, mk_olean_loader());
     }
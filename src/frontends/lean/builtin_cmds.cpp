@@ -403,7 +403,7 @@ static environment compile_cmd(parser & p) {
     declaration d = p.env().get(n);
     if (!d.is_definition())
         throw parser_error("invalid #compile command, declaration is not a definition", pos);
-    return vm_compile(p.env(), d);
+    return vm_compile(p.env(), p.get_options(), d);
 }
 
 static environment compile_expr(environment const & env, name const & n, level_param_names const & ls, expr const & type, expr const & e, pos_info const & pos) {
@@ -456,7 +456,8 @@ static environment vm_eval_cmd(parser & p) {
     }
     name main("_main");
     environment new_env = compile_expr(p.env(), main, ls, type, e, pos);
-    vm_state s(new_env, p.get_options());
+    pooled_vm_state pooled_s(new_env, p.get_options());
+    vm_state & s = *pooled_s;
     optional<vm_obj> initial_state;
     if (is_io) initial_state = mk_vm_simple(0);
     auto out = p.mk_message(p.cmd_pos(), INFORMATION);
@@ -495,10 +496,12 @@ environment declare_trace_cmd(parser & p) {
     return module::add(p.env(), *g_declare_trace_key, [=](environment const &, serializer & s) { s << cls; });
 }
 
-static void declare_trace_reader(deserializer & d, environment &) {
+static module_modification declare_trace_reader(deserializer & d) {
     name cls;
     d >> cls;
-    register_trace_class(cls);
+    return [=](environment &) {
+        register_trace_class(cls);
+    };
 }
 
 environment add_key_equivalence_cmd(parser & p) {
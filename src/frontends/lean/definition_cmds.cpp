@@ -4,15 +4,18 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <algorithm>
 #include <string>
 #include <vector>
 #include "library/sorry.h"
 #include "library/module_mgr.h"
 #include "util/timeit.h"
+#include "util/sexpr/option_declarations.h"
 #include "kernel/type_checker.h"
 #include "kernel/declaration.h"
 #include "kernel/instantiate.h"
 #include "kernel/replace_fn.h"
+#include "kernel/find_fn.h"
 #include "library/trace.h"
 #include "library/constants.h"
 #include "library/explicit.h"
@@ -23,13 +26,16 @@ Author: Leonardo de Moura
 #include "library/unfold_macros.h"
 #include "library/noncomputable.h"
 #include "library/module.h"
+#include "library/placeholder.h"
 #include "library/documentation.h"
 #include "library/scope_pos_info_provider.h"
+#include "library/task_helper.h"
 #include "library/replace_visitor.h"
 #include "library/equations_compiler/equations.h"
 #include "library/compiler/vm_compiler.h"
 #include "library/compiler/rec_fn_macro.h"
 #include "library/tactic/eqn_lemmas.h"
+#include "library/tactic/elaborate.h"
 #include "frontends/lean/parser.h"
 #include "frontends/lean/tokens.h"
 #include "frontends/lean/elaborator.h"
@@ -44,7 +50,47 @@ Author: Leonardo de Moura
 #define LEAN_PROFILE_THRESHOLD 0.01
 #endif
 
+#ifndef LEAN_DEFAULT_PARALLEL_DEFINITIONS
+#define LEAN_DEFAULT_PARALLEL_DEFINITIONS false
+#endif
+
 namespace lean {
+static name * g_parallel_definitions = nullptr;
+
+static bool get_parallel_definitions(options const & opts) {
+    return opts.get_bool(*g_parallel_definitions, LEAN_DEFAULT_PARALLEL_DEFINITIONS);
+}
+
+/* Definition whose value is being elaborated by a task. It has already been added to the environment,
+   but it has not been compiled into bytecode yet (see finalize_delayed_definitions). */
+struct delayed_definition {
+    name        m_name;
+    name        m_real_name;
+    bool        m_is_noncomputable;
+    pos_info    m_pos;
+    /* number of parameters in the header, used to replace the value with 'sorry' when the elaboration fails */
+    unsigned    m_num_params;
+};
+
+struct delayed_definitions_ext : public environment_extension {
+    list<delayed_definition> m_defs;
+};
+
+struct delayed_definitions_ext_reg {
+    unsigned m_ext_id;
+    delayed_definitions_ext_reg() {
+        m_ext_id = environment::register_extension(std::make_shared<delayed_definitions_ext>());
+    }
+};
+
+static delayed_definitions_ext_reg * g_ext = nullptr;
+static delayed_definitions_ext const & get_extension(environment const & env) {
+    return static_cast<delayed_definitions_ext const &>(env.get_extension(g_ext->m_ext_id));
+}
+static environment update(environment const & env, delayed_definitions_ext const & ext) {
+    return env.update(g_ext->m_ext_id, std::make_shared<delayed_definitions_ext>(ext));
+}
+
 environment ensure_decl_namespaces(environment const & env, name const & full_n) {
     if (full_n.is_atomic())
         return env;
@@ -325,7 +371,7 @@ static environment compile_decl(parser & p, environment const & env, def_cmd_kin
         return env;
     try {
         declaration d = env.get(c_real_name);
-        return vm_compile(env, d);
+        return vm_compile(env, p.get_options(), d);
     } catch (exception & ex) {
         if (p.found_errors())
             return env;
@@ -351,7 +397,7 @@ static pair<environment, name>
 declare_definition(parser & p, environment const & env, def_cmd_kind kind, buffer<name> const & lp_names,
                    name const & c_name, expr const & type, optional<expr> const & _val, task_result<expr> const & proof,
                    decl_modifiers const & modifiers, decl_attributes attrs, optional<std::string> const & doc_string,
-                   pos_info const & pos) {
+                   pos_info const & pos, reducibility_hints const & hints = reducibility_hints::mk_opaque()) {
     auto env_n = mk_real_name(env, c_name, modifiers.m_is_private, pos);
     environment new_env = env_n.first;
     name c_real_name    = env_n.second;
@@ -360,14 +406,22 @@ declare_definition(parser & p, environment const & env, def_cmd_kind kind, buffe
         *val = fix_rec_fn_name(*val, c_name, c_real_name);
     bool use_conv_opt = true;
     bool is_trusted   = !modifiers.m_is_meta;
+    /* When the value of a definition is computed by a task, we only check whether it is computable and
+       generate bytecode in finalize_delayed_definitions. */
+    bool is_delayed   = !val && kind != Theorem;
     auto def          =
-        !val ? mk_theorem(c_real_name, to_list(lp_names), type, proof) : (kind == Theorem ?
-        mk_theorem(c_real_name, to_list(lp_names), type, *val) :
-        mk_definition(new_env, c_real_name, to_list(lp_names), type, *val, use_conv_opt, is_trusted));
+        !val ? (kind == Theorem ?
+                mk_theorem(c_real_name, to_list(lp_names), type, proof) :
+                mk_definition(c_real_name, to_list(lp_names), type, proof, hints, is_trusted)) :
+        (kind == Theorem ?
+         mk_theorem(c_real_name, to_list(lp_names), type, *val) :
+         mk_definition(new_env, c_real_name, to_list(lp_names), type, *val, use_conv_opt, is_trusted));
     auto cdef         = check(p, new_env, c_name, def, pos);
     new_env           = module::add(new_env, cdef);
 
-    check_noncomputable(p.ignore_noncomputable(), new_env, c_name, c_real_name, modifiers.m_is_noncomputable);
+    if (!is_delayed) {
+        check_noncomputable(p.ignore_noncomputable(), new_env, c_name, c_real_name, modifiers.m_is_noncomputable);
+    }
 
     if (modifiers.m_is_protected)
         new_env = add_protected(new_env, c_real_name);
@@ -379,13 +433,115 @@ declare_definition(parser & p, environment const & env, def_cmd_kind kind, buffe
     }
 
     new_env = attrs.apply(new_env, p.ios(), c_real_name);
-    new_env = compile_decl(p, new_env, kind, modifiers.m_is_noncomputable, c_name, c_real_name, pos);
+    if (!is_delayed)
+        new_env = compile_decl(p, new_env, kind, modifiers.m_is_noncomputable, c_name, c_real_name, pos);
     if (doc_string) {
         new_env = add_doc_string(new_env, c_real_name, *doc_string);
     }
     return mk_pair(new_env, c_real_name);
 }
 
+static environment add_delayed_definition(environment const & env, delayed_definition const & d) {
+    delayed_definitions_ext ext = get_extension(env);
+    ext.m_defs = cons(d, ext.m_defs);
+    return update(env, ext);
+}
+
+/* Replace the value of the delayed definition \c d with 'sorry', as single_definition_cmd_core does
+   when the elaboration of a definition fails. */
+static environment replace_with_sorry(parser & p, environment env, delayed_definition const & d) {
+    p.mk_sorry(d.m_pos);
+    env = declare_sorry(env);
+    declaration decl = env.get(d.m_real_name);
+    type_context ctx(env, p.get_options());
+    buffer<expr> params;
+    expr type = decl.get_type();
+    for (unsigned i = 0; i < d.m_num_params; i++) {
+        lean_assert(is_pi(type));
+        expr param = ctx.push_local(binding_name(type), binding_domain(type), binding_info(type));
+        type = instantiate(binding_body(type), param);
+        params.push_back(param);
+    }
+    expr sorry = mk_app(mk_constant(get_sorry_name(), {get_level(ctx, type)}), type);
+    auto def   = mk_definition(d.m_real_name, decl.get_univ_params(), decl.get_type(), ctx.mk_lambda(params, sorry),
+                               decl.get_hints(), decl.is_trusted());
+    env = env.replace(check_replacement(env, def));
+    return mark_noncomputable(env, d.m_real_name);
+}
+
+environment finalize_delayed_definitions(parser & p) {
+    environment env = p.env();
+    delayed_definitions_ext ext = get_extension(env);
+    if (!ext.m_defs)
+        return env;
+    buffer<delayed_definition> defs;
+    to_buffer(ext.m_defs, defs);
+    std::reverse(defs.begin(), defs.end());
+    ext.m_defs = list<delayed_definition>();
+    env = update(env, ext);
+    for (delayed_definition const & d : defs) {
+        bool failed = false;
+        try {
+            env.get(d.m_real_name).get_value();
+        } catch (exception &) {
+            /* the error has already been reported by the elaboration task */
+            failed = true;
+        }
+        try {
+            if (failed) {
+                p.set_found_errors();
+                env = replace_with_sorry(p, env, d);
+                continue;
+            }
+            if (!check_computable(env, d.m_real_name))
+                env = mark_noncomputable(env, d.m_real_name);
+            check_noncomputable(p.ignore_noncomputable(), env, d.m_name, d.m_real_name, d.m_is_noncomputable);
+            env = compile_decl(p, env, Definition, d.m_is_noncomputable, d.m_name, d.m_real_name, d.m_pos);
+        } catch (exception & ex) {
+            auto out = p.mk_message(d.m_pos, ERROR);
+            out.set_exception(ex);
+            out.report();
+        }
+    }
+    return env;
+}
+
+/** \brief Return true iff the header or the value of a declaration contains a tactic block.
+    Tactic blocks may execute the preceding definitions, so pending definitions must be finalized before them. */
+static bool has_tactic_block(buffer<expr> const & params, expr const & fn, expr const & val) {
+    auto is_tactic_block = [](expr const & e, unsigned) { return is_by(e); };
+    if (find(mlocal_type(fn), is_tactic_block) || find(val, is_tactic_block))
+        return true;
+    for (expr const & param : params) {
+        if (find(mlocal_type(param), is_tactic_block))
+            return true;
+    }
+    return false;
+}
+
+/** \brief Return true iff the value of the given definition can be elaborated by a task, while we keep
+    processing the following commands. The type of the definition must be known before its value
+    is elaborated, and the value must not produce auxiliary declarations (e.g., equation lemmas).
+    Moreover, we do not delay definitions that are (potentially) executed while processing the
+    following commands, i.e., meta definitions and definitions with attributes such as instances.
+    Definitions containing tactic blocks are not delayed either, see has_tactic_block. */
+static bool is_delayable_definition(parser & p, def_cmd_kind kind, decl_modifiers const & modifiers,
+                                    decl_attributes const & attrs, buffer<expr> const & params,
+                                    expr const & fn, expr const & val) {
+    if (kind != Definition || modifiers.m_is_meta || modifiers.m_is_instance || attrs ||
+        !get_parallel_definitions(p.get_options()))
+        return false;
+    if (has_placeholder(mlocal_type(fn)))
+        return false;
+    for (expr const & param : params) {
+        if (has_placeholder(mlocal_type(param)))
+            return false;
+    }
+    if (has_tactic_block(params, fn, val))
+        return false;
+    return !find(val, [](expr const & e, unsigned) { return is_equations(e); });
+}
+
 struct fix_rec_fn_macro_args_fn : public replace_visitor {
     buffer<expr> const &             m_params;
     buffer<pair<name, expr>> const & m_fns;
@@ -578,10 +734,12 @@ static expr inline_new_defs(environment const & old_env, environment const & new
     });
 }
 
+/* Elaborate the proof of a theorem or the value of a delayed definition (see is_delayable_definition). */
 class proof_elaboration_task : public task<expr> {
     environment m_decl_env;
     options m_opts;
     bool m_use_info_manager;
+    def_cmd_kind m_kind;
 
     std::vector<expr> m_params;
     expr m_fn, m_val;
@@ -596,18 +754,19 @@ class proof_elaboration_task : public task<expr> {
 public:
     proof_elaboration_task(environment const & decl_env,
                            options const & opts,
+                           def_cmd_kind kind,
                            buffer<expr> const & params,
                            expr const & fn, expr const & val, elaborator::theorem_finalization_info const & finfo,
                            bool is_rfl_lemma, expr const & final_type,
                            metavar_context const & mctx, local_context const & lctx,
                            parser_pos_provider const & prov) :
-        m_decl_env(decl_env), m_opts(opts), m_use_info_manager(get_global_info_manager() != nullptr),
+        m_decl_env(decl_env), m_opts(opts), m_use_info_manager(get_global_info_manager() != nullptr), m_kind(kind),
         m_params(params.begin(), params.end()), m_fn(fn), m_val(val), m_finfo(finfo),
         m_is_rfl_lemma(is_rfl_lemma), m_final_type(final_type),
         m_mctx(mctx), m_lctx(lctx), m_pos_provider(prov) {}
 
     void description(std::ostream & out) const override {
-        out << "proving " << local_pp_name(m_fn) << " (" << get_module_id() << ")";
+        out << (m_kind == Theorem ? "proving " : "elaborating ") << local_pp_name(m_fn) << " (" << get_module_id() << ")";
     }
 
     expr execute() override {
@@ -633,7 +792,10 @@ public:
                                       ERROR);
             error_msg.set_exception(ex);
             error_msg.report();
-            throw exception("failed to elaborate theorem");
+            if (m_kind == Theorem)
+                throw exception("failed to elaborate theorem");
+            /* finalize_delayed_definitions replaces the value with 'sorry' */
+            throw reported_task_exception("failed to elaborate definition");
         }
     }
 };
@@ -732,6 +894,9 @@ environment single_definition_cmd_core(parser & p, def_cmd_kind kind, decl_modif
         attrs.set_attribute(p.env(), "instance");
     std::tie(fn, val) = parse_definition(p, lp_names, params, is_example, is_instance);
     p.declare_sorry_if_used();
+    bool is_delayed  = is_delayable_definition(p, kind, modifiers, attrs, params, fn, val);
+    if ((kind == Definition && !is_delayed) || has_tactic_block(params, fn, val))
+        p.set_env(finalize_delayed_definitions(p));
     elaborator elab(p.env(), p.get_options(), metavar_context(), local_context());
     buffer<expr> new_params;
     elaborate_params(elab, params, new_params);
@@ -754,10 +919,29 @@ environment single_definition_cmd_core(parser & p, def_cmd_kind kind, decl_modif
             finalize_theorem_type(elab, new_params, type, lp_names, thm_finfo);
             auto decl_env = elab.env();
             auto elab_task = get_global_task_queue().submit<proof_elaboration_task>(
-                decl_env, p.get_options(), new_params, new_fn, val, thm_finfo, is_rfl, type,
+                decl_env, p.get_options(), kind, new_params, new_fn, val, thm_finfo, is_rfl, type,
                 elab.mctx(), elab.lctx(), p.get_parser_pos_provider(header_pos));
             env_n = declare_definition(p, elab.env(), kind, lp_names, c_name, type, opt_val, elab_task, modifiers, attrs,
                                        doc_string, header_pos);
+        } else if (is_delayed) {
+            /* Similar to theorems, but the value is not opaque. Since the value is not available yet,
+               we approximate the definitional height using the constants occurring in the type and
+               in the value before elaboration. */
+            type = elab.elaborate_type(mlocal_type(fn));
+            elab.ensure_no_unassigned_metavars(type);
+            expr new_fn = update_mlocal(fn, type);
+            val = replace_local_preserving_pos_info(val, fn, new_fn);
+            elaborator::theorem_finalization_info finfo;
+            finalize_theorem_type(elab, new_params, type, lp_names, finfo);
+            auto decl_env = elab.env();
+            unsigned h    = std::max(get_max_height(decl_env, type), get_max_height(decl_env, val));
+            auto elab_task = get_global_task_queue().submit<proof_elaboration_task>(
+                decl_env, p.get_options(), kind, new_params, new_fn, val, finfo, false, type,
+                elab.mctx(), elab.lctx(), p.get_parser_pos_provider(header_pos));
+            env_n = declare_definition(p, elab.env(), kind, lp_names, c_name, type, opt_val, elab_task, modifiers, attrs,
+                                       doc_string, header_pos, reducibility_hints::mk_regular(h+1, true));
+            env_n.first = add_delayed_definition(env_n.first, delayed_definition{
+                    c_name, env_n.second, modifiers.m_is_noncomputable, header_pos, new_params.size()});
         } else if (kind == Example) {
             get_global_task_queue().submit<example_checking_task>(
                     p.env(), p.get_options(),
@@ -812,9 +996,24 @@ environment single_definition_cmd_core(parser & p, def_cmd_kind kind, decl_modif
 }
 
 environment definition_cmd_core(parser & p, def_cmd_kind kind, decl_modifiers const & modifiers, decl_attributes attrs) {
-    if (modifiers.m_is_mutual)
+    if (modifiers.m_is_mutual) {
+        p.set_env(finalize_delayed_definitions(p));
         return mutual_definition_cmd_core(p, kind, modifiers, attrs);
+    }
     else
         return single_definition_cmd_core(p, kind, modifiers, attrs);
 }
+
+void initialize_definition_cmds() {
+    g_parallel_definitions = new name{"parser", "parallel_definitions"};
+    register_bool_option(*g_parallel_definitions, LEAN_DEFAULT_PARALLEL_DEFINITIONS,
+                         "(lean parser) elaborate definitions in parallel when they have an explicit type, "
+                         "no attributes, and do not use pattern matching");
+    g_ext = new delayed_definitions_ext_reg();
+}
+
+void finalize_definition_cmds() {
+    delete g_ext;
+    delete g_parallel_definitions;
+}
 }
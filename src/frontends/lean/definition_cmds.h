@@ -13,4 +13,12 @@ namespace lean {
 environment definition_cmd_core(parser & p, def_cmd_kind k, decl_modifiers const & modifies, decl_attributes attributes);
 
 environment ensure_decl_namespaces(environment const & env, name const & full_n);
+
+/** \brief Wait for the definitions whose values are being elaborated in parallel, and compile them into bytecode.
+    The parser invokes this function before any command that may depend on them being compiled.
+    See option \c parser.parallel_definitions. */
+environment finalize_delayed_definitions(parser & p);
+
+void initialize_definition_cmds();
+void finalize_definition_cmds();
 }
@@ -62,6 +62,7 @@ Author: Leonardo de Moura
 #include "frontends/lean/prenum.h"
 #include "frontends/lean/elaborator.h"
 #include "frontends/lean/local_context_adapter.h"
+#include "frontends/lean/definition_cmds.h"
 
 #ifndef LEAN_DEFAULT_PARSER_SHOW_ERRORS
 #define LEAN_DEFAULT_PARSER_SHOW_ERRORS true
@@ -2039,6 +2040,14 @@ static bool support_docummentation(name const & n) {
     return g_documentable_cmds->contains(n);
 }
 
+/* Return true iff the command \c n may declare a definition whose value is elaborated in parallel.
+   The pending definitions are finalized before any other command, since it may execute them. */
+static bool is_definition_cmd(name const & n) {
+    return
+        n == get_definition_tk() || n == get_theorem_tk() || n == get_private_tk() ||
+        n == get_protected_tk() || n == get_noncomputable_tk();
+}
+
 void parser::parse_command() {
     lean_assert(curr() == scanner::token_kind::CommandKeyword);
     m_last_cmd_pos = pos();
@@ -2054,6 +2063,8 @@ void parser::parse_command() {
         scope_global_ios scope1(m_ios);
         scope_trace_env  scope2(m_env, m_ios.get_options(), tc);
         scope_traces_as_messages traces_as_messages(get_stream_name(), pos());
+        if (!is_definition_cmd(cmd_name))
+            m_env = finalize_delayed_definitions(*this);
         if (is_notation_cmd(cmd_name)) {
             in_notation_ctx ctx(*this);
             if (it->get_skip_token())
@@ -2234,6 +2245,7 @@ bool parser::parse_commands() {
                         break;
                     case scanner::token_kind::Eof:
                         check_no_doc_string();
+                        m_env = finalize_delayed_definitions(*this);
                         done = true;
                         break;
                     case scanner::token_kind::Keyword:
@@ -243,6 +243,7 @@ public:
     void set_ignore_noncomputable() { m_ignore_noncomputable = true; }
 
     bool found_errors() const { return m_found_errors; }
+    void set_found_errors() { m_found_errors = true; }
 
     name mk_anonymous_inst_name();
     bool is_anonymous_inst_name(name const & n) const;
@@ -252,6 +253,7 @@ public:
     cmd_table const & cmds() const { return get_cmd_table(env()); }
 
     environment const & env() const { return m_env; }
+    void set_env(environment const & env) { m_env = env; }
     io_state const & ios() const { return m_ios; }
 
     message_builder mk_message(pos_info const & p, message_severity severity);
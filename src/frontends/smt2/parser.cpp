@@ -8,12 +8,16 @@ Author: Daniel Selsam
 #include <stack>
 #include <utility>
 #include <vector>
+#include <memory>
+#include <iomanip>
 #include <library/message_builder.h>
 #include "util/flet.h"
 #include "util/name_map.h"
 #include "util/exception.h"
 #include "util/fresh_name.h"
 #include "util/lean_path.h"
+#include "util/timeit.h"
+#include "util/sexpr/option_declarations.h"
 #include "kernel/environment.h"
 #include "kernel/kernel_exception.h"
 #include "kernel/abstract.h"
@@ -33,6 +37,7 @@ Author: Daniel Selsam
 #include "library/trace.h"
 #include "library/mpq_macro.h"
 #include "library/scope_pos_info_provider.h"
+#include "library/vm/vm.h"
 #include "library/tactic/tactic_state.h"
 #include "frontends/smt2/scanner.h"
 #include "frontends/smt2/elaborator.h"
@@ -41,7 +46,16 @@ Author: Daniel Selsam
 namespace lean {
 namespace smt2 {
 
+#ifndef LEAN_DEFAULT_SMT2_TIMING
+#define LEAN_DEFAULT_SMT2_TIMING false
+#endif
+
 static name * g_smt2_unique_prefix;
+static name * g_smt2_timing;
+
+static bool get_smt2_timing(options const & opts) {
+    return opts.get_bool(*g_smt2_timing, LEAN_DEFAULT_SMT2_TIMING);
+}
 
 // Reserved words
 // (a) General
@@ -81,7 +95,7 @@ static char const * g_token_set_logic             = "set-logic";
 static char const * g_token_set_option            = "set-option";
 
 // Making bindings
-enum class binding_type { FORALL, EXISTS, LET };
+enum class binding_type { FORALL, EXISTS, LET, LAMBDA };
 
 expr mk_binding(local_context const & lctx, binding_type btype, unsigned num_locals, expr const * locals, expr const & e) {
     buffer<local_decl>     decls;
@@ -117,6 +131,10 @@ expr mk_binding(local_context const & lctx, binding_type btype, unsigned num_loc
             lean_assert(values[i]);
             new_e = mk_let(decls[i].get_pp_name(), types[i], *values[i], new_e);
             break;
+        case binding_type::LAMBDA:
+            lean_assert(!values[i]);
+            new_e = ::lean::mk_lambda(decls[i].get_pp_name(), types[i], new_e, decls[i].get_info());
+            break;
         }
     }
     return new_e;
@@ -150,6 +168,17 @@ private:
 
     type_context *          m_tctx_ptr{nullptr};
 
+    /* Assertion stack: (push n) saves the local context and environment n times, and (pop n)
+       restores them. Declarations and assertions live in m_lctx (or m_env when !m_use_locals),
+       so a scope is just a snapshot of both. */
+    std::vector<pair<local_context, environment>> m_scopes;
+
+    /* The vm_state is kept across check-sat queries, and rebased on the current environment
+       before each one. Thus, 0-ary declarations used by the smt tactic (e.g., configuration
+       objects) are evaluated only once per benchmark file. */
+    std::unique_ptr<pooled_vm_state> m_vm_state;
+    unsigned                m_num_queries{0};
+
     // Util
     std::string const & get_stream_name() const { return m_scanner.get_stream_name(); }
 
@@ -181,6 +210,25 @@ private:
         }
     }
 
+    void push_scope() {
+        m_scopes.emplace_back(m_lctx, m_env);
+    }
+
+    void pop_scope() {
+        lean_assert(!m_scopes.empty());
+        m_lctx = m_scopes.back().first;
+        m_env  = m_scopes.back().second;
+        m_scopes.pop_back();
+    }
+
+    vm_state & get_query_vm_state() {
+        if (m_vm_state)
+            (*m_vm_state)->rebase(env(), ios().get_options());
+        else
+            m_vm_state.reset(new pooled_vm_state(env(), ios().get_options()));
+        return **m_vm_state;
+    }
+
     environment & env() { return m_env; }
     io_state & ios() { return m_ios; }
     local_context const & lctx() { return m_tctx_ptr ? m_tctx_ptr->lctx() : m_lctx; }
@@ -471,16 +519,24 @@ private:
         next();
     }
 
-    void parse_check_sat() {
-        lean_assert(curr_kind() == scanner::token_kind::SYMBOL);
-        lean_assert(curr_symbol() == g_token_check_sat);
+    unsigned parse_scope_count(char const * context) {
+        // Note: the official standard requires the numeral, but we treat a missing one as 1
+        if (curr_kind() == scanner::token_kind::RIGHT_PAREN)
+            return 1;
+        check_curr_kind(scanner::token_kind::INT, std::string(context) + ", numeral expected");
+        mpq n = curr_numeral();
+        if (!n.is_integer() || n.is_neg() || n > 10000)
+            throw_parser_exception(std::string(context) + ", invalid number of scopes");
         next();
+        return n.get_numerator().get_unsigned_int();
+    }
 
+    void check_sat_core() {
         metavar_context mctx;
         expr goal_mvar = mctx.mk_metavar_decl(lctx(), mk_constant(get_false_name()));
         vm_obj s = to_obj(tactic_state(env(), ios().get_options(), mctx, list<expr>(goal_mvar), goal_mvar));
 
-        vm_state state(env(), ios().get_options());
+        vm_state & state = get_query_vm_state();
         scope_vm_state scope(state);
         vm_obj result = state.invoke(get_smt_prove_name(), s);
         if (optional<tactic_state> s_new = is_tactic_success(result)) {
@@ -494,11 +550,58 @@ private:
         } else {
             ios().get_regular_stream() << "<tactic failed>\n";
         }
-        check_curr_kind(scanner::token_kind::RIGHT_PAREN, "invalid constant declaration, ')' expected");
+    }
+
+    void check_sat(char const * cmd) {
+        m_num_queries++;
+        if (get_smt2_timing(ios().get_options())) {
+            pos_info pos = m_scanner.get_pos_info();
+            xtimeit timer([&](double duration) {
+                    ios().get_regular_stream()
+                        << "[" << cmd << " #" << m_num_queries << ", " << get_stream_name() << ":" << pos.first
+                        << "] " << std::fixed << std::setprecision(5) << duration << " secs\n";
+                });
+            check_sat_core();
+        } else {
+            check_sat_core();
+        }
+    }
+
+    void parse_check_sat() {
+        lean_assert(curr_kind() == scanner::token_kind::SYMBOL);
+        lean_assert(curr_symbol() == g_token_check_sat);
+        next();
+        check_sat(g_token_check_sat);
+        check_curr_kind(scanner::token_kind::RIGHT_PAREN, "invalid check-sat, ')' expected");
+        next();
+    }
+
+    void parse_check_sat_assuming() {
+        lean_assert(curr_kind() == scanner::token_kind::SYMBOL);
+        lean_assert(curr_symbol() == g_token_check_sat_assuming);
+        next();
+
+        buffer<expr> assumptions;
+        {
+            type_context aux_tctx(m_env, m_ios.get_options(), m_lctx);
+            flet<type_context *> parsing_a_term(m_tctx_ptr, &aux_tctx);
+            parse_expr_list(assumptions, "invalid check-sat-assuming command");
+        }
+
+        // The assumptions are only in effect for this query
+        push_scope();
+        for (expr const & e : assumptions) {
+            if (m_verbose)
+                ios().get_regular_stream() << "[assume] " << e << "\n";
+            register_hypothesis(e);
+        }
+        check_sat(g_token_check_sat_assuming);
+        pop_scope();
+
+        check_curr_kind(scanner::token_kind::RIGHT_PAREN, "invalid check-sat-assuming, ')' expected");
         next();
     }
 
-    void parse_check_sat_assuming() { throw_parser_exception("check-sat-assuming not yet supported"); }
     void parse_declare_const() {
         lean_assert(curr_kind() == scanner::token_kind::SYMBOL);
         lean_assert(curr_symbol() == g_token_declare_const);
@@ -575,7 +678,41 @@ private:
         next();
     }
 
-    void parse_define_fun() { throw_parser_exception("define-fun not yet supported"); }
+    void parse_define_fun() {
+        lean_assert(curr_kind() == scanner::token_kind::SYMBOL);
+        lean_assert(curr_symbol() == g_token_define_fun);
+        next();
+        check_curr_kind(scanner::token_kind::SYMBOL, "invalid function definition, symbol expected");
+        symbol sym = curr_symbol();
+        next();
+
+        type_context aux_tctx(m_env, m_ios.get_options(), m_lctx);
+        expr ty, val;
+        {
+            flet<type_context *> parsing_a_term(m_tctx_ptr, &aux_tctx);
+            buffer<expr> params;
+            parse_sorted_var_list(params, "invalid function definition");
+            expr range = parse_expr("invalid function definition");
+            expr body  = parse_expr("invalid function definition");
+            ty  = mk_binding(aux_tctx.lctx(), binding_type::FORALL, params, range);
+            val = mk_binding(aux_tctx.lctx(), binding_type::LAMBDA, params, body);
+            for (unsigned i = 0; i < params.size(); ++i)
+                aux_tctx.pop_local();
+        }
+
+        if (m_verbose)
+            ios().get_regular_stream() << "[define_fun] " << sym << " : " << ty << " := " << val << "\n";
+
+        if (m_use_locals) {
+            m_lctx.mk_local_decl(sym, ty, val);
+        } else {
+            declaration d = mk_definition(env(), mk_user_name(sym), list<name>(), ty, val);
+            m_env = env().add(check(env(), d));
+        }
+        check_curr_kind(scanner::token_kind::RIGHT_PAREN, "invalid function definition, ')' expected");
+        next();
+    }
+
     void parse_define_fun_rec() { throw_parser_exception("define-fun-rec not yet supported"); }
     void parse_define_funs_rec() { throw_parser_exception("define-funs-rec not yet supported"); }
     void parse_define_sort() { throw_parser_exception("define-sort not yet supported"); }
@@ -599,8 +736,31 @@ private:
     void parse_get_unsat_assumptions() { throw_parser_exception("get-unsat-assumptions not yet supported"); }
     void parse_get_unsat_core() { throw_parser_exception("get-unsat-core not yet supported"); }
     void parse_get_value() { throw_parser_exception("get-value not yet supported"); }
-    void parse_pop() { throw_parser_exception("pop not yet supported"); }
-    void parse_push() { throw_parser_exception("push not yet supported"); }
+    void parse_pop() {
+        lean_assert(curr_kind() == scanner::token_kind::SYMBOL);
+        lean_assert(curr_symbol() == g_token_pop);
+        next();
+        unsigned n = parse_scope_count("invalid pop");
+        if (n > m_scopes.size())
+            throw_parser_exception("invalid pop, only " + std::to_string(m_scopes.size()) +
+                                   " scope(s) have been pushed");
+        for (unsigned i = 0; i < n; i++)
+            pop_scope();
+        check_curr_kind(scanner::token_kind::RIGHT_PAREN, "invalid pop, ')' expected");
+        next();
+    }
+
+    void parse_push() {
+        lean_assert(curr_kind() == scanner::token_kind::SYMBOL);
+        lean_assert(curr_symbol() == g_token_push);
+        next();
+        unsigned n = parse_scope_count("invalid push");
+        for (unsigned i = 0; i < n; i++)
+            push_scope();
+        check_curr_kind(scanner::token_kind::RIGHT_PAREN, "invalid push, ')' expected");
+        next();
+    }
+
     void parse_reset() { throw_parser_exception("reset not yet supported"); }
     void parse_reset_assertions() { throw_parser_exception("reset-assertions not yet supported"); }
     void parse_set_info() {
@@ -632,7 +792,17 @@ private:
         symbol sym = curr_symbol();
         next();
         if (sym == ":use_locals") {
+            // Note: the argument is optional, a missing one means 'true'
             m_use_locals = true;
+            if (curr_kind() == scanner::token_kind::SYMBOL) {
+                symbol val = curr_symbol();
+                next();
+                if (val == "false")
+                    m_use_locals = false;
+                else if (val != "true")
+                    throw_parser_exception("invalid set-option command, "
+                                           "option ':use_locals' requires argument 'true' or 'false'");
+            }
         } else if (sym == ":verbose") {
             check_curr_kind(scanner::token_kind::SYMBOL, "invalid set-option command, option ':verbose' requires argument 'true' or 'false'");
             symbol val = curr_symbol();
@@ -718,10 +888,14 @@ public:
 
 void initialize_parser() {
     g_smt2_unique_prefix = new name(name::mk_internal_unique_name());
+    g_smt2_timing        = new name{"smt2", "timing"};
+    register_bool_option(*g_smt2_timing, LEAN_DEFAULT_SMT2_TIMING,
+                         "(smt2) display the time spent in each check-sat query");
 }
 
 void finalize_parser() {
     delete g_smt2_unique_prefix;
+    delete g_smt2_timing;
 }
 
 // Entry point
@@ -48,7 +48,7 @@ declaration::~declaration() { if (m_ptr) m_ptr->dec_ref(); }
 declaration & declaration::operator=(declaration const & s) { LEAN_COPY_REF(s); }
 declaration & declaration::operator=(declaration && s) { LEAN_MOVE_REF(s); }
 
-bool declaration::is_definition() const    { return static_cast<bool>(m_ptr->m_value) || static_cast<bool>(m_ptr->m_proof); }
+bool declaration::is_definition() const    { return m_ptr->m_has_value; }
 bool declaration::is_constant_assumption() const { return !is_definition(); }
 bool declaration::is_axiom() const         { return is_constant_assumption() && m_ptr->m_theorem; }
 bool declaration::is_theorem() const       { return is_definition() && m_ptr->m_theorem; }
@@ -57,14 +57,35 @@ bool declaration::is_trusted() const       { return m_ptr->m_trusted; }
 name const & declaration::get_name() const { return m_ptr->m_name; }
 level_param_names const & declaration::get_univ_params() const { return m_ptr->m_params; }
 unsigned declaration::get_num_univ_params() const { return length(get_univ_params()); }
-expr const & declaration::get_type() const { return m_ptr->m_type; }
+expr const & declaration::get_type() const { check_materialized(); return m_ptr->m_type; }
 
+void declaration::materialize() const {
+    lock_guard<mutex> lock(*m_ptr->m_decoder_mutex);
+    if (!m_ptr->m_lazy.load())
+        return;
+    declaration d = m_ptr->m_decoder();
+    lean_assert(d.get_name() == get_name());
+    lean_assert(d.is_definition() == is_definition());
+    m_ptr->m_type    = d.m_ptr->m_type;
+    m_ptr->m_value   = d.m_ptr->m_value;
+    m_ptr->m_proof   = d.m_ptr->m_proof;
+    m_ptr->m_decoder = nullptr;
+    m_ptr->m_lazy.store(false);
+}
+
+bool declaration::has_value_task() const {
+    if (!is_definition()) return false;
+    check_materialized();
+    return static_cast<bool>(m_ptr->m_proof);
+}
 task_result<expr> const & declaration::get_value_task() const {
     lean_assert(is_definition());
+    check_materialized();
     return m_ptr->m_proof;
 }
 expr const & declaration::get_value() const {
     lean_assert(is_definition());
+    check_materialized();
     if (m_ptr->m_proof) {
         return m_ptr->m_proof.get();
     } else {
@@ -77,7 +98,7 @@ declaration mk_definition(name const & n, level_param_names const & params, expr
                           reducibility_hints const & h, bool trusted) {
     return declaration(new declaration::cell(n, params, t, v, h, trusted));
 }
-static unsigned get_max_height(environment const & env, expr const & v) {
+unsigned get_max_height(environment const & env, expr const & v) {
     unsigned h = 0;
     for_each(v, [&](expr const & e, unsigned) {
             if (is_constant(e)) {
@@ -95,6 +116,10 @@ declaration mk_definition(environment const & env, name const & n, level_param_n
     unsigned h = get_max_height(env, v);
     return mk_definition(n, params, t, v, reducibility_hints::mk_regular(h+1, use_self_opt), trusted);
 }
+declaration mk_definition(name const & n, level_param_names const & params, expr const & t, task_result<expr> const & v,
+                          reducibility_hints const & h, bool trusted) {
+    return declaration(new declaration::cell(n, params, t, v, h, trusted));
+}
 declaration mk_theorem(name const & n, level_param_names const & params, expr const & t, task_result<expr> const & v) {
     return declaration(new declaration::cell(n, params, t, v));
 }
@@ -107,6 +132,12 @@ declaration mk_axiom(name const & n, level_param_names const & params, expr cons
 declaration mk_constant_assumption(name const & n, level_param_names const & params, expr const & t, bool trusted) {
     return declaration(new declaration::cell(n, params, t, false, trusted));
 }
+declaration mk_lazy_declaration(name const & n, level_param_names const & params, bool has_value,
+                                bool is_theorem_or_axiom, reducibility_hints const & hints, bool trusted,
+                                declaration_decoder const & decoder, std::shared_ptr<mutex> const & decoder_mutex) {
+    return declaration(new declaration::cell(n, params, has_value, is_theorem_or_axiom, hints, trusted, decoder,
+                                             decoder_mutex));
+}
 
 bool use_untrusted(environment const & env, expr const & e) {
     bool found = false;
@@ -8,7 +8,10 @@ Author: Leonardo de Moura
 #include <algorithm>
 #include <string>
 #include <limits>
+#include <functional>
+#include <memory>
 #include "util/rc.h"
+#include "util/thread.h"
 #include "util/task_queue.h"
 #include "kernel/expr.h"
 
@@ -67,6 +70,10 @@ public:
 
 int compare(reducibility_hints const & h1, reducibility_hints const & h2);
 
+class declaration;
+/** \brief Function producing the actual declaration for a lazy declaration, see #mk_lazy_declaration. */
+typedef std::function<declaration()> declaration_decoder;
+
 /** \brief Environment definitions, theorems, axioms and variable declarations. */
 class declaration {
     struct cell {
@@ -75,6 +82,7 @@ class declaration {
         level_param_names  m_params;
         expr               m_type;
         bool               m_theorem;
+        bool               m_has_value;
         optional<expr>     m_value;        // if none, then declaration is actually a postulate
         task_result<expr>  m_proof;
         reducibility_hints m_hints;
@@ -83,22 +91,39 @@ class declaration {
            associated definitions are "untrusted". We use this feature to define tactical-definitions.
            The kernel type checker ensures trusted definitions do not use untrusted ones. */
         bool              m_trusted;
+        /* When m_lazy is true, m_type, m_value and m_proof have not been computed yet.
+           They are obtained using m_decoder the first time they are accessed. */
+        atomic<bool>        m_lazy;
+        declaration_decoder m_decoder;
+        /* Lock used to materialize the declaration, it is shared by the declarations of a module. */
+        std::shared_ptr<mutex> m_decoder_mutex;
         void dealloc() { delete this; }
 
         cell(name const & n, level_param_names const & params, expr const & t, bool is_axiom, bool trusted):
-            m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(is_axiom),
-            m_hints(reducibility_hints::mk_opaque()), m_trusted(trusted) {}
+            m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(is_axiom), m_has_value(false),
+            m_hints(reducibility_hints::mk_opaque()), m_trusted(trusted), m_lazy(false) {}
         cell(name const & n, level_param_names const & params, expr const & t, expr const & v,
              reducibility_hints const & h, bool trusted):
-            m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(false),
-            m_value(v), m_hints(h), m_trusted(trusted) {}
+            m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(false), m_has_value(true),
+            m_value(v), m_hints(h), m_trusted(trusted), m_lazy(false) {}
         cell(name const & n, level_param_names const & params, expr const & t, task_result<expr> const & v):
-            m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(true),
-            m_proof(v), m_hints(reducibility_hints::mk_opaque()), m_trusted(true) {}
+            m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(true), m_has_value(true),
+            m_proof(v), m_hints(reducibility_hints::mk_opaque()), m_trusted(true), m_lazy(false) {}
+        cell(name const & n, level_param_names const & params, expr const & t, task_result<expr> const & v,
+             reducibility_hints const & h, bool trusted):
+            m_rc(1), m_name(n), m_params(params), m_type(t), m_theorem(false), m_has_value(true),
+            m_proof(v), m_hints(h), m_trusted(trusted), m_lazy(false) {}
+        cell(name const & n, level_param_names const & params, bool has_value, bool theorem,
+             reducibility_hints const & h, bool trusted, declaration_decoder const & decoder,
+             std::shared_ptr<mutex> const & decoder_mutex):
+            m_rc(1), m_name(n), m_params(params), m_theorem(theorem), m_has_value(has_value),
+            m_hints(h), m_trusted(trusted), m_lazy(true), m_decoder(decoder), m_decoder_mutex(decoder_mutex) {}
     };
     cell * m_ptr;
     explicit declaration(cell * ptr);
     friend struct cell;
+    void materialize() const;
+    void check_materialized() const { if (m_ptr->m_lazy.load()) materialize(); }
 public:
     /**
        \brief The default constructor creates a reference to a "dummy"
@@ -132,6 +157,9 @@ public:
     unsigned get_num_univ_params() const;
     expr const & get_type() const;
 
+    /** \brief Return true iff the value of this definition is computed by a task.
+        This is always the case for theorems. */
+    bool has_value_task() const;
     task_result<expr> const & get_value_task() const;
     expr const & get_value() const;
 
@@ -141,9 +169,15 @@ public:
                                      reducibility_hints const & hints, bool trusted);
     friend declaration mk_definition(environment const & env, name const & n, level_param_names const & params, expr const & t,
                                      expr const & v, bool use_conv_opt, bool trusted);
+    friend declaration mk_definition(name const & n, level_param_names const & params, expr const & t,
+                                     task_result<expr> const & v, reducibility_hints const & hints, bool trusted);
     friend declaration mk_theorem(name const &, level_param_names const &, expr const &, task_result<expr> const &);
     friend declaration mk_axiom(name const & n, level_param_names const & params, expr const & t);
     friend declaration mk_constant_assumption(name const & n, level_param_names const & params, expr const & t, bool trusted);
+    friend declaration mk_lazy_declaration(name const & n, level_param_names const & params, bool has_value,
+                                           bool is_theorem_or_axiom, reducibility_hints const & hints, bool trusted,
+                                           declaration_decoder const & decoder,
+                                           std::shared_ptr<mutex> const & decoder_mutex);
 };
 
 inline optional<declaration> none_declaration() { return optional<declaration>(); }
@@ -154,10 +188,25 @@ declaration mk_definition(name const & n, level_param_names const & params, expr
                           reducibility_hints const & hints, bool trusted = true);
 declaration mk_definition(environment const & env, name const & n, level_param_names const & params, expr const & t, expr const & v,
                           bool use_conv_opt = true, bool trusted = true);
+/** \brief Create a definition whose value is computed by the task \c v.
+    Since the value is not available yet, the caller must provide the reducibility hints. */
+declaration mk_definition(name const & n, level_param_names const & params, expr const & t, task_result<expr> const & v,
+                          reducibility_hints const & hints, bool trusted = true);
+/** \brief Return the maximum definitional height of the constants occurring in \c e. */
+unsigned get_max_height(environment const & env, expr const & e);
 declaration mk_theorem(name const & n, level_param_names const & params, expr const & t, expr const & v);
 declaration mk_theorem(name const & n, level_param_names const & params, expr const & t, task_result<expr> const & v);
 declaration mk_axiom(name const & n, level_param_names const & params, expr const & t);
 declaration mk_constant_assumption(name const & n, level_param_names const & params, expr const & t, bool trusted = true);
+/** \brief Create a declaration whose type and value are only computed when they are first accessed.
+    The name, universe parameters, kind and reducibility hints are available immediately.
+    The result of \c decoder must agree with them. \c decoder_mutex protects the materialization,
+    declarations coming from the same module share it.
+
+    \remark We use lazy declarations to avoid decoding every declaration stored in imported .olean files. */
+declaration mk_lazy_declaration(name const & n, level_param_names const & params, bool has_value,
+                                bool is_theorem_or_axiom, reducibility_hints const & hints, bool trusted,
+                                declaration_decoder const & decoder, std::shared_ptr<mutex> const & decoder_mutex);
 
 /** \brief Return true iff \c e depends on meta-declarations */
 bool use_untrusted(environment const & env, expr const & e);
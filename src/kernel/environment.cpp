@@ -130,15 +130,23 @@ environment environment::replace(certified_declaration const & t) const {
     name const & n = t.get_declaration().get_name();
     auto ax = find(n);
     if (!ax)
-        throw_kernel_exception(*this, "invalid replacement of axiom with theorem, the environment does not have an axiom with the given name");
-    if (!ax->is_axiom())
-        throw_kernel_exception(*this, "invalid replacement of axiom with theorem, the current declaration in the environment is not an axiom");
-    if (!t.get_declaration().is_theorem())
-        throw_kernel_exception(*this, "invalid replacement of axiom with theorem, the new declaration is not a theorem");
+        throw_kernel_exception(*this, "invalid replacement of declaration, the environment does not have a declaration with the given name");
+    if (ax->is_axiom()) {
+        if (!t.get_declaration().is_theorem())
+            throw_kernel_exception(*this, "invalid replacement of axiom with theorem, the new declaration is not a theorem");
+    } else if (ax->is_definition() && !ax->is_theorem() && ax->has_value_task()) {
+        if (!t.get_declaration().is_definition() || t.get_declaration().is_theorem())
+            throw_kernel_exception(*this, "invalid replacement of definition, the new declaration is not a definition");
+    } else {
+        throw_kernel_exception(*this, "invalid replacement of declaration, the current declaration in the environment "
+                               "is neither an axiom nor a definition whose value is computed by a task");
+    }
     if (ax->get_type() != t.get_declaration().get_type())
-        throw_kernel_exception(*this, "invalid replacement of axiom with theorem, the 'replace' operation can only be used when the axiom and theorem have the same type");
+        throw_kernel_exception(*this, "invalid replacement of declaration, the 'replace' operation can only be used when "
+                               "both declarations have the same type");
     if (ax->get_univ_params() != t.get_declaration().get_univ_params())
-        throw_kernel_exception(*this, "invalid replacement of axiom with theorem, the 'replace' operation can only be used when the axiom and theorem have the same universe parameters");
+        throw_kernel_exception(*this, "invalid replacement of declaration, the 'replace' operation can only be used when "
+                               "both declarations have the same universe parameters");
     return environment(m_header, m_id, insert(m_declarations, n, t.get_declaration()), m_global_levels, m_extensions);
 }
 
@@ -158,10 +158,12 @@ public:
     environment add(certified_declaration const & d) const;
 
     /**
-       \brief Replace the axiom with name <tt>t.get_declaration().get_name()</tt> with the theorem t.get_declaration().
+       \brief Replace the axiom with name <tt>t.get_declaration().get_name()</tt> with the theorem t.get_declaration(),
+       or the definition whose value is computed by a task with the definition t.get_declaration().
        This method throws an exception if:
-          - The theorem was certified in an environment which is not an ancestor of this one.
-          - The environment does not contain an axiom named <tt>t.get_declaration().get_name()</tt>
+          - The new declaration was certified in an environment which is not an ancestor of this one.
+          - The environment does not contain an axiom or such a definition named <tt>t.get_declaration().get_name()</tt>
+          - The two declarations do not have the same type and universe parameters.
     */
     environment replace(certified_declaration const & t) const;
 
@@ -218,6 +220,7 @@ class name_generator;
 class certified_declaration {
     friend class certify_unchecked;
     friend certified_declaration check(environment const & env, declaration const & d, bool immediately);
+    friend certified_declaration check_replacement(environment const & env, declaration const & d);
     environment_id m_id;
     declaration    m_declaration;
     certified_declaration(environment_id const & id, declaration const & d):m_id(id), m_declaration(d) {}
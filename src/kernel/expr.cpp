@@ -12,6 +12,7 @@ Author: Leonardo de Moura
 #include <limits>
 #include "util/list_fn.h"
 #include "util/hash.h"
+#include "util/thread.h"
 #include "util/buffer.h"
 #include "util/object_serializer.h"
 #include "util/lru_cache.h"
@@ -329,17 +330,110 @@ expr_macro::~expr_macro() {
 
 // =======================================
 // Constructors
+
+/* Hash-consing tables are swept when their size doubles. The sweep removes the entries
+   that are only referenced by the table itself, i.e., the table behaves as a set of weak references. */
+#ifndef LEAN_EXPR_CACHE_MIN_SWEEP
+#define LEAN_EXPR_CACHE_MIN_SWEEP 4096
+#endif
+
+#ifndef LEAN_GLOBAL_EXPR_CACHE_SHARDS
+#define LEAN_GLOBAL_EXPR_CACHE_SHARDS 64
+#endif
+
+class expr_cache {
+    typedef std::unordered_set<expr, expr_hash, is_bi_equal_proc> expr_set;
+    expr_set m_set;
+    size_t   m_sweep_at = LEAN_EXPR_CACHE_MIN_SWEEP;
+public:
+    /* \brief Return an expression in the table that is structurally equal to \c e, or insert \c e.
+       Entries removed by the sweep are moved to \c todelete, so that the caller can destroy them
+       after releasing any lock protecting the table. */
+    expr insert(expr const & e, buffer<expr> & todelete) {
+        auto it = m_set.find(e);
+        if (it != m_set.end())
+            return *it;
+        if (m_set.size() >= m_sweep_at) {
+            auto it2 = m_set.begin();
+            while (it2 != m_set.end()) {
+                if (it2->raw()->get_rc() == 1) {
+                    todelete.push_back(*it2);
+                    it2 = m_set.erase(it2);
+                } else {
+                    ++it2;
+                }
+            }
+            m_sweep_at = std::max(static_cast<size_t>(LEAN_EXPR_CACHE_MIN_SWEEP), 2 * m_set.size());
+        }
+        m_set.insert(e);
+        return e;
+    }
+    bool contains(expr const & e) const { return m_set.find(e) != m_set.end(); }
+    size_t size() const { return m_set.size(); }
+    void swap(expr_cache & other) {
+        m_set.swap(other.m_set);
+        std::swap(m_sweep_at, other.m_sweep_at);
+    }
+};
+
+/** \brief Hash-consing table shared by all threads. It is split into shards indexed by the expression hash code,
+    each one protected by its own mutex, to reduce contention. Structurally equal expressions created by different
+    threads (e.g., by different elaboration tasks) become pointer equal, and the is_eqp fast paths in
+    expr_eq_fn, replace_fn and the type checker caches can be used across threads. */
+class global_expr_cache {
+    struct shard {
+        mutex      m_mutex;
+        expr_cache m_cache;
+    };
+    shard m_shards[LEAN_GLOBAL_EXPR_CACHE_SHARDS];
+    shard & get_shard(expr const & e) { return m_shards[e.hash() % LEAN_GLOBAL_EXPR_CACHE_SHARDS]; }
+public:
+    expr insert(expr const & e) {
+        /* todelete is declared before the lock, so the swept expressions are destroyed after it is released */
+        buffer<expr> todelete;
+        shard & s = get_shard(e);
+        lock_guard<mutex> lock(s.m_mutex);
+        return s.m_cache.insert(e, todelete);
+    }
+    bool contains(expr const & e) {
+        shard & s = get_shard(e);
+        lock_guard<mutex> lock(s.m_mutex);
+        return s.m_cache.contains(e);
+    }
+    size_t size() {
+        size_t r = 0;
+        for (shard & s : m_shards) {
+            lock_guard<mutex> lock(s.m_mutex);
+            r += s.m_cache.size();
+        }
+        return r;
+    }
+};
+
+static global_expr_cache * g_global_expr_cache = nullptr;
+static atomic<bool> g_global_expr_cache_enabled(false);
+
+void enable_global_expr_caching(bool f) {
+    g_global_expr_cache_enabled = f;
+}
+
+bool is_global_expr_caching_enabled() {
+    return g_global_expr_cache_enabled.load();
+}
+
+size_t get_global_expr_cache_size() {
+    return g_global_expr_cache->size();
+}
+
 LEAN_THREAD_VALUE(bool, g_expr_cache_enabled, true);
-typedef typename std::unordered_set<expr, expr_hash, is_bi_equal_proc> expr_cache;
 MK_THREAD_LOCAL_GET_DEF(expr_cache, get_expr_cache);
 inline expr cache(expr const & e) {
     if (g_expr_cache_enabled) {
-        expr_cache & cache = get_expr_cache();
-        auto it = cache.find(e);
-        if (it != cache.end()) {
-            return *it;
+        if (g_global_expr_cache_enabled.load()) {
+            return g_global_expr_cache->insert(e);
         } else {
-            cache.insert(e);
+            buffer<expr> todelete;
+            return get_expr_cache().insert(e, todelete);
         }
     }
     return e;
@@ -360,7 +454,9 @@ bool enable_expr_caching(bool f) {
     return r2;
 }
 bool is_cached(expr const & e) {
-    return get_expr_cache().find(e) != get_expr_cache().end();
+    if (g_global_expr_cache_enabled.load() && g_global_expr_cache->contains(e))
+        return true;
+    return get_expr_cache().contains(e);
 }
 
 expr mk_var(unsigned idx, tag g) {
@@ -731,6 +827,7 @@ std::ostream & operator<<(std::ostream & out, expr_kind const & k) {
 }
 
 void initialize_expr() {
+    g_global_expr_cache = new global_expr_cache();
     g_dummy        = new expr(mk_constant("__expr_for_default_constructor__"));
     g_default_name = new name("a");
     g_Type1        = new expr(mk_sort(mk_level_one()));
@@ -742,5 +839,6 @@ void finalize_expr() {
     delete g_Type1;
     delete g_dummy;
     delete g_default_name;
+    delete g_global_expr_cache;
 }
 }
@@ -503,6 +503,12 @@ struct scoped_expr_caching {
 };
 /** \brief Return true iff \c e is in the cache */
 bool is_cached(expr const & e);
+/** \brief When enabled, hash-consing uses a table shared by all threads instead of thread local ones.
+    It is disabled by default. */
+void enable_global_expr_caching(bool f);
+bool is_global_expr_caching_enabled();
+/** \brief Return the number of expressions in the table shared by all threads. It is only used for testing. */
+size_t get_global_expr_cache_size();
 // =======================================
 
 // =======================================
@@ -762,7 +762,7 @@ class proof_checking_task : public task<expr> {
 public:
     proof_checking_task(environment const & env, declaration const & d) :
             m_env(env), m_decl(d) {
-        lean_assert(d.is_theorem());
+        lean_assert(d.has_value_task());
     }
 
     virtual bool is_tiny() const override { return true; }
@@ -784,23 +784,36 @@ public:
     }
 };
 
-certified_declaration check(environment const & env, declaration const & d, bool immediately) {
-    check_no_mlocal(env, d.get_name(), d.get_type(), true);
-    check_name(env, d.get_name());
+/* Type check \c d, and return the declaration to be certified. */
+static declaration check_core(environment const & env, declaration const & d, bool immediately) {
     check_duplicated_params(env, d);
     bool memoize = true; bool trusted_only = d.is_trusted();
     type_checker checker(env, memoize, trusted_only);
     expr sort = checker.check(d.get_type(), d.get_univ_params());
     checker.ensure_sort(sort, d.get_type());
     if (d.is_definition()) {
-        if (!immediately && env.trust_lvl() != 0 && d.is_theorem() && &get_global_task_queue()) {
+        if (!immediately && env.trust_lvl() != 0 && d.has_value_task() && &get_global_task_queue()) {
             auto checked_proof = get_global_task_queue().submit<proof_checking_task>(env, d);
-            return certified_declaration(env.get_id(),
-                                         mk_theorem(d.get_name(), d.get_univ_params(), d.get_type(), checked_proof));
+            if (d.is_theorem())
+                return mk_theorem(d.get_name(), d.get_univ_params(), d.get_type(), checked_proof);
+            else
+                return mk_definition(d.get_name(), d.get_univ_params(), d.get_type(), checked_proof,
+                                     d.get_hints(), d.is_trusted());
         }
         check_definition(env, d, checker);
     }
-    return certified_declaration(env.get_id(), d);
+    return d;
+}
+
+certified_declaration check(environment const & env, declaration const & d, bool immediately) {
+    check_no_mlocal(env, d.get_name(), d.get_type(), true);
+    check_name(env, d.get_name());
+    return certified_declaration(env.get_id(), check_core(env, d, immediately));
+}
+
+certified_declaration check_replacement(environment const & env, declaration const & d) {
+    check_no_mlocal(env, d.get_name(), d.get_type(), true);
+    return certified_declaration(env.get_id(), check_core(env, d, true));
 }
 
 certified_declaration certify_unchecked::certify(environment const & env, declaration const & d) {
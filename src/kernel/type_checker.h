@@ -147,6 +147,9 @@ void check_no_metavar(environment const & env, name const & n, expr const & e, b
 /** \brief Type check the given declaration, and return a certified declaration if it is type correct.
     Throw an exception if the declaration is type incorrect. */
 certified_declaration check(environment const & env, declaration const & d, bool immediately = false);
+/** \brief Similar to check, but \c d is meant to replace the declaration with the same name in \c env
+    (see environment::replace). */
+certified_declaration check_replacement(environment const & env, declaration const & d);
 
 void initialize_type_checker();
 void finalize_type_checker();
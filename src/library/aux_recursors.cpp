@@ -54,20 +54,24 @@ bool is_no_confusion(environment const & env, name const & r) {
     return get_extension(env).m_no_confusion_set.contains(r);
 }
 
-static void aux_recursor_reader(deserializer & d, environment & env) {
+static module_modification aux_recursor_reader(deserializer & d) {
     name r;
     d >> r;
-    aux_recursor_ext ext = get_extension(env);
-    ext.m_aux_recursor_set.insert(r);
-    env = update(env, ext);
+    return [=](environment & env) {
+        aux_recursor_ext ext = get_extension(env);
+        ext.m_aux_recursor_set.insert(r);
+        env = update(env, ext);
+    };
 }
 
-static void no_confusion_reader(deserializer & d, environment & env) {
+static module_modification no_confusion_reader(deserializer & d) {
     name r;
     d >> r;
-    aux_recursor_ext ext = get_extension(env);
-    ext.m_no_confusion_set.insert(r);
-    env = update(env, ext);
+    return [=](environment & env) {
+        aux_recursor_ext ext = get_extension(env);
+        ext.m_no_confusion_set.insert(r);
+        env = update(env, ext);
+    };
 }
 
 void initialize_aux_recursors() {
@@ -25,17 +25,20 @@ struct class_entry {
     name             m_class;
     name             m_instance; // only relevant if m_kind == Instance
     unsigned         m_priority; // only relevant if m_kind == Instance
+    list<name>       m_arg_keys; // only relevant if m_kind == Instance, see get_instance_arg_keys
     class_entry():m_kind(class_entry_kind::Class), m_priority(0) {}
     explicit class_entry(name const & c):m_kind(class_entry_kind::Class), m_class(c), m_priority(0) {}
-    class_entry(class_entry_kind k, name const & c, name const & i, unsigned p):
-        m_kind(k), m_class(c), m_instance(i), m_priority(p) {}
+    class_entry(class_entry_kind k, name const & c, name const & i, unsigned p, list<name> const & keys):
+        m_kind(k), m_class(c), m_instance(i), m_priority(p), m_arg_keys(keys) {}
 };
 
 struct class_state {
     typedef name_map<list<name>> class_instances;
     typedef name_map<unsigned>   instance_priorities;
+    typedef name_map<list<name>> instance_arg_keys;
     class_instances       m_instances;
     instance_priorities   m_priorities;
+    instance_arg_keys     m_arg_keys;
 
     unsigned get_priority(name const & i) const {
         if (auto it = m_priorities.find(i))
@@ -63,7 +66,7 @@ struct class_state {
             m_instances.insert(c, list<name>());
     }
 
-    void add_instance(name const & c, name const & i, unsigned p) {
+    void add_instance(name const & c, name const & i, unsigned p, list<name> const & keys) {
         auto it = m_instances.find(c);
         if (!it) {
             m_instances.insert(c, to_list(i));
@@ -72,6 +75,7 @@ struct class_state {
             m_instances.insert(c, insert(i, p, lst));
         }
         m_priorities.insert(i, p);
+        m_arg_keys.insert(i, keys);
     }
 };
 
@@ -87,7 +91,7 @@ struct class_config {
             s.add_class(e.m_class);
             break;
         case class_entry_kind::Instance:
-            s.add_instance(e.m_class, e.m_instance, e.m_priority);
+            s.add_instance(e.m_class, e.m_instance, e.m_priority, e.m_arg_keys);
             break;
         }
     }
@@ -105,6 +109,7 @@ struct class_config {
             break;
         case class_entry_kind::Instance:
             s << e.m_class << e.m_instance << e.m_priority;
+            write_list(s, e.m_arg_keys);
             break;
         }
     }
@@ -118,6 +123,7 @@ struct class_config {
             break;
         case class_entry_kind::Instance:
             d >> e.m_class >> e.m_instance >> e.m_priority;
+            e.m_arg_keys = read_list<name>(d);
             break;
         }
         return e;
@@ -171,6 +177,25 @@ bool is_class(environment const & env, name const & c) {
     return s.m_instances.contains(c);
 }
 
+name get_instance_arg_key(environment const & env, expr const & arg) {
+    expr const & fn = get_app_fn(arg);
+    if (is_constant(fn) && is_rigid_head_symbol(env, const_name(fn)))
+        return const_name(fn);
+    return name();
+}
+
+/* Return the key of each argument of \c e, see get_instance_arg_key.
+   The local constants introduced for the hypotheses of an instance become metavariables during
+   type class resolution, so they must not be used as keys. */
+static list<name> mk_arg_keys(environment const & env, expr const & e) {
+    buffer<expr> args;
+    get_app_args(e, args);
+    buffer<name> keys;
+    for (expr const & arg : args)
+        keys.push_back(get_instance_arg_key(env, arg));
+    return to_list(keys);
+}
+
 static environment set_reducible_if_def(environment const & env, name const & n, bool persistent) {
     declaration const & d = env.get(n);
     if (d.is_definition() && !d.is_theorem())
@@ -196,8 +221,8 @@ environment add_instance_core(environment const & env, name const & n, unsigned
     }
     name c = get_class_name(env, get_app_fn(type));
     check_is_class(env, c);
-    environment new_env = class_ext::add_entry(env, get_dummy_ios(), class_entry(class_entry_kind::Instance, c, n, priority),
-                                               persistent);
+    class_entry e(class_entry_kind::Instance, c, n, priority, mk_arg_keys(env, type));
+    environment new_env = class_ext::add_entry(env, get_dummy_ios(), e, persistent);
     return set_reducible_if_def(new_env, n, persistent);
 }
 
@@ -231,6 +256,11 @@ list<name> get_class_instances(environment const & env, name const & c) {
     return ptr_to_list(s.m_instances.find(c));
 }
 
+list<name> get_instance_arg_keys(environment const & env, name const & i) {
+    class_state const & s = class_ext::get_state(env);
+    return ptr_to_list(s.m_arg_keys.find(i));
+}
+
 static name * g_class_attr_name    = nullptr;
 static name * g_instance_attr_name = nullptr;
 
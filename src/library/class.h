@@ -21,6 +21,14 @@ name_predicate mk_class_pred(environment const & env);
 name_predicate mk_instance_pred(environment const & env);
 /** \brief Return the instances of the given class. */
 list<name> get_class_instances(environment const & env, name const & c);
+/** \brief Return the head constant of \c arg if it is a rigid head symbol (see is_rigid_head_symbol),
+    and the anonymous name (i.e., a wildcard) otherwise. It is used for the arguments of the class application
+    in the resulting type of an instance and in the goal, so both sides are normalized in the same way. */
+name get_instance_arg_key(environment const & env, expr const & arg);
+/** \brief Return the keys (see get_instance_arg_key) of the arguments of the class application in the resulting
+    type of the instance \c i. The type class resolution procedure uses them to skip instances that cannot
+    match the goal. */
+list<name> get_instance_arg_keys(environment const & env, name const & i);
 /** \brief Return the classes in the given environment. */
 void get_classes(environment const & env, buffer<name> & classes);
 name get_class_name(environment const & env, expr const & e);
@@ -7,10 +7,13 @@ Author: Leonardo de Moura
 #include <string>
 #include "util/numerics/mpz.h"
 #include "kernel/expr.h"
+#include "kernel/replace_fn.h"
 #include "library/constants.h"
 #include "library/num.h"
+#include "library/util.h"
 #include "library/kernel_serializer.h"
 #include "library/replace_visitor_with_tc.h"
+#include "library/compiler/nat_value.h"
 
 namespace lean {
 static expr * g_nat               = nullptr;
@@ -92,6 +95,33 @@ optional<expr> to_nat_value(type_context & ctx, expr const & e) {
     return none_expr();
 }
 
+/* Return the value of the constant \c n (e.g., char_sz) if it reduces to a numeral or the successor of a numeral. */
+static optional<mpz> get_nat_constant_value(type_context & ctx, name const & n) {
+    if (!ctx.env().find(n))
+        return optional<mpz>();
+    expr v = ctx.whnf(mk_constant(n));
+    if (auto r = to_num(v))
+        return r;
+    if (is_app_of(v, get_nat_succ_name(), 1)) {
+        if (auto r = to_num(app_arg(v)))
+            return optional<mpz>(*r + 1);
+    }
+    return optional<mpz>();
+}
+
+/* Numerals of type unsigned are encoded using bit0, bit1 and the fin arithmetic.
+   We replace them with (unsigned.of_nat v) where v is a nat_value macro, see fold_of_nat_values. */
+static optional<expr> to_unsigned_value(type_context & ctx, expr const & e) {
+    if (optional<mpz> v = to_num(e)) {
+        if (is_constant(ctx.infer(e), get_unsigned_name())) {
+            optional<mpz> sz = get_nat_constant_value(ctx, get_unsigned_sz_name());
+            if (sz && *v >= 0 && *v < *sz)
+                return some_expr(mk_app(mk_constant(get_unsigned_of_nat_name()), mk_nat_value(*v)));
+        }
+    }
+    return none_expr();
+}
+
 class find_nat_values_fn : public replace_visitor_with_tc {
     expr visit_app(expr const & e) override {
         if (auto v = to_nat_value(m_ctx, e))
@@ -107,6 +137,40 @@ expr find_nat_values(environment const & env, expr const & e) {
     return find_nat_values_fn(ctx)(e);
 }
 
+class find_unsigned_values_fn : public replace_visitor_with_tc {
+    expr visit_app(expr const & e) override {
+        if (auto v = to_unsigned_value(m_ctx, e))
+            return copy_tag(e, expr(*v));
+        return replace_visitor_with_tc::visit_app(e);
+    }
+public:
+    find_unsigned_values_fn(type_context & ctx):replace_visitor_with_tc(ctx) {}
+};
+
+expr find_unsigned_values(environment const & env, expr const & e) {
+    type_context ctx(env, transparency_mode::All);
+    return find_unsigned_values_fn(ctx)(e);
+}
+
+void fold_of_nat_values(environment const & env, buffer<procedure> & procs) {
+    type_context ctx(env, transparency_mode::All);
+    optional<mpz> char_sz     = get_nat_constant_value(ctx, get_char_sz_name());
+    optional<mpz> unsigned_sz = get_nat_constant_value(ctx, get_unsigned_sz_name());
+    for (procedure & p : procs) {
+        p.m_code = replace(p.m_code, [&](expr const & e, unsigned) {
+                if (!is_app(e) || !is_nat_value(app_arg(e)) || !is_constant(app_fn(e)))
+                    return none_expr();
+                name const & fn  = const_name(app_fn(e));
+                mpz const & v    = get_nat_value_value(app_arg(e));
+                /* In the VM, char and unsigned values are represented by the natural number they wrap. */
+                if ((fn == get_char_of_nat_name() && char_sz && v < *char_sz) ||
+                    (fn == get_unsigned_of_nat_name() && unsigned_sz && v < *unsigned_sz))
+                    return some_expr(copy_tag(e, expr(app_arg(e))));
+                return none_expr();
+            });
+    }
+}
+
 void initialize_nat_value() {
     g_nat_macro  = new name("nat_value_macro");
     g_nat        = new expr(Const(get_nat_name()));
@@ -6,11 +6,15 @@ Author: Leonardo de Moura
 */
 #pragma once
 #include "library/type_context.h"
+#include "library/compiler/procedure.h"
 
 namespace lean {
 /** \brief Replace nat numerals encoded using bit0, bit1, one with an auxiliary nat_value macro.
     This macro wraps a mpz number. */
 expr find_nat_values(environment const & env, expr const & e);
+/** \brief Replace unsigned numerals with (unsigned.of_nat v) where v is a nat_value macro.
+    This transformation must be applied before the instances used to encode the numerals are inlined. */
+expr find_unsigned_values(environment const & env, expr const & e);
 /** \brief Create a nat_value macro expression. This macro should only be used in the compiler. */
 expr mk_nat_value(mpz const & v);
 /** \brief Return true iff \c e is a nat_value macro expression. */
@@ -22,6 +26,10 @@ mpz const & get_nat_value_value(expr const & e);
 /** \brief If \c e encodes a nat numeral, then convert it into a nat_value macro */
 optional<expr> to_nat_value(type_context & ctx, expr const & e);
 
+/** \brief Replace (char.of_nat v) and (unsigned.of_nat v) with v when v is a nat_value macro within bounds.
+    This transformation must be applied after erase_irrelevant. */
+void fold_of_nat_values(environment const & env, buffer<procedure> & procs);
+
 void initialize_nat_value();
 void finalize_nat_value();
 }
@@ -201,6 +201,7 @@ public:
         expr v = d.get_value();
         lean_trace(name({"compiler", "input"}), tout() << "\n" << v << "\n";);
         v = fix_tactic_eval_expr(v);
+        v = find_unsigned_values(m_env, v);
         v = inline_simple_definitions(m_env, v);
         lean_cond_assert("compiler", check(d, v));
         lean_trace(name({"compiler", "inline"}), tout() << "\n" << v << "\n";);
@@ -231,6 +232,8 @@ public:
         lean_trace(name({"compiler", "simplify_inductive"}), tout() << "\n"; display(procs););
         elim_unused_lets(m_env, procs);
         lean_trace(name({"compiler", "elim_unused_lets"}), tout() << "\n"; display(procs););
+        fold_of_nat_values(m_env, procs);
+        lean_trace(name({"compiler", "fold_of_nat_values"}), tout() << "\n"; display(procs););
         extract_values(m_env, d.get_name(), procs);
         lean_trace(name({"compiler", "extract_values"}), tout() << "\n"; display(procs););
         cse(m_env, procs);
@@ -256,6 +259,7 @@ void initialize_preprocess() {
     register_trace_class({"compiler", "lambda_lifting"});
     register_trace_class({"compiler", "simplify_inductive"});
     register_trace_class({"compiler", "elim_unused_lets"});
+    register_trace_class({"compiler", "fold_of_nat_values"});
     register_trace_class({"compiler", "extract_values"});
     register_trace_class({"compiler", "cse"});
     register_trace_class({"compiler", "preprocess"});
@@ -4,8 +4,10 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <algorithm>
 #include "util/fresh_name.h"
 #include "util/sstream.h"
+#include "util/sexpr/option_declarations.h"
 #include "kernel/instantiate.h"
 #include "kernel/inductive/inductive.h"
 #include "library/constants.h"
@@ -28,10 +30,22 @@ Author: Leonardo de Moura
 #include "library/native_compiler/extern.h"
 #include "library/native_compiler/used_defs.h"
 
+#ifndef LEAN_VALUE_SWITCH_MIN_CASES
+#define LEAN_VALUE_SWITCH_MIN_CASES 4
+#endif
+
+#ifndef LEAN_VALUE_SWITCH_LINEAR_CASES
+#define LEAN_VALUE_SWITCH_LINEAR_CASES 3
+#endif
+
 namespace lean {
 class vm_compiler_fn {
     environment        m_env;
     buffer<vm_instr> & m_code;
+    bool               m_value_switch;
+    bool               m_registers;
+    /* Mapping from decision procedures for equality of natural numbers to their arity, see get_nat_eq_arity. */
+    name_map<unsigned> m_nat_eq_arity;
 
     void emit(vm_instr const & i) {
         m_code.push_back(i);
@@ -60,7 +74,60 @@ class vm_compiler_fn {
         }
     }
 
+    /* Return the operand for \c e when it is a local or a simple object, see vm_operand. */
+    optional<vm_operand> to_operand(expr const & e, name_map<unsigned> const & m) {
+        optional<unsigned> simple;
+        if (is_local(e)) {
+            unsigned idx = *m.find(mlocal_name(e));
+            if (vm_operand::fits(idx))
+                return optional<vm_operand>(vm_operand(vm_operand_kind::Local, idx));
+        } else if (is_constant(e)) {
+            if (is_neutral_expr(e) || const_name(e) == get_nat_zero_name())
+                simple = 0;
+            else if (!is_unreachable_expr(e))
+                simple = is_internal_cnstr(e);
+        } else if (is_nat_value(e) && get_nat_value_value(e) < LEAN_MAX_SMALL_NAT) {
+            simple = get_nat_value_value(e).get_unsigned_int();
+        }
+        if (simple && vm_operand::fits(*simple))
+            return optional<vm_operand>(vm_operand(vm_operand_kind::Simple, *simple));
+        return optional<vm_operand>();
+    }
+
+    /* Register-based encoding: the arguments \c args (in the order they would be pushed) that are locals or
+       simple objects are stored in \c ops, and the other ones are compiled on the stack (Stack operands).
+       If none of the arguments is a local or a simple object, nothing is compiled and the result is false,
+       since the register-based instruction would not save any instruction. */
+    bool compile_operands(buffer<expr> const & args, unsigned bpz, name_map<unsigned> const & m,
+                          buffer<vm_operand> & ops) {
+        if (!m_registers || std::none_of(args.begin(), args.end(), [&](expr const & a) { return to_operand(a, m); }))
+            return false;
+        for (expr const & a : args) {
+            if (optional<vm_operand> o = to_operand(a, m)) {
+                ops.push_back(*o);
+            } else {
+                compile(a, bpz, m);
+                bpz++;
+                ops.push_back(vm_operand(vm_operand_kind::Stack, 0));
+            }
+        }
+        return true;
+    }
+
     void compile_global(vm_decl const & decl, unsigned nargs, expr const * args, unsigned bpz, name_map<unsigned> const & m) {
+        if (m_registers && decl.get_arity() >= nargs) {
+            buffer<expr> rev_args;
+            for (unsigned i = nargs; i > 0; i--)
+                rev_args.push_back(args[i - 1]);
+            buffer<vm_operand> ops;
+            if (compile_operands(rev_args, bpz, m, ops)) {
+                if (decl.get_arity() == nargs)
+                    emit(mk_rinvoke_instr(decl.get_idx(), ops.size(), ops.data()));
+                else
+                    emit(mk_rclosure_instr(decl.get_idx(), ops.size(), ops.data()));
+                return;
+            }
+        }
         compile_rev_args(nargs, args, bpz, m);
         if (decl.get_arity() <= nargs) {
             if (decl.is_builtin())
@@ -183,11 +250,193 @@ class vm_compiler_fn {
         }
     }
 
+    /* Return n > 0 if the constant \c fn is a decision procedure for equality of values of type nat, char, unsigned
+       or (fin k) with n arguments, where the last two arguments are the values being compared. Return 0 otherwise.
+       In the VM, all these types are represented by natural numbers. */
+    unsigned get_nat_eq_arity(name const & fn) {
+        if (unsigned const * r = m_nat_eq_arity.find(fn))
+            return *r;
+        unsigned r = 0;
+        if (optional<declaration> d = m_env.find(fn)) {
+            type_context ctx(m_env, transparency_mode::All);
+            type_context::tmp_locals locals(ctx);
+            expr type = ctx.whnf(d->get_type());
+            while (is_pi(type)) {
+                expr l = locals.push_local_from_binding(type);
+                type   = ctx.whnf(instantiate(binding_body(type), l));
+            }
+            buffer<expr> const & ls = locals.as_buffer();
+            if (ls.size() >= 2 && is_app_of(type, get_decidable_name(), 1) && is_eq(app_arg(type)) &&
+                app_arg(app_fn(app_arg(type))) == ls[ls.size() - 2] && app_arg(app_arg(type)) == ls[ls.size() - 1]) {
+                expr A = ctx.whnf(app_arg(app_fn(app_fn(app_arg(type)))));
+                if (is_constant(A, get_nat_name()) || is_app_of(A, get_fin_name(), 1))
+                    r = ls.size();
+            }
+        }
+        m_nat_eq_arity.insert(fn, r);
+        return r;
+    }
+
+    static optional<unsigned> to_switch_value(expr const & e) {
+        if (is_constant(e, get_nat_zero_name()))
+            return optional<unsigned>(0);
+        if (is_nat_value(e) && get_nat_value_value(e) < LEAN_MAX_SMALL_NAT)
+            return optional<unsigned>(get_nat_value_value(e).get_unsigned_int());
+        return optional<unsigned>();
+    }
+
+    /* Return true if \c e is of the form (_cases.2 (eq x v) else_case then_case) where \c eq is a decision
+       procedure for equality of natural numbers, \c x is a local and \c v is a small numeral. */
+    bool is_value_test(expr const & e, expr & x, unsigned & v, expr & then_case, expr & else_case) {
+        buffer<expr> args;
+        expr const & fn = get_app_args(e, args);
+        optional<unsigned> num = is_internal_cases(fn);
+        if (!num || *num != 2 || args.size() != 3 || is_lambda(args[1]) || is_lambda(args[2]))
+            return false;
+        buffer<expr> eq_args;
+        expr const & eq_fn = get_app_args(args[0], eq_args);
+        if (!is_constant(eq_fn) || eq_args.size() < 2 || get_nat_eq_arity(const_name(eq_fn)) != eq_args.size())
+            return false;
+        expr const & a = eq_args[eq_args.size() - 2];
+        expr const & b = eq_args[eq_args.size() - 1];
+        optional<unsigned> val;
+        if (is_local(a) && (val = to_switch_value(b))) {
+            x = a;
+        } else if (is_local(b) && (val = to_switch_value(a))) {
+            x = b;
+        } else {
+            return false;
+        }
+        v         = *val;
+        else_case = args[1];
+        then_case = args[2];
+        return true;
+    }
+
+    struct value_case {
+        unsigned m_value;
+        expr     m_rhs;
+        value_case(unsigned v, expr const & rhs):m_value(v), m_rhs(rhs) {}
+    };
+
+    /* A pc that must be set to the code of the case \c m_case, where \c m_case == number of cases
+       denotes the default case. */
+    struct value_switch_fixup {
+        unsigned m_pos;
+        unsigned m_pc_idx;
+        unsigned m_case;
+        value_switch_fixup(unsigned pos, unsigned pc_idx, unsigned c):m_pos(pos), m_pc_idx(pc_idx), m_case(c) {}
+    };
+
+    void compile_value_test(name const & fn, expr const & x, unsigned v, unsigned bpz, name_map<unsigned> const & m) {
+        compile(mk_app(mk_constant(fn), x, mk_nat_value(mpz(v))), bpz, m);
+    }
+
+    /* Emit a balanced binary decision tree for the sorted cases [begin, end).
+       Small groups of cases are tested sequentially, and dense groups use a jump table. */
+    void compile_decision_tree(expr const & x, buffer<value_case> const & cases, unsigned begin, unsigned end,
+                               unsigned bpz, name_map<unsigned> const & m, buffer<value_switch_fixup> & fixups) {
+        unsigned num     = end - begin;
+        unsigned dflt    = cases.size();
+        unsigned lower   = cases[begin].m_value;
+        unsigned range   = cases[end - 1].m_value - lower + 1;
+        if (num <= LEAN_VALUE_SWITCH_LINEAR_CASES) {
+            for (unsigned i = begin; i < end; i++) {
+                compile_value_test(get_nat_decidable_eq_name(), x, cases[i].m_value, bpz, m);
+                unsigned pos = next_pc();
+                emit(mk_cases2_instr(pos + 1, 0));
+                fixups.emplace_back(pos, 1, i);
+                if (i + 1 == end)
+                    fixups.emplace_back(pos, 0, dflt);
+            }
+        } else if (range <= 2 * num) {
+            /* jump table, the last pc is used for the default case */
+            compile(x, bpz, m);
+            unsigned pos = next_pc();
+            buffer<unsigned> pcs;
+            pcs.resize(range + 1, 0);
+            emit(mk_nat_jump_table_instr(lower, pcs.size(), pcs.data()));
+            unsigned j = begin;
+            for (unsigned i = 0; i < range; i++) {
+                if (j < end && cases[j].m_value == lower + i) {
+                    fixups.emplace_back(pos, i, j);
+                    j++;
+                } else {
+                    fixups.emplace_back(pos, i, dflt);
+                }
+            }
+            fixups.emplace_back(pos, range, dflt);
+        } else {
+            unsigned mid = begin + num / 2;
+            compile_value_test(get_nat_decidable_lt_name(), x, cases[mid].m_value, bpz, m);
+            unsigned pos = next_pc();
+            emit(mk_cases2_instr(0, 0));
+            m_code[pos].set_pc(0, next_pc());
+            compile_decision_tree(x, cases, mid, end, bpz, m, fixups);
+            m_code[pos].set_pc(1, next_pc());
+            compile_decision_tree(x, cases, begin, mid, bpz, m, fixups);
+        }
+    }
+
+    /* Matching on numerals, characters and unsigned values produces nested tests of the form
+
+           _cases.2 (eq x v_1) (_cases.2 (eq x v_2) ... else_case ... rhs_2) rhs_1
+
+       The VM would execute them as a linear chain of comparisons. If there are at least LEAN_VALUE_SWITCH_MIN_CASES
+       tests, we compile them into a balanced binary decision tree, and dense groups of values into jump tables.
+       The code for each right-hand-side and the default case is emitted only once. */
+    bool compile_value_switch(expr const & e, unsigned bpz, name_map<unsigned> const & m) {
+        if (!m_value_switch)
+            return false;
+        expr x, then_case, else_case;
+        unsigned v;
+        if (!is_value_test(e, x, v, then_case, else_case))
+            return false;
+        buffer<value_case> cases;
+        expr dflt = e;
+        expr y;
+        while (is_value_test(dflt, y, v, then_case, else_case) && y == x) {
+            /* If v has already been tested, then then_case is unreachable */
+            auto it = std::find_if(cases.begin(), cases.end(), [&](value_case const & c) { return c.m_value == v; });
+            if (it == cases.end())
+                cases.emplace_back(v, then_case);
+            dflt = else_case;
+        }
+        if (cases.size() < LEAN_VALUE_SWITCH_MIN_CASES)
+            return false;
+        std::sort(cases.begin(), cases.end(), [](value_case const & c1, value_case const & c2) {
+                return c1.m_value < c2.m_value;
+            });
+        buffer<value_switch_fixup> fixups;
+        compile_decision_tree(x, cases, 0, cases.size(), bpz, m, fixups);
+        buffer<unsigned> case_pcs;
+        buffer<unsigned> goto_pcs;
+        for (value_case const & c : cases) {
+            case_pcs.push_back(next_pc());
+            compile(c.m_rhs, bpz, m);
+            goto_pcs.push_back(next_pc());
+            emit(mk_goto_instr(0)); // fix later
+        }
+        case_pcs.push_back(next_pc());
+        compile(dflt, bpz, m);
+        unsigned end_pc = next_pc();
+        for (value_switch_fixup const & f : fixups)
+            m_code[f.m_pos].set_pc(f.m_pc_idx, case_pcs[f.m_case]);
+        for (unsigned pc : goto_pcs)
+            m_code[pc].set_goto_pc(end_pc);
+        return true;
+    }
+
     void compile_cnstr(expr const & e, unsigned bpz, name_map<unsigned> const & m) {
         buffer<expr> args;
         expr const & fn = get_app_args(e, args);
         lean_assert(is_internal_cnstr(fn));
         unsigned cidx = *is_internal_cnstr(fn);
+        buffer<vm_operand> ops;
+        if (compile_operands(args, bpz, m, ops)) {
+            emit(mk_rconstructor_instr(cidx, ops.size(), ops.data()));
+            return;
+        }
         compile_args(args.size(), args.data(), bpz, m);
         emit(mk_constructor_instr(cidx, get_app_num_args(e)));
     }
@@ -240,7 +489,8 @@ class vm_compiler_fn {
     void compile_app(expr const & e, unsigned bpz, name_map<unsigned> const & m) {
         expr const & fn = get_app_fn(e);
         if (is_vm_supported_cases(m_env, fn)) {
-            compile_cases_on(e, bpz, m);
+            if (!compile_value_switch(e, bpz, m))
+                compile_cases_on(e, bpz, m);
         } else if (is_internal_cnstr(fn)) {
             compile_cnstr(e, bpz, m);
         } else if (is_internal_proj(fn)) {
@@ -324,8 +574,8 @@ class vm_compiler_fn {
     }
 
 public:
-    vm_compiler_fn(environment const & env, buffer<vm_instr> & code):
-        m_env(env), m_code(code) {}
+    vm_compiler_fn(environment const & env, buffer<vm_instr> & code, bool value_switch, bool registers):
+        m_env(env), m_code(code), m_value_switch(value_switch), m_registers(registers) {}
 
     pair<unsigned, list<vm_local_info>> operator()(expr e) {
         buffer<expr> locals;
@@ -370,7 +620,35 @@ buffer<name> extern_names(environment const & env, buffer<procedure> const & pro
     return extern_ns;
 }
 
-static environment vm_compile(environment const & env, buffer<procedure> const & procs) {
+#ifndef LEAN_DEFAULT_COMPILER_SUPERINSTRUCTIONS
+#define LEAN_DEFAULT_COMPILER_SUPERINSTRUCTIONS true
+#endif
+
+#ifndef LEAN_DEFAULT_COMPILER_VALUE_SWITCH
+#define LEAN_DEFAULT_COMPILER_VALUE_SWITCH true
+#endif
+
+#ifndef LEAN_DEFAULT_COMPILER_REGISTER_ENCODING
+#define LEAN_DEFAULT_COMPILER_REGISTER_ENCODING true
+#endif
+
+static name * g_compiler_superinstructions = nullptr;
+static name * g_compiler_value_switch      = nullptr;
+static name * g_compiler_register_encoding = nullptr;
+
+static bool get_compiler_superinstructions(options const & opts) {
+    return opts.get_bool(*g_compiler_superinstructions, LEAN_DEFAULT_COMPILER_SUPERINSTRUCTIONS);
+}
+
+static bool get_compiler_value_switch(options const & opts) {
+    return opts.get_bool(*g_compiler_value_switch, LEAN_DEFAULT_COMPILER_VALUE_SWITCH);
+}
+
+static bool get_compiler_register_encoding(options const & opts) {
+    return opts.get_bool(*g_compiler_register_encoding, LEAN_DEFAULT_COMPILER_REGISTER_ENCODING);
+}
+
+static environment vm_compile(environment const & env, options const & opts, buffer<procedure> const & procs) {
     environment new_env = env;
     for (auto const & p : procs) {
         new_env = reserve_vm_index(new_env, p.m_name, p.m_code);
@@ -384,13 +662,15 @@ static environment vm_compile(environment const & env, buffer<procedure> const &
 
     for (auto const & p : procs) {
         buffer<vm_instr> code;
-        vm_compiler_fn gen(new_env, code);
+        vm_compiler_fn gen(new_env, code, get_compiler_value_switch(opts), get_compiler_register_encoding(opts));
         list<vm_local_info> args_info;
         unsigned arity;
         std::tie(arity, args_info) = gen(p.m_code);
         lean_trace(name({"compiler", "code_gen"}), tout() << " " << p.m_name << " " << arity << "\n";
                    display_vm_code(tout().get_stream(), new_env, code.size(), code.data()););
         optimize(new_env, code);
+        if (get_compiler_superinstructions(opts))
+            fuse_superinstructions(code);
         lean_trace(name({"compiler", "optimize_bytecode"}), tout() << " " << p.m_name << " " << arity << "\n";
                    display_vm_code(tout().get_stream(), new_env, code.size(), code.data()););
         new_env = update_vm_code(new_env, p.m_name, code.size(), code.data(), args_info, p.m_pos);
@@ -398,18 +678,37 @@ static environment vm_compile(environment const & env, buffer<procedure> const &
     return new_env;
 }
 
-environment vm_compile(environment const & env, declaration const & d) {
+environment vm_compile(environment const & env, options const & opts, declaration const & d) {
     if (!d.is_definition()) return env;
     buffer<procedure> procs;
     preprocess(env, d, procs);
-    return vm_compile(env, procs);
+    return vm_compile(env, opts, procs);
+}
+
+environment vm_compile(environment const & env, declaration const & d) {
+    return vm_compile(env, options(), d);
 }
 
 void initialize_vm_compiler() {
     register_trace_class({"compiler", "optimize_bytecode"});
     register_trace_class({"compiler", "code_gen"});
+    g_compiler_superinstructions = new name{"compiler", "superinstructions"};
+    register_bool_option(*g_compiler_superinstructions, LEAN_DEFAULT_COMPILER_SUPERINSTRUCTIONS,
+                         "(compiler) fuse frequent bytecode instruction sequences into superinstructions");
+    g_compiler_value_switch      = new name{"compiler", "value_switch"};
+    register_bool_option(*g_compiler_value_switch, LEAN_DEFAULT_COMPILER_VALUE_SWITCH,
+                         "(compiler) compile matches on numerals, characters and unsigned values into "
+                         "balanced decision trees and jump tables");
+    g_compiler_register_encoding = new name{"compiler", "register_encoding"};
+    register_bool_option(*g_compiler_register_encoding, LEAN_DEFAULT_COMPILER_REGISTER_ENCODING,
+                         "(compiler) use the register-based encoding for function calls, closures and constructors, "
+                         "where the arguments that are locals or simple values are operands of the instruction "
+                         "instead of being pushed by separate instructions");
 }
 
 void finalize_vm_compiler() {
+    delete g_compiler_superinstructions;
+    delete g_compiler_value_switch;
+    delete g_compiler_register_encoding;
 }
 }
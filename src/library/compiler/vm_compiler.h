@@ -5,10 +5,14 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include "util/sexpr/options.h"
 #include "kernel/environment.h"
 
 namespace lean {
 environment vm_compile(environment const & env, declaration const & d);
+/** \brief Similar to vm_compile(env, d), but the bytecode generator options are retrieved from \c opts.
+    Example: <tt>compiler.superinstructions</tt>. */
+environment vm_compile(environment const & env, options const & opts, declaration const & d);
 void initialize_vm_compiler();
 void finalize_vm_compiler();
 }
@@ -29,6 +29,7 @@ name const * g_cast_heq = nullptr;
 name const * g_char = nullptr;
 name const * g_char_of_nat = nullptr;
 name const * g_char_of_nat_ne_of_ne = nullptr;
+name const * g_char_sz = nullptr;
 name const * g_classical = nullptr;
 name const * g_classical_prop_decidable = nullptr;
 name const * g_classical_type_decidable_eq = nullptr;
@@ -201,6 +202,8 @@ name const * g_nat_has_le = nullptr;
 name const * g_nat_add = nullptr;
 name const * g_nat_no_confusion = nullptr;
 name const * g_nat_cases_on = nullptr;
+name const * g_nat_decidable_eq = nullptr;
+name const * g_nat_decidable_lt = nullptr;
 name const * g_nat_bit0_ne = nullptr;
 name const * g_nat_bit0_ne_bit1 = nullptr;
 name const * g_nat_bit0_ne_zero = nullptr;
@@ -418,6 +421,9 @@ name const * g_unification_constraint_mk = nullptr;
 name const * g_unit = nullptr;
 name const * g_unit_cases_on = nullptr;
 name const * g_unit_star = nullptr;
+name const * g_unsigned = nullptr;
+name const * g_unsigned_of_nat = nullptr;
+name const * g_unsigned_sz = nullptr;
 name const * g_user_attribute = nullptr;
 name const * g_vm_monitor = nullptr;
 name const * g_weak_order = nullptr;
@@ -454,6 +460,7 @@ void initialize_constants() {
     g_char = new name{"char"};
     g_char_of_nat = new name{"char", "of_nat"};
     g_char_of_nat_ne_of_ne = new name{"char", "of_nat_ne_of_ne"};
+    g_char_sz = new name{"char_sz"};
     g_classical = new name{"classical"};
     g_classical_prop_decidable = new name{"classical", "prop_decidable"};
     g_classical_type_decidable_eq = new name{"classical", "type_decidable_eq"};
@@ -626,6 +633,8 @@ void initialize_constants() {
     g_nat_add = new name{"nat", "add"};
     g_nat_no_confusion = new name{"nat", "no_confusion"};
     g_nat_cases_on = new name{"nat", "cases_on"};
+    g_nat_decidable_eq = new name{"nat", "decidable_eq"};
+    g_nat_decidable_lt = new name{"nat", "decidable_lt"};
     g_nat_bit0_ne = new name{"nat", "bit0_ne"};
     g_nat_bit0_ne_bit1 = new name{"nat", "bit0_ne_bit1"};
     g_nat_bit0_ne_zero = new name{"nat", "bit0_ne_zero"};
@@ -843,6 +852,9 @@ void initialize_constants() {
     g_unit = new name{"unit"};
     g_unit_cases_on = new name{"unit", "cases_on"};
     g_unit_star = new name{"unit", "star"};
+    g_unsigned = new name{"unsigned"};
+    g_unsigned_of_nat = new name{"unsigned", "of_nat"};
+    g_unsigned_sz = new name{"unsigned_sz"};
     g_user_attribute = new name{"user_attribute"};
     g_vm_monitor = new name{"vm_monitor"};
     g_weak_order = new name{"weak_order"};
@@ -880,6 +892,7 @@ void finalize_constants() {
     delete g_char;
     delete g_char_of_nat;
     delete g_char_of_nat_ne_of_ne;
+    delete g_char_sz;
     delete g_classical;
     delete g_classical_prop_decidable;
     delete g_classical_type_decidable_eq;
@@ -1052,6 +1065,8 @@ void finalize_constants() {
     delete g_nat_add;
     delete g_nat_no_confusion;
     delete g_nat_cases_on;
+    delete g_nat_decidable_eq;
+    delete g_nat_decidable_lt;
     delete g_nat_bit0_ne;
     delete g_nat_bit0_ne_bit1;
     delete g_nat_bit0_ne_zero;
@@ -1269,6 +1284,9 @@ void finalize_constants() {
     delete g_unit;
     delete g_unit_cases_on;
     delete g_unit_star;
+    delete g_unsigned;
+    delete g_unsigned_of_nat;
+    delete g_unsigned_sz;
     delete g_user_attribute;
     delete g_vm_monitor;
     delete g_weak_order;
@@ -1305,6 +1323,7 @@ name const & get_cast_heq_name() { return *g_cast_heq; }
 name const & get_char_name() { return *g_char; }
 name const & get_char_of_nat_name() { return *g_char_of_nat; }
 name const & get_char_of_nat_ne_of_ne_name() { return *g_char_of_nat_ne_of_ne; }
+name const & get_char_sz_name() { return *g_char_sz; }
 name const & get_classical_name() { return *g_classical; }
 name const & get_classical_prop_decidable_name() { return *g_classical_prop_decidable; }
 name const & get_classical_type_decidable_eq_name() { return *g_classical_type_decidable_eq; }
@@ -1477,6 +1496,8 @@ name const & get_nat_has_le_name() { return *g_nat_has_le; }
 name const & get_nat_add_name() { return *g_nat_add; }
 name const & get_nat_no_confusion_name() { return *g_nat_no_confusion; }
 name const & get_nat_cases_on_name() { return *g_nat_cases_on; }
+name const & get_nat_decidable_eq_name() { return *g_nat_decidable_eq; }
+name const & get_nat_decidable_lt_name() { return *g_nat_decidable_lt; }
 name const & get_nat_bit0_ne_name() { return *g_nat_bit0_ne; }
 name const & get_nat_bit0_ne_bit1_name() { return *g_nat_bit0_ne_bit1; }
 name const & get_nat_bit0_ne_zero_name() { return *g_nat_bit0_ne_zero; }
@@ -1694,6 +1715,9 @@ name const & get_unification_constraint_mk_name() { return *g_unification_constr
 name const & get_unit_name() { return *g_unit; }
 name const & get_unit_cases_on_name() { return *g_unit_cases_on; }
 name const & get_unit_star_name() { return *g_unit_star; }
+name const & get_unsigned_name() { return *g_unsigned; }
+name const & get_unsigned_of_nat_name() { return *g_unsigned_of_nat; }
+name const & get_unsigned_sz_name() { return *g_unsigned_sz; }
 name const & get_user_attribute_name() { return *g_user_attribute; }
 name const & get_vm_monitor_name() { return *g_vm_monitor; }
 name const & get_weak_order_name() { return *g_weak_order; }
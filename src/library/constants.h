@@ -31,6 +31,7 @@ name const & get_cast_heq_name();
 name const & get_char_name();
 name const & get_char_of_nat_name();
 name const & get_char_of_nat_ne_of_ne_name();
+name const & get_char_sz_name();
 name const & get_classical_name();
 name const & get_classical_prop_decidable_name();
 name const & get_classical_type_decidable_eq_name();
@@ -203,6 +204,8 @@ name const & get_nat_has_le_name();
 name const & get_nat_add_name();
 name const & get_nat_no_confusion_name();
 name const & get_nat_cases_on_name();
+name const & get_nat_decidable_eq_name();
+name const & get_nat_decidable_lt_name();
 name const & get_nat_bit0_ne_name();
 name const & get_nat_bit0_ne_bit1_name();
 name const & get_nat_bit0_ne_zero_name();
@@ -420,6 +423,9 @@ name const & get_unification_constraint_mk_name();
 name const & get_unit_name();
 name const & get_unit_cases_on_name();
 name const & get_unit_star_name();
+name const & get_unsigned_name();
+name const & get_unsigned_of_nat_name();
+name const & get_unsigned_sz_name();
 name const & get_user_attribute_name();
 name const & get_vm_monitor_name();
 name const & get_weak_order_name();
@@ -161,12 +161,14 @@ void get_module_doc_strings(environment const & env, buffer<doc_entry> & result)
     std::reverse(result.begin(), result.end());
 }
 
-static void documentation_reader(deserializer & d, environment & env) {
+static module_modification documentation_reader(deserializer & d) {
     name n; std::string doc;
     d >> n >> doc;
-    auto ext = get_extension(env);
-    ext.m_doc_string_map.insert(n, doc);
-    env = update(env, ext);
+    return [=](environment & env) {
+        auto ext = get_extension(env);
+        ext.m_doc_string_map.insert(n, doc);
+        env = update(env, ext);
+    };
 }
 
 void initialize_documentation() {
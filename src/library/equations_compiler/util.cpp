@@ -295,7 +295,7 @@ pair<environment, expr> mk_aux_definition(environment const & env, options const
     if (!header.m_is_lemma && !header.m_is_noncomputable) {
         try {
             declaration d = new_env.get(new_c);
-            new_env = vm_compile(new_env, d);
+            new_env = vm_compile(new_env, opts, d);
         } catch (exception & ex) {
             if (!header.m_prev_errors) {
                 throw nested_exception(sstream() << "equation compiler failed to generate bytecode for "
@@ -218,12 +218,14 @@ list<name> get_ginductive_all_nested_inds(environment const & env) {
     return get_extension(env).get_all_nested_inds();
 }
 
-static void ginductive_reader(deserializer & d, environment & env) {
+static module_modification ginductive_reader(deserializer & d) {
     ginductive_entry entry;
     d >> entry;
-    ginductive_env_ext ext = get_extension(env);
-    ext.register_ginductive_entry(entry);
-    env = update(env, ext);
+    return [=](environment & env) {
+        ginductive_env_ext ext = get_extension(env);
+        ext.register_ginductive_entry(entry);
+        env = update(env, ext);
+    };
 }
 
 void initialize_inductive_compiler_ginductive() {
@@ -26,6 +26,9 @@ serializer & operator<<(serializer & s, expr const & e);
 expr read_expr(deserializer & d);
 inline deserializer & operator>>(deserializer & d, expr & e) { e = read_expr(d); return d; }
 
+serializer & operator<<(serializer & s, reducibility_hints const & h);
+reducibility_hints read_hints(deserializer & d);
+
 serializer & operator<<(serializer & s, declaration const & d);
 declaration read_declaration(deserializer & d);
 
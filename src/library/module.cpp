@@ -5,6 +5,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include <utility>
 #include <string>
@@ -152,15 +153,23 @@ environment add_transient_decl_pos_info(environment const & env, name const & de
     return update(env, ext);
 }
 
-static void pos_info_reader(deserializer & d, environment & env) {
+static module_modification pos_info_reader(deserializer & d) {
     name decl_name;
     unsigned line, column;
     d >> decl_name >> line >> column;
-    env = add_transient_decl_pos_info(env, decl_name, pos_info(line, column));
+    return [=](environment & env) {
+        env = add_transient_decl_pos_info(env, decl_name, pos_info(line, column));
+    };
 }
 
 static char const * g_olean_end_file = "EndFile";
 static char const * g_olean_header   = "oleanfile";
+/* Version of the .olean file format. It must be increased whenever the format changes,
+   so that files produced by older versions are rejected instead of being misread.
+   Version 2: declarations are stored as a header followed by a blob (lazy decoding).
+   Version 3: bytecode may move locals (the move instruction, and move flags in superinstructions).
+   Version 4: bytecode may use the register-based instructions (rinvoke, rclosure and rcnstr). */
+static unsigned const g_olean_version = 4;
 
 serializer & operator<<(serializer & s, module_name const & n) {
     if (n.m_relative)
@@ -195,7 +204,7 @@ public:
     }
 };
 
-void export_module(std::ostream & out, environment const & env) {
+void export_module(std::ostream & out, environment const & env, uint64 src_hash, uint64 trans_hash) {
     module_ext const & ext = get_extension(env);
 
     buffer<module_name> imports;
@@ -220,8 +229,8 @@ void export_module(std::ostream & out, environment const & env) {
     serializer s2(out);
     std::string r = out1.str();
     unsigned h    = hash(r.size(), [&](unsigned i) { return r[i]; });
-    s2 << g_olean_header << LEAN_VERSION_MAJOR << LEAN_VERSION_MINOR << LEAN_VERSION_PATCH;
-    s2 << h;
+    s2 << g_olean_header << g_olean_version << LEAN_VERSION_MAJOR << LEAN_VERSION_MINOR << LEAN_VERSION_PATCH;
+    s2 << h << src_hash << trans_hash;
     // store imported files
     s2 << imports.size();
     for (auto m : imports)
@@ -295,7 +304,22 @@ static environment export_decl(environment const & env, declaration const & d) {
                 s << true << theorem2axiom(d) << static_cast<unsigned>(g_export_delayed_proofs->size());
                 g_export_delayed_proofs->push_back(d.get_value_task());
             } else {
-                s << false << d;
+                /* We store the header of the declaration separately, so that the importer can
+                   postpone decoding its type and value until they are needed (see import_decl). */
+                char k = 0;
+                if (d.is_definition())
+                    k |= 1;
+                if (d.is_theorem() || d.is_axiom())
+                    k |= 2;
+                if (d.is_trusted())
+                    k |= 4;
+                s << false << k << d.get_name() << d.get_univ_params();
+                if (d.is_definition() && !d.is_theorem())
+                    s << d.get_hints();
+                std::ostringstream body(std::ios_base::binary);
+                serializer s1(body);
+                s1 << d;
+                s.write_blob(body.str());
             }
         });
 }
@@ -303,7 +327,9 @@ static environment export_decl(environment const & env, declaration const & d) {
 environment add(environment const & env, certified_declaration const & d) {
     environment new_env = env.add(d);
     declaration _d = d.get_declaration();
-    if (!check_computable(new_env, _d.get_name()))
+    /* We do not wait for values computed by tasks here, the caller is responsible for
+       checking whether they are computable. */
+    if ((_d.is_theorem() || !_d.has_value_task()) && !check_computable(new_env, _d.get_name()))
         new_env = mark_noncomputable(new_env, _d.get_name());
     new_env = export_decl(update_module_defs(new_env, _d), _d);
     return add_decl_pos_info(new_env, _d.get_name());
@@ -319,8 +345,10 @@ environment declare_quotient(environment const & env) {
     return add(new_env, *g_quotient, [=](environment const &, serializer &) {});
 }
 
-static void quotient_reader(deserializer &, environment & env) {
-    env = ::lean::declare_quotient(env);
+static module_modification quotient_reader(deserializer &) {
+    return [](environment & env) {
+        env = ::lean::declare_quotient(env);
+    };
 }
 
 using inductive::certified_inductive_decl;
@@ -341,39 +369,43 @@ environment add_inductive(environment                       env,
 }
 } // end of namespace module
 
-std::pair<std::vector<module_name>, std::vector<char>> parse_olean(std::istream & in, std::string const & file_name, bool check_hash) {
+olean_data parse_olean(char const * contents, size_t size, std::string const & file_name, bool check_hash) {
     unsigned major, minor, patch, claimed_hash;
-    unsigned code_size;
-    std::vector<module_name> imports;
-    std::vector<char> code;
+    olean_data r;
 
-    deserializer d1(in, optional<std::string>(file_name));
+    deserializer d1(contents, contents + size, optional<std::string>(file_name));
     std::string header;
     d1 >> header;
     if (header != g_olean_header)
         throw exception(sstream() << "file '" << file_name << "' does not seem to be a valid object Lean file, invalid header");
+    unsigned version = d1.read_unsigned();
+    if (version != g_olean_version)
+        throw exception(sstream() << "file '" << file_name << "' was created using an incompatible version of Lean, "
+                        << "it must be recompiled");
     d1 >> major >> minor >> patch >> claimed_hash;
+    r.m_src_hash   = d1.read_uint64();
+    r.m_trans_hash = d1.read_uint64();
     // Enforce version?
 
     unsigned num_imports  = d1.read_unsigned();
     for (unsigned i = 0; i < num_imports; i++) {
-        module_name r;
-        d1 >> r;
-        imports.push_back(r);
+        module_name m;
+        d1 >> m;
+        r.m_imports.push_back(m);
     }
 
-    code_size = d1.read_unsigned();
-    code.resize(code_size);
-    d1.read(code);
+    r.m_code_size = d1.read_unsigned();
+    r.m_code      = d1.read_view(r.m_code_size);
 
 //    if (m_senv.env().trust_lvl() <= LEAN_BELIEVER_TRUST_LEVEL) {
     if (check_hash) {
-        unsigned computed_hash = hash(code_size, [&](unsigned i) { return code[i]; });
+        char const * code = r.m_code;
+        unsigned computed_hash = hash(r.m_code_size, [&](unsigned i) { return code[i]; });
         if (claimed_hash != computed_hash)
             throw exception(sstream() << "file '" << file_name << "' has been corrupted, checksum mismatch");
     }
 
-    return { imports, code };
+    return r;
 }
 
 struct import_helper {
@@ -385,93 +417,178 @@ struct import_helper {
     }
 };
 
-static void import_module(environment & env, std::string const & module_file_name, module_name const & ref,
-                          module_loader const & mod_ldr) {
-    auto res = mod_ldr(module_file_name, ref);
-    if (get_extension(env).m_imported.contains(res.m_module_name)) return;
-    std::istringstream in(res.m_obj_code, std::ios_base::binary);
-    auto olean = parse_olean(in, res.m_module_name, false);
-    for (auto & dep : olean.first) {
-        import_module(env, res.m_module_name, dep, mod_ldr);
+static declaration read_lazy_declaration(deserializer & d, std::string const & file_name, mapped_file_ref const & owner,
+                                         std::shared_ptr<mutex> const & decoder_mutex) {
+    char k               = d.read_char();
+    bool has_value       = (k & 1) != 0;
+    bool is_th_ax        = (k & 2) != 0;
+    bool is_trusted      = (k & 4) != 0;
+    name n               = read_name(d);
+    level_param_names ps = read_level_params(d);
+    reducibility_hints hints = reducibility_hints::mk_opaque();
+    if (has_value && !is_th_ax)
+        hints = read_hints(d);
+    unsigned sz          = d.read_unsigned();
+    char const * body    = d.read_view(sz);
+    if (!owner) {
+        deserializer d1(body, body + sz, optional<std::string>(file_name));
+        return read_declaration(d1);
     }
-    auto ext = get_extension(env);
-    ext.m_imported.insert(res.m_module_name);
-    env = update(env, ext);
-    import_module(olean.second, res.m_module_name, env, res.m_delayed_proofs);
+    /* owner is captured to keep body alive */
+    return mk_lazy_declaration(n, ps, has_value, is_th_ax, hints, is_trusted, [owner, body, sz, file_name]() {
+            deserializer d1(body, body + sz, optional<std::string>(file_name));
+            return read_declaration(d1);
+        }, decoder_mutex);
 }
 
-environment import_module(environment const & env0, std::string const & module_file_name,
-                          module_name const & ref,
-                          module_loader const & mod_ldr) {
-    environment env = env0;
-    module_ext ext = get_extension(env);
-    ext.m_direct_imports = cons(ref, ext.m_direct_imports);
-    env = update(env, ext);
-    import_module(env, module_file_name, ref, mod_ldr);
-    return env;
-}
-
-static optional<name> import_decl(deserializer & d, environment & env,
-                                  std::vector<task_result<expr>> const & delayed_proofs) {
+static module_modification import_decl(deserializer & d, std::string const & file_name, mapped_file_ref const & owner,
+                                       std::shared_ptr<mutex> const & decoder_mutex,
+                                       std::vector<task_result<expr>> const & delayed_proofs) {
     bool is_delayed; d >> is_delayed;
-    declaration decl = read_declaration(d);
-    decl = unfold_untrusted_macros(env, decl);
-    if (decl.get_name() == get_sorry_name() && has_sorry(env)) {
-        // TODO(gabriel): not sure why this is here
-        return optional<name>();
-    }
+    declaration decl;
     if (is_delayed) {
+        decl = read_declaration(d);
         unsigned i; d >> i;
         auto delayed_proof = delayed_proofs.at(i);
         decl = mk_theorem(decl.get_name(), decl.get_univ_params(), decl.get_type(), delayed_proof);
+    } else {
+        decl = read_lazy_declaration(d, file_name, owner, decoder_mutex);
     }
-    env = import_helper::add_unchecked(env, decl);
-    return optional<name>(decl.get_name());
+    return [=](environment & env) {
+        if (decl.get_name() == get_sorry_name() && has_sorry(env)) {
+            // TODO(gabriel): not sure why this is here
+            return;
+        }
+        env = import_helper::add_unchecked(env, unfold_untrusted_macros(env, decl));
+        env = add_decl_olean(env, decl.get_name(), file_name);
+    };
 }
 
-static void import_universe(deserializer & d, environment & env) {
+static module_modification import_universe(deserializer & d) {
     name const l = read_name(d);
-    env = env.add_universe(l);
+    return [=](environment & env) {
+        env = env.add_universe(l);
+    };
 }
 
-void import_module(std::vector<char> const & olean_code, std::string const & file_name, environment & env,
-                   std::vector<task_result<expr>> const & delayed_proofs) {
-    // TODO(gabriel): update extension
-    std::string s(olean_code.data(), olean_code.size());
-    std::istringstream in(s, std::ios_base::binary);
-    deserializer d(in, optional<std::string>(file_name));
-    unsigned obj_counter = 0;
+static module_modification import_inductive(deserializer & d, std::string const & file_name) {
+    inductive::certified_inductive_decl cdecl = read_certified_inductive_decl(d);
+    return [=](environment & env) {
+        env = cdecl.add(env);
+        env = add_decl_olean(env, cdecl.get_decl().m_name, file_name);
+    };
+}
+
+/* Decode the object code of a module. The result does not depend on the environment,
+   so object code of different modules can be decoded concurrently.
+   If \c owner is not null, then it contains the object code, and the types and values
+   of declarations are only decoded when they are used. */
+static std::vector<module_modification> decode_olean(char const * olean_code, size_t olean_code_size,
+                                                     std::string const & file_name, mapped_file_ref const & owner,
+                                                     std::vector<task_result<expr>> const & delayed_proofs) {
+    deserializer d(olean_code, olean_code + olean_code_size, optional<std::string>(file_name));
+    std::vector<module_modification> mods;
+    /* Declarations of different modules can be materialized concurrently */
+    auto decoder_mutex = std::make_shared<mutex>();
     while (true) {
         std::string k;
         d >> k;
         if (k == g_olean_end_file) {
             break;
         } else if (k == *g_decl_key) {
-            if (auto decl_name = import_decl(d, env, delayed_proofs))
-                env = add_decl_olean(env, *decl_name, file_name);
+            mods.push_back(import_decl(d, file_name, owner, decoder_mutex, delayed_proofs));
         } else if (k == *g_glvl_key) {
-            import_universe(d, env);
+            mods.push_back(import_universe(d));
         } else if (k == *g_inductive) {
-            inductive::certified_inductive_decl cdecl = read_certified_inductive_decl(d);
-            env = cdecl.add(env);
-            env = add_decl_olean(env, cdecl.get_decl().m_name, file_name);
+            mods.push_back(import_inductive(d, file_name));
         } else {
             object_readers & readers = get_object_readers();
             auto it = readers.find(k);
             if (it == readers.end())
                 throw exception(sstream() << "file '" << file_name << "' has been corrupted, unknown object: " << k);
-            it->second(d, env);
+            mods.push_back(it->second(d));
         }
-        obj_counter++;
     }
+    return mods;
+}
+
+static void apply_modifications(std::vector<module_modification> const & mods, environment & env) {
+    for (auto const & mod : mods)
+        mod(env);
+}
+
+void import_module(char const * olean_code, size_t olean_code_size, std::string const & file_name, environment & env,
+                   std::vector<task_result<expr>> const & delayed_proofs) {
+    // TODO(gabriel): update extension
+    apply_modifications(decode_olean(olean_code, olean_code_size, file_name, mapped_file_ref(), delayed_proofs), env);
+}
+
+class decode_olean_task : public task<std::vector<module_modification>> {
+    mapped_file_ref                m_contents; // keeps m_olean_code alive
+    char const *                   m_olean_code;
+    size_t                         m_olean_code_size;
+    std::string                    m_file_name;
+    std::vector<task_result<expr>> m_delayed_proofs;
+
+public:
+    decode_olean_task(mapped_file_ref const & contents, char const * olean_code, size_t olean_code_size,
+                      std::string const & file_name, std::vector<task_result<expr>> const & delayed_proofs) :
+        m_contents(contents), m_olean_code(olean_code), m_olean_code_size(olean_code_size),
+        m_file_name(file_name), m_delayed_proofs(delayed_proofs) {}
+
+    void description(std::ostream & out) const override {
+        out << "decoding " << m_file_name;
+    }
+
+    std::vector<module_modification> execute() override {
+        return decode_olean(m_olean_code, m_olean_code_size, m_file_name, m_contents, m_delayed_proofs);
+    }
+};
+
+typedef std::pair<std::string, task_result<std::vector<module_modification>>> decoded_module;
+
+/* Load the modules transitively imported by \c ref that have not been imported in \c env yet.
+   The decoding of each module is submitted to the global task queue as soon as the module is loaded.
+   The modules are stored in \c result in topological order, i.e., every module comes after its imports. */
+static void load_imports(environment const & env, std::string const & module_file_name, module_name const & ref,
+                         module_loader const & mod_ldr, std::unordered_set<std::string> & visited,
+                         std::vector<decoded_module> & result) {
+    auto res = mod_ldr(module_file_name, ref);
+    if (get_extension(env).m_imported.contains(res.m_module_name)) return;
+    if (!visited.insert(res.m_module_name).second) return;
+    auto olean = parse_olean(res.m_obj_code->data(), res.m_obj_code->size(), res.m_module_name, false);
+    auto decoded = get_global_task_queue().submit<decode_olean_task>(res.m_obj_code, olean.m_code, olean.m_code_size,
+                                                                     res.m_module_name, res.m_delayed_proofs);
+    for (auto & dep : olean.m_imports) {
+        load_imports(env, res.m_module_name, dep, mod_ldr, visited, result);
+    }
+    result.emplace_back(res.m_module_name, decoded);
+}
+
+environment import_module(environment const & env0, std::string const & module_file_name,
+                          module_name const & ref,
+                          module_loader const & mod_ldr) {
+    environment env = env0;
+    module_ext ext = get_extension(env);
+    ext.m_direct_imports = cons(ref, ext.m_direct_imports);
+    env = update(env, ext);
+    std::unordered_set<std::string> visited;
+    std::vector<decoded_module> modules;
+    load_imports(env, module_file_name, ref, mod_ldr, visited, modules);
+    for (auto & mod : modules) {
+        auto ext = get_extension(env);
+        ext.m_imported.insert(mod.first);
+        env = update(env, ext);
+        apply_modifications(mod.second.get(), env);
+    }
+    return env;
 }
 
 module_loader mk_olean_loader() {
     return[=] (std::string const & module_fn, module_name const & ref) {
         auto base_dir = dirname(module_fn.c_str());
         auto fn = find_file(base_dir, ref.m_relative, ref.m_name, ".olean");
-        auto contents = read_file(fn, std::ios_base::binary);
-        return loaded_module { fn, contents, {} };
+        return loaded_module { fn, map_file(fn), {} };
     };
 }
 
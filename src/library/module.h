@@ -9,8 +9,10 @@ Author: Leonardo de Moura
 #include <iostream>
 #include <utility>
 #include <vector>
+#include <functional>
 #include "util/serializer.h"
 #include "util/optional.h"
+#include "util/mapped_file.h"
 #include "kernel/pos_info_provider.h"
 #include "kernel/inductive/inductive.h"
 #include "library/io_state.h"
@@ -29,7 +31,7 @@ struct module_name {
 
 struct loaded_module {
     std::string m_module_name;
-    std::string m_obj_code;
+    mapped_file_ref m_obj_code;
     std::vector<task_result<expr>> m_delayed_proofs;
 };
 using module_loader = std::function<loaded_module(std::string const &, module_name const &)>;
@@ -47,6 +49,9 @@ list<module_name> get_curr_module_imports(environment const & env);
     Modules included directly or indirectly by them are also imported.
     The environment \c env is usually an empty environment.
 
+    The .olean files of the imported modules are decoded in parallel using the global task queue,
+    and then added to the environment in dependency order.
+
     If \c keep_proofs is false, then the proof of the imported theorems is discarded after being
     checked. The idea is to save memory.
 */
@@ -66,20 +71,41 @@ optional<pos_info> get_decl_pos_info(environment const & env, name const & decl_
     .olean files. We use this function for attaching position information to temporary functions. */
 environment add_transient_decl_pos_info(environment const & env, name const & decl_name, pos_info const & pos);
 
-/** \brief Store/Export module using \c env to the output stream \c out. */
-void export_module(std::ostream & out, environment const & env);
+/** \brief Store/Export module using \c env to the output stream \c out.
+    \c src_hash and \c trans_hash are stored in the header, they are used to decide whether the
+    .olean file is still valid (see module_mgr). */
+void export_module(std::ostream & out, environment const & env, uint64 src_hash = 0, uint64 trans_hash = 0);
 std::vector<task_result<expr>> export_module_delayed(std::ostream & out, environment const & env);
 
-std::pair<std::vector<module_name>, std::vector<char>> parse_olean(
-        std::istream & in, std::string const & file_name, bool check_hash = true);
-void import_module(std::vector<char> const & olean_code, std::string const & file_name, environment & env,
+/** \brief Header of an .olean file. The object code is not copied, \c m_code points into
+    the buffer the header was parsed from. */
+struct olean_data {
+    /* hash of the source text */
+    uint64                   m_src_hash;
+    /* hash of the source text, the Lean version, and the hashes of the imported modules */
+    uint64                   m_trans_hash;
+    std::vector<module_name> m_imports;
+    char const *             m_code;
+    size_t                   m_code_size;
+};
+olean_data parse_olean(char const * contents, size_t size, std::string const & file_name, bool check_hash = true);
+inline olean_data parse_olean(mapped_file const & contents, bool check_hash = true) {
+    return parse_olean(contents.data(), contents.size(), contents.get_fname(), check_hash);
+}
+void import_module(char const * olean_code, size_t olean_code_size, std::string const & file_name, environment & env,
                    std::vector<task_result<expr>> const & delayed_proofs);
 
+/** \brief Update to the environment being constructed produced by decoding an object stored in a .olean file. */
+typedef std::function<void(environment &)> module_modification;
+
 /** \brief A reader for importing data from a stream using deserializer \c d.
-    There is one way to update the environment being constructed.
-     1- Direct update it using \c env.
+    The reader must only decode the object, it must not depend on the environment being constructed.
+    The environment is updated by the returned modification. The modifications of a module are applied
+    in the same order the objects were exported.
+
+    \remark Readers of different modules are executed in parallel on the global task queue.
 */
-typedef void (*module_object_reader)(deserializer & d, environment & env);
+typedef module_modification (*module_object_reader)(deserializer & d);
 
 /** \brief Register a module object reader. The key \c k is used to identify the class of objects
     that can be read by the given reader.
@@ -98,7 +124,9 @@ environment add(environment const & env, std::string const & k, std::function<vo
 /** \brief Add the global universe declaration to the environment, and mark it to be exported. */
 environment add_universe(environment const & env, name const & l);
 
-/** \brief Add the given declaration to the environment, and mark it to be exported. */
+/** \brief Add the given declaration to the environment, and mark it to be exported.
+    \remark If \c d is a definition whose value is computed by a task, then it is not
+    marked as noncomputable (see check_computable), since that would wait for the task. */
 environment add(environment const & env, certified_declaration const & d);
 
 /** \brief Return true iff \c n is a definition added to the current module using #module::add */
@@ -8,6 +8,10 @@ Author: Gabriel Ebner
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include "util/hash.h"
 #include "util/lean_path.h"
 #include "util/file_lock.h"
 #include "library/module_mgr.h"
@@ -15,8 +19,45 @@ Author: Gabriel Ebner
 #include "library/versioned_msg_buf.h"
 #include "frontends/lean/pp.h"
 #include "frontends/lean/parser.h"
+#include "version.h"
 
 namespace lean {
+/** \brief Hash of the source text of a module. The result is used as a key in the .olean cache,
+    so we combine two 32-bit hashes computed using different seeds. */
+static uint64 hash_module_source(std::string const & contents) {
+    unsigned len = contents.size();
+    uint64 h1    = hash_str(len, contents.data(), 11);
+    uint64 h2    = hash_str(len, contents.data(), 31);
+    return (h1 << 32) | h2;
+}
+
+/** \brief Initial value for module_info::m_trans_hash, the hashes of the imported modules are
+    mixed into it. The Lean version is included since the .olean format may change between versions. */
+static uint64 hash_module(uint64 src_hash) {
+    uint64 version = (static_cast<uint64>(LEAN_VERSION_MAJOR) << 32) +
+        (static_cast<uint64>(LEAN_VERSION_MINOR) << 16) + static_cast<uint64>(LEAN_VERSION_PATCH);
+    return hash(src_hash, version);
+}
+
+static std::string get_cache_file_name(std::string const & cache_dir, uint64 trans_hash) {
+    std::ostringstream out;
+    out << std::hex << std::setfill('0') << std::setw(16) << trans_hash << ".olean";
+    return path_append(cache_dir.c_str(), out.str().c_str());
+}
+
+/** \brief Replace the contents of \c fn with \c contents.
+    .olean files are mapped into memory when imported, so we must not overwrite them in place. */
+static void write_olean(std::string const & fn, std::string const & contents) {
+    exclusive_file_lock output_lock(fn);
+    auto tmp_fn = fn + ".tmp";
+    {
+        std::ofstream out(tmp_fn, std::ios_base::binary);
+        out.write(contents.data(), contents.size());
+        if (!out) throw exception(sstream() << "failed to write '" << tmp_fn << "'");
+    }
+    if (!rename_file(tmp_fn, fn))
+        throw exception(sstream() << "failed to write '" << fn << "'");
+}
 
 void module_mgr::mark_out_of_date(module_id const & id) {
     for (auto & mod : m_modules) {
@@ -91,7 +132,7 @@ public:
             std::ostringstream obj_code_buf(std::ios_base::binary);
             mod.m_obj_code_delayed_proofs =
                     export_module_delayed(obj_code_buf, p.env());
-            mod.m_obj_code = obj_code_buf.str();
+            mod.m_obj_code = mk_mapped_file(get_module_id(), obj_code_buf.str());
         }
 
         mod.m_env = optional<environment>(p.env());
@@ -106,17 +147,22 @@ public:
 
 class olean_compilation_task : public task<unit> {
     std::shared_ptr<module_info const> m_mod;
+    optional<std::string> m_cache_dir;
 
 public:
-    olean_compilation_task(std::shared_ptr<module_info const> const & mod) : m_mod(mod) {}
+    olean_compilation_task(std::shared_ptr<module_info const> const & mod, optional<std::string> const & cache_dir) :
+        m_mod(mod), m_cache_dir(cache_dir) {}
     task_kind get_kind() const override { return task_kind::parse; }
 
     std::vector<generic_task_result> get_dependencies() override {
         if (auto res = m_mod->m_result.peek()) {
             std::vector<generic_task_result> deps;
-            res->m_env->for_each_declaration([&] (declaration const & d) {
-                if (d.is_theorem()) deps.push_back(d.get_value_task());
-            });
+            /* Only declarations of the current module are exported. We do not visit imported declarations,
+               since retrieving their proofs would force their decoding. */
+            for (name const & n : get_curr_module_decl_names(*res->m_env)) {
+                declaration const & d = res->m_env->get(n);
+                if (d.has_value_task()) deps.push_back(d.get_value_task());
+            }
             return deps;
         } else {
             return {m_mod->m_result};
@@ -136,10 +182,17 @@ public:
         if (!res.m_ok)
             throw exception("not creating olean file because of errors");
 
-        auto olean_fn = olean_of_lean(m_mod->m_mod);
-        exclusive_file_lock output_lock(olean_fn);
-        std::ofstream out(olean_fn, std::ios_base::binary);
-        export_module(out, env);
+        std::ostringstream out(std::ios_base::binary);
+        export_module(out, env, m_mod->m_src_hash, m_mod->m_trans_hash);
+        std::string contents = out.str();
+        write_olean(olean_of_lean(m_mod->m_mod), contents);
+        if (m_cache_dir) {
+            try {
+                write_olean(get_cache_file_name(*m_cache_dir, m_mod->m_trans_hash), contents);
+            } catch (exception &) {
+                // the cache is only an optimization, the .olean file has already been created
+            }
+        }
         return {};
     }
 };
@@ -170,50 +223,16 @@ void module_mgr::build_module(module_id const & id, bool can_use_olean, name_set
 
         bool already_have_lean_version = m_modules[id] && m_modules[id]->m_source == module_src::LEAN;
 
-        std::string contents;
+        mapped_file_ref file;
         module_src src;
         time_t mtime;
-        std::tie(contents, src, mtime) = m_vfs->load_module(id, !already_have_lean_version && can_use_olean);
+        std::tie(file, src, mtime) = m_vfs->load_module(id, !already_have_lean_version && can_use_olean);
 
         if (src == module_src::OLEAN) {
-            auto obj_code = contents;
-
-            std::istringstream in2(obj_code, std::ios_base::binary);
-            auto olean_fn = olean_of_lean(id);
-            auto parsed_olean = parse_olean(in2, olean_fn);
-
-            auto mod = std::make_shared<module_info>();
-
-            mod->m_mod = id;
-            mod->m_source = module_src::OLEAN;
-            mod->m_version = m_current_period;
-            mod->m_trans_mtime = mod->m_mtime = mtime;
-
-            for (auto & d : parsed_olean.first) {
-                auto d_id = resolve(id, d);
-                build_module(d_id, true, module_stack);
-
-                mod->m_deps.push_back(std::make_pair(d_id, d));
-
-                auto & d_mod = m_modules[d_id];
-                mod->m_trans_mtime = std::max(mod->m_trans_mtime, d_mod->m_trans_mtime);
-            }
-
-            if (mod->m_trans_mtime > mod->m_mtime)
+            if (!load_olean_module(id, file, mtime, module_stack))
                 return build_module(id, false, orig_module_stack);
-
-            module_info::parse_result res;
-            res.m_obj_code = obj_code;
-            res.m_ok = true;
-            mod->m_result = mk_pure_task_result(res, "Loading " + olean_fn);
-
-            get_global_task_queue().cancel_if(
-                    [=] (generic_task * t) {
-                        return t->get_version() < m_current_period && t->get_module_id() == id;
-                    });
-            m_modules[id] = mod;
         } else if (src == module_src::LEAN) {
-            std::istringstream in(contents);
+            std::string contents = file->to_string();
 
             auto bucket_name = "_build_module";
 
@@ -235,13 +254,15 @@ void module_mgr::build_module(module_id const & id, bool can_use_olean, name_set
             auto mod = std::make_shared<module_info>();
             mod->m_mod = id;
             mod->m_source = module_src::LEAN;
-            mod->m_trans_mtime = mod->m_mtime = mtime;
+            mod->m_mtime = mtime;
+            mod->m_src_hash = hash_module_source(contents);
+            mod->m_trans_hash = hash_module(mod->m_src_hash);
             for (auto & d : imports) {
                 module_id d_id;
                 try {
                     d_id = resolve(id, d);
                     build_module(d_id, true, module_stack);
-                    mod->m_trans_mtime = std::max(mod->m_trans_mtime, m_modules[d_id]->m_trans_mtime);
+                    mod->m_trans_hash = hash(mod->m_trans_hash, m_modules[d_id]->m_trans_hash);
                 } catch (throwable & ex) {
                     message_builder msg(m_initial_env, m_ios, id, pos_info {1, 0}, ERROR);
                     msg.set_exception(ex);
@@ -249,9 +270,16 @@ void module_mgr::build_module(module_id const & id, bool can_use_olean, name_set
                 }
                 mod->m_deps.push_back({ d_id, d });
             }
+            if (can_use_olean && m_save_olean && m_cache_dir) {
+                /* The module has been built before, possibly in a different directory. */
+                if (auto cached = fetch_from_cache(id, mod->m_trans_hash))
+                    if (load_olean_module(id, cached, get_mtime(cached->get_fname()), module_stack))
+                        return;
+            }
             if (m_use_snapshots) {
                 mod->m_lean_contents = optional<std::string>(contents);
                 mod->m_still_valid_snapshots = snapshots;
+                m_first_changes.erase(id);
             }
             mod->m_version = m_current_period;
 
@@ -262,7 +290,7 @@ void module_mgr::build_module(module_id const & id, bool can_use_olean, name_set
                     deps);
 
             if (m_save_olean)
-                mod->m_olean_task = get_global_task_queue().submit<olean_compilation_task>(mod);
+                mod->m_olean_task = get_global_task_queue().submit<olean_compilation_task>(mod, m_cache_dir);
 
             get_global_task_queue().cancel_if([=] (generic_task * t) {
                 return t->get_version() < m_current_period && t->get_module_id() == id && t->get_pos() >= task_pos;
@@ -279,6 +307,70 @@ void module_mgr::build_module(module_id const & id, bool can_use_olean, name_set
     }
 }
 
+/** \brief Use the .olean file \c file as the contents of \c id. Return false if the .olean file is out of date,
+    i.e., the imported modules changed after it was created. */
+bool module_mgr::load_olean_module(module_id const & id, mapped_file_ref const & file, time_t mtime,
+                                   name_set const & module_stack) {
+    auto olean_fn = olean_of_lean(id);
+    auto parsed_olean = parse_olean(file->data(), file->size(), olean_fn);
+
+    auto mod = std::make_shared<module_info>();
+
+    mod->m_mod = id;
+    mod->m_source = module_src::OLEAN;
+    mod->m_version = m_current_period;
+    mod->m_mtime = mtime;
+    mod->m_src_hash = parsed_olean.m_src_hash;
+    mod->m_trans_hash = hash_module(mod->m_src_hash);
+
+    for (auto & d : parsed_olean.m_imports) {
+        auto d_id = resolve(id, d);
+        build_module(d_id, true, module_stack);
+
+        mod->m_deps.push_back(std::make_pair(d_id, d));
+
+        auto & d_mod = m_modules[d_id];
+        mod->m_trans_hash = hash(mod->m_trans_hash, d_mod->m_trans_hash);
+    }
+
+    if (mod->m_trans_hash != parsed_olean.m_trans_hash)
+        return false;
+
+    module_info::parse_result res;
+    res.m_obj_code = file;
+    res.m_ok = true;
+    mod->m_result = mk_pure_task_result(res, "Loading " + olean_fn);
+
+    get_global_task_queue().cancel_if(
+            [=] (generic_task * t) {
+                return t->get_version() < m_current_period && t->get_module_id() == id;
+            });
+    m_modules[id] = mod;
+    return true;
+}
+
+/** \brief Copy the .olean file for \c trans_hash from the cache directory, and return its contents.
+    Return nullptr if the cache does not contain it. */
+mapped_file_ref module_mgr::fetch_from_cache(module_id const & id, uint64 trans_hash) {
+    auto cache_fn = get_cache_file_name(*m_cache_dir, trans_hash);
+    if (get_mtime(cache_fn) == -1) return nullptr;
+    try {
+        std::string contents;
+        {
+            shared_file_lock cache_lock(cache_fn);
+            contents = read_file(cache_fn, std::ios_base::binary);
+        }
+        if (parse_olean(contents.data(), contents.size(), cache_fn).m_trans_hash != trans_hash)
+            return nullptr;
+        auto olean_fn = olean_of_lean(id);
+        write_olean(olean_fn, contents);
+        shared_file_lock olean_lock(olean_fn);
+        return map_file(olean_fn);
+    } catch (exception &) {
+        return nullptr;
+    }
+}
+
 std::shared_ptr<module_info const> module_mgr::get_module(module_id const & id) {
     unique_lock<mutex> lock(m_mutex);
     name_set module_stack;
@@ -288,6 +380,21 @@ std::shared_ptr<module_info const> module_mgr::get_module(module_id const & id)
 
 void module_mgr::invalidate(module_id const & id) {
     unique_lock<mutex> lock(m_mutex);
+    m_first_changes.erase(id);
+    invalidate_core(id);
+}
+
+void module_mgr::invalidate(module_id const & id, pos_info const & first_change) {
+    unique_lock<mutex> lock(m_mutex);
+    auto it = m_first_changes.find(id);
+    if (it == m_first_changes.end())
+        m_first_changes.insert(mk_pair(id, first_change));
+    else if (first_change < it->second)
+        it->second = first_change;
+    invalidate_core(id);
+}
+
+void module_mgr::invalidate_core(module_id const & id) {
     m_current_period++;
 
     if (auto & mod = m_modules[id]) {
@@ -337,7 +444,14 @@ module_mgr::get_snapshots_or_unchanged_module(module_id const &id, std::string c
 
     if (!mod->m_lean_contents) return false;
 
-    if (*mod->m_lean_contents == contents) return true;
+    optional<pos_info> diff_pos;
+    auto first_change = m_first_changes.find(id);
+    if (first_change != m_first_changes.end()) {
+        diff_pos = first_change->second;
+    } else {
+        if (*mod->m_lean_contents == contents) return true;
+        diff_pos = get_first_diff_pos(contents, *mod->m_lean_contents);
+    }
 
     if (mod->m_result) {
         if (auto parse_res = mod->m_result.peek())
@@ -345,7 +459,7 @@ module_mgr::get_snapshots_or_unchanged_module(module_id const &id, std::string c
     }
     if (mod->m_still_valid_snapshots.empty()) return false;
 
-    if (auto diff_pos = get_first_diff_pos(contents, *mod->m_lean_contents)) {
+    if (diff_pos) {
         auto & snaps = mod->m_still_valid_snapshots;
         auto it = snaps.begin();
         while (it != snaps.end() && (*it)->m_pos < *diff_pos)
@@ -393,22 +507,27 @@ std::vector<std::tuple<module_id, module_name, std::shared_ptr<module_info const
     return res;
 }
 
-std::tuple<std::string, module_src, time_t> fs_module_vfs::load_module(module_id const & id, bool can_use_olean) {
+std::tuple<mapped_file_ref, module_src, time_t> fs_module_vfs::load_module(module_id const & id, bool can_use_olean) {
     auto lean_fn = id;
     auto lean_mtime = get_mtime(lean_fn);
+    auto contents = read_file(lean_fn);
+
+    if (can_use_olean && !m_modules_to_load_from_source.count(id)) {
+        try {
+            /* The .olean file is only used if it was created from the current contents of the .lean file,
+               module_mgr checks that the imported modules did not change either. */
+            auto olean_fn = olean_of_lean(lean_fn);
+            shared_file_lock olean_lock(olean_fn);
+            auto olean_mtime = get_mtime(olean_fn);
+            if (olean_mtime != -1) {
+                auto olean = map_file(olean_fn);
+                if (parse_olean(*olean, false).m_src_hash == hash_module_source(contents))
+                    return std::make_tuple(olean, module_src::OLEAN, olean_mtime);
+            }
+        } catch (exception) {}
+    }
 
-    try {
-        auto olean_fn = olean_of_lean(lean_fn);
-        shared_file_lock olean_lock(olean_fn);
-        auto olean_mtime = get_mtime(olean_fn);
-        if (olean_mtime != -1 && olean_mtime >= lean_mtime &&
-            can_use_olean &&
-            !m_modules_to_load_from_source.count(id)) {
-            return std::make_tuple(read_file(olean_fn, std::ios_base::binary), module_src::OLEAN, olean_mtime);
-        }
-    } catch (exception) {}
-
-    return std::make_tuple(read_file(lean_fn), module_src::LEAN, lean_mtime);
+    return std::make_tuple(mk_mapped_file(lean_fn, contents), module_src::LEAN, lean_mtime);
 }
 
 }
@@ -31,7 +31,10 @@ struct module_info {
 
     module_id m_mod;
     module_src m_source = module_src::LEAN;
-    time_t m_mtime = -1, m_trans_mtime = -1;
+    time_t m_mtime = -1;
+    /* Hash of the source text, and hash of the source text of this module and all its transitive
+       imports (see hash_module). An .olean file is only reused if its hashes match. */
+    uint64 m_src_hash = 0, m_trans_hash = 0;
     std::vector<std::pair<module_id, module_name>> m_deps;
     optional<std::string> m_lean_contents;
 
@@ -42,7 +45,7 @@ struct module_info {
         options               m_opts;
         bool m_ok = false;
 
-        std::string m_obj_code;
+        mapped_file_ref m_obj_code;
         std::vector<task_result<expr>> m_obj_code_delayed_proofs;
 
         snapshot_vector m_snapshots;
@@ -59,13 +62,13 @@ public:
     virtual ~module_vfs() {}
     // need to support changed lean dependencies of olean files
     // need to support changed editor dependencies of olean files
-    virtual std::tuple<std::string, module_src, time_t> load_module(module_id const &, bool can_use_olean) = 0;
+    virtual std::tuple<mapped_file_ref, module_src, time_t> load_module(module_id const &, bool can_use_olean) = 0;
 };
 
 class fs_module_vfs : public module_vfs {
 public:
     std::unordered_set<module_id> m_modules_to_load_from_source;
-    std::tuple<std::string, module_src, time_t> load_module(module_id const & id, bool can_use_olean) override;
+    std::tuple<mapped_file_ref, module_src, time_t> load_module(module_id const & id, bool can_use_olean) override;
 };
 
 class module_mgr {
@@ -73,6 +76,9 @@ class module_mgr {
 
     bool m_use_snapshots = false;
     bool m_save_olean = false;
+    /* Directory where .olean files are stored indexed by module_info::m_trans_hash, it is used to
+       avoid elaborating modules that have already been built (e.g., in a different checkout). */
+    optional<std::string> m_cache_dir;
 
     environment m_initial_env;
     io_state m_ios;
@@ -81,9 +87,16 @@ class module_mgr {
 
     mutex m_mutex;
     std::unordered_map<module_id, std::shared_ptr<module_info>> m_modules;
+    /* For modules invalidated using invalidate(id, first_change): position of the first change since
+       the contents stored at module_info::m_lean_contents. */
+    std::unordered_map<module_id, pos_info> m_first_changes;
 
     void mark_out_of_date(module_id const & id);
+    void invalidate_core(module_id const & id);
     void build_module(module_id const & id, bool can_use_olean, name_set module_stack);
+    bool load_olean_module(module_id const & id, mapped_file_ref const & file, time_t mtime,
+                           name_set const & module_stack);
+    mapped_file_ref fetch_from_cache(module_id const & id, uint64 trans_hash);
     std::vector<module_name> get_direct_imports(module_id const & id, std::string const & contents);
     void gather_transitive_imports(
         std::vector<std::tuple<module_id, module_name, std::shared_ptr<module_info const>>> & res,
@@ -99,6 +112,10 @@ public:
             m_initial_env(initial_env), m_ios(ios), m_vfs(vfs), m_msg_buf(msg_buf) {}
 
     void invalidate(module_id const & id);
+    /** \brief Similar to invalidate(id), but the caller guarantees that the contents of \c id before
+        \c first_change did not change. So, the snapshots before \c first_change are reused without
+        comparing the old and new contents. */
+    void invalidate(module_id const & id, pos_info const & first_change);
 
     std::shared_ptr<module_info const> get_module(module_id const &);
 
@@ -110,6 +127,9 @@ public:
     void set_save_olean(bool save_olean) { m_save_olean = save_olean; }
     bool get_save_olean() const { return m_save_olean; }
 
+    void set_cache_dir(optional<std::string> const & dir) { m_cache_dir = dir; }
+    optional<std::string> const & get_cache_dir() const { return m_cache_dir; }
+
     environment get_initial_env() const { return m_initial_env; }
     options get_options() const { return m_ios.get_options(); }
     io_state get_io_state() const { return m_ios; }
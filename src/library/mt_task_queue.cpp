@@ -7,6 +7,7 @@ Author: Gabriel Ebner
 #include <string>
 #include <algorithm>
 #include <vector>
+#include <limits>
 #include "library/mt_task_queue.h"
 #include "util/interrupt.h"
 #include "util/flet.h"
@@ -27,11 +28,18 @@ struct scoped_current_task {
     }
 };
 
-template <class T>
+/* Worker threads remember the queue they belong to, so that the tasks they submit
+   or release end up in their own ready queue. */
+LEAN_THREAD_PTR(mt_task_queue, g_worker_tq);
+LEAN_THREAD_VALUE(unsigned, g_worker_queue_idx, 0);
+
+static constexpr uint64 g_empty_queue_prio = std::numeric_limits<uint64>::max();
+
+template <class T, class D = T>
 struct scoped_add {
     T & m_ref;
-    T m_delta;
-    scoped_add(T & ref, T delta) : m_ref(ref), m_delta(delta) {
+    D m_delta;
+    scoped_add(T & ref, D delta) : m_ref(ref), m_delta(delta) {
         m_ref += m_delta;
     }
     ~scoped_add() {
@@ -46,7 +54,14 @@ mt_task_queue::mt_task_queue(unsigned num_workers) :
         return p;
     }) {}
 
+mt_task_queue::ready_queue::ready_queue() : m_best_prio(g_empty_queue_prio) {}
+
+void mt_task_queue::ready_queue::update_best_prio() {
+    m_best_prio = m_tasks.empty() ? g_empty_queue_prio : m_tasks.begin()->first;
+}
+
 mt_task_queue::mt_task_queue(unsigned num_workers, mt_tq_prioritizer const & prioritizer) :
+        m_num_queues(std::max(num_workers, 1u)), m_queues(new ready_queue[m_num_queues]),
         m_required_workers(num_workers), m_prioritizer(prioritizer),
         m_ios(get_global_ios()), m_msg_buf(&get_global_message_buffer()) {
     for (unsigned i = 0; i < num_workers; i++)
@@ -55,19 +70,26 @@ mt_task_queue::mt_task_queue(unsigned num_workers, mt_tq_prioritizer const & pri
     m_monitor_thr.reset(new lthread([=] {
         unique_lock<mutex> lock(m_mutex);
         while (true) {
-            m_queue_changed.wait(lock, [=] { return m_monitor_needs_to_run; });
+            m_monitor_cv.wait(lock, [=] { return m_monitor_needs_to_run.load(); });
             if (m_shutting_down) return;
             m_monitor_needs_to_run = false;
 
             mt_tq_status st;
             if (m_status_cb) {
                 for (auto & w : m_workers)
-                    if (w->m_current_task)
-                        st.m_executing.push_back(unwrap(w->m_current_task)->m_task);
-                for (auto & q : m_queue)
-                    for (auto & tr : q.second)
-                        if (auto t = unwrap(tr)->m_task)
-                            st.m_queued.push_back(t);
+                    if (auto tr = get_current_task(*w))
+                        st.m_executing.push_back(unwrap(*tr)->m_task);
+                for (unsigned i = 0; i < m_num_queues; i++) {
+                    lock_guard<mutex> q_lock(m_queues[i].m_mutex);
+                    for (auto & q : m_queues[i].m_tasks)
+                        for (auto & tr : q.second)
+                            if (unwrap(tr)->m_state.load() == task_result_state::QUEUED)
+                                if (auto t = unwrap(tr)->m_task)
+                                    st.m_queued.push_back(t);
+                }
+                /* tasks whose priority has been bumped are stored twice */
+                std::sort(st.m_queued.begin(), st.m_queued.end());
+                st.m_queued.erase(std::unique(st.m_queued.begin(), st.m_queued.end()), st.m_queued.end());
                 for (auto & tr : m_waiting)
                     if (auto t = unwrap(tr)->m_task)
                         st.m_waiting.push_back(t);
@@ -76,8 +98,8 @@ mt_task_queue::mt_task_queue(unsigned num_workers, mt_tq_prioritizer const & pri
             generic_task * cur_task = nullptr;
             if (m_progress_cb) {
                 for (auto & w : m_workers) {
-                    if (w->m_current_task) {
-                        cur_task = unwrap(w->m_current_task)->m_task;
+                    if (auto tr = get_current_task(*w)) {
+                        cur_task = unwrap(*tr)->m_task;
                         break;
                     }
                 }
@@ -99,6 +121,7 @@ mt_task_queue::~mt_task_queue() {
         m_monitor_needs_to_run = true;
         m_queue_added.notify_all();
         m_queue_changed.notify_all();
+        m_monitor_cv.notify_all();
         m_wake_up_worker.notify_all();
         m_shut_down_cv.notify_all();
     }
@@ -107,57 +130,67 @@ mt_task_queue::~mt_task_queue() {
 }
 
 void mt_task_queue::notify_queue_changed() {
-    m_monitor_needs_to_run = true;
+    /* The monitor only needs to be woken up once per status report. */
+    if (!m_monitor_needs_to_run.exchange(true))
+        m_monitor_cv.notify_one();
     m_queue_changed.notify_all();
 }
 
 void mt_task_queue::spawn_worker() {
     lean_assert(!m_shutting_down);
     auto this_worker = std::make_shared<worker_info>();
+    unsigned queue_idx = m_workers.size() % m_num_queues;
     this_worker->m_thread.reset(new lthread([=]() {
         save_stack_info(false);
         this_worker->m_interrupt_flag = get_interrupt_flag();
+        g_worker_tq = this;
+        g_worker_queue_idx = queue_idx;
 
         scope_global_task_queue scope_tq(this);
         scope_global_ios scope_ios(m_ios);
         scoped_message_buffer scope_msg_buf(m_msg_buf);
 
-        unique_lock<mutex> lock(m_mutex);
-        scoped_add<int> dec_required(m_required_workers, -1);
+        scoped_add<atomic<int>, int> dec_required(m_required_workers, -1);
         while (true) {
-            if (m_shutting_down) {
-                run_thread_finalizers();
-                run_post_thread_finalizers();
-                return;
-            }
-            if (m_required_workers < 0) {
-                scoped_add<int> inc_required(m_required_workers, +1);
-                scoped_add<unsigned> inc_sleeping(m_sleeping_workers, +1);
-                m_wake_up_worker.wait(lock);
-                continue;
-            }
-            if (m_queue.empty()) {
-                m_queue_added.wait(lock);
+            generic_task_result t;
+            if (m_required_workers.load() < 0 || !try_dequeue(queue_idx, *this_worker, t)) {
+                unique_lock<mutex> lock(m_mutex);
+                if (m_shutting_down) {
+                    run_thread_finalizers();
+                    run_post_thread_finalizers();
+                    return;
+                }
+                if (m_required_workers.load() < 0) {
+                    scoped_add<atomic<int>, int> inc_required(m_required_workers, +1);
+                    scoped_add<unsigned> inc_sleeping(m_sleeping_workers, +1);
+                    m_wake_up_worker.wait(lock);
+                    continue;
+                }
+                /* Tasks are only added while holding m_mutex, so we cannot miss the notification. */
+                if (m_num_ready.load() == 0) {
+                    scoped_add<unsigned> inc_idle(m_idle_workers, +1);
+                    m_queue_added.wait(lock);
+                }
                 continue;
             }
 
-            auto t = dequeue();
-            if (unwrap(t)->m_state.load() != task_result_state::QUEUED) continue;
-
-            unwrap(t)->m_state = task_result_state::EXECUTING;
             bool is_ok;
-            reset_interrupt();
             {
-                flet<generic_task_result> _(this_worker->m_current_task, t);
                 scoped_current_task scope_cur_task(&t);
-                notify_queue_changed();
-                lock.unlock();
+                if (!m_monitor_needs_to_run.exchange(true)) {
+                    lock_guard<mutex> lock(m_mutex);
+                    m_monitor_cv.notify_one();
+                }
                 is_ok = execute_task_with_scopes(unwrap(t));
-                lock.lock();
             }
             reset_interrupt();
 
+            unique_lock<mutex> lock(m_mutex);
             unwrap(t)->m_state = is_ok ? task_result_state::FINISHED : task_result_state::FAILED;
+            {
+                lock_guard<mutex> w_lock(this_worker->m_mutex);
+                this_worker->m_current_task.reset();
+            }
             get_data(t).m_has_finished.notify_all();
 
             if (is_ok) {
@@ -174,6 +207,7 @@ void mt_task_queue::spawn_worker() {
                                 }
                                 break;
                             case task_result_state::QUEUED: break;
+                            case task_result_state::EXECUTING: break;
                             case task_result_state::FAILED: break;
                             default:
                                 lean_unreachable();
@@ -191,6 +225,78 @@ void mt_task_queue::spawn_worker() {
     m_workers.push_back(this_worker);
 }
 
+bool mt_task_queue::try_dequeue(unsigned queue_idx, worker_info & w, generic_task_result & result) {
+    while (true) {
+        /* Pick the queue containing the best priority class, preferring our own queue. */
+        unsigned best_idx = queue_idx;
+        uint64 best_prio = m_queues[queue_idx].m_best_prio.load();
+        for (unsigned i = 1; i < m_num_queues; i++) {
+            unsigned idx = (queue_idx + i) % m_num_queues;
+            uint64 prio = m_queues[idx].m_best_prio.load();
+            if (prio < best_prio) {
+                best_prio = prio;
+                best_idx  = idx;
+            }
+        }
+        if (best_prio == g_empty_queue_prio) return false;
+
+        generic_task_result t;
+        {
+            ready_queue & q = m_queues[best_idx];
+            lock_guard<mutex> lock(q.m_mutex);
+            if (q.m_tasks.empty()) continue;
+            auto it = q.m_tasks.begin();
+            t = std::move(it->second.front());
+            it->second.pop_front();
+            if (it->second.empty()) q.m_tasks.erase(it);
+            q.update_best_prio();
+            m_num_ready--;
+        }
+
+        /* The task is published before it is started, so that cancel_core can interrupt it. */
+        reset_interrupt();
+        {
+            lock_guard<mutex> lock(w.m_mutex);
+            w.m_current_task = t;
+        }
+        auto expected = task_result_state::QUEUED;
+        if (unwrap(t)->m_state.compare_exchange_strong(expected, task_result_state::EXECUTING)) {
+            m_num_queued--;
+            result = std::move(t);
+            return true;
+        }
+
+        /* Stale entry: the task has been cancelled, or it was already executed from a better priority class. */
+        {
+            lock_guard<mutex> lock(w.m_mutex);
+            w.m_current_task.reset();
+        }
+        lock_guard<mutex> lock(m_mutex);
+        m_queue_changed.notify_all();
+    }
+}
+
+bool mt_task_queue::fail(generic_task_result const & t, std::exception_ptr const & ex) {
+    auto st = unwrap(t)->m_state.load();
+    switch (st) {
+        case task_result_state::CREATED:
+        case task_result_state::WAITING:
+            break;
+        case task_result_state::QUEUED:
+            /* Queued tasks can be picked up by workers without holding m_mutex,
+               we claim the task by moving it back to CREATED before setting the exception. */
+            if (!unwrap(t)->m_state.compare_exchange_strong(st, task_result_state::CREATED))
+                return false;
+            m_num_queued--;
+            break;
+        default:
+            return false;
+    }
+    unwrap(t)->m_ex = ex;
+    unwrap(t)->m_state = task_result_state::FAILED;
+    return true;
+}
+
 void mt_task_queue::propagate_failure(generic_task_result const & tr) {
     lean_assert(unwrap(tr)->m_state.load() == task_result_state::FAILED);
     m_waiting.erase(tr);
@@ -202,9 +308,8 @@ void mt_task_queue::propagate_failure(generic_task_result const & tr) {
             switch (unwrap(rdep)->m_state.load()) {
                 case task_result_state::WAITING:
                 case task_result_state::QUEUED:
-                    unwrap(rdep)->m_ex = unwrap(tr)->m_ex;
-                    unwrap(rdep)->m_state = task_result_state::FAILED;
-                    propagate_failure(rdep);
+                    if (fail(rdep, unwrap(tr)->m_ex))
+                        propagate_failure(rdep);
                     break;
                 default: break;
             }
@@ -234,16 +339,13 @@ void mt_task_queue::bump_prio(generic_task_result const & t, task_priority const
     if (unwrap(t)->m_task && new_prio < get_prio(t)) {
         switch (unwrap(t)->m_state.load()) {
         case task_result_state::QUEUED: {
-            auto prio = get_prio(t).m_prio;
-            auto &q = m_queue[prio];
-            auto it = std::find(q.begin(), q.end(), t);
-            lean_assert(it != q.end());
-            q.erase(it);
-            if (q.empty()) m_queue.erase(prio);
-
+            auto old_prio = get_prio(t).m_prio;
             get_prio(t).bump(new_prio);
+            bool moved = get_prio(t).m_prio != old_prio;
             check_deps(t);
-            enqueue(t);
+            /* The old entry stays in its queue, and is skipped once the task has been started. */
+            if (moved && unwrap(t)->m_state.load() == task_result_state::QUEUED)
+                push_ready(t);
             break;
         }
         case task_result_state::WAITING:
@@ -279,9 +381,8 @@ bool mt_task_queue::check_deps(generic_task_result const & t) {
             case task_result_state::FINISHED:
                 break;
             case task_result_state::FAILED:
-                unwrap(t)->m_ex = unwrap(dep)->m_ex;
-                unwrap(t)->m_state = task_result_state::FAILED;
-                propagate_failure(t);
+                if (fail(t, unwrap(dep)->m_ex))
+                    propagate_failure(t);
                 return true;
             default: lean_unreachable();
         }
@@ -297,7 +398,7 @@ void mt_task_queue::wait(generic_task_result const & t) {
     }
     while (!unwrap(t)->has_evaluated()) {
         if (g_current_task) {
-            scoped_add<int> inc_required(m_required_workers, +1);
+            scoped_add<atomic<int>, int> inc_required(m_required_workers, +1);
             if (m_sleeping_workers == 0) {
                 spawn_worker();
             } else {
@@ -320,13 +421,18 @@ void mt_task_queue::cancel_if(const std::function<bool(generic_task *)> & pred)
     unique_lock<mutex> lock(m_mutex);
 
     for (auto & w : m_workers)
-        if (w->m_current_task && pred(unwrap(w->m_current_task)->m_task))
-            to_cancel.push_back(w->m_current_task);
-
-    for (auto & q : m_queue)
-        for (auto & t : q.second)
-            if (unwrap(t)->m_task && pred(unwrap(t)->m_task))
-                to_cancel.push_back(t);
+        if (auto t = get_current_task(*w))
+            if (pred(unwrap(*t)->m_task))
+                to_cancel.push_back(*t);
+
+    for (unsigned i = 0; i < m_num_queues; i++) {
+        lock_guard<mutex> q_lock(m_queues[i].m_mutex);
+        for (auto & q : m_queues[i].m_tasks)
+            for (auto & t : q.second)
+                if (unwrap(t)->m_state.load() == task_result_state::QUEUED &&
+                    unwrap(t)->m_task && pred(unwrap(t)->m_task))
+                    to_cancel.push_back(t);
+    }
 
     for (auto & t : m_waiting)
         if (unwrap(t)->m_task && pred(unwrap(t)->m_task))
@@ -339,15 +445,17 @@ void mt_task_queue::cancel_if(const std::function<bool(generic_task *)> & pred)
 void mt_task_queue::cancel_core(generic_task_result const & t) {
     switch (unwrap(t)->m_state.load()) {
         case task_result_state::WAITING:
-            m_waiting.erase(t);
         case task_result_state::QUEUED:
-            unwrap(t)->m_ex = std::make_exception_ptr(task_cancellation_exception(t));
-            unwrap(t)->m_state = task_result_state::FAILED;
+            if (!fail(t, std::make_exception_ptr(task_cancellation_exception(t)))) {
+                /* a worker has just started executing the task */
+                return cancel_core(t);
+            }
             propagate_failure(t);
-            unwrap(t)->clear_task();
+            notify_queue_changed();
             return;
         case task_result_state::EXECUTING:
             for (auto & w : m_workers) {
+                lock_guard<mutex> lock(w->m_mutex);
                 if (w->m_current_task == t) {
                     w->m_interrupt_flag->store(true);
                 }
@@ -369,10 +477,10 @@ void mt_task_queue::join() {
 
 bool mt_task_queue::empty_core() {
     for (auto & w : m_workers) {
-        if (w->m_current_task)
+        if (get_current_task(*w))
             return false;
     }
-    return m_queue.empty() && m_waiting.empty();
+    return m_num_queued.load() == 0 && m_waiting.empty();
 }
 
 bool mt_task_queue::empty() {
@@ -380,35 +488,46 @@ bool mt_task_queue::empty() {
     return empty_core();
 }
 
+optional<generic_task_result> mt_task_queue::get_current_task(worker_info & w) {
+    lock_guard<mutex> lock(w.m_mutex);
+    if (w.m_current_task)
+        return optional<generic_task_result>(w.m_current_task);
+    return optional<generic_task_result>();
+}
+
 optional<generic_task_result> mt_task_queue::get_current_task() {
     unique_lock<mutex> lock(m_mutex);
     for (auto & w : m_workers) {
-        if (w->m_current_task) {
-            return optional<generic_task_result>(w->m_current_task);
-        }
+        if (auto t = get_current_task(*w))
+            return t;
     }
     return optional<generic_task_result>();
 }
 
-generic_task_result mt_task_queue::dequeue() {
-    lean_assert(!m_queue.empty());
-    auto it = m_queue.begin();
-    auto & highest_prio = it->second;
-    lean_assert(!highest_prio.empty());
-    auto result = std::move(highest_prio.front());
-    highest_prio.pop_front();
-    if (highest_prio.empty()) {
-        m_queue.erase(it);
+unsigned mt_task_queue::get_local_queue() {
+    if (g_worker_tq == this)
+        return g_worker_queue_idx;
+    return m_next_queue++ % m_num_queues;
+}
+
+void mt_task_queue::push_ready(generic_task_result const & t) {
+    ready_queue & q = m_queues[get_local_queue()];
+    {
+        lock_guard<mutex> lock(q.m_mutex);
+        q.m_tasks[get_prio(t).m_prio].push_back(t);
+        q.update_best_prio();
+        m_num_ready++;
     }
-    return result;
+    if (m_idle_workers > 0)
+        m_queue_added.notify_one();
 }
 
 void mt_task_queue::enqueue(generic_task_result const & t) {
     lean_assert(unwrap(t)->m_state.load() < task_result_state::EXECUTING);
     lean_assert(unwrap(t)->m_task);
     unwrap(t)->m_state = task_result_state::QUEUED;
-    m_queue[get_prio(t).m_prio].push_back(t);
-    m_queue_added.notify_one();
+    m_num_queued++;
+    push_ready(t);
     notify_queue_changed();
 }
 
@@ -424,17 +543,28 @@ void mt_task_queue::reprioritize() {
 }
 
 void mt_task_queue::reprioritize_core() {
-    auto old_queues = m_queue;
-    m_queue.clear();
-    for (auto & q : old_queues) {
-        for (auto & t : q.second) {
-            if (unwrap(t)) {
-                get_prio(t) = m_prioritizer(unwrap(t)->m_task);
-                enqueue(t);
+    std::vector<generic_task_result> queued;
+    std::unordered_set<generic_task_result, generic_task_result::hash> visited;
+    for (unsigned i = 0; i < m_num_queues; i++) {
+        ready_queue & q = m_queues[i];
+        lock_guard<mutex> lock(q.m_mutex);
+        for (auto & p : q.m_tasks) {
+            for (auto & t : p.second) {
+                if (unwrap(t)->m_state.load() == task_result_state::QUEUED && visited.insert(t).second)
+                    queued.push_back(t);
+                m_num_ready--;
             }
         }
+        q.m_tasks.clear();
+        q.update_best_prio();
+    }
+    for (auto & t : queued) {
+        get_prio(t) = m_prioritizer(unwrap(t)->m_task);
+        /* tasks that were started in the meantime are not added back */
+        if (unwrap(t)->m_state.load() == task_result_state::QUEUED)
+            push_ready(t);
     }
-    for (auto & q : old_queues) for (auto & t : q.second) check_deps(t);
+    for (auto & t : queued) if (unwrap(t)->m_task) check_deps(t);
 
     for (auto & t : m_waiting) {
         if (unwrap(t)->m_task) {
@@ -11,8 +11,10 @@ Author: Gabriel Ebner
 #include <unordered_set>
 #include <map>
 #include <functional>
+#include <memory>
 #include <unordered_map>
 #include "util/optional.h"
+#include "util/int64.h"
 #include "library/io_state.h"
 #include "util/task_queue.h"
 #include "library/message_buffer.h"
@@ -38,17 +40,41 @@ struct mt_tq_status {
 using mt_tq_status_cb = std::function<void(mt_tq_status const &)>;
 
 class mt_task_queue : public task_queue {
+    /* m_mutex protects the dependency graph (reverse dependencies, m_waiting, state changes of
+       tasks that are not queued), the worker list and the callbacks. Queued tasks are stored in
+       per-worker queues with their own locks, so that workers can pick up tasks without taking m_mutex. */
     mutex m_mutex;
-    std::map<unsigned, std::deque<generic_task_result>> m_queue;
     std::unordered_set<generic_task_result, generic_task_result::hash> m_waiting;
-    condition_variable m_queue_added, m_queue_changed;
+    condition_variable m_queue_added, m_queue_changed, m_monitor_cv;
     void notify_queue_changed();
 
+    /* Ready tasks, indexed by priority class. Each worker owns one of these queues: it
+       pushes the tasks it submits or releases into it, and steals from the other queues
+       when they contain tasks with a better priority than its own. */
+    struct ready_queue {
+        mutex m_mutex;
+        std::map<unsigned, std::deque<generic_task_result>> m_tasks;
+        /* priority class of the first task in m_tasks, or g_empty_queue_prio;
+           can be read without holding m_mutex. */
+        atomic<uint64> m_best_prio;
+        ready_queue();
+        void update_best_prio();
+    };
+    unsigned m_num_queues;
+    std::unique_ptr<ready_queue[]> m_queues;
+    /* number of entries in m_queues, including the ones of tasks that are no longer queued */
+    atomic<unsigned> m_num_ready { 0 };
+    /* number of tasks in state QUEUED */
+    atomic<unsigned> m_num_queued { 0 };
+    atomic<unsigned> m_next_queue { 0 };
+
     bool m_shutting_down = false;
     condition_variable m_shut_down_cv;
 
     struct worker_info {
         std::unique_ptr<lthread> m_thread;
+        /* protects m_current_task */
+        mutex m_mutex;
         generic_task_result m_current_task;
         atomic_bool * m_interrupt_flag = nullptr;
     };
@@ -56,7 +82,8 @@ class mt_task_queue : public task_queue {
     void spawn_worker();
 
     unsigned m_sleeping_workers = 0;
-    int m_required_workers;
+    unsigned m_idle_workers = 0;
+    atomic<int> m_required_workers;
     condition_variable m_wake_up_worker;
 
     mt_tq_prioritizer m_prioritizer;
@@ -65,17 +92,21 @@ class mt_task_queue : public task_queue {
     progress_cb      m_progress_cb;
     mt_tq_status_cb  m_status_cb;
     std::unique_ptr<lthread> m_monitor_thr;
-    bool             m_monitor_needs_to_run = false;
+    atomic<bool>     m_monitor_needs_to_run { false };
 
     io_state m_ios;
     message_buffer * m_msg_buf;
 
     bool empty_core();
+    optional<generic_task_result> get_current_task(worker_info & w);
 
-    generic_task_result dequeue();
+    bool try_dequeue(unsigned queue_idx, worker_info & w, generic_task_result & result);
     void enqueue(generic_task_result const &);
+    void push_ready(generic_task_result const &);
+    unsigned get_local_queue();
 
     bool check_deps(generic_task_result const &);
+    bool fail(generic_task_result const &, std::exception_ptr const & ex);
     void propagate_failure(generic_task_result const &);
     void submit(generic_task_result const &) override;
     void bump_prio(generic_task_result const &, task_priority const &);
@@ -474,18 +474,18 @@ void native_compile_module(environment const & env) {
 // Setup for the storage of native modules to .olean files.
 static std::string *g_native_module_key = nullptr;
 
-static void native_module_reader(
-    deserializer & d,
-    environment & /* env */) {
+static module_modification native_module_reader(deserializer & d) {
     name fn;
     d >> fn;
-    std::cout << "reading native module from meta-data: " << fn << std::endl;
-    // senv.update([&](environment const & env) -> environment {
-    //     vm_decls ext = get_extension(env);
-    //     // ext.update(fn, code_sz, code.data());
-    //     // return update(env, ext);
-    //     return
-    // });
+    return [=](environment & /* env */) {
+        std::cout << "reading native module from meta-data: " << fn << std::endl;
+        // senv.update([&](environment const & env) -> environment {
+        //     vm_decls ext = get_extension(env);
+        //     // ext.update(fn, code_sz, code.data());
+        //     // return update(env, ext);
+        //     return
+        // });
+    };
 }
 
 environment set_native_module_path(environment & env, name const & n) {
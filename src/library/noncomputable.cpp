@@ -38,12 +38,14 @@ static environment update(environment const & env, noncomputable_ext const & ext
 static name * g_noncomputable = nullptr;
 static std::string * g_key    = nullptr;
 
-static void noncomputable_reader(deserializer & d, environment & env) {
+static module_modification noncomputable_reader(deserializer & d) {
     name n;
     d >> n;
-    noncomputable_ext ext = get_extension(env);
-    ext.m_noncomputable.insert(n);
-    env = update(env, ext);
+    return [=](environment & env) {
+        noncomputable_ext ext = get_extension(env);
+        ext.m_noncomputable.insert(n);
+        env = update(env, ext);
+    };
 }
 
 static bool is_noncomputable(type_checker & tc, noncomputable_ext const & ext, name const & n) {
@@ -56,14 +56,16 @@ pair<environment, name> add_private_name(environment const & env, name const & n
     return mk_pair(new_env, r);
 }
 
-static void private_reader(deserializer & d, environment & env) {
+static module_modification private_reader(deserializer & d) {
     name n, h;
     d >> n >> h;
-    private_ext ext = get_extension(env);
-    // we restore only the mapping hidden-name -> user-name (for pretty printing purposes)
-    ext.m_inv_map.insert(h, n);
-    ext.m_counter++;
-    env = update(env, ext);
+    return [=](environment & env) {
+        private_ext ext = get_extension(env);
+        // we restore only the mapping hidden-name -> user-name (for pretty printing purposes)
+        ext.m_inv_map.insert(h, n);
+        ext.m_counter++;
+        env = update(env, ext);
+    };
 }
 
 optional<name> hidden_to_user_name(environment const & env, name const & n) {
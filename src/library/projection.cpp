@@ -63,10 +63,12 @@ name_map<projection_info> const & get_projection_info_map(environment const & en
     return get_extension(env).m_info;
 }
 
-static void projection_info_reader(deserializer & d, environment & env) {
+static module_modification projection_info_reader(deserializer & d) {
     name p, mk; unsigned nparams, i; bool inst_implicit;
     d >> p >> mk >> nparams >> i >> inst_implicit;
-    env = save_projection_info_core(env, p, mk, nparams, i, inst_implicit);
+    return [=](environment & env) {
+        env = save_projection_info_core(env, p, mk, nparams, i, inst_implicit);
+    };
 }
 
 /** \brief Return true iff the type named \c S can be viewed as
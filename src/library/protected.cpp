@@ -37,12 +37,14 @@ environment add_protected(environment const & env, name const & n) {
     return module::add(new_env, *g_prt_key, [=](environment const &, serializer & s) { s << n; });
 }
 
-static void protected_reader(deserializer & d, environment & env) {
+static module_modification protected_reader(deserializer & d) {
     name n;
     d >> n;
-    protected_ext ext = get_extension(env);
-    ext.m_protected.insert(n);
-    env = update(env, ext);
+    return [=](environment & env) {
+        protected_ext ext = get_extension(env);
+        ext.m_protected.insert(n);
+        env = update(env, ext);
+    };
 }
 
 bool is_protected(environment const & env, name const & n) {
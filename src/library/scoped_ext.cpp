@@ -118,12 +118,14 @@ environment push_scope(environment const & env, io_state const & ios, scope_kind
     return r;
 }
 
-static void namespace_reader(deserializer & d, environment & env) {
+static module_modification namespace_reader(deserializer & d) {
     name n;
     d >> n;
-    scope_mng_ext ext = get_extension(env);
-    ext.m_namespace_set.insert(n);
-    env = update(env, ext);
+    return [=](environment & env) {
+        scope_mng_ext ext = get_extension(env);
+        ext.m_namespace_set.insert(n);
+        env = update(env, ext);
+    };
 }
 
 environment pop_scope_core(environment const & env, io_state const & ios) {
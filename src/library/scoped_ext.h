@@ -173,9 +173,11 @@ public:
         }
     }
 
-    static void reader(deserializer & d, environment & env) {
+    static module_modification reader(deserializer & d) {
         entry e = read_entry(d);
-        env = register_entry(env, get_global_ios(), e);
+        return [=](environment & env) {
+            env = register_entry(env, get_global_ios(), e);
+        };
     }
     static state const & get_state(environment const & env) {
         return get(env).m_state;
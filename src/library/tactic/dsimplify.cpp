@@ -213,10 +213,9 @@ optional<pair<expr, bool>> dsimplify_fn::post(expr const & e) {
     while (true) {
         check_system("dsimplify");
         inc_num_steps();
-        list<simp_lemma> const * simp_lemmas_ptr = m_simp_lemmas.find(curr_e);
-        if (!simp_lemmas_ptr) break;
         buffer<simp_lemma> simp_lemmas;
-        to_buffer(*simp_lemmas_ptr, simp_lemmas);
+        m_index.find(m_ctx, m_simp_lemmas, curr_e, simp_lemmas);
+        if (simp_lemmas.empty()) break;
 
         expr new_e = curr_e;
         for (simp_lemma const & sl : simp_lemmas) {
@@ -237,7 +236,7 @@ optional<pair<expr, bool>> dsimplify_fn::post(expr const & e) {
 
 dsimplify_fn::dsimplify_fn(type_context & ctx, unsigned max_steps, bool visit_instances, simp_lemmas_for const & lemmas):
     dsimplify_core_fn(ctx, max_steps, visit_instances),
-    m_simp_lemmas(lemmas) {
+    m_simp_lemmas(lemmas), m_index(ctx) {
 }
 
 class tactic_dsimplify_fn : public dsimplify_core_fn {
@@ -36,7 +36,8 @@ public:
 };
 
 class dsimplify_fn : public dsimplify_core_fn {
-    simp_lemmas_for m_simp_lemmas;
+    simp_lemmas_for     m_simp_lemmas;
+    simp_lemma_index_fn m_index;
     virtual optional<pair<expr, bool>> pre(expr const & e) override;
     virtual optional<pair<expr, bool>> post(expr const & e) override;
 public:
@@ -81,10 +81,12 @@ bool has_eqn_lemmas(environment const & env, name const & cname) {
     return ext.m_lemmas.contains(cname);
 }
 
-static void eqn_lemmas_reader(deserializer & d, environment & env) {
+static module_modification eqn_lemmas_reader(deserializer & d) {
     name lemma;
     d >> lemma;
-    env = add_eqn_lemma_core(env, lemma);
+    return [=](environment & env) {
+        env = add_eqn_lemma_core(env, lemma);
+    };
 }
 
 void initialize_eqn_lemmas() {
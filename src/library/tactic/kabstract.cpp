@@ -130,12 +130,14 @@ void for_each_key_equivalence(environment const & env, std::function<void(buffer
         });
 }
 
-static void key_equivalence_reader(deserializer & d, environment & env) {
+static module_modification key_equivalence_reader(deserializer & d) {
     name n1, n2;
     d >> n1 >> n2;
-    key_equivalence_ext ext = get_extension(env);
-    ext.add_alias(n1, n2);
-    env = update(env, ext);
+    return [=](environment & env) {
+        key_equivalence_ext ext = get_extension(env);
+        ext.add_alias(n1, n2);
+        env = update(env, ext);
+    };
 }
 
 expr kabstract(type_context & ctx, expr const & e, expr const & t, occurrences const & occs) {
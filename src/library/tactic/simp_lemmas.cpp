@@ -6,6 +6,8 @@ Author: Leonardo de Moura
 */
 #include <vector>
 #include <algorithm>
+#include "util/thread.h"
+#include "util/sexpr/option_declarations.h"
 #include "kernel/error_msgs.h"
 #include "kernel/instantiate.h"
 #include "kernel/for_each_fn.h"
@@ -14,6 +16,8 @@ Author: Leonardo de Moura
 #include "library/trace.h"
 #include "library/util.h"
 #include "library/reducible.h"
+#include "library/unification_hint.h"
+#include "library/fun_info.h"
 #include "library/attribute_manager.h"
 #include "library/relation_manager.h"
 #include "library/vm/vm_expr.h"
@@ -24,9 +28,38 @@ Author: Leonardo de Moura
 #include "library/tactic/simp_lemmas.h"
 #include "library/tactic/tactic_state.h"
 
+#ifndef LEAN_SIMP_LEMMAS_CACHE_SLOTS
+#define LEAN_SIMP_LEMMAS_CACHE_SLOTS 4
+#endif
+
+#ifndef LEAN_DEFAULT_SIMP_LEMMAS_INDEX
+#define LEAN_DEFAULT_SIMP_LEMMAS_INDEX true
+#endif
+
 namespace lean {
 LEAN_THREAD_VALUE(bool, g_throw_ex, false);
 
+static name * g_simp_lemmas_index = nullptr;
+
+static bool get_simp_lemmas_index(options const & o) {
+    return o.get_bool(*g_simp_lemmas_index, LEAN_DEFAULT_SIMP_LEMMAS_INDEX);
+}
+
+/* Return the head constant of \c e, or the anonymous name if the head is not a constant. */
+static name get_key(expr const & e) {
+    expr const & fn = get_app_fn(e);
+    return is_constant(fn) ? const_name(fn) : name();
+}
+
+static list<name> mk_arg_keys(expr const & e) {
+    buffer<expr> args;
+    get_app_args(e, args);
+    buffer<name> keys;
+    for (expr const & arg : args)
+        keys.push_back(get_key(arg));
+    return to_list(keys);
+}
+
 struct simp_lemma_cell {
     simp_lemma_kind     m_kind;
     name                m_id;
@@ -37,6 +70,8 @@ struct simp_lemma_cell {
     expr                m_lhs;
     expr                m_rhs;
     unsigned            m_priority;
+    /* Head constants of the arguments of m_lhs, see simp_lemma_index_fn */
+    list<name>          m_arg_keys;
     MK_LEAN_RC(); // Declare m_rc counter
     void dealloc();
     simp_lemma_cell():m_kind(simp_lemma_kind::Simp) {}
@@ -45,7 +80,7 @@ struct simp_lemma_cell {
                     list<bool> const & instances, expr const & lhs, expr const & rhs,
                     unsigned priority):
         m_kind(k), m_id(id), m_umetas(umetas), m_emetas(emetas), m_instances(instances),
-        m_lhs(lhs), m_rhs(rhs), m_priority(priority), m_rc(0) {}
+        m_lhs(lhs), m_rhs(rhs), m_priority(priority), m_arg_keys(mk_arg_keys(lhs)), m_rc(0) {}
 };
 
 struct simp_lemma_with_proof_cell : public simp_lemma_cell {
@@ -154,6 +189,10 @@ unsigned simp_lemma::get_priority() const {
     return m_ptr->m_priority;
 }
 
+list<name> const & simp_lemma::get_arg_keys() const {
+    return m_ptr->m_arg_keys;
+}
+
 expr const & simp_lemma::get_lhs() const {
     return m_ptr->m_lhs;
 }
@@ -253,6 +292,68 @@ list<simp_lemma> const * simp_lemmas_for::find(head_index const & h) const {
     return m_simp_set.find(h);
 }
 
+simp_lemma_index_fn::simp_lemma_index_fn(type_context & ctx):
+    m_enabled(get_simp_lemmas_index(ctx.get_options()) && get_unification_hints(ctx.env()).empty()) {
+}
+
+bool simp_lemma_index_fn::may_match(environment const & env, list<name> const & arg_keys) const {
+    if (length(arg_keys) != m_keys.size())
+        return true;
+    unsigned i = 0;
+    for (name const & k : arg_keys) {
+        name const & k_e = m_keys[i];
+        i++;
+        if (!k.is_anonymous() && !k_e.is_anonymous() && k != k_e &&
+            is_rigid_head_symbol(env, k) && is_rigid_head_symbol(env, k_e))
+            return false;
+    }
+    return true;
+}
+
+void simp_lemma_index_fn::collect(type_context & ctx, list<simp_lemma> const * lemmas, expr const & e,
+                                  buffer<simp_lemma> & r) {
+    if (!lemmas)
+        return;
+    if (!m_enabled || (ctx.mode() != transparency_mode::Reducible && ctx.mode() != transparency_mode::None)) {
+        to_buffer(*lemmas, r);
+        return;
+    }
+    buffer<expr> args;
+    expr const & fn = get_app_args(e, args);
+    if (!is_constant(fn)) {
+        to_buffer(*lemmas, r);
+        return;
+    }
+    /* As in discr_tree, we ignore propositions (proof irrelevance), implicit and inst-implicit arguments */
+    fun_info info = get_fun_info(ctx, fn, args.size());
+    m_keys.clear();
+    unsigned i = 0;
+    for (param_info const & pinfo : info.get_params_info()) {
+        if (pinfo.is_prop() || pinfo.is_inst_implicit() || pinfo.is_implicit())
+            m_keys.push_back(name());
+        else
+            m_keys.push_back(get_key(args[i]));
+        i++;
+    }
+    for (; i < args.size(); i++)
+        m_keys.push_back(get_key(args[i]));
+    for (simp_lemma const & sl : *lemmas) {
+        if (may_match(ctx.env(), sl.get_arg_keys()))
+            r.push_back(sl);
+        else
+            m_num_skipped++;
+    }
+}
+
+void simp_lemma_index_fn::find(type_context & ctx, simp_lemmas_for const & s, expr const & e, buffer<simp_lemma> & r) {
+    collect(ctx, s.find(e), e, r);
+}
+
+void simp_lemma_index_fn::find_congr(type_context & ctx, simp_lemmas_for const & s, expr const & e,
+                                     buffer<simp_lemma> & r) {
+    collect(ctx, s.find_congr(e), e, r);
+}
+
 void simp_lemmas_for::for_each(std::function<void(simp_lemma const &)> const & fn) const {
     m_simp_set.for_each_entry([&](head_index const &, simp_lemma const & r) { fn(r); });
 }
@@ -937,32 +1038,6 @@ static void on_add_congr_lemma(environment const & env, name const & c, bool) {
     add_congr_core(ctx, s, c, LEAN_DEFAULT_PRIORITY);
 }
 
-static simp_lemmas get_simp_lemmas_from_attribute(type_context & ctx, name const & attr_name, simp_lemmas result) {
-    auto const & attr = get_attribute(ctx.env(), attr_name);
-    buffer<name> simp_lemmas;
-    attr.get_instances(ctx.env(), simp_lemmas);
-    unsigned i = simp_lemmas.size();
-    while (i > 0) {
-        i--;
-        name const & id = simp_lemmas[i];
-        result = add_core(ctx, result, id, attr.get_prio(ctx.env(), id));
-    }
-    return result;
-}
-
-static simp_lemmas get_congr_lemmas_from_attribute(type_context & ctx, name const & attr_name, simp_lemmas result) {
-    auto const & attr = get_attribute(ctx.env(), attr_name);
-    buffer<name> congr_lemmas;
-    attr.get_instances(ctx.env(), congr_lemmas);
-    unsigned i = congr_lemmas.size();
-    while (i > 0) {
-        i--;
-        name const & id = congr_lemmas[i];
-        result = add_congr_core(ctx, result, id, attr.get_prio(ctx.env(), id));
-    }
-    return result;
-}
-
 struct simp_lemmas_config {
     std::vector<name> m_simp_attrs;
     std::vector<name> m_congr_attrs;
@@ -997,96 +1072,227 @@ static simp_lemmas_config const & get_simp_lemmas_config(simp_lemmas_token tk) {
     return (*g_simp_lemmas_configs)[tk];
 }
 
-/* This is the cache for internally used simp_lemma collections */
+/* This is the cache for internally used simp_lemma collections.
+
+   It is shared by all threads, and it keeps up to LEAN_SIMP_LEMMAS_CACHE_SLOTS collections for each
+   transparency mode and token. This is important when the threads process different files, or different
+   points of the same file. When the attributes of a collection change, the cached collection is
+   updated by erasing/adding the lemmas for the declarations whose attribute was added, removed or whose
+   priority changed, instead of rebuilding the whole collection (see update_lemmas). */
 class simp_lemmas_cache {
     struct entry {
         environment           m_env;
         std::vector<unsigned> m_fingerprints;
+        /* Declarations tagged with each attribute, and their priorities, when m_lemmas was computed */
+        std::vector<name_map<unsigned>> m_instances;
         unsigned              m_reducibility_fingerprint;
         optional<simp_lemmas> m_lemmas;
+        unsigned              m_last_used;
         entry(environment const & env):
-            m_env(env), m_reducibility_fingerprint(0) {}
+            m_env(env), m_reducibility_fingerprint(0), m_last_used(0) {}
     };
-    std::vector<entry>        m_entries[4];
+    typedef std::vector<entry> slots;
+    mutex                     m_mutex;
+    std::vector<slots>        m_entries[4];
+    unsigned                  m_timestamp{0};
 
-public:
-    void expand(environment const & env, transparency_mode m, unsigned new_sz) {
-        unsigned midx = static_cast<unsigned>(m);
-        for (unsigned tk = m_entries[midx].size(); tk < new_sz; tk++) {
-            auto & cfg   = get_simp_lemmas_config(tk);
-            m_entries[midx].emplace_back(env);
-            auto & entry = m_entries[midx].back();
-            entry.m_fingerprints.resize(cfg.m_simp_attrs.size() + cfg.m_congr_attrs.size());
-        }
+    static std::vector<name> get_attrs(simp_lemmas_token tk) {
+        auto & cfg = get_simp_lemmas_config(tk);
+        std::vector<name> r(cfg.m_simp_attrs);
+        r.insert(r.end(), cfg.m_congr_attrs.begin(), cfg.m_congr_attrs.end());
+        return r;
+    }
+
+    static simp_lemmas add_lemma(type_context & ctx, simp_lemmas_token tk, unsigned attr_idx, simp_lemmas const & s,
+                                 name const & id, unsigned prio) {
+        if (attr_idx < get_simp_lemmas_config(tk).m_simp_attrs.size())
+            return add_core(ctx, s, id, prio);
+        else
+            return add_congr_core(ctx, s, id, prio);
     }
 
-    simp_lemmas mk_lemmas(environment const & env, transparency_mode m, entry & C, simp_lemmas_token tk) {
+    static void mk_lemmas(environment const & env, transparency_mode m, entry & C, simp_lemmas_token tk) {
         lean_trace("simp_lemmas_cache", tout() << "make simp lemmas [" << tk << "]\n";);
         type_context ctx(env, m);
-        C.m_env = env;
-        auto & cfg = get_simp_lemmas_config(tk);
+        std::vector<name> attrs = get_attrs(tk);
         simp_lemmas lemmas;
-        unsigned i = 0;
-        for (name const & attr_name : cfg.m_simp_attrs) {
-            lemmas = get_simp_lemmas_from_attribute(ctx, attr_name, lemmas);
-            C.m_fingerprints[i] = get_attribute_fingerprint(env, attr_name);
-            i++;
-        }
-        for (name const & attr_name : cfg.m_congr_attrs) {
-            lemmas = get_congr_lemmas_from_attribute(ctx, attr_name, lemmas);
-            C.m_fingerprints[i] = get_attribute_fingerprint(env, attr_name);
-            i++;
+        for (unsigned i = 0; i < attrs.size(); i++) {
+            auto const & attr = get_attribute(env, attrs[i]);
+            buffer<name> ids;
+            attr.get_instances(env, ids);
+            name_map<unsigned> instances;
+            unsigned j = ids.size();
+            while (j > 0) {
+                j--;
+                unsigned prio = attr.get_prio(env, ids[j]);
+                lemmas = add_lemma(ctx, tk, i, lemmas, ids[j], prio);
+                instances.insert(ids[j], prio);
+            }
+            C.m_fingerprints[i] = get_attribute_fingerprint(env, attrs[i]);
+            C.m_instances[i]    = instances;
         }
-        C.m_lemmas = lemmas;
+        C.m_env     = env;
+        C.m_lemmas  = lemmas;
         C.m_reducibility_fingerprint = get_reducibility_fingerprint(env);
-        return lemmas;
     }
 
-    simp_lemmas lemmas_of(entry const & C, simp_lemmas_token tk) {
-        lean_trace("simp_lemmas_cache", tout() << "reusing cached simp lemmas [" << tk << "]\n";);
-        return *C.m_lemmas;
+    /* \pre env is a descendant of C.m_env, and the reducibility fingerprints are equal
+
+       Lemmas with the same priority are tried in the order they were added, so the lemmas can only be
+       updated in place when the result is the collection mk_lemmas would produce: the erased declarations
+       must not be provided by other attributes, and the new lemmas must come after the existing ones
+       in the order used by mk_lemmas. Otherwise, the collection is rebuilt. */
+    static void update_lemmas(environment const & env, transparency_mode m, entry & C, simp_lemmas_token tk) {
+        std::vector<name> attrs = get_attrs(tk);
+        struct instance_info {
+            name     m_id;
+            unsigned m_prio;
+            bool     m_is_new;
+        };
+        /* Instances of the attributes that have been modified, in the order used by mk_lemmas */
+        std::vector<buffer<instance_info>> instances(attrs.size());
+        std::vector<name_map<unsigned>> new_instances(C.m_instances);
+        std::vector<unsigned> fingerprints(C.m_fingerprints);
+        std::vector<bool> modified(attrs.size(), false);
+        name_set to_erase;
+        for (unsigned i = 0; i < attrs.size(); i++) {
+            unsigned fingerprint = get_attribute_fingerprint(env, attrs[i]);
+            if (fingerprint == C.m_fingerprints[i])
+                continue;
+            modified[i] = true;
+            auto const & attr = get_attribute(env, attrs[i]);
+            buffer<name> ids;
+            attr.get_instances(env, ids);
+            name_map<unsigned> old_instances = C.m_instances[i];
+            new_instances[i] = name_map<unsigned>();
+            unsigned j = ids.size();
+            while (j > 0) {
+                j--;
+                name const & id = ids[j];
+                unsigned prio = attr.get_prio(env, id);
+                new_instances[i].insert(id, prio);
+                bool is_new = true;
+                if (unsigned const * old_prio = old_instances.find(id)) {
+                    if (*old_prio != prio)
+                        to_erase.insert(id);
+                    else
+                        is_new = false;
+                    old_instances.erase(id);
+                }
+                instances[i].push_back(instance_info{id, prio, is_new});
+            }
+            /* the remaining old instances are not tagged anymore */
+            old_instances.for_each([&](name const & id, unsigned) { to_erase.insert(id); });
+            fingerprints[i] = fingerprint;
+        }
+        bool in_place   = true;
+        bool found_new  = false;
+        for (unsigned i = 0; i < attrs.size() && in_place; i++) {
+            if (modified[i]) {
+                for (instance_info const & info : instances[i]) {
+                    if (info.m_is_new)
+                        found_new = true;
+                    else if (found_new || to_erase.contains(info.m_id))
+                        in_place = false;
+                }
+            } else {
+                C.m_instances[i].for_each([&](name const & id, unsigned) {
+                        if (found_new || to_erase.contains(id))
+                            in_place = false;
+                    });
+            }
+        }
+        if (!in_place) {
+            mk_lemmas(env, m, C, tk);
+            return;
+        }
+        lean_trace("simp_lemmas_cache", tout() << "update simp lemmas [" << tk << "]\n";);
+        type_context ctx(env, m);
+        simp_lemmas lemmas = *C.m_lemmas;
+        if (!to_erase.empty())
+            lemmas.erase(to_erase);
+        for (unsigned i = 0; i < attrs.size(); i++) {
+            for (instance_info const & info : instances[i]) {
+                if (info.m_is_new)
+                    lemmas = add_lemma(ctx, tk, i, lemmas, info.m_id, info.m_prio);
+            }
+        }
+        C.m_env          = env;
+        C.m_lemmas       = lemmas;
+        C.m_fingerprints = fingerprints;
+        C.m_instances    = new_instances;
     }
 
-    bool is_compatible(entry const & C, environment const & env, simp_lemmas_token tk) {
-        if (!env.is_descendant(C.m_env))
-            return false;
-        if (get_reducibility_fingerprint(env) != C.m_reducibility_fingerprint)
-            return false;
-        auto & cfg = get_simp_lemmas_config(tk);
-        unsigned i = 0;
-        for (name const & attr_name : cfg.m_simp_attrs) {
-            if (get_attribute_fingerprint(env, attr_name) != C.m_fingerprints[i])
-                return false;
-            i++;
-        }
-        for (name const & attr_name : cfg.m_congr_attrs) {
-            if (get_attribute_fingerprint(env, attr_name) != C.m_fingerprints[i])
+    static bool is_compatible(entry const & C, environment const & env, simp_lemmas_token tk) {
+        std::vector<name> attrs = get_attrs(tk);
+        for (unsigned i = 0; i < attrs.size(); i++) {
+            if (get_attribute_fingerprint(env, attrs[i]) != C.m_fingerprints[i])
                 return false;
-            i++;
         }
         return true;
     }
 
+public:
     simp_lemmas get(environment const & env, transparency_mode m, simp_lemmas_token tk) {
         lean_assert(tk < g_simp_lemmas_configs->size());
         unsigned midx = static_cast<unsigned>(m);
-        if (tk >= m_entries[midx].size()) expand(env, m, tk+1);
-        lean_assert(tk < m_entries[midx].size());
-        entry & C = m_entries[midx][tk];
-        if (!C.m_lemmas) return mk_lemmas(env, m, C, tk);
-        if (is_eqp(env, C.m_env)) return lemmas_of(C, tk);
-        if (!is_compatible(C, env, tk)) {
+        unsigned reducibility_fingerprint = get_reducibility_fingerprint(env);
+        entry C(env);
+        {
+            lock_guard<mutex> lock(m_mutex);
+            if (tk >= m_entries[midx].size())
+                m_entries[midx].resize(tk + 1);
+            slots & S = m_entries[midx][tk];
+            optional<unsigned> best;
+            for (unsigned i = 0; i < S.size(); i++) {
+                if (is_eqp(env, S[i].m_env)) {
+                    lean_trace("simp_lemmas_cache", tout() << "reusing cached simp lemmas [" << tk << "]\n";);
+                    S[i].m_last_used = ++m_timestamp;
+                    return *S[i].m_lemmas;
+                }
+                if (env.is_descendant(S[i].m_env) &&
+                    S[i].m_reducibility_fingerprint == reducibility_fingerprint &&
+                    (!best || S[*best].m_last_used < S[i].m_last_used))
+                    best = i;
+            }
+            if (best) {
+                S[*best].m_last_used = ++m_timestamp;
+                C = S[*best];
+            }
+        }
+        if (C.m_lemmas) {
+            if (is_compatible(C, env, tk)) {
+                lean_trace("simp_lemmas_cache", tout() << "reusing cached simp lemmas [" << tk << "]\n";);
+                return *C.m_lemmas;
+            }
+            update_lemmas(env, m, C, tk);
+        } else {
             lean_trace("simp_lemmas_cache", tout() << "creating new cache\n";);
-            return mk_lemmas(env, m, C, tk);
+            C.m_fingerprints.resize(get_attrs(tk).size());
+            C.m_instances.resize(C.m_fingerprints.size());
+            mk_lemmas(env, m, C, tk);
         }
-        return lemmas_of(C, tk);
+        /* The lemmas are computed without holding the lock, and stored in a new slot.
+           When all slots are used, we replace the least recently used one. */
+        lock_guard<mutex> lock(m_mutex);
+        slots & S = m_entries[midx][tk];
+        C.m_last_used = ++m_timestamp;
+        if (S.size() >= LEAN_SIMP_LEMMAS_CACHE_SLOTS) {
+            auto lru = std::min_element(S.begin(), S.end(), [](entry const & e1, entry const & e2) {
+                    return e1.m_last_used < e2.m_last_used;
+                });
+            *lru = C;
+        } else {
+            S.push_back(C);
+        }
+        return *C.m_lemmas;
     }
 };
 
-MK_THREAD_LOCAL_GET_DEF(simp_lemmas_cache, get_cache);
+static simp_lemmas_cache * g_simp_lemmas_cache = nullptr;
 
 simp_lemmas get_simp_lemmas(environment const & env, transparency_mode m, simp_lemmas_token tk) {
-    return get_cache().get(env, m, tk);
+    return g_simp_lemmas_cache->get(env, m, tk);
 }
 
 simp_lemmas get_default_simp_lemmas(environment const & env, transparency_mode m) {
@@ -1337,12 +1543,13 @@ vm_obj simp_lemmas_rewrite_core(transparency_mode const & m, simp_lemmas const &
     simp_lemmas_for const * sr = sls.find(R);
     if (!sr) return mk_tactic_exception("failed to apply simp_lemmas, no lemmas for the given relation", s);
 
-    list<simp_lemma> const * srs = sr->find(e);
-    if (!srs) return mk_tactic_exception("failed to apply simp_lemmas, no simp lemma", s);
+    if (!sr->find(e)) return mk_tactic_exception("failed to apply simp_lemmas, no simp lemma", s);
 
     type_context ctx = mk_type_context_for(s, m);
+    buffer<simp_lemma> srs;
+    simp_lemma_index_fn(ctx).find(ctx, *sr, e, srs);
 
-    for (simp_lemma const & lemma : *srs) {
+    for (simp_lemma const & lemma : srs) {
         simp_result r = simp_lemma_rewrite(ctx, lemma, prove_fn, e);
         if (!is_eqp(r.get_new(), e)) {
             lean_trace("simp_lemmas", scope_trace_env scope(ctx.env(), ctx);
@@ -1367,12 +1574,13 @@ vm_obj simp_lemmas_drewrite_core(transparency_mode const & m, simp_lemmas const
     simp_lemmas_for const * sr = sls.find(get_eq_name());
     if (!sr) return mk_tactic_exception("failed to apply simp_lemmas, no lemmas for 'eq' relation", s);
 
-    list<simp_lemma> const * srs = sr->find(e);
-    if (!srs) return mk_tactic_exception("failed to apply simp_lemmas, no simp lemma", s);
+    if (!sr->find(e)) return mk_tactic_exception("failed to apply simp_lemmas, no simp lemma", s);
 
     type_context ctx = mk_type_context_for(s, m);
+    buffer<simp_lemma> srs;
+    simp_lemma_index_fn(ctx).find(ctx, *sr, e, srs);
 
-    for (simp_lemma const & lemma : *srs) {
+    for (simp_lemma const & lemma : srs) {
         if (lemma.is_refl()) {
             expr new_e = refl_lemma_rewrite(ctx, e, lemma);
             if (new_e != e)
@@ -1434,10 +1642,15 @@ environment mark_rfl_lemma(environment const & env, name const & cname) {
 void initialize_simp_lemmas() {
     g_dummy               = new simp_lemma_cell();
     g_simp_lemmas_configs = new std::vector<simp_lemmas_config>();
+    g_simp_lemmas_cache   = new simp_lemmas_cache();
     g_name2simp_token     = new name_map<unsigned>();
     g_default_token       = register_simp_attribute("default", {"simp", "wrapper_eq"}, {"congr"});
     g_refl_lemma_attr     = new name{"_refl_lemma"};
     register_trace_class("simp_lemmas");
+    g_simp_lemmas_index = new name{"simp_lemmas", "index"};
+    register_bool_option(*g_simp_lemmas_index, LEAN_DEFAULT_SIMP_LEMMAS_INDEX,
+                         "(simp) skip simp lemmas whose left-hand-side cannot match the term being simplified "
+                         "by comparing the head symbols of the arguments, before invoking the unifier");
     register_trace_class("simp_lemmas_cache");
     register_trace_class(name{"simp_lemmas", "failure"});
     register_system_attribute(basic_attribute(
@@ -1458,7 +1671,9 @@ void initialize_simp_lemmas() {
 }
 
 void finalize_simp_lemmas() {
+    delete g_simp_lemmas_cache;
     delete g_simp_lemmas_configs;
+    delete g_simp_lemmas_index;
     delete g_name2simp_token;
     delete g_dummy;
     delete g_refl_lemma_attr;
@@ -56,6 +56,10 @@ public:
     expr const & get_lhs() const;
     expr const & get_rhs() const;
 
+    /** \brief Return the head constant of each argument of the left-hand-side,
+        or the anonymous name if the head is not a constant. */
+    list<name> const & get_arg_keys() const;
+
     /** \brief Return the proof for the simp_lemma.
         \pre kind() == Simp || kind() == Congr */
     expr const & get_proof() const;
@@ -98,6 +102,32 @@ public:
     void for_each_congr(std::function<void(simp_lemma const &)> const & fn) const;
 };
 
+/** \brief Imperfect discrimination of simp lemmas.
+
+    Simp lemma sets are indexed by the head symbol of the left-hand-side only, so for heads such as
+    \c eq or \c add, a term is unified with many lemmas that cannot possibly match it.
+    This object discards a lemma without invoking the unifier when there is an argument position
+    where the head constants of the left-hand-side and the term are different, and neither of them
+    can be reduced by the unifier (e.g., reducible definitions, projections, recursors, and numerals).
+
+    The test is only performed when the transparency mode of the given type context is Reducible or None,
+    there are no unification hints, and the option `simp_lemmas.index` is true. */
+class simp_lemma_index_fn {
+    bool           m_enabled;
+    buffer<name>   m_keys;
+    unsigned       m_num_skipped{0};
+    bool may_match(environment const & env, list<name> const & arg_keys) const;
+    void collect(type_context & ctx, list<simp_lemma> const * lemmas, expr const & e, buffer<simp_lemma> & r);
+public:
+    simp_lemma_index_fn(type_context & ctx);
+    /* Store in \c r the Simp/Refl lemmas in \c s that may match \c e, in priority order */
+    void find(type_context & ctx, simp_lemmas_for const & s, expr const & e, buffer<simp_lemma> & r);
+    /* Store in \c r the Congr lemmas in \c s that may match \c e, in priority order */
+    void find_congr(type_context & ctx, simp_lemmas_for const & s, expr const & e, buffer<simp_lemma> & r);
+    /* Number of lemmas discarded so far */
+    unsigned get_num_skipped() const { return m_num_skipped; }
+};
+
 /** \brief Collection of simplification and congruence lemmas for different equivalence relations.
     \remark Refl lemmas are use only for eq */
 class simp_lemmas {
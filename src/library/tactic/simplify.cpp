@@ -213,10 +213,11 @@ simp_result simplify_core_fn::try_user_congrs(expr const & e) {
     simp_lemmas_for const * sls = m_slss.find(m_rel);
     if (!sls) return simp_result(e);
 
-    list<simp_lemma> const * cls = sls->find_congr(e);
-    if (!cls) return simp_result(e);
+    buffer<simp_lemma> cls;
+    m_index.find_congr(m_ctx, *sls, e, cls);
 
-    for (simp_lemma const & cl : *cls) {
+    for (simp_lemma const & cl : cls) {
+        m_num_lemmas_tried++;
         simp_result r = try_user_congr(e, cl);
         if (r.get_new() != e)
             return r;
@@ -476,12 +477,11 @@ simp_result simplify_core_fn::rewrite(expr const & e) {
     simp_lemmas_for const * sr = m_slss.find(m_rel);
     if (!sr) return simp_result(e);
 
-    list<simp_lemma> const * srs = sr->find(e);
-    if (!srs) {
-        return simp_result(e);
-    }
+    buffer<simp_lemma> srs;
+    m_index.find(m_ctx, *sr, e, srs);
 
-    for (simp_lemma const & lemma : *srs) {
+    for (simp_lemma const & lemma : srs) {
+        m_num_lemmas_tried++;
         simp_result r = rewrite(e, lemma);
         if (!is_eqp(r.get_new(), e)) {
             lean_trace_d(name({"simplify", "rewrite"}), tout() << "[" << lemma.get_id() << "]: " << e
@@ -700,7 +700,7 @@ optional<pair<simp_result, bool>> simplify_core_fn::post(expr const &, optional<
 simplify_core_fn::simplify_core_fn(type_context & ctx, simp_lemmas const & slss,
                                    unsigned max_steps, bool contextual, bool lift_eq,
                                    bool canonize_instances, bool canonize_proofs):
-    m_ctx(ctx), m_slss(slss), m_max_steps(max_steps), m_contextual(contextual),
+    m_ctx(ctx), m_slss(slss), m_index(m_ctx), m_max_steps(max_steps), m_contextual(contextual),
     m_lift_eq(lift_eq), m_canonize_instances(canonize_instances), m_canonize_proofs(canonize_proofs) {
 }
 
@@ -711,8 +711,12 @@ simp_result simplify_core_fn::operator()(name const & rel, expr const & e) {
     while (true) {
         m_need_restart = false;
         r = join(r, visit(r.get_new(), none_expr()));
-        if (!m_need_restart || !should_defeq_canonize())
+        if (!m_need_restart || !should_defeq_canonize()) {
+            lean_simp_trace(m_ctx, name({"simplify", "index"}),
+                            tout() << "lemmas tried: " << m_num_lemmas_tried
+                            << ", skipped by index: " << m_index.get_num_skipped() << "\n";);
             return r;
+        }
         m_cache.clear();
     }
 }
@@ -1088,6 +1092,7 @@ void initialize_simplify() {
     register_trace_class(name({"simplify", "congruence"}));
     register_trace_class(name({"simplify", "rewrite"}));
     register_trace_class(name({"simplify", "perm"}));
+    register_trace_class(name({"simplify", "index"}));
     register_trace_class(name({"debug", "simplify", "try_rewrite"}));
     register_trace_class(name({"debug", "simplify", "try_congruence"}));
 
@@ -37,10 +37,12 @@ protected:
     type_context              m_ctx;
     name                      m_rel;
     simp_lemmas               m_slss;
+    simp_lemma_index_fn       m_index;
     simplify_cache            m_cache;
 
     /* Logging */
     unsigned                  m_num_steps{0};
+    unsigned                  m_num_lemmas_tried{0};
     bool                      m_need_restart{false};
 
     /* Options */
@@ -66,7 +66,8 @@ static environment add_user_attr(environment const & env, name const & d) {
     if (!is_constant(ty, get_user_attribute_name()) && !is_constant(get_app_fn(ty), get_caching_user_attribute_name()))
         throw exception("invalid attribute.register argument, must be name of a definition of type user_attribute");
 
-    vm_state vm(env, options());
+    pooled_vm_state pooled_vm(env, options());
+    vm_state & vm = *pooled_vm;
     vm_obj o = vm.invoke(d, {});
     name const & n = to_name(cfield(o, 0));
     if (n.is_anonymous())
@@ -80,10 +81,12 @@ static environment add_user_attr(environment const & env, name const & d) {
     return update(env, ext);
 }
 
-static void user_attr_reader(deserializer & d, environment & env) {
+static module_modification user_attr_reader(deserializer & d) {
     name n;
     d >> n;
-    env = add_user_attr(env, n);
+    return [=](environment & env) {
+        env = add_user_attr(env, n);
+    };
 }
 
 
@@ -24,6 +24,8 @@ bool execute_task_with_scopes(generic_task_result_cell * task) {
             throw;
         } catch (interrupted) {
             throw;
+        } catch (reported_task_exception &) {
+            throw;
         } catch (throwable & ex) {
             environment env;
             message_builder builder(env, get_global_ios(), task->m_task->get_module_id(), task->m_task->get_pos(), ERROR);
@@ -5,10 +5,22 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Gabriel Ebner
 */
 #pragma once
+#include <string>
 #include "util/task_queue.h"
+#include "util/exception.h"
 
 namespace lean {
 
+/** \brief Exception thrown by a task that has already reported the reason of its failure.
+    execute_task_with_scopes does not report it again. */
+class reported_task_exception : public exception {
+public:
+    reported_task_exception(char const * msg):exception(msg) {}
+    reported_task_exception(std::string const & msg):exception(msg) {}
+    virtual throwable * clone() const override { return new reported_task_exception(m_msg); }
+    virtual void rethrow() const override { throw *this; }
+};
+
 bool execute_task_with_scopes(generic_task_result_cell * task);
 
 }
@@ -5,6 +5,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <algorithm>
+#include <vector>
 #include "util/flet.h"
 #include "util/interrupt.h"
 #include "util/sexpr/option_declarations.h"
@@ -40,15 +41,55 @@ Author: Leonardo de Moura
 #define LEAN_DEFAULT_NAT_OFFSET_CNSTR_THRESHOLD 256
 #endif
 
+#ifndef LEAN_DEFAULT_CLASS_GLOBAL_INSTANCE_CACHE
+#define LEAN_DEFAULT_CLASS_GLOBAL_INSTANCE_CACHE true
+#endif
+
+#ifndef LEAN_DEFAULT_CLASS_INSTANCE_INDEX
+#define LEAN_DEFAULT_CLASS_INSTANCE_INDEX true
+#endif
+
+#ifndef LEAN_TYPE_CONTEXT_CACHE_SLOTS
+#define LEAN_TYPE_CONTEXT_CACHE_SLOTS 4
+#endif
+
+#ifndef LEAN_DEFAULT_CLASS_TABLED_RESOLUTION
+#define LEAN_DEFAULT_CLASS_TABLED_RESOLUTION false
+#endif
+
+#ifndef LEAN_GLOBAL_INSTANCE_CACHE_MAX_GENERATIONS
+#define LEAN_GLOBAL_INSTANCE_CACHE_MAX_GENERATIONS 16
+#endif
+
+#ifndef LEAN_GLOBAL_INSTANCE_CACHE_MAX_ENTRIES
+#define LEAN_GLOBAL_INSTANCE_CACHE_MAX_ENTRIES 65536
+#endif
+
 namespace lean {
 static name * g_class_instance_max_depth = nullptr;
 static name * g_instance                 = nullptr;
 static name * g_nat_offset_threshold     = nullptr;
+static name * g_class_global_cache       = nullptr;
+static name * g_class_instance_index     = nullptr;
+static name * g_class_tabled_resolution  = nullptr;
+static name * g_unify                    = nullptr;
 
 unsigned get_class_instance_max_depth(options const & o) {
     return o.get_unsigned(*g_class_instance_max_depth, LEAN_DEFAULT_CLASS_INSTANCE_MAX_DEPTH);
 }
 
+bool get_class_global_instance_cache(options const & o) {
+    return o.get_bool(*g_class_global_cache, LEAN_DEFAULT_CLASS_GLOBAL_INSTANCE_CACHE);
+}
+
+bool get_class_instance_index(options const & o) {
+    return o.get_bool(*g_class_instance_index, LEAN_DEFAULT_CLASS_INSTANCE_INDEX);
+}
+
+bool get_class_tabled_resolution(options const & o) {
+    return o.get_bool(*g_class_tabled_resolution, LEAN_DEFAULT_CLASS_TABLED_RESOLUTION);
+}
+
 unsigned get_nat_offset_cnstr_threshold(options const & o) {
     return o.get_unsigned(*g_nat_offset_threshold, LEAN_DEFAULT_NAT_OFFSET_CNSTR_THRESHOLD);
 }
@@ -64,6 +105,9 @@ type_context_cache::type_context_cache(environment const & env, options const &
     m_infer_cache(use_bi) {
     m_ci_max_depth               = get_class_instance_max_depth(opts);
     m_nat_offset_cnstr_threshold = get_nat_offset_cnstr_threshold(opts);
+    m_ci_global_cache            = get_class_global_instance_cache(opts);
+    m_ci_index                   = get_class_instance_index(opts);
+    m_ci_tabled                  = get_class_tabled_resolution(opts);
     lean_trace("type_context_cache", tout() << "type_context_cache constructed\n";);
 }
 
@@ -138,45 +182,85 @@ static type_context_cache_ptr mk_cache(environment const & env, options const &
     return std::make_shared<type_context_cache>(env, o, use_bi);
 }
 
-type_context_cache_ptr type_context_cache_manager::release() {
-    type_context_cache_ptr c = m_cache_ptr;
-    m_cache_ptr.reset();
+type_context_cache_ptr type_context_cache_manager::release(unsigned i) {
+    type_context_cache_ptr c = m_slots[i].m_cache_ptr;
+    m_slots.erase(m_slots.begin() + i);
+    m_num_hits++;
+    lean_trace("type_context_cache",
+               tout() << "reusing cache, hits: " << m_num_hits << ", misses: " << m_num_misses << "\n";);
     return c;
 }
 
+void type_context_cache_manager::update_fingerprints(environment const & env) {
+    if (!is_eqp(env, m_env)) {
+        m_env                      = env;
+        m_reducibility_fingerprint = get_reducibility_fingerprint(env);
+        m_instance_fingerprint     = get_attribute_fingerprint(env, *g_instance);
+    }
+}
+
 type_context_cache_ptr type_context_cache_manager::mk(environment const & env, options const & o) {
-    if (!m_cache_ptr || get_class_instance_max_depth(o) != m_max_depth) return mk_cache(env, o, m_use_bi);
-    if (is_eqp(env, m_env)) {
-        m_cache_ptr->m_options = o;
-        return release();
-    }
-    if (!env.is_descendant(m_env) ||
-        get_reducibility_fingerprint(env) != m_reducibility_fingerprint ||
-        get_attribute_fingerprint(env, *g_instance) != m_instance_fingerprint) {
-        lean_trace("type_context_cache",
-                   bool c1 = (get_reducibility_fingerprint(env) == m_reducibility_fingerprint);
-                   bool c2 = (get_attribute_fingerprint(env, *g_instance) == m_instance_fingerprint);
-                   tout() << "creating new cache, is_descendant: " << env.is_descendant(m_env)
-                   << ", reducibility compatibility: " << c1 << ", instance compatibility: " << c2 << "\n";);
-        return mk_cache(env, o, m_use_bi);
-    }
-    m_cache_ptr->m_options = o;
-    m_cache_ptr->m_env     = env;
-    return release();
+    unsigned max_depth = get_class_instance_max_depth(o);
+    for (unsigned i = 0; i < m_slots.size(); i++) {
+        slot const & s = m_slots[i];
+        if (s.m_max_depth == max_depth && is_eqp(env, s.m_env)) {
+            s.m_cache_ptr->m_options         = o;
+            s.m_cache_ptr->m_ci_global_cache = get_class_global_instance_cache(o);
+            s.m_cache_ptr->m_ci_index        = get_class_instance_index(o);
+            s.m_cache_ptr->m_ci_tabled       = get_class_tabled_resolution(o);
+            return release(i);
+        }
+    }
+    if (!m_slots.empty()) {
+        update_fingerprints(env);
+        optional<unsigned> best;
+        for (unsigned i = 0; i < m_slots.size(); i++) {
+            slot const & s = m_slots[i];
+            if (s.m_max_depth == max_depth &&
+                s.m_reducibility_fingerprint == m_reducibility_fingerprint &&
+                s.m_instance_fingerprint == m_instance_fingerprint &&
+                env.is_descendant(s.m_env) &&
+                (!best || m_slots[*best].m_last_used < s.m_last_used))
+                best = i;
+        }
+        if (best) {
+            type_context_cache_ptr const & c = m_slots[*best].m_cache_ptr;
+            c->m_options         = o;
+            c->m_env             = env;
+            c->m_ci_global_cache = get_class_global_instance_cache(o);
+            c->m_ci_index        = get_class_instance_index(o);
+            c->m_ci_tabled       = get_class_tabled_resolution(o);
+            return release(*best);
+        }
+    }
+    m_num_misses++;
+    lean_trace("type_context_cache",
+               tout() << "creating new cache, hits: " << m_num_hits << ", misses: " << m_num_misses
+               << ", recycled caches: " << m_slots.size() << "\n";);
+    return mk_cache(env, o, m_use_bi);
 }
 
 void type_context_cache_manager::recycle(type_context_cache_ptr const & ptr) {
-    m_max_depth = ptr->m_ci_max_depth;
-    m_cache_ptr = ptr;
-    if (!is_eqp(ptr->m_env, m_env)) {
-        m_env = ptr->m_env;
-        m_reducibility_fingerprint = get_reducibility_fingerprint(ptr->m_env);
-        m_instance_fingerprint     = get_attribute_fingerprint(ptr->m_env, *g_instance);
-    }
     if (!ptr->m_instance_fingerprint) {
         ptr->m_instance_cache.clear();
         ptr->m_subsingleton_cache.clear();
     }
+    update_fingerprints(ptr->m_env);
+    slot s;
+    s.m_cache_ptr                = ptr;
+    s.m_env                      = ptr->m_env;
+    s.m_max_depth                = ptr->m_ci_max_depth;
+    s.m_reducibility_fingerprint = m_reducibility_fingerprint;
+    s.m_instance_fingerprint     = m_instance_fingerprint;
+    s.m_last_used                = ++m_timestamp;
+    if (m_slots.size() >= LEAN_TYPE_CONTEXT_CACHE_SLOTS) {
+        auto lru = std::min_element(m_slots.begin(), m_slots.end(), [](slot const & s1, slot const & s2) {
+                return s1.m_last_used < s2.m_last_used;
+            });
+        *lru = s;
+    } else {
+        m_slots.push_back(s);
+    }
 }
 
 /* =====================
@@ -2900,6 +2984,122 @@ optional<name> type_context::is_class(expr const & type) {
 
 [[ noreturn ]] static void throw_class_exception(expr const & m, char const * msg) { throw generic_exception(m, msg); }
 
+/* =====================
+   global_instance_cache
+   ===================== */
+
+/* Type class resolution for a closed type (i.e., without local constants and metavariables) in a
+   local context without local instances only depends on the environment and the type class options.
+   We share these results between all type_context objects and threads.
+
+   Entries are grouped in generations. A generation is created for a base environment, and it can be used
+   by any descendant of the base environment with the same instance, reducibility and unification hint
+   fingerprints. A result is only stored in a generation if all constants occurring in the type and instance
+   are declared in the base environment. Thus, the result is also valid in sibling environments that have
+   redefined other constants (e.g., when a file is elaborated again after the user edited it). */
+class global_instance_cache {
+    struct generation {
+        environment                     m_env;
+        unsigned                        m_fingerprint;
+        unsigned                        m_max_depth;
+        unsigned                        m_nat_offset_threshold;
+        bool                            m_tabled;
+        unsigned                        m_last_used;
+        mutex                           m_mutex;
+        expr_struct_map<optional<expr>> m_entries;
+        generation(environment const & env, unsigned fingerprint, type_context_cache const & c):
+            m_env(env), m_fingerprint(fingerprint), m_max_depth(c.m_ci_max_depth),
+            m_nat_offset_threshold(c.m_nat_offset_cnstr_threshold), m_tabled(c.m_ci_tabled), m_last_used(0) {}
+    };
+    typedef std::shared_ptr<generation> generation_ptr;
+
+    mutex                       m_mutex;
+    std::vector<generation_ptr> m_generations;
+    unsigned                    m_timestamp = 0;
+
+    static unsigned get_fingerprint(environment const & env) {
+        return hash(hash(get_attribute_fingerprint(env, *g_instance), get_attribute_fingerprint(env, *g_unify)),
+                    get_reducibility_fingerprint(env));
+    }
+
+    void get_generations(type_context_cache const & c, unsigned fingerprint, buffer<generation_ptr> & r) {
+        lock_guard<mutex> lock(m_mutex);
+        m_timestamp++;
+        for (generation_ptr const & g : m_generations) {
+            if (g->m_fingerprint == fingerprint &&
+                g->m_max_depth == c.m_ci_max_depth &&
+                g->m_nat_offset_threshold == c.m_nat_offset_cnstr_threshold &&
+                g->m_tabled == c.m_ci_tabled &&
+                c.env().is_descendant(g->m_env)) {
+                g->m_last_used = m_timestamp;
+                r.push_back(g);
+            }
+        }
+    }
+
+    generation_ptr mk_generation(type_context_cache const & c, unsigned fingerprint) {
+        generation_ptr g = std::make_shared<generation>(c.env(), fingerprint, c);
+        lock_guard<mutex> lock(m_mutex);
+        g->m_last_used = ++m_timestamp;
+        if (m_generations.size() >= LEAN_GLOBAL_INSTANCE_CACHE_MAX_GENERATIONS) {
+            auto lru = std::min_element(m_generations.begin(), m_generations.end(),
+                                        [](generation_ptr const & g1, generation_ptr const & g2) {
+                                            return g1->m_last_used < g2->m_last_used;
+                                        });
+            *lru = g;
+        } else {
+            m_generations.push_back(g);
+        }
+        return g;
+    }
+
+    static bool all_constants_declared(environment const & env, expr const & e) {
+        bool ok = true;
+        for_each(e, [&](expr const & c, unsigned) {
+                if (!ok) return false;
+                if (is_constant(c) && !env.find(const_name(c)))
+                    ok = false;
+                return true;
+            });
+        return ok;
+    }
+
+public:
+    optional<optional<expr>> find(type_context_cache const & c, expr const & type) {
+        buffer<generation_ptr> gs;
+        get_generations(c, get_fingerprint(c.env()), gs);
+        for (generation_ptr const & g : gs) {
+            lock_guard<mutex> lock(g->m_mutex);
+            auto it = g->m_entries.find(type);
+            if (it != g->m_entries.end())
+                return optional<optional<expr>>(it->second);
+        }
+        return optional<optional<expr>>();
+    }
+
+    void insert(type_context_cache const & c, expr const & type, optional<expr> const & inst) {
+        if (inst && (has_local(*inst) || has_metavar(*inst)))
+            return;
+        unsigned fingerprint = get_fingerprint(c.env());
+        buffer<generation_ptr> gs;
+        get_generations(c, fingerprint, gs);
+        generation_ptr target;
+        for (generation_ptr const & g : gs) {
+            if (all_constants_declared(g->m_env, type) && (!inst || all_constants_declared(g->m_env, *inst))) {
+                target = g;
+                break;
+            }
+        }
+        if (!target)
+            target = mk_generation(c, fingerprint);
+        lock_guard<mutex> lock(target->m_mutex);
+        if (target->m_entries.size() < LEAN_GLOBAL_INSTANCE_CACHE_MAX_ENTRIES)
+            target->m_entries.insert(mk_pair(type, inst));
+    }
+};
+
+static global_instance_cache * g_global_instance_cache = nullptr;
+
 struct instance_synthesizer {
     struct stack_entry {
         expr     m_mvar;
@@ -2924,11 +3124,20 @@ struct instance_synthesizer {
     buffer<choice>        m_choices;
     bool                  m_displayed_trace_header;
     transparency_mode     m_old_transparency_mode;
+    /* true if the result can be stored in the global instance cache */
+    bool                  m_use_global_cache;
+    /* true if instances are filtered using get_instance_arg_keys, see filter_instances */
+    bool                  m_use_index;
+    buffer<name>          m_keys;
+    unsigned              m_num_tried{0};
+    unsigned              m_num_pruned{0};
 
     instance_synthesizer(type_context & ctx):
         m_ctx(ctx),
         m_displayed_trace_header(false),
-        m_old_transparency_mode(m_ctx.m_transparency_mode) {
+        m_old_transparency_mode(m_ctx.m_transparency_mode),
+        m_use_global_cache(false),
+        m_use_index(m_ctx.m_cache->m_ci_index && get_unification_hints(m_ctx.env()).empty()) {
         lean_assert(m_ctx.in_tmp_mode());
         m_ctx.m_transparency_mode = transparency_mode::Reducible;
     }
@@ -2958,7 +3167,7 @@ struct instance_synthesizer {
 
     void trace(unsigned depth, expr const & mvar, expr const & mvar_type, expr const & r) {
         auto out = tout();
-        if (!m_displayed_trace_header && m_choices.size() == 1) {
+        if (!m_displayed_trace_header && m_choices.size() <= 1) {
             out << tclass("class_instances");
             if (m_ctx.m_cache->m_pip) {
                 if (auto fname = m_ctx.m_cache->m_pip->get_file_name()) {
@@ -2974,11 +3183,12 @@ struct instance_synthesizer {
         out << mvar << " : " << m_ctx.instantiate_mvars(mvar_type) << " := " << r << endl;
     }
 
-    /* Try to synthesize e.m_mvar using instance inst : inst_type. */
-    bool try_instance(stack_entry const & e, expr const & inst, expr const & inst_type) {
+    /* Try to synthesize \c mvar using instance inst : inst_type.
+       The metavariables for the instance implicit arguments of \c inst are stored in \c new_inst_mvars. */
+    bool try_instance_core(expr const & mvar, unsigned depth, expr const & inst, expr const & inst_type,
+                           buffer<expr> & new_inst_mvars) {
         try {
             type_context::tmp_locals locals(m_ctx);
-            expr const & mvar = e.m_mvar;
             expr mvar_type    = m_ctx.infer(mvar);
             while (true) {
                 mvar_type = m_ctx.relaxed_whnf(mvar_type);
@@ -2989,7 +3199,6 @@ struct instance_synthesizer {
             }
             expr type  = inst_type;
             expr r     = inst;
-            buffer<expr> new_inst_mvars;
             while (true) {
                 type = m_ctx.relaxed_whnf(type);
                 if (!is_pi(type))
@@ -3004,19 +3213,13 @@ struct instance_synthesizer {
             }
             lean_trace_plain("class_instances",
                              scope_trace_env scope(m_ctx.env(), m_ctx);
-                             trace(e.m_depth, mk_app(mvar, locals.as_buffer()), mvar_type, r););
+                             trace(depth, mk_app(mvar, locals.as_buffer()), mvar_type, r););
             if (!m_ctx.is_def_eq(mvar_type, type)) {
                 lean_trace_plain("class_instances", tout() << "failed is_def_eq\n";);
                 return false;
             }
             r = locals.mk_lambda(r);
             m_ctx.assign(mvar, r);
-            // copy new_inst_mvars to stack
-            unsigned i = new_inst_mvars.size();
-            while (i > 0) {
-                --i;
-                m_state.m_stack = cons(stack_entry(new_inst_mvars[i], e.m_depth+1), m_state.m_stack);
-            }
             return true;
         } catch (exception & ex) {
             lean_trace_plain("class_instances", tout() << "exception: " << ex.what() << "\n";);
@@ -3024,7 +3227,8 @@ struct instance_synthesizer {
         }
     }
 
-    bool try_instance(stack_entry const & e, name const & inst_name) {
+    bool try_instance_core(expr const & mvar, unsigned depth, name const & inst_name, buffer<expr> & new_inst_mvars) {
+        m_num_tried++;
         if (auto decl = env().find(inst_name)) {
             buffer<level> ls_buffer;
             unsigned num_univ_ps = decl->get_num_univ_params();
@@ -3033,12 +3237,38 @@ struct instance_synthesizer {
             levels ls = to_list(ls_buffer.begin(), ls_buffer.end());
             expr inst_cnst = mk_constant(inst_name, ls);
             expr inst_type = instantiate_type_univ_params(*decl, ls);
-            return try_instance(e, inst_cnst, inst_type);
+            return try_instance_core(mvar, depth, inst_cnst, inst_type, new_inst_mvars);
         } else {
             return false;
         }
     }
 
+    void push_inst_mvars(stack_entry const & e, buffer<expr> const & new_inst_mvars) {
+        // copy new_inst_mvars to stack
+        unsigned i = new_inst_mvars.size();
+        while (i > 0) {
+            --i;
+            m_state.m_stack = cons(stack_entry(new_inst_mvars[i], e.m_depth+1), m_state.m_stack);
+        }
+    }
+
+    /* Try to synthesize e.m_mvar using instance inst : inst_type. */
+    bool try_instance(stack_entry const & e, expr const & inst, expr const & inst_type) {
+        buffer<expr> new_inst_mvars;
+        if (!try_instance_core(e.m_mvar, e.m_depth, inst, inst_type, new_inst_mvars))
+            return false;
+        push_inst_mvars(e, new_inst_mvars);
+        return true;
+    }
+
+    bool try_instance(stack_entry const & e, name const & inst_name) {
+        buffer<expr> new_inst_mvars;
+        if (!try_instance_core(e.m_mvar, e.m_depth, inst_name, new_inst_mvars))
+            return false;
+        push_inst_mvars(e, new_inst_mvars);
+        return true;
+    }
+
     list<expr> get_local_instances(name const & cname) {
         buffer<expr> selected;
         for (pair<name, expr> const & p : m_ctx.m_local_instances) {
@@ -3048,15 +3278,73 @@ struct instance_synthesizer {
         return to_list(selected);
     }
 
+    bool may_match(list<name> const & arg_keys) const {
+        if (length(arg_keys) != m_keys.size())
+            return true;
+        unsigned i = 0;
+        for (name const & k : arg_keys) {
+            name const & k_e = m_keys[i];
+            i++;
+            /* The instance keys were computed when the instance was declared,
+               so the head symbol may have been marked as reducible since then. */
+            if (!k.is_anonymous() && !k_e.is_anonymous() && k != k_e && is_rigid_head_symbol(env(), k))
+                return false;
+        }
+        return true;
+    }
+
+    /* Remove from \c insts the instances whose resulting type cannot be unified with \c mvar_type
+       because there is a class argument where both have different rigid head symbols.
+       The order of the remaining instances (i.e., their priority) is preserved. */
+    list<name> filter_instances(expr const & mvar_type, name const & cname, list<name> const & insts) {
+        if (!m_use_index || !insts)
+            return insts;
+        type_context::tmp_locals locals(m_ctx);
+        expr type = mvar_type;
+        while (true) {
+            type = m_ctx.relaxed_whnf(type);
+            if (!is_pi(type))
+                break;
+            expr local = locals.push_local_from_binding(type);
+            type       = instantiate(binding_body(type), local);
+        }
+        buffer<expr> args;
+        expr const & fn = get_app_args(type, args);
+        if (!is_constant(fn) || const_name(fn) != cname)
+            return insts;
+        /* As in discr_tree, we ignore propositions (proof irrelevance) and inst-implicit arguments */
+        fun_info info = get_fun_info(m_ctx, fn, args.size());
+        m_keys.clear();
+        unsigned i = 0;
+        for (param_info const & pinfo : info.get_params_info()) {
+            if (pinfo.is_prop() || pinfo.is_inst_implicit())
+                m_keys.push_back(name());
+            else
+                m_keys.push_back(get_instance_arg_key(env(), args[i]));
+            i++;
+        }
+        for (; i < args.size(); i++)
+            m_keys.push_back(get_instance_arg_key(env(), args[i]));
+        return filter(insts, [&](name const & inst) {
+                if (may_match(get_instance_arg_keys(env(), inst)))
+                    return true;
+                m_num_pruned++;
+                return false;
+            });
+    }
+
+    [[ noreturn ]] void throw_max_depth_exception() {
+        throw_class_exception(m_ctx.infer(m_main_mvar),
+                              "maximum class-instance resolution depth has been reached "
+                              "(the limit can be increased by setting option 'class.instance_max_depth') "
+                              "(the class-instance resolution trace can be visualized "
+                              "by setting option 'trace.class_instances')");
+    }
+
     bool mk_choice_point(expr const & mvar) {
         lean_assert(is_metavar(mvar));
-        if (m_choices.size() > m_ctx.m_cache->m_ci_max_depth) {
-            throw_class_exception(m_ctx.infer(m_main_mvar),
-                                  "maximum class-instance resolution depth has been reached "
-                                  "(the limit can be increased by setting option 'class.instance_max_depth') "
-                                  "(the class-instance resolution trace can be visualized "
-                                  "by setting option 'trace.class_instances')");
-        }
+        if (m_choices.size() > m_ctx.m_cache->m_ci_max_depth)
+            throw_max_depth_exception();
         // Remark: we initially tried to reject branches where mvar_type contained unassigned metavariables.
         // The idea was to make the procedure easier to understand.
         // However, it turns out this is too restrictive. The group_theory folder contains the following instance.
@@ -3072,7 +3360,7 @@ struct instance_synthesizer {
         if (!cname)
             return false;
         r.m_local_instances = get_local_instances(*cname);
-        r.m_instances = get_class_instances(env(), *cname);
+        r.m_instances = filter_instances(mvar_type, *cname, get_class_instances(env(), *cname));
         if (empty(r.m_local_instances) && empty(r.m_instances))
             return false;
         r.m_state = m_state;
@@ -3171,8 +3459,316 @@ struct instance_synthesizer {
             return none_expr();
     }
 
+    /* -------------
+       Tabled resolution
+
+       The depth-first search above derives the same subgoal again for each path that reaches it
+       (e.g., diamonds in the class hierarchy), and it only stops looping instances at the maximum depth.
+       The tabled resolution procedure creates a table entry for each subgoal, and each subgoal is solved only once.
+       A generator node tries the instances for a subgoal, and a consumer node is a partially applied instance
+       waiting for the answers of its next instance implicit argument. Whenever a new answer for a subgoal is found,
+       the consumers waiting for it are resumed. The search stops when the main goal has an answer without
+       metavariables.
+
+       Nodes and answers do not depend on the current assignment. Their temporary metavariables are renumbered
+       starting at 0 (see abstract_tmp_mvars), and they are imported using fresh metavariables.
+       Two subgoals are the same if their normalized types are equal.
+
+       Looping instances (e.g., [foo α] : foo (list α)) may produce infinitely many answers for a subgoal.
+       Thus, each answer records the nesting depth of its instances, and the search fails when it exceeds
+       class.instance_max_depth, as the depth-first search does.
+       ------------- */
+
+    /* Expressions whose (unassigned) temporary metavariables are numbered from 0 */
+    struct tabled_exprs {
+        buffer<expr> m_exprs;
+        unsigned     m_num_umvars{0};
+        unsigned     m_num_emvars{0};
+    };
+
+    struct consumer_node {
+        unsigned     m_key;   // table entry for the subgoal being solved by this node
+        unsigned     m_depth;
+        /* nesting depth of the partial solution, i.e., of the answers assigned so far */
+        unsigned     m_answer_depth;
+        /* [value, type, mvar_1, ..., mvar_n], value : type is the partial solution of the subgoal, and
+           mvar_i are the instance implicit arguments that have not been synthesized yet. */
+        tabled_exprs m_data;
+    };
+
+    struct generator_node {
+        unsigned     m_key;
+        unsigned     m_depth;
+        /* [type], the normalized type of the subgoal */
+        tabled_exprs m_goal;
+        list<expr>   m_local_instances;
+        list<name>   m_instances;
+    };
+
+    struct table_answer {
+        /* [value, type] */
+        tabled_exprs m_data;
+        /* nesting depth of the instances in value */
+        unsigned     m_depth;
+        table_answer(tabled_exprs const & data, unsigned depth):m_data(data), m_depth(depth) {}
+    };
+
+    struct table_entry {
+        /* true if the main goal is waiting for the answers of this subgoal */
+        bool                   m_root{false};
+        buffer<consumer_node>  m_waiters;
+        buffer<table_answer>   m_answers;
+    };
+
+    expr_struct_map<unsigned>                      m_table_idx;
+    std::vector<table_entry>                       m_tables;
+    std::vector<generator_node>                    m_generators;
+    std::vector<pair<consumer_node, table_answer>> m_resume_stack;
+    optional<tabled_exprs>                         m_root_answer;
+
+    tabled_exprs abstract_tmp_mvars(buffer<expr> const & es) {
+        tabled_exprs r;
+        std::unordered_map<unsigned, level> umap;
+        std::unordered_map<unsigned, expr>  emap;
+        auto visit_level = [&](level const & l) {
+            return replace(m_ctx.instantiate_mvars(l), [&](level const & l) {
+                    if (!has_meta(l))
+                        return some_level(l);
+                    if (is_idx_metauniv(l)) {
+                        auto it = umap.find(to_meta_idx(l));
+                        if (it != umap.end())
+                            return some_level(it->second);
+                        level new_l = mk_idx_metauniv(r.m_num_umvars++);
+                        umap.insert(mk_pair(to_meta_idx(l), new_l));
+                        return some_level(new_l);
+                    }
+                    return none_level();
+                });
+        };
+        std::function<expr(expr const &)> visit = [&](expr const & e) {
+            return replace(m_ctx.instantiate_mvars(e), [&](expr const & e, unsigned) {
+                    if (!has_univ_metavar(e) && !has_expr_metavar(e))
+                        return some_expr(e);
+                    if (is_idx_metavar(e)) {
+                        auto it = emap.find(to_meta_idx(e));
+                        if (it != emap.end())
+                            return some_expr(it->second);
+                        unsigned new_idx = r.m_num_emvars++;
+                        expr new_e = mk_idx_metavar(new_idx, visit(mlocal_type(e)));
+                        emap.insert(mk_pair(to_meta_idx(e), new_e));
+                        return some_expr(new_e);
+                    } else if (is_constant(e)) {
+                        levels ls = map(const_levels(e), [&](level const & l) { return visit_level(l); });
+                        return some_expr(update_constant(e, ls));
+                    } else if (is_sort(e)) {
+                        return some_expr(update_sort(e, visit_level(sort_level(e))));
+                    }
+                    return none_expr();
+                });
+        };
+        for (expr const & e : es)
+            r.m_exprs.push_back(visit(e));
+        return r;
+    }
+
+    void import_tmp_mvars(tabled_exprs const & t, buffer<expr> & r) {
+        unsigned uoffset = m_ctx.m_tmp_uassignment->size();
+        unsigned eoffset = m_ctx.m_tmp_eassignment->size();
+        m_ctx.ensure_num_tmp_mvars(uoffset + t.m_num_umvars, eoffset + t.m_num_emvars);
+        auto visit_level = [&](level const & l) {
+            return replace(l, [&](level const & l) {
+                    if (!has_meta(l))
+                        return some_level(l);
+                    if (is_idx_metauniv(l))
+                        return some_level(mk_idx_metauniv(to_meta_idx(l) + uoffset));
+                    return none_level();
+                });
+        };
+        std::function<expr(expr const &)> visit = [&](expr const & e) {
+            return replace(e, [&](expr const & e, unsigned) {
+                    if (!has_univ_metavar(e) && !has_expr_metavar(e))
+                        return some_expr(e);
+                    if (is_idx_metavar(e)) {
+                        return some_expr(mk_idx_metavar(to_meta_idx(e) + eoffset, visit(mlocal_type(e))));
+                    } else if (is_constant(e)) {
+                        levels ls = map(const_levels(e), [&](level const & l) { return visit_level(l); });
+                        return some_expr(update_constant(e, ls));
+                    } else if (is_sort(e)) {
+                        return some_expr(update_sort(e, visit_level(sort_level(e))));
+                    }
+                    return none_expr();
+                });
+        };
+        for (expr const & e : t.m_exprs)
+            r.push_back(visit(e));
+    }
+
+    void new_subgoal(tabled_exprs const & goal, unsigned depth, optional<consumer_node> const & waiter) {
+        if (depth > m_ctx.m_cache->m_ci_max_depth)
+            throw_max_depth_exception();
+        unsigned key = m_tables.size();
+        m_table_idx.insert(mk_pair(goal.m_exprs[0], key));
+        m_tables.push_back(table_entry());
+        if (waiter)
+            m_tables.back().m_waiters.push_back(*waiter);
+        else
+            m_tables.back().m_root = true;
+        lean_trace("class_instances", scope_trace_env scope(m_ctx.env(), m_ctx);
+                   tout() << "(" << depth << ") new subgoal " << goal.m_exprs[0] << "\n";);
+        generator_node g;
+        g.m_key   = key;
+        g.m_depth = depth;
+        g.m_goal  = goal;
+        buffer<expr> type;
+        import_tmp_mvars(goal, type);
+        if (auto cname = m_ctx.is_class(type[0])) {
+            g.m_local_instances = get_local_instances(*cname);
+            g.m_instances       = filter_instances(type[0], *cname, get_class_instances(env(), *cname));
+        }
+        m_generators.push_back(g);
+    }
+
+    void add_answer(unsigned key, tabled_exprs const & answer, unsigned depth) {
+        table_entry & entry = m_tables[key];
+        /* We only keep one answer for each type. In particular, ground subgoals have at most one answer. */
+        for (table_answer const & old : entry.m_answers) {
+            if (old.m_data.m_exprs[1] == answer.m_exprs[1])
+                return;
+        }
+        if (depth > m_ctx.m_cache->m_ci_max_depth)
+            throw_max_depth_exception();
+        lean_trace("class_instances", scope_trace_env scope(m_ctx.env(), m_ctx);
+                   tout() << "(" << depth << ") new answer " << answer.m_exprs[0] << " : "
+                   << answer.m_exprs[1] << "\n";);
+        entry.m_answers.push_back(table_answer(answer, depth));
+        if (entry.m_root && answer.m_num_umvars == 0 && answer.m_num_emvars == 0)
+            m_root_answer = answer;
+        for (consumer_node const & c : entry.m_waiters)
+            m_resume_stack.push_back(mk_pair(c, entry.m_answers.back()));
+    }
+
+    /* \c data is [value, type, mvar_1, ..., mvar_n] for the subgoal \c key, see consumer_node.
+       Wait for the answers of the first metavariable that has not been assigned yet,
+       or add an answer for \c key if there is none. \c answer_depth is the nesting depth of the partial solution. */
+    void consume(unsigned key, unsigned depth, unsigned answer_depth, buffer<expr> const & data) {
+        buffer<expr> rest;
+        rest.push_back(data[0]);
+        rest.push_back(data[1]);
+        for (unsigned i = 2; i < data.size(); i++) {
+            /* Remark: the instance implicit arguments may have been assigned by the unifier,
+               and they are not metavariables anymore after abstract_tmp_mvars. */
+            if (is_metavar(data[i]) && !m_ctx.is_assigned(data[i]))
+                rest.push_back(data[i]);
+        }
+        if (rest.size() == 2) {
+            add_answer(key, abstract_tmp_mvars(rest), answer_depth);
+            return;
+        }
+        consumer_node c;
+        c.m_key          = key;
+        c.m_depth        = depth;
+        c.m_answer_depth = answer_depth;
+        c.m_data         = abstract_tmp_mvars(rest);
+        buffer<expr> mvar_type;
+        mvar_type.push_back(m_ctx.infer(rest[2]));
+        tabled_exprs goal = abstract_tmp_mvars(mvar_type);
+        auto it = m_table_idx.find(goal.m_exprs[0]);
+        if (it == m_table_idx.end()) {
+            new_subgoal(goal, depth + 1, optional<consumer_node>(c));
+        } else {
+            table_entry & entry = m_tables[it->second];
+            entry.m_waiters.push_back(c);
+            for (table_answer const & answer : entry.m_answers)
+                m_resume_stack.push_back(mk_pair(c, answer));
+        }
+    }
+
+    /* Try the next instance of the generator at the top of the stack. */
+    void generate() {
+        generator_node & g = m_generators.back();
+        buffer<expr> goal;
+        import_tmp_mvars(g.m_goal, goal);
+        expr mvar = m_ctx.mk_tmp_mvar(goal[0]);
+        unsigned key   = g.m_key;
+        unsigned depth = g.m_depth;
+        buffer<expr> new_inst_mvars;
+        bool ok;
+        if (!empty(g.m_local_instances)) {
+            expr inst = head(g.m_local_instances);
+            g.m_local_instances = tail(g.m_local_instances);
+            ok = try_instance_core(mvar, depth, inst, m_ctx.infer(inst), new_inst_mvars);
+        } else if (!empty(g.m_instances)) {
+            name inst = head(g.m_instances);
+            g.m_instances = tail(g.m_instances);
+            ok = try_instance_core(mvar, depth, inst, new_inst_mvars);
+        } else {
+            m_generators.pop_back();
+            return;
+        }
+        if (!ok)
+            return;
+        buffer<expr> data;
+        data.push_back(mvar);
+        data.push_back(mlocal_type(mvar));
+        data.append(new_inst_mvars);
+        consume(key, depth, 1, data);
+    }
+
+    /* Assign the first metavariable of the consumer node \c c using \c answer. */
+    void resume(consumer_node const & c, table_answer const & answer) {
+        buffer<expr> data, new_answer;
+        import_tmp_mvars(c.m_data, data);
+        import_tmp_mvars(answer.m_data, new_answer);
+        expr const & mvar = data[2];
+        try {
+            if (!m_ctx.is_def_eq(m_ctx.infer(mvar), new_answer[1]))
+                return;
+        } catch (exception & ex) {
+            lean_trace_plain("class_instances", tout() << "exception: " << ex.what() << "\n";);
+            return;
+        }
+        m_ctx.assign(mvar, new_answer[0]);
+        consume(c.m_key, c.m_depth, std::max(c.m_answer_depth, answer.m_depth + 1), data);
+    }
+
+    optional<expr> tabled_search() {
+        expr type = m_ctx.infer(m_main_mvar);
+        {
+            /* The temporary metavariables created during the search are not needed after it */
+            type_context::scope scope(m_ctx);
+            buffer<expr> goal;
+            goal.push_back(type);
+            new_subgoal(abstract_tmp_mvars(goal), 0, optional<consumer_node>());
+            while (!m_root_answer) {
+                check_system("type class resolution");
+                if (!m_resume_stack.empty()) {
+                    pair<consumer_node, table_answer> p = m_resume_stack.back();
+                    m_resume_stack.pop_back();
+                    resume(p.first, p.second);
+                } else if (!m_generators.empty()) {
+                    generate();
+                } else {
+                    break;
+                }
+            }
+            lean_trace("class_instances",
+                       tout() << "tabled resolution, subgoals: " << m_tables.size() << "\n";);
+        }
+        if (!m_root_answer)
+            return none_expr();
+        /* The answer does not contain metavariables, but the unifier may need to
+           assign the metavariables in the given type. */
+        expr const & r = m_root_answer->m_exprs[0];
+        if (!m_ctx.is_def_eq(type, m_root_answer->m_exprs[1]))
+            return none_expr();
+        m_ctx.assign(m_main_mvar, r);
+        return some_expr(r);
+    }
+
     void cache_result(expr const & type, optional<expr> const & inst) {
         m_ctx.m_cache->m_instance_cache.insert(mk_pair(type, inst));
+        if (m_use_global_cache)
+            g_global_instance_cache->insert(*m_ctx.m_cache, type, inst);
     }
 
     optional<expr> ensure_no_meta(optional<expr> r) {
@@ -3211,8 +3807,27 @@ struct instance_synthesizer {
                            tout() << "cached failure for " << type << "\n";);
             return it->second;
         }
+        m_use_global_cache =
+            m_ctx.m_cache->m_ci_global_cache && empty(m_ctx.m_local_instances) &&
+            !has_local(type) && !has_metavar(type);
+        if (m_use_global_cache) {
+            if (auto r = g_global_instance_cache->find(*m_ctx.m_cache, type)) {
+                lean_trace("class_instances",
+                           if (*r)
+                               tout() << "globally cached instance for " << type << "\n" << **r << "\n";
+                           else
+                               tout() << "globally cached failure for " << type << "\n";);
+                m_ctx.m_cache->m_instance_cache.insert(mk_pair(type, *r));
+                return *r;
+            }
+        }
         m_state          = state();
         m_main_mvar      = m_ctx.mk_tmp_mvar(type);
+        if (m_ctx.m_cache->m_ci_tabled) {
+            auto r = tabled_search();
+            cache_result(type, r);
+            return r;
+        }
         m_state.m_stack  = to_list(stack_entry(m_main_mvar, 0));
         auto r = search();
         return ensure_no_meta(r);
@@ -3222,6 +3837,11 @@ struct instance_synthesizer {
         lean_trace_init_bool("class_instances", get_pp_purify_metavars_name(), false);
         lean_trace_init_bool("class_instances", get_pp_implicit_name(), true);
         auto r = mk_class_instance_core(type);
+        if (m_num_tried > 0 || m_num_pruned > 0) {
+            lean_trace(name({"class_instances", "index"}),
+                       tout() << "instances tried: " << m_num_tried
+                       << ", pruned by index: " << m_num_pruned << "\n";);
+        }
         if (r) {
             for (unsigned i = 0; i < m_choices.size(); i++) {
                 m_ctx.commit_scope();
@@ -3400,6 +4020,7 @@ mk_pp_ctx(type_context const & ctx) {
 
 void initialize_type_context() {
     register_trace_class("class_instances");
+    register_trace_class(name({"class_instances", "index"}));
     register_trace_class(name({"type_context", "unification_hint"}));
     register_trace_class(name({"type_context", "is_def_eq"}));
     register_trace_class(name({"type_context", "is_def_eq_detail"}));
@@ -3411,6 +4032,19 @@ void initialize_type_context() {
     g_instance                     = new name{"instance"};
     register_unsigned_option(*g_class_instance_max_depth, LEAN_DEFAULT_CLASS_INSTANCE_MAX_DEPTH,
                              "(class) max allowed depth in class-instance resolution");
+    g_class_global_cache           = new name{"class", "global_instance_cache"};
+    register_bool_option(*g_class_global_cache, LEAN_DEFAULT_CLASS_GLOBAL_INSTANCE_CACHE,
+                         "(class) share type class resolution results for closed types between declarations and threads");
+    g_class_instance_index         = new name{"class", "instance_index"};
+    register_bool_option(*g_class_instance_index, LEAN_DEFAULT_CLASS_INSTANCE_INDEX,
+                         "(class) skip instances whose resulting type cannot match the goal by comparing the head "
+                         "symbols of the class arguments, before invoking the unifier");
+    g_class_tabled_resolution      = new name{"class", "tabled_resolution"};
+    register_bool_option(*g_class_tabled_resolution, LEAN_DEFAULT_CLASS_TABLED_RESOLUTION,
+                         "(class) use tabled resolution in type class resolution, each subgoal is solved only once "
+                         "and its answers are reused by all instances waiting for it");
+    g_unify                        = new name{"unify"};
+    g_global_instance_cache        = new global_instance_cache();
     g_nat_offset_threshold         = new name{"unifier", "nat_offset_cnstr_threshold"};
     register_unsigned_option(*g_nat_offset_threshold, LEAN_DEFAULT_NAT_OFFSET_CNSTR_THRESHOLD,
                              "(unifier) the unifier has special support for offset nat constraints of the form: "
@@ -3423,5 +4057,10 @@ void finalize_type_context() {
     delete g_class_instance_max_depth;
     delete g_instance;
     delete g_nat_offset_threshold;
+    delete g_global_instance_cache;
+    delete g_unify;
+    delete g_class_global_cache;
+    delete g_class_instance_index;
+    delete g_class_tabled_resolution;
 }
 }
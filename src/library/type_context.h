@@ -118,10 +118,17 @@ class type_context_cache {
     unsigned                      m_ci_max_depth;
     /* See issue #1226 */
     unsigned                      m_nat_offset_cnstr_threshold;
+    /* Use the global cache for type class resolution results of closed types. */
+    bool                          m_ci_global_cache;
+    /* Skip instances that cannot match the goal before invoking the unifier, see get_instance_arg_keys. */
+    bool                          m_ci_index;
+    /* Use tabled resolution instead of depth-first search in type class resolution. */
+    bool                          m_ci_tabled;
 
     friend class type_context;
     friend class type_context_cache_manager;
     friend struct instance_synthesizer;
+    friend class global_instance_cache;
     void init(local_context const & lctx);
     bool is_transparent(transparency_mode m, declaration const & d);
     optional<declaration> is_transparent(transparency_mode m, name const & n);
@@ -149,15 +156,32 @@ public:
 typedef std::shared_ptr<type_context_cache> type_context_cache_ptr;
 
 /* \brief Type context cache managers are thread local data that we use
-   to try to reuse type_context_cache objects */
+   to try to reuse type_context_cache objects.
+
+   A manager keeps up to LEAN_TYPE_CONTEXT_CACHE_SLOTS recycled caches. This is important
+   when a thread interleaves tasks from different files, or from different points of the same file.
+   A cache can be reused for an environment \c env if \c env is a descendant of the environment
+   of the cache, and has the same reducibility and instance fingerprints. */
 class type_context_cache_manager {
-    type_context_cache_ptr m_cache_ptr;
+    struct slot {
+        type_context_cache_ptr m_cache_ptr;
+        unsigned               m_reducibility_fingerprint;
+        unsigned               m_instance_fingerprint;
+        environment            m_env;
+        unsigned               m_max_depth;
+        unsigned               m_last_used;
+    };
+    std::vector<slot>      m_slots;
+    /* fingerprints of m_env, we keep them to avoid recomputing them when the environment does not change */
+    environment            m_env;
     unsigned               m_reducibility_fingerprint;
     unsigned               m_instance_fingerprint;
-    environment            m_env;
-    unsigned               m_max_depth;
+    unsigned               m_timestamp{0};
+    unsigned               m_num_hits{0};
+    unsigned               m_num_misses{0};
     bool                   m_use_bi;
-    type_context_cache_ptr release();
+    type_context_cache_ptr release(unsigned i);
+    void update_fingerprints(environment const & env);
 public:
     type_context_cache_manager(bool use_bi = false):m_use_bi(use_bi) {}
     type_context_cache_ptr mk(environment const & env, options const & o);
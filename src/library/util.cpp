@@ -21,6 +21,8 @@ Author: Leonardo de Moura
 #include "library/unfold_macros.h"
 #include "library/pp_options.h"
 #include "library/projection.h"
+#include "library/reducible.h"
+#include "library/aux_recursors.h"
 #include "library/replace_visitor.h"
 
 namespace lean {
@@ -63,6 +65,18 @@ bool is_app_of(expr const & t, name const & f_name, unsigned nargs) {
     return is_constant(fn) && const_name(fn) == f_name && get_app_num_args(t) == nargs;
 }
 
+bool is_rigid_head_symbol(environment const & env, name const & n) {
+    /* Numerals and offset terms (e.g., `n+1 =?= nat.succ m`) are handled by the unifier */
+    if (n == get_nat_zero_name() || n == get_nat_succ_name() ||
+        n == get_bit0_name() || n == get_bit1_name())
+        return false;
+    return
+        !is_reducible(env, n) &&
+        !is_projection(env, n) &&
+        !is_aux_recursor(env, n) &&
+        !env.norm_ext().is_recursor(env, n);
+}
+
 optional<expr> unfold_term(environment const & env, expr const & e) {
     expr const & f = get_app_fn(e);
     if (!is_constant(f))
@@ -29,6 +29,12 @@ bool is_app_of(expr const & t, name const & f_name);
 /** \brief Return true iff t is a constant named f_name or an application of the form (f_name a_1 ... a_nargs) */
 bool is_app_of(expr const & t, name const & f_name, unsigned nargs);
 
+/** \brief Return true iff applications of \c n are never reduced by the unifier when using
+    reducible transparency, i.e., \c n is not a reducible definition, projection, recursor or numeral symbol.
+    Thus, two applications with different rigid head symbols are not definitionally equal
+    unless unification hints are used. */
+bool is_rigid_head_symbol(environment const & env, name const & n);
+
 /** \brief Unfold constant \c e or constant application (i.e., \c e is of the form (f ....),
     where \c f is a constant */
 optional<expr> unfold_term(environment const & env, expr const & e);
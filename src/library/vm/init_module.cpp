@@ -6,12 +6,14 @@ Author: Leonardo de Moura
 */
 #include "library/vm/vm.h"
 #include "library/vm/vm_nat.h"
+#include "library/vm/vm_string.h"
 #include "library/vm/vm_aux.h"
 #include "library/vm/vm_io.h"
 #include "library/vm/vm_name.h"
 #include "library/vm/vm_options.h"
 #include "library/vm/vm_format.h"
 #include "library/vm/vm_rb_map.h"
+#include "library/vm/vm_array.h"
 #include "library/vm/vm_level.h"
 #include "library/vm/vm_expr.h"
 #include "library/vm/vm_pexpr.h"
@@ -26,12 +28,14 @@ namespace lean {
 void initialize_vm_core_module() {
     initialize_vm_core();
     initialize_vm_nat();
+    initialize_vm_string();
     initialize_vm_aux();
     initialize_vm_io();
     initialize_vm_name();
     initialize_vm_options();
     initialize_vm_format();
     initialize_vm_rb_map();
+    initialize_vm_array();
     initialize_vm_level();
     initialize_vm_expr();
     initialize_vm_pexpr();
@@ -52,12 +56,14 @@ void finalize_vm_core_module() {
     finalize_vm_pexpr();
     finalize_vm_expr();
     finalize_vm_level();
+    finalize_vm_array();
     finalize_vm_rb_map();
     finalize_vm_format();
     finalize_vm_options();
     finalize_vm_name();
     finalize_vm_io();
     finalize_vm_aux();
+    finalize_vm_string();
     finalize_vm_nat();
     finalize_vm_core();
 }
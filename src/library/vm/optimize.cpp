@@ -4,6 +4,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <vector>
 #include "library/vm/vm.h"
 
 namespace lean {
@@ -79,8 +80,139 @@ static void compress_goto_ret(buffer<vm_instr> & code) {
     }
 }
 
+static bool is_push(vm_instr const & instr) {
+    return instr.op() == opcode::Push || instr.op() == opcode::Move;
+}
+
+/**
+   \brief Replace frequent instruction sequences with superinstructions.
+   This reduces the number of instructions dispatched by the interpreter.
+   ...
+   pc:   push i
+   pc+1: push j
+   pc+2: ginvoke fn
+   ...
+   ===>
+   ...
+   pc:   push2_ginvoke i j fn
+   ...
+
+   and
+   ...
+   pc:   destruct
+   pc+1: push i
+   pc+2: cases2 pc_1 pc_2
+   ...
+   ===>
+   ...
+   pc:   destruct_cases2 i pc_1 pc_2
+   ...
+
+   where each push may be a move. */
+void fuse_superinstructions(buffer<vm_instr> & code) {
+    if (code.size() < 3) return;
+    addr_set targets;
+    collect_targets(code, targets);
+    unsigned i = code.size() - 2;
+    while (i > 0) {
+        --i;
+        /* the code may have shrunk by fusing the instructions after i */
+        if (i + 2 >= code.size())
+            continue;
+        if (code[i].op()   == opcode::Destruct &&
+            is_push(code[i+1]) &&
+            code[i+2].op() == opcode::Cases2 &&
+            !targets.contains(i+1) && !targets.contains(i+2)) {
+            code[i] = mk_destruct_cases2_instr(code[i+1].get_idx(), code[i+2].get_cases2_pc(0),
+                                               code[i+2].get_cases2_pc(1), code[i+1].op() == opcode::Move);
+            del_instr_at(i+2, code);
+            del_instr_at(i+1, code);
+        } else if (is_push(code[i]) &&
+                   is_push(code[i+1]) &&
+                   code[i+2].op() == opcode::InvokeGlobal &&
+                   !targets.contains(i+1) && !targets.contains(i+2)) {
+            code[i] = mk_push2_invoke_global_instr(code[i].get_idx(), code[i+1].get_idx(), code[i+2].get_fn_idx(),
+                                                   code[i].op() == opcode::Move, code[i+1].op() == opcode::Move);
+            del_instr_at(i+2, code);
+            del_instr_at(i+1, code);
+        }
+    }
+}
+
+/* Add to \c r the indices of the locals read by \c instr */
+static void collect_reads(vm_instr const & instr, addr_set & r) {
+    switch (instr.op()) {
+    case opcode::Push: case opcode::Move:
+        r.insert(instr.get_idx());
+        break;
+    case opcode::Push2InvokeGlobal:
+        r.insert(instr.get_push_idx(0));
+        r.insert(instr.get_push_idx(1));
+        break;
+    case opcode::DestructCases2:
+        r.insert(instr.get_destruct_cases2_idx());
+        break;
+    case opcode::RInvoke: case opcode::RClosure: case opcode::RConstructor:
+        for (unsigned j = 0; j < instr.get_num_operands(); j++) {
+            vm_operand o = instr.get_operand(j);
+            if (o.kind() == vm_operand_kind::Local || o.kind() == vm_operand_kind::MoveLocal)
+                r.insert(o.value());
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/* Replace each Local operand of \c instr with a MoveLocal operand if the local is not in \c after, and it is
+   not read by the next operands. The operands are read from the first one to the last one. */
+static void move_last_operand_uses(vm_instr & instr, addr_set after) {
+    unsigned j = instr.get_num_operands();
+    while (j > 0) {
+        --j;
+        vm_operand o = instr.get_operand(j);
+        if (o.kind() == vm_operand_kind::Local) {
+            if (!after.contains(o.value()))
+                instr.set_operand(j, vm_operand(vm_operand_kind::MoveLocal, o.value()));
+            after.insert(o.value());
+        }
+    }
+}
+
+/**
+   \brief Replace each push i with move i when the local i is not read by the instructions that may be
+   executed after it, and similarly for the operands of the register-based instructions. Then, the reference counter of the local is not incremented, and it can be
+   updated in place (e.g., by array.write) or recycled by the instructions that destruct it.
+
+   The code does not contain backward jumps, so a single backward pass computes the locals that may be
+   read after each instruction. The analysis is conservative: the index of a local that has been dropped
+   may be reused by another local, and a read of the new one keeps the index live. */
+static void move_last_uses(buffer<vm_instr> & code) {
+    /* live[pc] contains the indices of the locals that may be read by the instructions at pc, pc+1, ... */
+    std::vector<addr_set> live(code.size() + 1);
+    unsigned i = code.size();
+    while (i > 0) {
+        --i;
+        vm_instr & c = code[i];
+        addr_set after;
+        if (c.op() != opcode::Goto && c.op() != opcode::Ret && c.op() != opcode::Unreachable)
+            after = live[i+1];
+        for (unsigned j = 0; j < c.get_num_pcs(); j++) {
+            lean_assert(c.get_pc(j) > i);
+            live[c.get_pc(j)].for_each([&](unsigned idx) { after.insert(idx); });
+        }
+        if (c.op() == opcode::Push && !after.contains(c.get_idx()))
+            c = mk_move_instr(c.get_idx());
+        else if (c.has_operands())
+            move_last_operand_uses(c, after);
+        collect_reads(c, after);
+        live[i] = after;
+    }
+}
+
 void optimize(environment const &, buffer<vm_instr> & code) {
     compress_goto_ret(code);
     compress_drop_drop(code);
+    move_last_uses(code);
 }
 }
@@ -9,4 +9,6 @@ Author: Leonardo de Moura
 
 namespace lean {
 void optimize(environment const &, buffer<vm_instr> & code);
+/** \brief Replace frequent instruction sequences in \c code with superinstructions. */
+void fuse_superinstructions(buffer<vm_instr> & code);
 }
@@ -38,6 +38,11 @@ Author: Leonardo de Moura
 #define LEAN_DEFAULT_PROFILER_FREQ 10
 #endif
 
+/* Maximum number of idle vm_state objects kept by each thread, see pooled_vm_state. */
+#ifndef LEAN_VM_STATE_POOL_SIZE
+#define LEAN_VM_STATE_POOL_SIZE 4
+#endif
+
 namespace lean {
 void vm_obj_cell::dec_ref(vm_obj & o, buffer<vm_obj_cell*> & todelete) {
     if (LEAN_VM_IS_PTR(o.m_data)) {
@@ -59,6 +64,12 @@ vm_composite::vm_composite(vm_obj_kind k, unsigned idx, unsigned sz, vm_obj cons
     std::uninitialized_copy(data, data + sz, fields);
 }
 
+vm_composite::vm_composite(vm_obj_kind k, unsigned idx, unsigned sz):
+    vm_obj_cell(k), m_idx(idx),  m_size(sz) {
+    vm_obj * fields = get_field_ptr();
+    std::uninitialized_fill(fields, fields + sz, vm_obj());
+}
+
 static vm_obj mk_vm_composite(vm_obj_kind k, unsigned idx, unsigned sz, vm_obj const * data) {
     lean_assert(k == vm_obj_kind::Constructor || k == vm_obj_kind::Closure);
     return vm_obj(new (get_small_allocator().allocate(sizeof(vm_composite) + sz * sizeof(vm_obj))) vm_composite(k, idx, sz, data));
@@ -217,11 +228,25 @@ static void display_builtin_cases(std::ostream & out, std::function<optional<nam
     display_fn(out, idx2name, cases_idx);
 }
 
+static void display_operands(std::ostream & out, vm_instr const & instr) {
+    out << ",";
+    for (unsigned i = 0; i < instr.get_num_operands(); i++) {
+        vm_operand o = instr.get_operand(i);
+        switch (o.kind()) {
+        case vm_operand_kind::Local:     out << " " << o.value(); break;
+        case vm_operand_kind::MoveLocal: out << " (move " << o.value() << ")"; break;
+        case vm_operand_kind::Simple:    out << " #" << o.value(); break;
+        case vm_operand_kind::Stack:     out << " stack"; break;
+        }
+    }
+}
+
 void vm_instr::display(std::ostream & out,
                        std::function<optional<name>(unsigned)> const & idx2name,
                        std::function<optional<name>(unsigned)> const & cases_idx2name) const {
     switch (m_op) {
     case opcode::Push:          out << "push " << m_idx; break;
+    case opcode::Move:          out << "move " << m_idx; break;
     case opcode::Ret:           out << "ret"; break;
     case opcode::Drop:          out << "drop " << m_num; break;
     case opcode::Goto:          out << "goto " << m_pc[0]; break;
@@ -267,6 +292,43 @@ void vm_instr::display(std::ostream & out,
         out << "pexpr " << *m_expr; break;
     case opcode::LocalInfo:
         out << "localinfo " << m_local_info->first << " @ " << m_local_idx; break;
+    case opcode::Push2InvokeGlobal:
+        out << "push2_ginvoke ";
+        for (unsigned i = 0; i < 2; i++) {
+            if (m_push_move[i])
+                out << "(move " << m_push_idx[i] << ") ";
+            else
+                out << m_push_idx[i] << " ";
+        }
+        display_fn(out, idx2name, m_fn_idx);
+        break;
+    case opcode::DestructCases2:
+        out << "destruct_cases2 ";
+        if (m_cases_move2)
+            out << "(move " << m_cases_idx2 << ")";
+        else
+            out << m_cases_idx2;
+        out << " " << m_pc[1];
+        break;
+    case opcode::NatJumpTable:
+        out << "nat_jump_table " << m_lower << ",";
+        for (unsigned i = 0; i < get_casesn_size(); i++)
+            out << " " << get_casesn_pc(i);
+        break;
+    case opcode::RInvoke:
+        out << "rinvoke ";
+        display_fn(out, idx2name, m_fn_idx);
+        display_operands(out, *this);
+        break;
+    case opcode::RClosure:
+        out << "rclosure ";
+        display_fn(out, idx2name, m_fn_idx);
+        display_operands(out, *this);
+        break;
+    case opcode::RConstructor:
+        out << "rcnstr #" << m_rcidx;
+        display_operands(out, *this);
+        break;
     }
 }
 
@@ -278,9 +340,9 @@ unsigned vm_instr::get_num_pcs() const {
     switch (m_op) {
     case opcode::Goto:
         return 1;
-    case opcode::Cases2: case opcode::NatCases:
+    case opcode::Cases2: case opcode::NatCases: case opcode::DestructCases2:
         return 2;
-    case opcode::CasesN: case opcode::BuiltinCases:
+    case opcode::CasesN: case opcode::BuiltinCases: case opcode::NatJumpTable:
         return get_casesn_size();
     default:
         return 0;
@@ -291,9 +353,9 @@ unsigned vm_instr::get_pc(unsigned i) const {
     lean_assert(i < get_num_pcs());
     switch (m_op) {
     case opcode::Goto:
-    case opcode::Cases2: case opcode::NatCases:
+    case opcode::Cases2: case opcode::NatCases: case opcode::DestructCases2:
         return m_pc[i];
-    case opcode::CasesN: case opcode::BuiltinCases:
+    case opcode::CasesN: case opcode::BuiltinCases: case opcode::NatJumpTable:
         return get_casesn_pc(i);
     default:
         lean_unreachable();
@@ -304,10 +366,10 @@ void vm_instr::set_pc(unsigned i, unsigned pc) {
     lean_assert(i < get_num_pcs());
     switch (m_op) {
     case opcode::Goto:
-    case opcode::Cases2: case opcode::NatCases:
+    case opcode::Cases2: case opcode::NatCases: case opcode::DestructCases2:
         m_pc[i] = pc;
         break;
-    case opcode::CasesN: case opcode::BuiltinCases:
+    case opcode::CasesN: case opcode::BuiltinCases: case opcode::NatJumpTable:
         set_casesn_pc(i, pc);
         break;
     default:
@@ -321,6 +383,12 @@ vm_instr mk_push_instr(unsigned idx) {
     return r;
 };
 
+vm_instr mk_move_instr(unsigned idx) {
+    vm_instr r(opcode::Move);
+    r.m_idx = idx;
+    return r;
+}
+
 vm_instr mk_drop_instr(unsigned n) {
     vm_instr r(opcode::Drop);
     r.m_num = n;
@@ -420,6 +488,17 @@ vm_instr mk_builtin_cases_instr(unsigned cases_idx, unsigned num_pc, unsigned co
     return r;
 }
 
+vm_instr mk_nat_jump_table_instr(unsigned lower, unsigned num_pc, unsigned const * pcs) {
+    lean_assert(num_pc >= 2);
+    vm_instr r(opcode::NatJumpTable);
+    r.m_lower   = lower;
+    r.m_npcs    = new unsigned[num_pc + 1];
+    r.m_npcs[0] = num_pc;
+    for (unsigned i = 0; i < num_pc; i++)
+        r.m_npcs[i+1] = pcs[i];
+    return r;
+}
+
 vm_instr mk_invoke_global_instr(unsigned fn_idx) {
     vm_instr r(opcode::InvokeGlobal);
     r.m_fn_idx = fn_idx;
@@ -445,6 +524,58 @@ vm_instr mk_closure_instr(unsigned fn_idx, unsigned n) {
     return r;
 }
 
+vm_instr mk_push2_invoke_global_instr(unsigned idx1, unsigned idx2, unsigned fn_idx, bool move1, bool move2) {
+    vm_instr r(opcode::Push2InvokeGlobal);
+    r.m_fn_idx       = fn_idx;
+    r.m_push_idx[0]  = idx1;
+    r.m_push_idx[1]  = idx2;
+    r.m_push_move[0] = move1;
+    r.m_push_move[1] = move2;
+    return r;
+}
+
+vm_instr mk_destruct_cases2_instr(unsigned idx, unsigned pc1, unsigned pc2, bool move) {
+    vm_instr r(opcode::DestructCases2);
+    r.m_cases_idx2  = idx;
+    r.m_cases_move2 = move;
+    r.m_pc[0] = pc1;
+    r.m_pc[1] = pc2;
+    return r;
+}
+
+static unsigned * mk_operands(unsigned num, vm_operand const * ops) {
+    unsigned * r = new unsigned[num + 2];
+    r[0] = num;
+    r[1] = 0;
+    for (unsigned i = 0; i < num; i++) {
+        if (ops[i].kind() == vm_operand_kind::Stack)
+            r[1]++;
+        r[i+2] = ops[i].raw();
+    }
+    return r;
+}
+
+vm_instr mk_rinvoke_instr(unsigned fn_idx, unsigned num, vm_operand const * ops) {
+    vm_instr r(opcode::RInvoke);
+    r.m_fn_idx   = fn_idx;
+    r.m_operands = mk_operands(num, ops);
+    return r;
+}
+
+vm_instr mk_rclosure_instr(unsigned fn_idx, unsigned num, vm_operand const * ops) {
+    vm_instr r(opcode::RClosure);
+    r.m_fn_idx   = fn_idx;
+    r.m_operands = mk_operands(num, ops);
+    return r;
+}
+
+vm_instr mk_rconstructor_instr(unsigned cidx, unsigned num, vm_operand const * ops) {
+    vm_instr r(opcode::RConstructor);
+    r.m_rcidx    = cidx;
+    r.m_operands = mk_operands(num, ops);
+    return r;
+}
+
 void vm_instr::copy_args(vm_instr const & i) {
     switch (i.m_op) {
     case opcode::InvokeGlobal: case opcode::InvokeBuiltin: case opcode::InvokeCFun:
@@ -454,7 +585,14 @@ void vm_instr::copy_args(vm_instr const & i) {
         m_fn_idx = i.m_fn_idx;
         m_nargs  = i.m_nargs;
         break;
-    case opcode::Push: case opcode::Proj:
+    case opcode::Push2InvokeGlobal:
+        m_fn_idx       = i.m_fn_idx;
+        m_push_idx[0]  = i.m_push_idx[0];
+        m_push_idx[1]  = i.m_push_idx[1];
+        m_push_move[0] = i.m_push_move[0];
+        m_push_move[1] = i.m_push_move[1];
+        break;
+    case opcode::Push: case opcode::Move: case opcode::Proj:
         m_idx  = i.m_idx;
         break;
     case opcode::Drop:
@@ -467,13 +605,26 @@ void vm_instr::copy_args(vm_instr const & i) {
         m_pc[0] = i.m_pc[0];
         m_pc[1] = i.m_pc[1];
         break;
+    case opcode::DestructCases2:
+        m_pc[0]       = i.m_pc[0];
+        m_pc[1]       = i.m_pc[1];
+        m_cases_idx2  = i.m_cases_idx2;
+        m_cases_move2 = i.m_cases_move2;
+        break;
     case opcode::CasesN:
     case opcode::BuiltinCases:
+    case opcode::NatJumpTable:
         m_npcs = new unsigned[i.m_npcs[0] + 1];
         for (unsigned j = 0; j < i.m_npcs[0] + 1; j++)
             m_npcs[j] = i.m_npcs[j];
         m_cases_idx = i.m_cases_idx;
         break;
+    case opcode::RInvoke: case opcode::RClosure: case opcode::RConstructor:
+        m_operands = new unsigned[i.m_operands[0] + 2];
+        for (unsigned j = 0; j < i.m_operands[0] + 2; j++)
+            m_operands[j] = i.m_operands[j];
+        m_fn_idx = i.m_fn_idx;
+        break;
     case opcode::SConstructor:
         m_cidx = i.m_cidx;
         break;
@@ -509,11 +660,16 @@ vm_instr::vm_instr(vm_instr && i):
         m_mpz    = i.m_mpz;
         i.m_mpz  = nullptr;
         break;
-    case opcode::CasesN: case opcode::BuiltinCases:
+    case opcode::CasesN: case opcode::BuiltinCases: case opcode::NatJumpTable:
         m_npcs      = i.m_npcs;
         m_cases_idx = i.m_cases_idx;
         i.m_npcs    = nullptr;
         break;
+    case opcode::RInvoke: case opcode::RClosure: case opcode::RConstructor:
+        m_operands   = i.m_operands;
+        m_fn_idx     = i.m_fn_idx;
+        i.m_operands = nullptr;
+        break;
     default:
         copy_args(i);
         break;
@@ -525,9 +681,12 @@ vm_instr::~vm_instr() {
     case opcode::Num:
         delete m_mpz;
         break;
-    case opcode::CasesN: case opcode::BuiltinCases:
+    case opcode::CasesN: case opcode::BuiltinCases: case opcode::NatJumpTable:
         delete[] m_npcs;
         break;
+    case opcode::RInvoke: case opcode::RClosure: case opcode::RConstructor:
+        delete[] m_operands;
+        break;
     case opcode::Pexpr:
         delete m_expr;
         break;
@@ -552,11 +711,16 @@ vm_instr & vm_instr::operator=(vm_instr && s) {
         m_mpz    = s.m_mpz;
         s.m_mpz  = nullptr;
         break;
-    case opcode::CasesN: case opcode::BuiltinCases:
+    case opcode::CasesN: case opcode::BuiltinCases: case opcode::NatJumpTable:
         m_cases_idx = s.m_cases_idx;
         m_npcs      = s.m_npcs;
         s.m_npcs    = nullptr;
         break;
+    case opcode::RInvoke: case opcode::RClosure: case opcode::RConstructor:
+        m_fn_idx     = s.m_fn_idx;
+        m_operands   = s.m_operands;
+        s.m_operands = nullptr;
+        break;
     default:
         copy_args(s);
         break;
@@ -564,6 +728,13 @@ vm_instr & vm_instr::operator=(vm_instr && s) {
     return *this;
 }
 
+/* The number of Stack operands is not stored, it is computed when the instruction is created. */
+static void write_operands(serializer & s, unsigned const * ops) {
+    s << ops[0];
+    for (unsigned j = 2; j < ops[0] + 2; j++)
+        s << ops[j];
+}
+
 void vm_instr::serialize(serializer & s, std::function<name(unsigned)> const & idx2name) const {
     s << static_cast<char>(m_op);
     switch (m_op) {
@@ -573,7 +744,10 @@ void vm_instr::serialize(serializer & s, std::function<name(unsigned)> const & i
     case opcode::Closure:
         s << idx2name(m_fn_idx) << m_nargs;
         break;
-    case opcode::Push: case opcode::Proj:
+    case opcode::Push2InvokeGlobal:
+        s << idx2name(m_fn_idx) << m_push_idx[0] << m_push_idx[1] << m_push_move[0] << m_push_move[1];
+        break;
+    case opcode::Push: case opcode::Move: case opcode::Proj:
         s << m_idx;
         break;
     case opcode::Drop:
@@ -586,7 +760,13 @@ void vm_instr::serialize(serializer & s, std::function<name(unsigned)> const & i
         s << m_pc[0];
         s << m_pc[1];
         break;
-    case opcode::BuiltinCases:
+    case opcode::DestructCases2:
+        s << m_cases_idx2;
+        s << m_cases_move2;
+        s << m_pc[0];
+        s << m_pc[1];
+        break;
+    case opcode::BuiltinCases: case opcode::NatJumpTable:
         s << m_cases_idx;
         // continue on CasesN
     case opcode::CasesN:
@@ -609,19 +789,25 @@ void vm_instr::serialize(serializer & s, std::function<name(unsigned)> const & i
     case opcode::LocalInfo:
         s << m_local_idx << m_local_info->first << m_local_info->second;
         break;
+    case opcode::RInvoke: case opcode::RClosure:
+        s << idx2name(m_fn_idx);
+        write_operands(s, m_operands);
+        break;
+    case opcode::RConstructor:
+        s << m_rcidx;
+        write_operands(s, m_operands);
+        break;
     case opcode::Ret:         case opcode::Destruct:
     case opcode::Unreachable: case opcode::Apply:
         break;
     }
 }
 
-static unsigned read_fn_idx(deserializer & d, name_map<unsigned> const & name2idx) {
-    name n;
-    d >> n;
-    if (auto r = name2idx.find(n))
-        return *r;
-    else
-        throw corrupted_stream_exception();
+/* Function references are stored by name in .olean files. The instruction is created with a dummy
+   function index, and the reference is resolved using \c set_fn_idx when the code is added to the environment. */
+static unsigned read_fn_idx(deserializer & d, name & fn) {
+    d >> fn;
+    return 0;
 }
 
 static void read_cases_pcs(deserializer & d, buffer<unsigned> & pcs) {
@@ -630,21 +816,36 @@ static void read_cases_pcs(deserializer & d, buffer<unsigned> & pcs) {
         pcs.push_back(d.read_unsigned());
 }
 
-static vm_instr read_vm_instr(deserializer & d, name_map<unsigned> const & name2idx) {
+static void read_operands(deserializer & d, buffer<vm_operand> & ops) {
+    unsigned n = d.read_unsigned();
+    for (unsigned j = 0; j < n; j++)
+        ops.push_back(vm_operand(d.read_unsigned()));
+}
+
+static vm_instr read_vm_instr(deserializer & d, name & fn) {
     opcode op = static_cast<opcode>(d.read_char());
     unsigned pc, idx;
     switch (op) {
     case opcode::InvokeGlobal:
-        return mk_invoke_global_instr(read_fn_idx(d, name2idx));
+        return mk_invoke_global_instr(read_fn_idx(d, fn));
     case opcode::InvokeBuiltin:
-        return mk_invoke_builtin_instr(read_fn_idx(d, name2idx));
+        return mk_invoke_builtin_instr(read_fn_idx(d, fn));
     case opcode::InvokeCFun:
-        return mk_invoke_cfun_instr(read_fn_idx(d, name2idx));
+        return mk_invoke_cfun_instr(read_fn_idx(d, fn));
     case opcode::Closure:
-        idx = read_fn_idx(d, name2idx);
+        idx = read_fn_idx(d, fn);
         return mk_closure_instr(idx, d.read_unsigned());
+    case opcode::Push2InvokeGlobal: {
+        idx = read_fn_idx(d, fn);
+        unsigned idx1 = d.read_unsigned();
+        unsigned idx2 = d.read_unsigned();
+        bool move1    = d.read_bool();
+        return mk_push2_invoke_global_instr(idx1, idx2, idx, move1, d.read_bool());
+    }
     case opcode::Push:
         return mk_push_instr(d.read_unsigned());
+    case opcode::Move:
+        return mk_move_instr(d.read_unsigned());
     case opcode::Proj:
         return mk_proj_instr(d.read_unsigned());
     case opcode::Drop:
@@ -657,6 +858,12 @@ static vm_instr read_vm_instr(deserializer & d, name_map<unsigned> const & name2
     case opcode::NatCases:
         pc = d.read_unsigned();
         return mk_nat_cases_instr(pc, d.read_unsigned());
+    case opcode::DestructCases2: {
+        idx = d.read_unsigned();
+        bool move = d.read_bool();
+        pc  = d.read_unsigned();
+        return mk_destruct_cases2_instr(idx, pc, d.read_unsigned(), move);
+    }
     case opcode::CasesN: {
         buffer<unsigned> pcs;
         read_cases_pcs(d, pcs);
@@ -668,6 +875,12 @@ static vm_instr read_vm_instr(deserializer & d, name_map<unsigned> const & name2
         read_cases_pcs(d, pcs);
         return mk_builtin_cases_instr(idx, pcs.size(), pcs.data());
     }
+    case opcode::NatJumpTable: {
+        idx = d.read_unsigned();
+        buffer<unsigned> pcs;
+        read_cases_pcs(d, pcs);
+        return mk_nat_jump_table_instr(idx, pcs.size(), pcs.data());
+    }
     case opcode::SConstructor:
         return mk_sconstructor_instr(d.read_unsigned());
     case opcode::Constructor:
@@ -691,6 +904,24 @@ static vm_instr read_vm_instr(deserializer & d, name_map<unsigned> const & name2
         return mk_unreachable_instr();
     case opcode::Apply:
         return mk_apply_instr();
+    case opcode::RInvoke: {
+        idx = read_fn_idx(d, fn);
+        buffer<vm_operand> ops;
+        read_operands(d, ops);
+        return mk_rinvoke_instr(idx, ops.size(), ops.data());
+    }
+    case opcode::RClosure: {
+        idx = read_fn_idx(d, fn);
+        buffer<vm_operand> ops;
+        read_operands(d, ops);
+        return mk_rclosure_instr(idx, ops.size(), ops.data());
+    }
+    case opcode::RConstructor: {
+        idx = d.read_unsigned();
+        buffer<vm_operand> ops;
+        read_operands(d, ops);
+        return mk_rconstructor_instr(idx, ops.size(), ops.data());
+    }
     }
     lean_unreachable();
 }
@@ -960,12 +1191,14 @@ environment reserve_vm_index(environment const & env, name const & fn, expr cons
         });
 }
 
-static void reserve_reader(deserializer & d, environment & env) {
+static module_modification reserve_reader(deserializer & d) {
     name fn; expr e;
     d >> fn >> e;
-    vm_decls ext = get_extension(env);
-    ext.reserve(fn, e);
-    env = update(env, ext);
+    return [=](environment & env) {
+        vm_decls ext = get_extension(env);
+        ext.reserve(fn, e);
+        env = update(env, ext);
+    };
 }
 
 void serialize_code(serializer & s, unsigned fidx, unsigned_map<vm_decl> const & decls) {
@@ -979,17 +1212,31 @@ void serialize_code(serializer & s, unsigned fidx, unsigned_map<vm_decl> const &
     }
 }
 
-static void code_reader(deserializer & d, environment & env) {
+static module_modification code_reader(deserializer & d) {
     name fn; unsigned code_sz; list<vm_local_info> args_info; optional<pos_info> pos;
     d >> fn >> code_sz >> pos;
     args_info = read_list<vm_local_info>(d);
-    vm_decls ext = get_extension(env);
-    buffer<vm_instr> code;
+    std::vector<vm_instr> code;
+    std::vector<pair<unsigned, name>> fn_refs;
     for (unsigned i = 0; i < code_sz; i++) {
-        code.push_back(read_vm_instr(d, ext.m_name2idx));
-    }
-    ext.update(fn, code_sz, code.data(), args_info, pos, d.get_fname());
-    env = update(env, ext);
+        name ref;
+        code.push_back(read_vm_instr(d, ref));
+        if (!ref.is_anonymous())
+            fn_refs.emplace_back(i, ref);
+    }
+    optional<std::string> olean = d.get_fname();
+    return [=](environment & env) {
+        vm_decls ext = get_extension(env);
+        std::vector<vm_instr> new_code = code;
+        for (auto const & p : fn_refs) {
+            if (auto idx = ext.m_name2idx.find(p.second))
+                new_code[p.first].set_fn_idx(*idx);
+            else
+                throw corrupted_stream_exception();
+        }
+        ext.update(fn, code_sz, new_code.data(), args_info, pos, olean);
+        env = update(env, ext);
+    };
 }
 
 environment update_vm_code(environment const & env, name const & fn, unsigned code_sz, vm_instr const * code,
@@ -1049,12 +1296,20 @@ vm_state::vm_state(environment const & env, options const & opts):
     m_code(nullptr),
     m_fn_idx(g_null_fn_idx),
     m_bp(0) {
+    std::fill(m_recycled, m_recycled + LEAN_VM_MAX_RECYCLED_FIELDS + 1, nullptr);
     if (get_debugger(opts) && has_monitor(env)) {
         debugger_init();
     }
 }
 
 vm_state::~vm_state() {
+    for (unsigned n = 0; n <= LEAN_VM_MAX_RECYCLED_FIELDS; n++) {
+        if (vm_composite * c = m_recycled[n]) {
+            /* the fields of recycled cells are simple objects */
+            c->~vm_composite();
+            get_small_allocator().deallocate(sizeof(vm_composite) + n * sizeof(vm_obj), c);
+        }
+    }
 }
 
 struct vm_state::debugger_state {
@@ -1118,6 +1373,90 @@ void vm_state::update_env(environment const & env) {
     lean_assert(is_eqp(m_builtin_cases_map, ext.m_cases));
 }
 
+void vm_state::rebase(environment const & env, options const & opts) {
+    lean_assert(m_call_stack.empty());
+    m_options     = opts;
+    m_debugging   = false;
+    m_debugger_state_ptr.reset();
+    auto const & ext = get_extension(env);
+    if (!is_eqp(m_decl_map, ext.m_decls)) {
+        unsigned sz = std::min(static_cast<unsigned>(m_decl_vector.size()), ext.m_next_decl_idx);
+        for (unsigned i = 0; i < sz; i++) {
+            if (!m_decl_vector[i]) continue;
+            vm_decl const * d = ext.m_decls.find(i);
+            if (!d || !is_eqp(*d, m_decl_vector[i]))
+                m_decl_vector[i] = vm_decl();
+        }
+        if (m_cache_vector.size() > ext.m_next_decl_idx)
+            m_cache_vector.resize(ext.m_next_decl_idx);
+        for (unsigned i = 0; i < m_cache_vector.size(); i++) {
+            if (!m_cache_vector[i]) continue;
+            vm_decl const * old_d = m_decl_map.find(i);
+            vm_decl const * d     = ext.m_decls.find(i);
+            if (!old_d || !d || !is_eqp(*old_d, *d))
+                m_cache_vector[i] = optional<vm_obj>();
+        }
+        m_decl_map = ext.m_decls;
+    }
+    m_decl_vector.resize(ext.m_next_decl_idx);
+    m_fn_name2idx = ext.m_name2idx;
+    if (!is_eqp(m_builtin_cases_map, ext.m_cases)) {
+        m_builtin_cases_map = ext.m_cases;
+        m_builtin_cases_vector.clear();
+        m_builtin_cases_vector.resize(ext.m_next_cases_idx);
+        m_builtin_cases_names = ext.m_cases_names;
+    }
+    m_env = env;
+    if (get_debugger(opts) && has_monitor(env)) {
+        debugger_init();
+    }
+}
+
+typedef std::vector<vm_state*> vm_state_pool;
+LEAN_THREAD_PTR(vm_state_pool, g_vm_state_pool);
+
+static void finalize_vm_state_pool(void * p) {
+    vm_state_pool * pool = reinterpret_cast<vm_state_pool*>(p);
+    for (vm_state * s : *pool)
+        delete s;
+    delete pool;
+    g_vm_state_pool = nullptr;
+}
+
+pooled_vm_state::pooled_vm_state(environment const & env, options const & opts) {
+    if (g_vm_state_pool && !g_vm_state_pool->empty()) {
+        m_state = g_vm_state_pool->back();
+        g_vm_state_pool->pop_back();
+        m_state->rebase(env, opts);
+    } else {
+        m_state = new vm_state(env, opts);
+    }
+}
+
+pooled_vm_state::~pooled_vm_state() {
+    /* We do not reuse a vm_state that was interrupted by an exception. */
+    if (!m_state->m_call_stack.empty() || m_state->m_profiling || in_thread_finalization()) {
+        delete m_state;
+        return;
+    }
+    if (!g_vm_state_pool) {
+        g_vm_state_pool = new vm_state_pool();
+        register_thread_finalizer(finalize_vm_state_pool, g_vm_state_pool);
+    }
+    if (g_vm_state_pool->size() >= LEAN_VM_STATE_POOL_SIZE) {
+        delete m_state;
+        return;
+    }
+    m_state->m_stack.clear();
+    m_state->m_stack_info.clear();
+    /* Idle states must not keep the environment (and the debugger using it) alive, rebase sets them again.
+       The compiled code and the values of 0-ary declarations are kept, they are the reason for the pool. */
+    m_state->m_env = environment();
+    m_state->m_debugging = false;
+    m_state->m_debugger_state_ptr.reset();
+    g_vm_state_pool->push_back(m_state);
+}
+
 void vm_state::push_fields(vm_obj const & obj) {
     if (is_constructor(obj)) {
         unsigned nflds = csize(obj);
@@ -1128,6 +1467,44 @@ void vm_state::push_fields(vm_obj const & obj) {
     }
 }
 
+/* Similar to push_fields, but \c obj is consumed. If \c obj is the only reference to a constructor cell,
+   then its fields are moved to the stack, and the cell is kept for being reused by mk_composite_from_stack.
+   This is a common pattern in code that destructs an object and builds an updated copy. */
+void vm_state::push_fields_and_recycle(vm_obj & obj) {
+    if (!is_constructor(obj))
+        return;
+    vm_composite * c = to_composite(obj.raw());
+    unsigned nflds   = c->size();
+    if (c->get_rc() == 1 && nflds <= LEAN_VM_MAX_RECYCLED_FIELDS && !m_recycled[nflds]) {
+        vm_obj * flds = c->get_field_ptr();
+        for (unsigned i = 0; i < nflds; i++, flds++)
+            m_stack.push_back(std::move(*flds));
+        obj.steal_ptr();
+        c->m_rc = 0;
+        m_recycled[nflds] = c;
+    } else {
+        push_fields(obj);
+    }
+}
+
+/* Create a constructor or closure using the \c nfields values on the top of the stack.
+   The values are moved, and the caller is responsible for removing them from the stack. */
+vm_obj vm_state::mk_composite_from_stack(vm_obj_kind k, unsigned idx, unsigned nfields) {
+    vm_obj * data = m_stack.data() + m_stack.size() - nfields;
+    vm_composite * c;
+    if (k == vm_obj_kind::Constructor && nfields <= LEAN_VM_MAX_RECYCLED_FIELDS && m_recycled[nfields]) {
+        c = m_recycled[nfields];
+        m_recycled[nfields] = nullptr;
+        c->m_idx = idx;
+    } else {
+        c = new (get_small_allocator().allocate(sizeof(vm_composite) + nfields * sizeof(vm_obj))) vm_composite(k, idx, nfields);
+    }
+    vm_obj * flds = c->get_field_ptr();
+    for (unsigned i = 0; i < nfields; i++)
+        flds[i] = std::move(data[i]);
+    return vm_obj(c);
+}
+
 void vm_state::shrink_stack_info() {
     if (m_stack.empty()) {
         m_stack_info.clear();
@@ -1145,6 +1522,65 @@ void vm_state::stack_pop_back() {
         m_stack_info.resize(m_stack.size());
 }
 
+/* Push the local \c idx of the current frame. When \c move is true, the local is not used anymore (see opcode::Move),
+   and it is moved instead of copied. The debugger displays the locals, so they are copied when debugging. */
+void vm_state::push_local(unsigned idx, bool move) {
+    vm_obj & a = m_stack[m_bp + idx];
+    if (move && !m_debugging) {
+        vm_obj v = std::move(a);
+        m_stack.push_back(std::move(v));
+    } else {
+        m_stack.push_back(a);
+    }
+}
+
+/* Push the arguments of a register-based instruction (see vm_operand). The values of the Stack operands are
+   already on the top of the stack, so they are moved to their final positions. */
+void vm_state::push_operands(vm_instr const & instr) {
+    auto read = [&](vm_operand const & o) {
+        switch (o.kind()) {
+        case vm_operand_kind::Local:
+            return m_stack[m_bp + o.value()];
+        case vm_operand_kind::MoveLocal:
+            if (m_debugging)
+                return m_stack[m_bp + o.value()];
+            else
+                return vm_obj(std::move(m_stack[m_bp + o.value()]));
+        case vm_operand_kind::Simple:
+            return mk_vm_simple(o.value());
+        case vm_operand_kind::Stack:
+            break;
+        }
+        lean_unreachable();
+    };
+    unsigned num    = instr.get_num_operands();
+    unsigned nstack = instr.get_num_stack_operands();
+    if (nstack == 0) {
+        for (unsigned i = 0; i < num; i++) {
+            vm_obj v = read(instr.get_operand(i));
+            m_stack.push_back(std::move(v));
+        }
+        return;
+    }
+    unsigned base = m_stack.size() - nstack;
+    m_stack.resize(base + num);
+    unsigned i = num;
+    unsigned j = nstack;
+    while (j > 0) {
+        --i;
+        if (instr.get_operand(i).kind() == vm_operand_kind::Stack) {
+            --j;
+            if (i != j)
+                m_stack[base + i] = std::move(m_stack[base + j]);
+        }
+    }
+    for (unsigned i = 0; i < num; i++) {
+        vm_operand o = instr.get_operand(i);
+        if (o.kind() != vm_operand_kind::Stack)
+            m_stack[base + i] = read(o);
+    }
+}
+
 void vm_state::invoke_builtin(vm_decl const & d) {
     if (m_profiling) {
         unique_lock<mutex> lk(m_call_stack_mtx);
@@ -1174,51 +1610,59 @@ void vm_state::invoke_cfun(vm_decl const & d) {
     unsigned arity = d.get_arity();
     vm_obj r;
     /* Important The stack m_stack may be resized during the execution of the function d.get_cfn().
-       Thus, to make sure the arguments are not garbage collected, we copy them into local variables a1 ... an.
-       The copy operation will bump the reference counter. */
+       Thus, to make sure the arguments are not garbage collected, we move them into local variables a1 ... an.
+       The arguments are removed from the stack after the call anyway, and moving them does not bump the
+       reference counter. So, the function can update an argument in place when it is not shared
+       (e.g., array.write). We copy them when debugging, since the debugger may display the stack. */
+    auto arg = [&](unsigned i) {
+        if (m_debugging)
+            return vm_obj(S[i]);
+        else
+            return vm_obj(std::move(S[i]));
+    };
     switch (arity) {
     case 0:
         r = reinterpret_cast<vm_cfunction_0>(d.get_cfn())();
         break;
     case 1: {
-        vm_obj a1 = S[sz-1];
+        vm_obj a1 = arg(sz - 1);
         r = reinterpret_cast<vm_cfunction_1>(d.get_cfn())(a1);
         break;
     }
     case 2: {
-        vm_obj a1 = S[sz - 1], a2 = S[sz - 2];
+        vm_obj a1 = arg(sz - 1), a2 = arg(sz - 2);
         r = reinterpret_cast<vm_cfunction_2>(d.get_cfn())(a1, a2);
         break;
     }
     case 3: {
-        vm_obj a1 = S[sz - 1], a2 = S[sz - 2], a3 = S[sz - 3];
+        vm_obj a1 = arg(sz - 1), a2 = arg(sz - 2), a3 = arg(sz - 3);
         r = reinterpret_cast<vm_cfunction_3>(d.get_cfn())(a1, a2, a3);
         break;
     }
     case 4: {
-        vm_obj a1 = S[sz - 1], a2 = S[sz - 2], a3 = S[sz - 3], a4 = S[sz - 4];
+        vm_obj a1 = arg(sz - 1), a2 = arg(sz - 2), a3 = arg(sz - 3), a4 = arg(sz - 4);
         r = reinterpret_cast<vm_cfunction_4>(d.get_cfn())(a1, a2, a3, a4);
         break;
     }
     case 5: {
-        vm_obj a1 = S[sz - 1], a2 = S[sz - 2], a3 = S[sz - 3], a4 = S[sz - 4], a5 = S[sz - 5];
+        vm_obj a1 = arg(sz - 1), a2 = arg(sz - 2), a3 = arg(sz - 3), a4 = arg(sz - 4), a5 = arg(sz - 5);
         r = reinterpret_cast<vm_cfunction_5>(d.get_cfn())(a1, a2, a3, a4, a5);
         break;
     }
     case 6: {
-        vm_obj a1 = S[sz - 1], a2 = S[sz - 2], a3 = S[sz - 3], a4 = S[sz - 4], a5 = S[sz - 5], a6 = S[sz - 6];
+        vm_obj a1 = arg(sz - 1), a2 = arg(sz - 2), a3 = arg(sz - 3), a4 = arg(sz - 4), a5 = arg(sz - 5), a6 = arg(sz - 6);
         r = reinterpret_cast<vm_cfunction_6>(d.get_cfn())(a1, a2, a3, a4, a5, a6);
         break;
     }
     case 7: {
-        vm_obj a1 = S[sz - 1], a2 = S[sz - 2], a3 = S[sz - 3], a4 = S[sz - 4], a5 = S[sz - 5], a6 = S[sz - 6];
-        vm_obj a7 = S[sz - 7];
+        vm_obj a1 = arg(sz - 1), a2 = arg(sz - 2), a3 = arg(sz - 3), a4 = arg(sz - 4), a5 = arg(sz - 5), a6 = arg(sz - 6);
+        vm_obj a7 = arg(sz - 7);
         r = reinterpret_cast<vm_cfunction_7>(d.get_cfn())(a1, a2, a3, a4, a5, a6, a7);
         break;
     }
     case 8: {
-        vm_obj a1 = S[sz - 1], a2 = S[sz - 2], a3 = S[sz - 3], a4 = S[sz - 4], a5 = S[sz - 5], a6 = S[sz - 6];
-        vm_obj a7 = S[sz - 7], a8 = S[sz - 8];
+        vm_obj a1 = arg(sz - 1), a2 = arg(sz - 2), a3 = arg(sz - 3), a4 = arg(sz - 4), a5 = arg(sz - 5), a6 = arg(sz - 6);
+        vm_obj a7 = arg(sz - 7), a8 = arg(sz - 8);
         r = reinterpret_cast<vm_cfunction_8>(d.get_cfn())(a1, a2, a3, a4, a5, a6, a7, a8);
         break;
     }
@@ -1227,7 +1671,7 @@ void vm_state::invoke_cfun(vm_decl const & d) {
         unsigned i = sz;
         while (i > sz - arity) {
             --i;
-            args.push_back(m_stack[i]);
+            args.push_back(arg(i));
         }
         lean_assert(args.size() == arity);
         r = reinterpret_cast<vm_cfunction_N>(d.get_cfn())(args.size(), args.data());
@@ -1977,6 +2421,26 @@ void vm_state::run() {
             m_stack.push_back(m_stack[m_bp + instr.get_idx()]);
             m_pc++;
             goto main_loop;
+        case opcode::Move: {
+            /* Instruction: move i
+
+               Similar to push i, but a_i is not used anymore, so it is moved instead of copied.
+               Thus, the reference counter of a_i is not incremented, and builtins such as array.write
+               can update it in place.
+
+               stack before,      after
+               ...                ...
+               bp :  a_0          bp :  a_0
+               ...                ...
+               a_i  ==>           #0
+               ...                ...
+               v                  v
+                                  a_i
+            */
+            push_local(instr.get_idx(), true);
+            m_pc++;
+            goto main_loop;
+        }
         case opcode::Drop: {
             /* Instruction: drop n
 
@@ -2027,7 +2491,7 @@ void vm_state::run() {
             */
             unsigned nfields = instr.get_nfields();
             unsigned sz      = m_stack.size();
-            vm_obj new_value = mk_vm_constructor(instr.get_cidx(), nfields, m_stack.data() + sz - nfields);
+            vm_obj new_value = mk_composite_from_stack(vm_obj_kind::Constructor, instr.get_cidx(), nfields);
             m_stack.resize(sz - nfields + 1);
             swap(m_stack.back(), new_value);
             if (m_debugging) shrink_stack_info();
@@ -2046,7 +2510,7 @@ void vm_state::run() {
             */
             unsigned nargs     = instr.get_nargs();
             unsigned sz        = m_stack.size();
-            vm_obj new_value   = mk_vm_closure(instr.get_fn_idx(), nargs, m_stack.data() + sz - nargs);
+            vm_obj new_value   = mk_composite_from_stack(vm_obj_kind::Closure, instr.get_fn_idx(), nargs);
             m_stack.resize(sz - nargs + 1);
             swap(m_stack.back(), new_value);
             if (m_debugging) shrink_stack_info();
@@ -2090,9 +2554,9 @@ void vm_state::run() {
                 ...
                 a_n
             */
-            vm_obj top = m_stack.back();
+            vm_obj top = std::move(m_stack.back());
             stack_pop_back();
-            push_fields(top);
+            push_fields_and_recycle(top);
             m_pc++;
             goto main_loop;
         }
@@ -2109,10 +2573,39 @@ void vm_state::run() {
                 m_pc := pc1  if  i == 0
                 := pc2  if  i == 1
             */
-            vm_obj top = m_stack.back();
+            vm_obj top = std::move(m_stack.back());
+            stack_pop_back();
+            unsigned i = cidx(top);
+            push_fields_and_recycle(top);
+            m_pc = instr.get_cases2_pc(i);
+            goto main_loop;
+        }
+        case opcode::DestructCases2: {
+            /** Instruction: destruct_cases2 i pc1 pc2
+
+                Superinstruction equivalent to
+
+                destruct
+                push i
+                cases2 pc1 pc2
+
+                where push i may be a move.
+            */
+            vm_obj top = std::move(m_stack.back());
             stack_pop_back();
-            push_fields(top);
-            m_pc = instr.get_cases2_pc(cidx(top));
+            push_fields_and_recycle(top);
+            vm_obj & a = m_stack[m_bp + instr.get_destruct_cases2_idx()];
+            unsigned i;
+            if (instr.is_destruct_cases2_move() && !m_debugging) {
+                top = std::move(a);
+                i   = cidx(top);
+                push_fields_and_recycle(top);
+            } else {
+                top = a;
+                i   = cidx(top);
+                push_fields(top);
+            }
+            m_pc = instr.get_cases2_pc(i);
             goto main_loop;
         }
         case opcode::NatCases: {
@@ -2165,10 +2658,11 @@ void vm_state::run() {
 
                 m_pc := pc_i
             */
-            vm_obj top = m_stack.back();
+            vm_obj top = std::move(m_stack.back());
             stack_pop_back();
-            push_fields(top);
-            m_pc = instr.get_casesn_pc(cidx(top));
+            unsigned i = cidx(top);
+            push_fields_and_recycle(top);
+            m_pc = instr.get_casesn_pc(i);
             goto main_loop;
         }
         case opcode::BuiltinCases: {
@@ -2184,6 +2678,29 @@ void vm_state::run() {
             m_pc = instr.get_casesn_pc(cidx);
             goto main_loop;
         }
+        case opcode::NatJumpTable: {
+            /** Instruction: nat_jump_table lower pc_0 ... pc_[n-1]
+
+                stack before,              after
+                ...                        ...
+                v                 ==>      v
+                k
+
+                m_pc := pc_(k - lower)  if  lower <= k < lower + n - 1
+                := pc_[n-1]     otherwise
+            */
+            vm_obj top = std::move(m_stack.back());
+            stack_pop_back();
+            unsigned last = instr.get_casesn_size() - 1;
+            unsigned i    = last;
+            if (is_simple(top)) {
+                unsigned k = cidx(top);
+                if (k >= instr.get_jump_table_lower() && k - instr.get_jump_table_lower() < last)
+                    i = k - instr.get_jump_table_lower();
+            }
+            m_pc = instr.get_casesn_pc(i);
+            goto main_loop;
+        }
         case opcode::Proj: {
             /** Instruction: proj i
 
@@ -2194,7 +2711,13 @@ void vm_state::run() {
 
             */
             vm_obj & top = m_stack.back();
-            top = cfield(top, instr.get_idx());
+            if (top.raw()->get_rc() == 1) {
+                /* top is not shared, so we move the field instead of copying it */
+                vm_obj fld = std::move(to_composite(top.raw())->get_field_ptr()[instr.get_idx()]);
+                top = std::move(fld);
+            } else {
+                top = cfield(top, instr.get_idx());
+            }
             m_pc++;
             goto main_loop;
         }
@@ -2323,6 +2846,33 @@ void vm_state::run() {
             invoke_global(decl);
             goto main_loop;
         }
+        case opcode::Push2InvokeGlobal: {
+            check_interrupted();
+            check_memory("vm");
+            /**
+               Instruction: push2_ginvoke i j fn
+
+               Superinstruction equivalent to
+
+               push i
+               push j
+               ginvoke fn
+
+               where each push may be a move.
+            */
+            push_local(instr.get_push_idx(0), instr.is_push_move(0));
+            push_local(instr.get_push_idx(1), instr.is_push_move(1));
+            vm_decl decl = get_decl(instr.get_fn_idx());
+            if (decl.get_arity() == 0 && decl.get_idx() < m_cache_vector.size()) {
+                if (auto r = m_cache_vector[decl.get_idx()]) {
+                    m_stack.push_back(*r);
+                    m_pc++;
+                    goto main_loop;
+                }
+            }
+            invoke_global(decl);
+            goto main_loop;
+        }
         case opcode::InvokeBuiltin: {
             check_interrupted();
             check_memory("vm");
@@ -2355,6 +2905,53 @@ void vm_state::run() {
             vm_decl decl = get_decl(instr.get_fn_idx());
             invoke_cfun(decl);
             goto main_loop;
+        }
+        case opcode::RInvoke: {
+            check_interrupted();
+            check_memory("vm");
+            /**
+               Instruction: rinvoke fn, o_n ... o_1
+
+               Push the operands o_n ... o_1 (see vm_operand), and then
+               it is similar to InvokeGlobal, InvokeBuiltin or InvokeCFun depending on fn.
+               The arity of fn is n.
+            */
+            push_operands(instr);
+            vm_decl decl = get_decl(instr.get_fn_idx());
+            invoke(decl);
+            goto main_loop;
+        }
+        case opcode::RClosure: {
+            /**
+               Instruction: rclosure fn, o_n ... o_1
+
+               Push the operands o_n ... o_1, and then it is similar to Closure.
+            */
+            push_operands(instr);
+            unsigned nargs   = instr.get_num_operands();
+            unsigned sz      = m_stack.size();
+            vm_obj new_value = mk_composite_from_stack(vm_obj_kind::Closure, instr.get_fn_idx(), nargs);
+            m_stack.resize(sz - nargs + 1);
+            swap(m_stack.back(), new_value);
+            if (m_debugging) shrink_stack_info();
+            m_pc++;
+            goto main_loop;
+        }
+        case opcode::RConstructor: {
+            /**
+               Instruction: rcnstr i, o_1 ... o_n
+
+               Push the operands o_1 ... o_n, and then it is similar to Constructor.
+            */
+            push_operands(instr);
+            unsigned nfields = instr.get_num_operands();
+            unsigned sz      = m_stack.size();
+            vm_obj new_value = mk_composite_from_stack(vm_obj_kind::Constructor, instr.get_rconstructor_cidx(), nfields);
+            m_stack.resize(sz - nfields + 1);
+            swap(m_stack.back(), new_value);
+            if (m_debugging) shrink_stack_info();
+            m_pc++;
+            goto main_loop;
         }}
     }
 }
@@ -2682,12 +3279,14 @@ environment load_external_fn(environment & env, name const & extern_n) {
     }
 }
 
-static void vm_monitor_reader(deserializer & d, environment & env) {
+static module_modification vm_monitor_reader(deserializer & d) {
     name n;
     d >> n;
-    vm_decls ext = get_extension(env);
-    ext.m_monitor = n;
-    env = update(env, ext);
+    return [=](environment & env) {
+        vm_decls ext = get_extension(env);
+        ext.m_monitor = n;
+        env = update(env, ext);
+    };
 }
 
 void initialize_vm_core() {
@@ -56,6 +56,7 @@ void display(std::ostream & out, vm_obj const & o);
 class vm_obj {
     vm_obj_cell * m_data;
     friend class vm_obj_cell;
+    friend class vm_state;
     vm_obj_cell * steal_ptr() {
         lean_assert(LEAN_VM_IS_PTR(m_data)); vm_obj_cell * r = m_data; m_data = LEAN_VM_BOX(0); return r;
     }
@@ -107,9 +108,12 @@ class vm_composite : public vm_obj_cell {
         return reinterpret_cast<vm_obj *>(reinterpret_cast<char *>(this)+sizeof(vm_composite));
     }
     friend vm_obj_cell;
+    friend class vm_state;
     void dealloc(buffer<vm_obj_cell*> & todelete);
 public:
     vm_composite(vm_obj_kind k, unsigned idx, unsigned sz, vm_obj const * data);
+    /** \brief Create a composite object where all fields are the simple object 0. */
+    vm_composite(vm_obj_kind k, unsigned idx, unsigned sz);
     unsigned size() const { return m_size; }
     unsigned idx() const { return m_idx; }
     vm_obj const * fields() const {
@@ -201,6 +205,12 @@ inline bool to_bool(vm_obj const & o) { return cidx(o) != 0; }
 
 #define LEAN_MAX_SMALL_NAT (1u << 31)
 
+/* Constructor cells with at most LEAN_VM_MAX_RECYCLED_FIELDS fields may be reused in place by the VM,
+   see vm_state::push_fields_and_recycle */
+#ifndef LEAN_VM_MAX_RECYCLED_FIELDS
+#define LEAN_VM_MAX_RECYCLED_FIELDS 8
+#endif
+
 class vm_state;
 
 /** Builtin functions that take arguments from the VM stack. */
@@ -237,7 +247,42 @@ enum class opcode {
     SConstructor, Constructor, Num,
     Destruct, Cases2, CasesN, NatCases, BuiltinCases, Proj,
     Apply, InvokeGlobal, InvokeBuiltin, InvokeCFun,
-    Closure, Unreachable, Pexpr, LocalInfo
+    Closure, Unreachable, Pexpr, LocalInfo,
+    /* Superinstructions, see fuse_superinstructions at library/vm/optimize.h */
+    Push2InvokeGlobal, DestructCases2,
+    /* Jump tables for matching on values, see compile_value_switch at library/compiler/vm_compiler.cpp */
+    NatJumpTable,
+    /* Push the last use of a local, see move_last_uses at library/vm/optimize.cpp */
+    Move,
+    /* Register-based encoding, the arguments are given as operands, see vm_operand */
+    RInvoke, RClosure, RConstructor
+};
+
+enum class vm_operand_kind { Local, MoveLocal, Simple, Stack };
+
+/** \brief Operand of the instructions RInvoke, RClosure and RConstructor.
+    These instructions read their arguments from the locals of the current frame (the registers),
+    instead of expecting them on the top of the stack. So, the arguments do not have to be pushed
+    by separate instructions. An operand is one of the following:
+
+    - Local i:     the local i is copied.
+    - MoveLocal i: the local i is moved, it is the last use of the local (see opcode::Move).
+    - Simple i:    the simple object #i.
+    - Stack:       the argument has been computed by the previous instructions, and it is on the stack.
+                   The Stack operands are the values on the top of the stack, in the same order.
+
+    The operands are encoded in a single unsigned, so their value must be smaller than 2^30. */
+class vm_operand {
+    unsigned m_data;
+public:
+    vm_operand(vm_operand_kind k, unsigned v):m_data((v << 2) | static_cast<unsigned>(k)) {
+        lean_assert(fits(v));
+    }
+    explicit vm_operand(unsigned data):m_data(data) {}
+    static bool fits(unsigned v) { return v < (1u << 30); }
+    vm_operand_kind kind() const { return static_cast<vm_operand_kind>(m_data & 3); }
+    unsigned value() const { lean_assert(kind() != vm_operand_kind::Stack); return m_data >> 2; }
+    unsigned raw() const { return m_data; }
 };
 
 /** \brief VM instructions */
@@ -245,20 +290,36 @@ class vm_instr {
     opcode m_op;
     union {
         struct {
-            unsigned m_fn_idx;  /* InvokeGlobal, InvokeBuiltin, InvokeCFun and Closure. */
-            unsigned m_nargs;   /* Closure */
+            /* InvokeGlobal, InvokeBuiltin, InvokeCFun, Closure, Push2InvokeGlobal, RInvoke and RClosure */
+            union {
+                unsigned m_fn_idx;
+                unsigned m_rcidx;   /* RConstructor */
+            };
+            bool m_push_move[2];        /* Push2InvokeGlobal, true if the local is moved (see opcode::Move) */
+            union {
+                unsigned m_nargs;       /* Closure */
+                unsigned m_push_idx[2]; /* Push2InvokeGlobal */
+                /* RInvoke, RClosure and RConstructor: the number of operands, the number of Stack operands,
+                   and the operands (see vm_operand::raw) */
+                unsigned * m_operands;
+            };
         };
-        /* Push, Proj */
+        /* Push, Move, Proj */
         unsigned m_idx;
         /* Drop */
         unsigned m_num;
-        /* Goto, Cases2 and NatCases */
+        /* Goto, Cases2, NatCases and DestructCases2 */
         struct {
             unsigned m_pc[2];
+            unsigned m_cases_idx2;  /* only used for DestructCases2 */
+            bool     m_cases_move2; /* only used for DestructCases2, true if the local is moved */
         };
-        /* CasesN and BuiltinCases */
+        /* CasesN, BuiltinCases and NatJumpTable */
         struct {
-            unsigned   m_cases_idx; /* only used for BuiltinCases */
+            union {
+                unsigned m_cases_idx; /* only used for BuiltinCases */
+                unsigned m_lower;     /* only used for NatJumpTable */
+            };
             unsigned * m_npcs;
         };
         /* Constructor, SConstructor */
@@ -278,6 +339,7 @@ class vm_instr {
     };
     /* Apply, Ret, Destruct and Unreachable do not have arguments */
     friend vm_instr mk_push_instr(unsigned idx);
+    friend vm_instr mk_move_instr(unsigned idx);
     friend vm_instr mk_drop_instr(unsigned n);
     friend vm_instr mk_proj_instr(unsigned n);
     friend vm_instr mk_goto_instr(unsigned pc);
@@ -291,6 +353,15 @@ class vm_instr {
     friend vm_instr mk_cases2_instr(unsigned pc1, unsigned pc2);
     friend vm_instr mk_casesn_instr(unsigned num_pc, unsigned const * pcs);
     friend vm_instr mk_builtin_cases_instr(unsigned cases_idx, unsigned num_pc, unsigned const * pcs);
+    friend vm_instr mk_nat_jump_table_instr(unsigned lower, unsigned num_pc, unsigned const * pcs);
+/** \brief Register-based version of <tt>ginvoke fn_idx</tt>, <tt>builtin fn_idx</tt> and <tt>cfun fn_idx</tt>.
+    The \c num arguments are given by the operands \c ops, in the order they would be pushed.
+    The arity of the function must be \c num. */
+vm_instr mk_rinvoke_instr(unsigned fn_idx, unsigned num, vm_operand const * ops);
+/** \brief Register-based version of <tt>closure fn_idx num</tt> */
+vm_instr mk_rclosure_instr(unsigned fn_idx, unsigned num, vm_operand const * ops);
+/** \brief Register-based version of <tt>cnstr cidx num</tt> */
+vm_instr mk_rconstructor_instr(unsigned cidx, unsigned num, vm_operand const * ops);
     friend vm_instr mk_apply_instr();
     friend vm_instr mk_invoke_global_instr(unsigned fn_idx);
     friend vm_instr mk_invoke_cfun_instr(unsigned fn_idx);
@@ -298,6 +369,11 @@ class vm_instr {
     friend vm_instr mk_closure_instr(unsigned fn_idx, unsigned n);
     friend vm_instr mk_pexpr_instr(expr const & e);
     friend vm_instr mk_local_info_instr(unsigned idx, name const & n, optional<expr> const & e);
+    friend vm_instr mk_push2_invoke_global_instr(unsigned idx1, unsigned idx2, unsigned fn_idx, bool move1, bool move2);
+    friend vm_instr mk_destruct_cases2_instr(unsigned idx, unsigned pc1, unsigned pc2, bool move);
+    friend vm_instr mk_rinvoke_instr(unsigned fn_idx, unsigned num, vm_operand const * ops);
+    friend vm_instr mk_rclosure_instr(unsigned fn_idx, unsigned num, vm_operand const * ops);
+    friend vm_instr mk_rconstructor_instr(unsigned cidx, unsigned num, vm_operand const * ops);
 
     void copy_args(vm_instr const & i);
 public:
@@ -314,17 +390,75 @@ public:
 
     unsigned get_fn_idx() const {
         lean_assert(m_op == opcode::InvokeGlobal || m_op == opcode::InvokeBuiltin ||
-                    m_op == opcode::InvokeCFun || m_op == opcode::Closure);
+                    m_op == opcode::InvokeCFun || m_op == opcode::Closure ||
+                    m_op == opcode::Push2InvokeGlobal || m_op == opcode::RInvoke || m_op == opcode::RClosure);
         return m_fn_idx;
     }
 
+    void set_fn_idx(unsigned fn_idx) {
+        lean_assert(m_op == opcode::InvokeGlobal || m_op == opcode::InvokeBuiltin ||
+                    m_op == opcode::InvokeCFun || m_op == opcode::Closure ||
+                    m_op == opcode::Push2InvokeGlobal || m_op == opcode::RInvoke || m_op == opcode::RClosure);
+        m_fn_idx = fn_idx;
+    }
+
+    bool has_operands() const {
+        return m_op == opcode::RInvoke || m_op == opcode::RClosure || m_op == opcode::RConstructor;
+    }
+
+    unsigned get_num_operands() const {
+        lean_assert(has_operands());
+        return m_operands[0];
+    }
+
+    unsigned get_num_stack_operands() const {
+        lean_assert(has_operands());
+        return m_operands[1];
+    }
+
+    vm_operand get_operand(unsigned i) const {
+        lean_assert(has_operands());
+        lean_assert(i < get_num_operands());
+        return vm_operand(m_operands[i+2]);
+    }
+
+    /* \remark The new operand must be a Stack operand iff the old one is. */
+    void set_operand(unsigned i, vm_operand const & o) {
+        lean_assert(has_operands());
+        lean_assert(i < get_num_operands());
+        lean_assert((get_operand(i).kind() == vm_operand_kind::Stack) == (o.kind() == vm_operand_kind::Stack));
+        m_operands[i+2] = o.raw();
+    }
+
+    unsigned get_push_idx(unsigned i) const {
+        lean_assert(m_op == opcode::Push2InvokeGlobal);
+        lean_assert(i < 2);
+        return m_push_idx[i];
+    }
+
+    bool is_push_move(unsigned i) const {
+        lean_assert(m_op == opcode::Push2InvokeGlobal);
+        lean_assert(i < 2);
+        return m_push_move[i];
+    }
+
+    unsigned get_destruct_cases2_idx() const {
+        lean_assert(m_op == opcode::DestructCases2);
+        return m_cases_idx2;
+    }
+
+    bool is_destruct_cases2_move() const {
+        lean_assert(m_op == opcode::DestructCases2);
+        return m_cases_move2;
+    }
+
     unsigned get_nargs() const {
         lean_assert(m_op == opcode::Closure);
         return m_nargs;
     }
 
     unsigned get_idx() const {
-        lean_assert(m_op == opcode::Push || m_op == opcode::Proj);
+        lean_assert(m_op == opcode::Push || m_op == opcode::Move || m_op == opcode::Proj);
         return m_idx;
     }
 
@@ -344,13 +478,13 @@ public:
     }
 
     unsigned get_cases2_pc(unsigned i) const {
-        lean_assert(m_op == opcode::Cases2 || m_op == opcode::NatCases);
+        lean_assert(m_op == opcode::Cases2 || m_op == opcode::NatCases || m_op == opcode::DestructCases2);
         lean_assert(i < 2);
         return m_pc[i];
     }
 
     void set_cases2_pc(unsigned i, unsigned pc) {
-        lean_assert(m_op == opcode::Cases2 || m_op == opcode::NatCases);
+        lean_assert(m_op == opcode::Cases2 || m_op == opcode::NatCases || m_op == opcode::DestructCases2);
         lean_assert(i < 2);
         m_pc[i] = pc;
     }
@@ -360,19 +494,24 @@ public:
         return m_cases_idx;
     }
 
+    unsigned get_jump_table_lower() const {
+        lean_assert(m_op == opcode::NatJumpTable);
+        return m_lower;
+    }
+
     unsigned get_casesn_size() const {
-        lean_assert(m_op == opcode::CasesN || m_op == opcode::BuiltinCases);
+        lean_assert(m_op == opcode::CasesN || m_op == opcode::BuiltinCases || m_op == opcode::NatJumpTable);
         return m_npcs[0];
     }
 
     unsigned get_casesn_pc(unsigned i) const {
-        lean_assert(m_op == opcode::CasesN || m_op == opcode::BuiltinCases);
+        lean_assert(m_op == opcode::CasesN || m_op == opcode::BuiltinCases || m_op == opcode::NatJumpTable);
         lean_assert(i < get_casesn_size());
         return m_npcs[i+1];
     }
 
     void set_casesn_pc(unsigned i, unsigned pc) const {
-        lean_assert(m_op == opcode::CasesN || m_op == opcode::BuiltinCases);
+        lean_assert(m_op == opcode::CasesN || m_op == opcode::BuiltinCases || m_op == opcode::NatJumpTable);
         lean_assert(i < get_casesn_size());
         m_npcs[i+1] = pc;
     }
@@ -382,6 +521,11 @@ public:
         return m_cidx;
     }
 
+    unsigned get_rconstructor_cidx() const {
+        lean_assert(m_op == opcode::RConstructor);
+        return m_rcidx;
+    }
+
     unsigned get_nfields() const {
         lean_assert(m_op == opcode::Constructor);
         return m_nfields;
@@ -420,6 +564,7 @@ public:
 };
 
 vm_instr mk_push_instr(unsigned idx);
+vm_instr mk_move_instr(unsigned idx);
 vm_instr mk_drop_instr(unsigned n);
 vm_instr mk_proj_instr(unsigned n);
 vm_instr mk_goto_instr(unsigned pc);
@@ -440,6 +585,22 @@ vm_instr mk_invoke_builtin_instr(unsigned fn_idx);
 vm_instr mk_closure_instr(unsigned fn_idx, unsigned n);
 vm_instr mk_pexpr_instr(expr const & e);
 vm_instr mk_local_info_instr(unsigned idx, name const & n, optional<expr> const & e);
+/** \brief Superinstruction equivalent to <tt>push idx1; push idx2; ginvoke fn_idx</tt> */
+vm_instr mk_push2_invoke_global_instr(unsigned idx1, unsigned idx2, unsigned fn_idx, bool move1, bool move2);
+/** \brief Superinstruction equivalent to <tt>destruct; push idx; cases2 pc1 pc2</tt> */
+vm_instr mk_destruct_cases2_instr(unsigned idx, unsigned pc1, unsigned pc2, bool move);
+/** \brief Jump table for a natural number \c n at the top of the stack.
+    It jumps to <tt>pcs[n - lower]</tt> if <tt>lower <= n < lower + num_pc - 1</tt>,
+    and to the last pc <tt>pcs[num_pc - 1]</tt> otherwise. */
+vm_instr mk_nat_jump_table_instr(unsigned lower, unsigned num_pc, unsigned const * pcs);
+/** \brief Register-based version of <tt>ginvoke fn_idx</tt>, <tt>builtin fn_idx</tt> and <tt>cfun fn_idx</tt>.
+    The \c num arguments are given by the operands \c ops, in the order they would be pushed.
+    The arity of the function must be \c num. */
+vm_instr mk_rinvoke_instr(unsigned fn_idx, unsigned num, vm_operand const * ops);
+/** \brief Register-based version of <tt>closure fn_idx num</tt> */
+vm_instr mk_rclosure_instr(unsigned fn_idx, unsigned num, vm_operand const * ops);
+/** \brief Register-based version of <tt>cnstr cidx num</tt> */
+vm_instr mk_rconstructor_instr(unsigned cidx, unsigned num, vm_operand const * ops);
 
 class vm_state;
 class vm_instr;
@@ -493,6 +654,7 @@ public:
     ~vm_decl() { if (m_ptr) m_ptr->dec_ref(); }
 
     friend void swap(vm_decl & a, vm_decl & b) { std::swap(a.m_ptr, b.m_ptr); }
+    friend bool is_eqp(vm_decl const & a, vm_decl const & b) { return a.m_ptr == b.m_ptr; }
 
     vm_decl & operator=(vm_decl const & s) { LEAN_COPY_REF(s); }
     vm_decl & operator=(vm_decl && s) { LEAN_MOVE_REF(s); }
@@ -554,6 +716,9 @@ class vm_state {
             m_curr_fn_idx(curr_fn_idx), m_frame_idx(frame_idx) {}
     };
     std::vector<vm_obj>         m_stack;
+    /* m_recycled[n] (if not null) is a constructor cell with n fields that is not referenced anymore.
+       It is reused by the next constructor instruction with n fields. */
+    vm_composite *              m_recycled[LEAN_VM_MAX_RECYCLED_FIELDS + 1];
     std::vector<vm_local_info>  m_stack_info;
     std::vector<frame>          m_call_stack;
     mutex                       m_call_stack_mtx; /* used only when profiling */
@@ -567,6 +732,10 @@ class vm_state {
     void shrink_stack_info();
     void stack_pop_back();
     void push_fields(vm_obj const & obj);
+    void push_fields_and_recycle(vm_obj & obj);
+    void push_local(unsigned idx, bool move);
+    void push_operands(vm_instr const & instr);
+    vm_obj mk_composite_from_stack(vm_obj_kind k, unsigned idx, unsigned nfields);
     void push_frame_core(unsigned num, unsigned next_pc, unsigned next_fn_idx);
     void push_frame(unsigned num, unsigned next_pc, unsigned next_fn_idx);
     unsigned pop_frame_core();
@@ -587,6 +756,8 @@ class vm_state {
         return m_decl_vector[idx];
     }
 
+    friend class pooled_vm_state;
+
     vm_cases_function const & get_builtin_cases(unsigned idx) const {
         lean_assert(idx < m_builtin_cases_vector.size());
         vm_cases_function const & fn = m_builtin_cases_vector[idx];
@@ -603,6 +774,11 @@ public:
 
     void update_env(environment const & env);
 
+    /** \brief Prepare this (idle) vm_state for executing code in \c env, which does not need to be a
+        descendant of the current environment. The declarations already retrieved, and the values of
+        0-ary declarations are kept when the code of the declaration is the same in both environments. */
+    void rebase(environment const & env, options const & opts);
+
     options const & get_options() const { return m_options; }
 
     /** \brief Push object into the data stack */
@@ -746,6 +922,19 @@ public:
 /** \brief Return reference to thread local VM state object. */
 vm_state & get_vm_state();
 
+/** \brief vm_state for executing code in \c env. It is taken from a thread local pool, and it is returned
+    to the pool when this object is destroyed. So, the values of 0-ary declarations (e.g., configuration
+    objects) are not evaluated again by each tactic block, see vm_state::rebase. */
+class pooled_vm_state {
+    vm_state * m_state;
+public:
+    pooled_vm_state(environment const & env, options const & opts);
+    pooled_vm_state(pooled_vm_state const &) = delete;
+    ~pooled_vm_state();
+    vm_state & operator*() const { return *m_state; }
+    vm_state * operator->() const { return m_state; }
+};
+
 /** \brief Return reference to thread local VM state object being debugged. */
 vm_state & get_vm_state_being_debugged();
 
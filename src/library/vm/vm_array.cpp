@@ -0,0 +1,114 @@
+/*
+Copyright (c) 2026 agent. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#include <vector>
+#include "util/sstream.h"
+#include "library/vm/vm.h"
+#include "library/vm/vm_nat.h"
+
+namespace lean {
+/** \brief Mutable arrays for metaprograms.
+
+    Arrays are updated in place when they are not shared (i.e., the reference counter is 1),
+    and copied otherwise. So, from the point of view of Lean code, arrays are persistent values.
+    The compiler moves the last use of a local (see move_last_uses at library/vm/optimize.cpp), and
+    the VM moves the arguments into the builtins, so an array stored in a local that is not used after
+    the update is not shared. */
+struct vm_array : public vm_external {
+    std::vector<vm_obj> m_data;
+    vm_array(std::vector<vm_obj> const & d):m_data(d) {}
+    virtual ~vm_array() {}
+    virtual void dealloc() override { this->~vm_array(); get_vm_allocator().deallocate(sizeof(vm_array), this); }
+};
+
+static vm_array * to_vm_array(vm_obj const & o) {
+    lean_assert(is_external(o));
+    lean_assert(dynamic_cast<vm_array*>(to_external(o)));
+    return static_cast<vm_array*>(to_external(o));
+}
+
+static vm_obj mk_vm_array(std::vector<vm_obj> const & d) {
+    return mk_vm_external(new (get_vm_allocator().allocate(sizeof(vm_array))) vm_array(d));
+}
+
+/* Return an array that can be updated in place: \c a itself if it is not shared, and a copy otherwise. */
+static vm_obj ensure_unshared(vm_obj const & a) {
+    if (a.raw()->get_rc() == 1)
+        return a;
+    else
+        return mk_vm_array(to_vm_array(a)->m_data);
+}
+
+static size_t to_index(vm_obj const & a, vm_obj const & i, char const * fn) {
+    optional<unsigned> idx = try_to_unsigned(i);
+    size_t sz = to_vm_array(a)->m_data.size();
+    if (!idx || *idx >= sz)
+        throw exception(sstream() << fn << " failed, index out of bounds");
+    return *idx;
+}
+
+vm_obj array_empty(vm_obj const &) {
+    return mk_vm_array(std::vector<vm_obj>());
+}
+
+vm_obj array_mk(vm_obj const &, vm_obj const & n, vm_obj const & v) {
+    optional<unsigned> sz = try_to_unsigned(n);
+    if (!sz)
+        throw exception("array.mk failed, size is too big");
+    return mk_vm_array(std::vector<vm_obj>(*sz, v));
+}
+
+vm_obj array_size(vm_obj const &, vm_obj const & a) {
+    return mk_vm_nat(to_vm_array(a)->m_data.size());
+}
+
+vm_obj array_read(vm_obj const &, vm_obj const & a, vm_obj const & i) {
+    return to_vm_array(a)->m_data[to_index(a, i, "array.read")];
+}
+
+vm_obj array_write(vm_obj const &, vm_obj const & a, vm_obj const & i, vm_obj const & v) {
+    size_t idx = to_index(a, i, "array.write");
+    vm_obj r   = ensure_unshared(a);
+    to_vm_array(r)->m_data[idx] = v;
+    return r;
+}
+
+vm_obj array_push_back(vm_obj const &, vm_obj const & a, vm_obj const & v) {
+    vm_obj r = ensure_unshared(a);
+    to_vm_array(r)->m_data.push_back(v);
+    return r;
+}
+
+vm_obj array_pop_back(vm_obj const &, vm_obj const & a) {
+    if (to_vm_array(a)->m_data.empty())
+        throw exception("array.pop_back failed, array is empty");
+    vm_obj r = ensure_unshared(a);
+    to_vm_array(r)->m_data.pop_back();
+    return r;
+}
+
+vm_obj array_foldl(vm_obj const &, vm_obj const &, vm_obj const & a, vm_obj const & b, vm_obj const & fn) {
+    /* \c a is referenced by the VM stack during the loop, so \c fn cannot update it in place */
+    vm_obj r = b;
+    for (vm_obj const & v : to_vm_array(a)->m_data)
+        r = invoke(fn, v, r);
+    return r;
+}
+
+void initialize_vm_array() {
+    DECLARE_VM_BUILTIN(name({"array", "empty"}),     array_empty);
+    DECLARE_VM_BUILTIN(name({"array", "mk"}),        array_mk);
+    DECLARE_VM_BUILTIN(name({"array", "size"}),      array_size);
+    DECLARE_VM_BUILTIN(name({"array", "read"}),      array_read);
+    DECLARE_VM_BUILTIN(name({"array", "write"}),     array_write);
+    DECLARE_VM_BUILTIN(name({"array", "push_back"}), array_push_back);
+    DECLARE_VM_BUILTIN(name({"array", "pop_back"}),  array_pop_back);
+    DECLARE_VM_BUILTIN(name({"array", "foldl"}),     array_foldl);
+}
+
+void finalize_vm_array() {
+}
+}
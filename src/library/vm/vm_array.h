@@ -0,0 +1,12 @@
+/*
+Copyright (c) 2026 agent. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#pragma once
+
+namespace lean {
+void initialize_vm_array();
+void finalize_vm_array();
+}
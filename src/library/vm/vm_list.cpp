@@ -8,6 +8,7 @@ Author: Leonardo de Moura
 #include "library/vm/vm_nat.h"
 #include "library/vm/vm_level.h"
 #include "library/vm/vm_expr.h"
+#include "library/vm/vm_string.h"
 #include "library/vm/vm_list.h"
 
 namespace lean {
@@ -86,6 +87,10 @@ unsigned list_cases_on(vm_obj const & o, buffer<vm_obj> & data) {
     } else if (is_constructor(o)) {
         data.append(csize(o), cfields(o));
         return 1;
+    } else if (is_packed_string(o)) {
+        vm_obj c = unpack_string(o);
+        data.append(csize(c), cfields(c));
+        return 1;
     } else {
         lean_assert(is_external(o));
         if (auto l = dynamic_cast<vm_list<name>*>(to_external(o))) {
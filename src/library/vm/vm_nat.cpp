@@ -75,6 +75,16 @@ static mpz const & to_mpz2(vm_obj const & o) {
     }
 }
 
+int nat_cmp(vm_obj const & a1, vm_obj const & a2) {
+    if (is_simple(a1) && is_simple(a2)) {
+        unsigned v1 = cidx(a1);
+        unsigned v2 = cidx(a2);
+        return v1 < v2 ? -1 : (v1 == v2 ? 0 : 1);
+    } else {
+        return cmp(to_mpz1(a1), to_mpz2(a2));
+    }
+}
+
 vm_obj nat_succ(vm_obj const & a) {
     if (is_simple(a)) {
         return mk_vm_nat(cidx(a) + 1);
@@ -11,6 +11,8 @@ namespace lean {
 unsigned to_unsigned(vm_obj const & o);
 optional<unsigned> try_to_unsigned(vm_obj const & o);
 unsigned force_to_unsigned(vm_obj const & o, unsigned def);
+/** \brief Return -1, 0 or 1 if the natural number \c a1 is less than, equal to or greater than \c a2 */
+int nat_cmp(vm_obj const & a1, vm_obj const & a2);
 void initialize_vm_nat();
 void finalize_vm_nat();
 }
@@ -6,19 +6,54 @@ Author: Leonardo de Moura
 */
 #include <iostream>
 #include "util/rb_map.h"
+#include "util/list.h"
+#include "library/expr_lt.h"
 #include "library/vm/vm.h"
 #include "library/vm/vm_nat.h"
+#include "library/vm/vm_name.h"
+#include "library/vm/vm_expr.h"
 #include "library/vm/vm_option.h"
 #include "library/vm/vm_ordering.h"
 
 namespace lean {
+/* Key types whose comparison and hashing functions are implemented natively.
+   We use them to avoid invoking the VM for each comparison. */
+enum class vm_key_kind { Other, Nat, Name, Expr };
+
+static bool is_closure_for(vm_obj const & fn, optional<unsigned> const & fn_idx) {
+    return fn_idx && is_closure(fn) && csize(fn) == 0 && cfn_idx(fn) == *fn_idx;
+}
+
+/* Return the key kind if \c cmp is one of the comparison functions used to implement has_ordering for
+   nat, name and expr. */
+static vm_key_kind get_cmp_key_kind(vm_obj const & cmp) {
+    if (!is_closure(cmp) || csize(cmp) != 0)
+        return vm_key_kind::Other;
+    environment const & env = get_vm_state().env();
+    if (is_closure_for(cmp, get_vm_constant_idx(env, name({"nat", "cmp"}))))
+        return vm_key_kind::Nat;
+    else if (is_closure_for(cmp, get_vm_builtin_idx(name({"name", "cmp"}))))
+        return vm_key_kind::Name;
+    else if (is_closure_for(cmp, get_vm_constant_idx(env, name({"expr", "cmp"}))))
+        return vm_key_kind::Expr;
+    else
+        return vm_key_kind::Other;
+}
+
 struct vm_obj_cmp {
-    vm_obj m_cmp;
+    vm_obj      m_cmp;
+    vm_key_kind m_kind;
     int operator()(vm_obj const & o1, vm_obj const & o2) const {
-        return ordering_to_int(invoke(m_cmp, o1, o2));
+        switch (m_kind) {
+        case vm_key_kind::Nat:   return nat_cmp(o1, o2);
+        case vm_key_kind::Name:  return quick_cmp(to_name(o1), to_name(o2));
+        case vm_key_kind::Expr:  return expr_quick_cmp()(to_expr(o1), to_expr(o2));
+        case vm_key_kind::Other: return ordering_to_int(invoke(m_cmp, o1, o2));
+        }
+        lean_unreachable();
     }
-    vm_obj_cmp() {}
-    explicit vm_obj_cmp(vm_obj const & cmp):m_cmp(cmp) {}
+    vm_obj_cmp():m_kind(vm_key_kind::Other) {}
+    explicit vm_obj_cmp(vm_obj const & cmp):m_cmp(cmp), m_kind(get_cmp_key_kind(cmp)) {}
 };
 
 typedef rb_map<vm_obj, vm_obj, vm_obj_cmp> vm_obj_map;
@@ -89,6 +124,142 @@ vm_obj rb_map_fold(vm_obj const &, vm_obj const &, vm_obj const &, vm_obj const
     return r;
 }
 
+/* Hash and equality functions for hash_map */
+struct vm_obj_hash_eq {
+    vm_obj      m_hash;
+    vm_obj      m_eq;
+    vm_key_kind m_kind;
+    vm_obj_hash_eq(vm_obj const & h, vm_obj const & eq):m_hash(h), m_eq(eq), m_kind(vm_key_kind::Other) {
+        if (is_closure_for(h, get_vm_builtin_idx(name({"expr", "hash"}))) &&
+            is_closure_for(eq, get_vm_builtin_idx(name({"expr", "alpha_eqv"}))))
+            m_kind = vm_key_kind::Expr;
+    }
+    unsigned hash(vm_obj const & o) const {
+        if (m_kind == vm_key_kind::Expr)
+            return to_expr(o).hash();
+        else
+            return force_to_unsigned(invoke(m_hash, o), 0);
+    }
+    bool eq(vm_obj const & o1, vm_obj const & o2) const {
+        if (m_kind == vm_key_kind::Expr)
+            return to_expr(o1) == to_expr(o2);
+        else
+            return to_bool(invoke(m_eq, o1, o2));
+    }
+};
+
+/* The buckets are stored in a persistent map indexed by the hash code, so insert and erase
+   do not need to copy the whole table, and keys are only compared using \c m_eq when their
+   hash codes collide. */
+typedef list<pair<vm_obj, vm_obj>>                  vm_obj_bucket;
+typedef rb_map<unsigned, vm_obj_bucket, unsigned_cmp> vm_obj_buckets;
+
+struct vm_hash_map : public vm_external {
+    vm_obj_hash_eq m_fns;
+    vm_obj_buckets m_buckets;
+    unsigned       m_size;
+    vm_hash_map(vm_obj_hash_eq const & fns, vm_obj_buckets const & bs, unsigned sz):
+        m_fns(fns), m_buckets(bs), m_size(sz) {}
+    virtual ~vm_hash_map() {}
+    virtual void dealloc() override { this->~vm_hash_map(); get_vm_allocator().deallocate(sizeof(vm_hash_map), this); }
+};
+
+static vm_hash_map const & to_hash_map(vm_obj const & o) {
+    lean_assert(is_external(o));
+    lean_assert(dynamic_cast<vm_hash_map*>(to_external(o)));
+    return *static_cast<vm_hash_map*>(to_external(o));
+}
+
+static vm_obj mk_vm_hash_map(vm_obj_hash_eq const & fns, vm_obj_buckets const & bs, unsigned sz) {
+    return mk_vm_external(new (get_vm_allocator().allocate(sizeof(vm_hash_map))) vm_hash_map(fns, bs, sz));
+}
+
+static optional<vm_obj> find(vm_hash_map const & m, unsigned h, vm_obj const & k) {
+    if (vm_obj_bucket const * b = m.m_buckets.find(h)) {
+        for (pair<vm_obj, vm_obj> const & p : *b) {
+            if (m.m_fns.eq(p.first, k))
+                return optional<vm_obj>(p.second);
+        }
+    }
+    return optional<vm_obj>();
+}
+
+/* Remove \c k from the bucket \c h, return true if it was found */
+static bool erase(vm_hash_map const & m, unsigned h, vm_obj const & k, vm_obj_buckets & r) {
+    vm_obj_bucket const * b = m.m_buckets.find(h);
+    if (!b) return false;
+    bool found = false;
+    buffer<pair<vm_obj, vm_obj>> new_b;
+    for (pair<vm_obj, vm_obj> const & p : *b) {
+        if (!found && m.m_fns.eq(p.first, k))
+            found = true;
+        else
+            new_b.push_back(p);
+    }
+    if (!found) return false;
+    r = m.m_buckets;
+    if (new_b.empty())
+        r.erase(h);
+    else
+        r.insert(h, to_list(new_b));
+    return true;
+}
+
+vm_obj hash_map_mk_core(vm_obj const &, vm_obj const &, vm_obj const & hash, vm_obj const & eq) {
+    return mk_vm_hash_map(vm_obj_hash_eq(hash, eq), vm_obj_buckets(), 0);
+}
+
+vm_obj hash_map_size(vm_obj const &, vm_obj const &, vm_obj const & m) {
+    return mk_vm_nat(to_hash_map(m).m_size);
+}
+
+vm_obj hash_map_insert(vm_obj const &, vm_obj const &, vm_obj const & o, vm_obj const & k, vm_obj const & d) {
+    vm_hash_map const & m = to_hash_map(o);
+    unsigned h  = m.m_fns.hash(k);
+    unsigned sz = m.m_size;
+    vm_obj_buckets r;
+    if (erase(m, h, k, r))
+        sz--;
+    else
+        r = m.m_buckets;
+    vm_obj_bucket b;
+    if (vm_obj_bucket const * old_b = r.find(h))
+        b = *old_b;
+    r.insert(h, cons(mk_pair(k, d), b));
+    return mk_vm_hash_map(m.m_fns, r, sz + 1);
+}
+
+vm_obj hash_map_erase(vm_obj const &, vm_obj const &, vm_obj const & o, vm_obj const & k) {
+    vm_hash_map const & m = to_hash_map(o);
+    vm_obj_buckets r;
+    if (erase(m, m.m_fns.hash(k), k, r))
+        return mk_vm_hash_map(m.m_fns, r, m.m_size - 1);
+    else
+        return o;
+}
+
+vm_obj hash_map_contains(vm_obj const &, vm_obj const &, vm_obj const & o, vm_obj const & k) {
+    vm_hash_map const & m = to_hash_map(o);
+    return mk_vm_bool(static_cast<bool>(find(m, m.m_fns.hash(k), k)));
+}
+
+vm_obj hash_map_find(vm_obj const &, vm_obj const &, vm_obj const & o, vm_obj const & k) {
+    vm_hash_map const & m = to_hash_map(o);
+    if (auto d = find(m, m.m_fns.hash(k), k))
+        return mk_vm_some(*d);
+    else
+        return mk_vm_none();
+}
+
+vm_obj hash_map_fold(vm_obj const &, vm_obj const &, vm_obj const &, vm_obj const & o, vm_obj const & a, vm_obj const & fn) {
+    vm_obj r = a;
+    to_hash_map(o).m_buckets.for_each([&](unsigned, vm_obj_bucket const & b) {
+            for (pair<vm_obj, vm_obj> const & p : b)
+                r = invoke(fn, p.first, p.second, r);
+        });
+    return r;
+}
+
 void initialize_vm_rb_map() {
     DECLARE_VM_BUILTIN(name({"rb_map", "mk_core"}),        rb_map_mk_core);
     DECLARE_VM_BUILTIN(name({"rb_map", "size"}),           rb_map_size);
@@ -99,6 +270,14 @@ void initialize_vm_rb_map() {
     DECLARE_VM_BUILTIN(name({"rb_map", "min"}),            rb_map_min);
     DECLARE_VM_BUILTIN(name({"rb_map", "max"}),            rb_map_max);
     DECLARE_VM_BUILTIN(name({"rb_map", "fold"}),           rb_map_fold);
+
+    DECLARE_VM_BUILTIN(name({"hash_map", "mk_core"}),      hash_map_mk_core);
+    DECLARE_VM_BUILTIN(name({"hash_map", "size"}),         hash_map_size);
+    DECLARE_VM_BUILTIN(name({"hash_map", "insert"}),       hash_map_insert);
+    DECLARE_VM_BUILTIN(name({"hash_map", "erase"}),        hash_map_erase);
+    DECLARE_VM_BUILTIN(name({"hash_map", "contains"}),     hash_map_contains);
+    DECLARE_VM_BUILTIN(name({"hash_map", "find"}),         hash_map_find);
+    DECLARE_VM_BUILTIN(name({"hash_map", "fold"}),         hash_map_fold);
 }
 
 void finalize_vm_rb_map() {
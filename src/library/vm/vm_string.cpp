@@ -5,11 +5,49 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #include <string>
+#include <memory>
+#include "library/vm/vm.h"
+#include "library/vm/vm_nat.h"
 #include "library/vm/vm_string.h"
 
 namespace lean {
+/* The characters of a packed string are the first m_size characters of m_data, in order.
+   Several packed strings may share the same buffer, e.g., the tails created by unpack_string. */
+struct vm_string : public vm_external {
+    std::shared_ptr<std::string> m_data;
+    size_t                       m_size;
+    vm_string(std::shared_ptr<std::string> const & data, size_t sz):m_data(data), m_size(sz) {}
+    virtual ~vm_string() {}
+    virtual void dealloc() override { this->~vm_string(); get_vm_allocator().deallocate(sizeof(vm_string), this); }
+};
+
+bool is_packed_string(vm_obj const & o) {
+    return is_external(o) && dynamic_cast<vm_string*>(to_external(o));
+}
+
+static vm_string * to_vm_string(vm_obj const & o) {
+    lean_assert(is_packed_string(o));
+    return static_cast<vm_string*>(to_external(o));
+}
+
+static vm_obj mk_vm_string(std::shared_ptr<std::string> const & data, size_t sz) {
+    if (sz == 0)
+        return mk_vm_simple(0);
+    return mk_vm_external(new (get_vm_allocator().allocate(sizeof(vm_string))) vm_string(data, sz));
+}
+
+vm_obj unpack_string(vm_obj const & o) {
+    vm_string * s = to_vm_string(o);
+    lean_assert(s->m_size > 0);
+    char c = (*s->m_data)[s->m_size - 1];
+    return mk_vm_constructor(1, mk_vm_simple(c), mk_vm_string(s->m_data, s->m_size - 1));
+}
+
 static void to_string(vm_obj const & o, std::string & s) {
-    if (!is_simple(o)) {
+    if (is_packed_string(o)) {
+        vm_string * p = to_vm_string(o);
+        s.append(*p->m_data, 0, p->m_size);
+    } else if (!is_simple(o)) {
         to_string(cfield(o, 1), s);
         s += static_cast<char>(cidx(cfield(o, 0)));
     }
@@ -22,11 +60,94 @@ std::string to_string(vm_obj const & o) {
 }
 
 vm_obj to_obj(std::string const & str) {
-    vm_obj r = mk_vm_simple(0);
-    for (unsigned i = 0; i < str.size(); i++) {
-        vm_obj args[2] = { mk_vm_simple(str[i]), r };
-        r = mk_vm_constructor(1, 2, args);
+    return mk_vm_string(std::make_shared<std::string>(str), str.size());
+}
+
+/* Number of characters of the given string, without converting it */
+static size_t string_size(vm_obj const & o) {
+    size_t r = 0;
+    vm_obj const * it = &o;
+    while (true) {
+        if (is_packed_string(*it)) {
+            return r + to_vm_string(*it)->m_size;
+        } else if (is_simple(*it)) {
+            return r;
+        } else {
+            r++;
+            it = &cfield(*it, 1);
+        }
     }
-    return r;
+}
+
+/* string.concat a b: the characters of a followed by the characters of b */
+static vm_obj string_concat(vm_obj const & a, vm_obj const & b) {
+    if (is_simple(b))
+        return a;
+    if (is_packed_string(a)) {
+        vm_string * p = to_vm_string(a);
+        if (a.raw()->get_rc() == 1 && p->m_data.use_count() == 1) {
+            /* The string is not shared, so we append in place. This makes sure
+               strings built using repeated appends are constructed in linear time. */
+            p->m_data->resize(p->m_size);
+            to_string(b, *p->m_data);
+            p->m_size = p->m_data->size();
+            return a;
+        }
+    }
+    std::string r = to_string(a);
+    to_string(b, r);
+    return to_obj(r);
+}
+
+static vm_obj string_decidable_eq(vm_obj const & a, vm_obj const & b) {
+    size_t sz = string_size(a);
+    if (sz != string_size(b))
+        return mk_vm_bool(false);
+    if (is_packed_string(a) && is_packed_string(b)) {
+        vm_string * p1 = to_vm_string(a);
+        vm_string * p2 = to_vm_string(b);
+        return mk_vm_bool(p1->m_data->compare(0, sz, *p2->m_data, 0, sz) == 0);
+    }
+    /* Walk both strings in lockstep while they are cons cells, and compare the
+       remaining packed suffixes (if any) at once. */
+    vm_obj const * it1 = &a;
+    vm_obj const * it2 = &b;
+    while (!is_simple(*it1) && !is_packed_string(*it1) && !is_simple(*it2) && !is_packed_string(*it2)) {
+        if (cidx(cfield(*it1, 0)) != cidx(cfield(*it2, 0)))
+            return mk_vm_bool(false);
+        it1 = &cfield(*it1, 1);
+        it2 = &cfield(*it2, 1);
+    }
+    return mk_vm_bool(to_string(*it1) == to_string(*it2));
+}
+
+/* Same algorithm used at utf8_length in library/init/data/string/basic.lean */
+static vm_obj string_utf8_length(vm_obj const & s) {
+    std::string str = to_string(s);
+    unsigned skip = 0;
+    unsigned r    = 0;
+    for (char c : str) {
+        unsigned n = static_cast<unsigned char>(c);
+        if (skip > 0) {
+            skip--;
+            continue;
+        }
+        r++;
+        if (0xC0 <= n && n < 0xE0) skip = 1;
+        else if (0xE0 <= n && n < 0xF0) skip = 2;
+        else if (0xF0 <= n && n < 0xF8) skip = 3;
+        else if (0xF8 <= n && n < 0xFC) skip = 4;
+        else if (0xFC <= n && n < 0xFE) skip = 5;
+    }
+    return mk_vm_nat(r);
+}
+
+void initialize_vm_string() {
+    DECLARE_VM_BUILTIN(name({"string", "concat"}),        string_concat);
+    DECLARE_VM_BUILTIN(name({"string", "decidable_eq"}),  string_decidable_eq);
+    DECLARE_VM_BUILTIN(name("utf8_length"),               string_utf8_length);
+}
+
+void finalize_vm_string() {
 }
 }
@@ -9,6 +9,20 @@ Author: Leonardo de Moura
 #include "library/vm/vm.h"
 
 namespace lean {
+/** \brief Strings are lists of characters (where the head is the last character).
+    The VM also supports a packed representation for them, an external object storing the characters in a buffer.
+    Objects produced by C++ code (e.g., format.to_string) are packed, and the builtin string operations
+    accept both representations. Packed strings are converted into list cells on demand by
+    list.cases_on. */
+bool is_packed_string(vm_obj const & o);
+/** \brief Return the list cell corresponding to the packed string \c o.
+    The tail of the resulting cell is a packed string sharing the buffer with \c o.
+    \pre is_packed_string(o) */
+vm_obj unpack_string(vm_obj const & o);
+
 std::string to_string(vm_obj const & o);
 vm_obj to_obj(std::string const & str);
+
+void initialize_vm_string();
+void finalize_vm_string();
 }
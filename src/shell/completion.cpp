@@ -9,8 +9,16 @@ Authors: Gabriel Ebner, Leonardo de Moura, Sebastian Ullrich
 #include <algorithm>
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include "shell/server.h"
 #include "util/bitap_fuzzy_search.h"
+#include "util/trie.h"
+#include "util/rb_map.h"
+#include "util/name_set.h"
+#include "kernel/inductive/inductive.h"
+#include "library/module.h"
+#include "library/aliases.h"
+#include "library/projection.h"
 #include "library/protected.h"
 #include "library/scoped_ext.h"
 #include "frontends/lean/util.h"
@@ -47,39 +55,207 @@ unsigned get_fuzzy_match_max_errors(unsigned prefix_sz) {
     return r;
 }
 
-optional<name> exact_prefix_match(environment const & env, std::string const & pattern, declaration const & d) {
-    if (auto it = is_essentially_atomic(env, d.get_name())) {
+optional<name> exact_prefix_match(environment const & env, std::string const & pattern, name const & n) {
+    if (auto it = is_essentially_atomic(env, n)) {
         std::string it_str = it->to_string();
         // if pattern "perfectly" matches beginning of declaration name, we just display d on the top of the list
         if (it_str.compare(0, pattern.size(), pattern) == 0)
             return it;
     } else {
-        std::string d_str = d.get_name().to_string();
+        std::string d_str = n.to_string();
         if (d_str.compare(0, pattern.size(), pattern) == 0)
-            return optional<name>(d.get_name());
+            return optional<name>(n);
     }
     return optional<name>();
 }
 
-std::vector<json> get_completions(std::string const & pattern, environment const & env, options const & opts) {
+typedef rb_map<unsigned, list<name>, unsigned_cmp> trigram_postings;
+
+static unsigned get_trigram(std::string const & s, unsigned i) {
+    return (static_cast<unsigned char>(s[i]) << 16) | (static_cast<unsigned char>(s[i+1]) << 8) |
+        static_cast<unsigned char>(s[i+2]);
+}
+
+static void get_trigrams(std::string const & s, std::vector<unsigned> & r) {
+    for (unsigned i = 0; i + 3 <= s.size(); i++)
+        r.push_back(get_trigram(s, i));
+    std::sort(r.begin(), r.end());
+    r.erase(std::unique(r.begin(), r.end()), r.end());
+}
+
+class completion_index {
+    /* Module declarations that have already been indexed, see mk_completion_index */
+    list<name>        m_module_decls;
+    /* full names of the indexed declarations */
+    ctrie<name>       m_names;
+    /* last component of the indexed declarations, it is used to find names that are essentially atomic */
+    ctrie<list<name>> m_last_names;
+    /* declarations containing a given trigram in their full names */
+    trigram_postings  m_trigrams;
+
+    void add(name const & n) {
+        std::string str = n.to_string();
+        m_names.insert(str.begin(), str.end(), n);
+        if (n.is_string()) {
+            std::string last(n.get_string());
+            list<name> const * ns = m_last_names.find(last.begin(), last.end());
+            m_last_names.insert(last.begin(), last.end(), cons(n, ns ? *ns : list<name>()));
+        }
+        std::vector<unsigned> trigrams;
+        get_trigrams(str, trigrams);
+        for (unsigned t : trigrams) {
+            list<name> const * ns = m_trigrams.find(t);
+            m_trigrams.insert(t, cons(n, ns ? *ns : list<name>()));
+        }
+    }
+
+    void add(environment const & env, name const & n) {
+        if (!env.find(n) || is_projection(env, n))
+            return;
+        add(n);
+    }
+
+    /* Index \c n, and the constructors and recursor if \c n is an inductive datatype.
+       We need this because only the name of the datatype is stored in the list of module declarations. */
+    void add_module_decl(environment const & env, name const & n) {
+        add(env, n);
+        if (auto decl = inductive::is_inductive_decl(env, n)) {
+            for (inductive::intro_rule const & ir : decl->m_intro_rules)
+                add(env, inductive::intro_rule_name(ir));
+            add(env, inductive::get_elim_name(n));
+        }
+    }
+
+    template<typename F>
+    static void for_each_prefix(ctrie<name> const & t, std::string const & pattern, F && f) {
+        ctrie<name> const * it = &t;
+        for (char c : pattern) {
+            it = it->find(c);
+            if (!it) return;
+        }
+        it->for_each([&](unsigned, char const *, name const & n) { f(n); });
+    }
+
+public:
+    completion_index(environment const & env, completion_index const * base) {
+        list<name> const & module_decls = get_curr_module_decl_names(env);
+        buffer<name> new_decls;
+        if (base) {
+            list<name> it = module_decls;
+            while (!is_nil(it) && !is_eqp(it, base->m_module_decls)) {
+                new_decls.push_back(head(it));
+                it = tail(it);
+            }
+            if (is_eqp(it, base->m_module_decls)) {
+                *this = *base;
+            } else {
+                /* \c base is not an index for an environment extended by \c env */
+                new_decls.clear();
+                base = nullptr;
+            }
+        }
+        if (!base) {
+            name_set module_decl_set;
+            for (name const & n : module_decls) module_decl_set.insert(n);
+            env.for_each_declaration([&](declaration const & d) {
+                    if (!module_decl_set.contains(d.get_name()) && !is_projection(env, d.get_name()))
+                        add(d.get_name());
+                });
+            to_buffer(module_decls, new_decls);
+        }
+        /* module declarations are stored in reverse order */
+        unsigned i = new_decls.size();
+        while (i > 0) {
+            --i;
+            add_module_decl(env, new_decls[i]);
+        }
+        m_module_decls = module_decls;
+    }
+
+    /** \brief Invoke \c f for the declarations whose full name or last component start with \c pattern. */
+    template<typename F>
+    void for_each_prefix_match(std::string const & pattern, F && f) const {
+        for_each_prefix(m_names, pattern, f);
+        ctrie<list<name>> const * it = &m_last_names;
+        for (char c : pattern) {
+            it = it->find(c);
+            if (!it) return;
+        }
+        it->for_each([&](unsigned, char const *, list<name> const & ns) {
+                for (name const & n : ns) f(n);
+            });
+    }
+
+    /** \brief Invoke \c f for every declaration that may contain \c pattern with at most \c max_errors errors.
+        A string containing \c pattern with \c k errors contains all but at most <tt>3*k</tt> trigrams of \c pattern. */
+    template<typename F>
+    void for_each_fuzzy_candidate(std::string const & pattern, unsigned max_errors, F && f) const {
+        std::vector<unsigned> trigrams;
+        get_trigrams(pattern, trigrams);
+        if (trigrams.size() <= 3 * max_errors) {
+            /* trigrams cannot be used to filter candidates */
+            m_names.for_each([&](unsigned, char const *, name const & n) { f(n); });
+            return;
+        }
+        unsigned threshold = trigrams.size() - 3 * max_errors;
+        std::unordered_map<name, unsigned, name_hash> counters;
+        for (unsigned t : trigrams) {
+            if (list<name> const * ns = m_trigrams.find(t)) {
+                for (name const & n : *ns) {
+                    if (++counters[n] == threshold)
+                        f(n);
+                }
+            }
+        }
+    }
+};
+
+completion_index_ref mk_completion_index(environment const & env, completion_index_ref const & base) {
+    return std::make_shared<completion_index const>(env, base.get());
+}
+
+std::vector<json> get_completions(std::string const & pattern, environment const & env, options const & opts,
+                                  completion_index const & idx) {
     std::vector<json> completions;
 
     unsigned max_results = get_auto_completion_max_results(opts);
     unsigned max_errors = get_fuzzy_match_max_errors(pattern.size());
     std::vector<pair<name, name>> exact_matches;
     std::vector<pair<std::string, name>> selected;
-    bitap_fuzzy_search matcher(pattern, max_errors);
-    env.for_each_declaration([&](declaration const & d) {
-        if (is_projection(env, d.get_name()))
+    name_set visited;
+    auto add_exact_match = [&](name const & n) {
+        if (visited.contains(n))
             return;
-        if (auto it = exact_prefix_match(env, pattern, d)) {
-            exact_matches.emplace_back(*it, d.get_name());
-        } else {
-            std::string text = d.get_name().to_string();
-            if (matcher.match(text))
-                selected.emplace_back(text, d.get_name());
+        if (auto it = exact_prefix_match(env, pattern, n)) {
+            visited.insert(n);
+            exact_matches.emplace_back(*it, n);
         }
-    });
+    };
+    idx.for_each_prefix_match(pattern, add_exact_match);
+    /* Declarations that are essentially atomic because of an alias with a different name (e.g., after
+       'open ... (renaming ...)'). The aliases are not indexed since they depend on the current scope. */
+    for_each_expr_alias(env, [&](name const & a, list<name> const & ns) {
+            std::string a_str = a.to_string();
+            if (a_str.compare(0, pattern.size(), pattern) != 0)
+                return;
+            for (name const & n : ns) {
+                if (env.find(n) && !is_projection(env, n))
+                    add_exact_match(n);
+            }
+        });
+    bitap_fuzzy_search matcher(pattern, max_errors);
+    idx.for_each_fuzzy_candidate(pattern, max_errors, [&](name const & n) {
+            if (visited.contains(n))
+                return;
+            visited.insert(n);
+            std::string text = n.to_string();
+            if (matcher.match(text))
+                selected.emplace_back(text, n);
+        });
+    std::sort(selected.begin(), selected.end(),
+              [](pair<std::string, name> const & p1, pair<std::string, name> const & p2) {
+                  return p1.first < p2.first;
+              });
     unsigned num_results = 0;
     if (!exact_matches.empty()) {
         std::sort(exact_matches.begin(), exact_matches.end(),
@@ -118,5 +294,9 @@ std::vector<json> get_completions(std::string const & pattern, environment const
     return completions;
 }
 
+
+std::vector<json> get_completions(std::string const & pattern, environment const & env, options const & opts) {
+    return get_completions(pattern, env, opts, *mk_completion_index(env));
+}
 }
 #endif
@@ -5,6 +5,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Authors: Gabriel Ebner, Leonardo de Moura, Sebastian Ullrich
 */
 #pragma once
+#include <memory>
 #include <string>
 #include <vector>
 #include "kernel/environment.h"
@@ -12,7 +13,18 @@ Authors: Gabriel Ebner, Leonardo de Moura, Sebastian Ullrich
 #include "frontends/lean/json.h"
 
 namespace lean {
+/** \brief Index of the declaration names of an environment. It is used to answer completion
+    requests without visiting every declaration in the environment. */
+class completion_index;
+typedef std::shared_ptr<completion_index const> completion_index_ref;
 
-std::vector<json> get_completions(std::string const & pattern, environment const & env, options const & o);
+/** \brief Create the completion index for \c env.
+    If \c base is not null, then it must be the index of an environment that is extended by \c env,
+    and \c env must only contain additional declarations from the current module
+    (see get_curr_module_decl_names). In this case, only the new declarations are indexed. */
+completion_index_ref mk_completion_index(environment const & env, completion_index_ref const & base = completion_index_ref());
 
+std::vector<json> get_completions(std::string const & pattern, environment const & env, options const & o,
+                                  completion_index const & idx);
+std::vector<json> get_completions(std::string const & pattern, environment const & env, options const & o);
 }
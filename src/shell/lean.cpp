@@ -19,6 +19,7 @@ Author: Leonardo de Moura
 #include "util/sstream.h"
 #include "util/interrupt.h"
 #include "util/memory.h"
+#include "util/memory_pool.h"
 #include "util/thread.h"
 #include "util/lean_path.h"
 #include "util/file_lock.h"
@@ -77,6 +78,7 @@ static void display_help(std::ostream & out) {
     display_header(out);
     std::cout << "Input format:\n";
     std::cout << "  --smt2            interpret files as SMT-Lib2 files\n";
+    std::cout << "                    (use -D smt2.timing=true to display the time of each query)\n";
     std::cout << "Miscellaneous:\n";
     std::cout << "  --help -h         display this message\n";
     std::cout << "  --version -v      display version number\n";
@@ -84,6 +86,8 @@ static void display_help(std::ostream & out) {
     std::cout << "  --path            display the path used for finding Lean libraries and extensions\n";
     std::cout << "  --doc=file -r     generate module documentation based on module doc strings\n";
     std::cout << "  --make            create olean files\n";
+    std::cout << "  --cache-dir=dir   directory where --make stores and looks up olean files indexed by\n"
+              << "                    the hash of their sources, e.g., to share them between checkouts\n";
     std::cout << "  --trust=num -t    trust level (default: max) 0 means do not trust any macro,\n"
               << "                    and type check all imported modules\n";
     std::cout << "  --quiet -q        do not print verbose messages\n";
@@ -92,6 +96,7 @@ static void display_help(std::ostream & out) {
 #if defined(LEAN_MULTI_THREAD)
     std::cout << "  --threads=num -j  number of threads used to process lean files\n";
     std::cout << "  --tstack=num -s   thread stack size in Kb\n";
+    std::cout << "  --global-hash-consing  share hash-consed expressions between threads\n";
 #endif
     std::cout << "  --deps            just print dependencies of a Lean input\n";
 #if defined(LEAN_SERVER)
@@ -116,6 +121,7 @@ static struct option g_long_options[] = {
     {"path",         no_argument,       0, 'p'},
     {"githash",      no_argument,       0, 'g'},
     {"make",         no_argument,       0, 'm'},
+    {"cache-dir",    required_argument, 0, 'c'},
     {"export",       required_argument, 0, 'E'},
     {"export-all",   required_argument, 0, 'A'},
     {"memory",       required_argument, 0, 'M'},
@@ -132,6 +138,7 @@ static struct option g_long_options[] = {
     {"doc",          required_argument, 0, 'r'},
 #if defined(LEAN_MULTI_THREAD)
     {"tstack",       required_argument, 0, 's'},
+    {"global-hash-consing", no_argument, 0, 'H'},
 #endif
 #ifdef LEAN_DEBUG
     {"debug",        required_argument, 0, 'B'},
@@ -266,6 +273,7 @@ int main(int argc, char ** argv) {
     bool json_output        = false;
 #endif
     options opts;
+    optional<std::string> cache_dir;
     optional<std::string> export_txt;
     optional<std::string> export_all_txt;
     optional<std::string> doc;
@@ -297,9 +305,15 @@ int main(int argc, char ** argv) {
         case 's':
             lean::lthread::set_thread_stack_size(static_cast<size_t>((atoi(optarg)/4)*4)*static_cast<size_t>(1024));
             break;
+        case 'H':
+            lean::enable_global_expr_caching(true);
+            break;
         case 'm':
             make_mode = true;
             break;
+        case 'c':
+            cache_dir = std::string(optarg);
+            break;
         case 'n':
             native_output         = optarg;
             break;
@@ -368,9 +382,16 @@ int main(int argc, char ** argv) {
 
     if (smt2) {
         // Note: the smt2 flag may override other flags
+        /* Importing decodes the .olean files on the task queue */
+        st_task_queue tq;
+        scope_global_task_queue scope_tq(&tq);
+        stream_message_buffer msg_buf(std::cout);
+        scoped_message_buffer scope_msg_buf(&msg_buf);
+        scope_message_context scope_msg_ctx(message_bucket_id { "_global", 1 });
         bool ok = true;
         for (int i = optind; i < argc; i++) {
             try {
+                scoped_task_context scope_task_ctx(argv[i], {1, 0});
                 if (doc) throw lean::exception("leandoc does not support .smt2 files");
                 ok = ::lean::smt2::parse_commands(env, ios, argv[i]);
             } catch (lean::exception & ex) {
@@ -466,6 +487,9 @@ int main(int argc, char ** argv) {
 
         module_mgr mod_mgr(&vfs, msg_buf.get(), env, ios);
         mod_mgr.set_save_olean(make_mode);
+        /* The modules being exported must be elaborated, they cannot be copied from the cache. */
+        if (!export_txt && !export_all_txt)
+            mod_mgr.set_cache_dir(cache_dir);
 
         bool ok = true;
 
@@ -502,6 +526,9 @@ int main(int argc, char ** argv) {
             }
         }
 
+        if (opts.get_bool("profiler", false))
+            display_memory_pool_stats(std::cerr);
+
         // Options appear to be empty, pretty sure I'm making a mistake here.
         if (compile && !mods.empty()) {
             auto final_env = *mods.front().second->m_result.get().m_env;
@@ -9,7 +9,9 @@ Authors: Gabriel Ebner, Leonardo de Moura, Sebastian Ullrich
 #include <string>
 #include <algorithm>
 #include <vector>
+#include <utility>
 #include <clocale>
+#include "util/utf8.h"
 #include "util/sexpr/option_declarations.h"
 #include "library/mt_task_queue.h"
 #include "library/st_task_queue.h"
@@ -251,9 +253,48 @@ void server::handle_request(server::cmd_req const & req) {
     send_msg(cmd_res(req.m_seq_num, std::string("unknown command")));
 }
 
+/* Return the offset of the position (line, col) in \c content.
+   Lines start at 1, and columns are measured in unicode characters. */
+static size_t get_offset(std::string const & content, unsigned line, unsigned col) {
+    size_t offset = 0;
+    for (unsigned l = 1; l < line; l++) {
+        offset = content.find('\n', offset);
+        if (offset == std::string::npos)
+            throw exception(sstream() << "invalid edit, line " << line << " does not exist");
+        offset++;
+    }
+    for (unsigned c = 0; c < col; c++) {
+        if (offset >= content.size() || content[offset] == '\n')
+            throw exception(sstream() << "invalid edit, line " << line << " does not have column " << col);
+        offset += get_utf8_size(content[offset]);
+    }
+    return std::min(offset, content.size());
+}
+
+/* Apply the given edits to \c content, and return the position of the first change. */
+static optional<pos_info> apply_edits(std::string & content, json const & edits) {
+    optional<pos_info> first_change;
+    for (auto & edit : edits) {
+        unsigned start_line = edit.at("start_line");
+        unsigned start_col  = edit.at("start_column");
+        unsigned end_line   = edit.at("end_line");
+        unsigned end_col    = edit.at("end_column");
+        std::string text    = edit.at("text");
+        size_t start = get_offset(content, start_line, start_col);
+        size_t end   = get_offset(content, end_line, end_col);
+        if (end < start)
+            throw exception("invalid edit, end position precedes start position");
+        content.replace(start, end - start, text);
+        /* the snapshot mechanism only tracks lines */
+        pos_info pos(start_line, 0);
+        if (!first_change || pos < *first_change)
+            first_change = pos;
+    }
+    return first_change;
+}
+
 server::cmd_res server::handle_sync(server::cmd_req const & req) {
     std::string new_file_name = req.m_payload.at("file_name");
-    std::string new_content = req.m_payload.at("content");
 
     auto mtime = time(nullptr);
 
@@ -269,17 +310,37 @@ server::cmd_res server::handle_sync(server::cmd_req const & req) {
 #endif
 
     bool needs_invalidation = !m_open_files.count(new_file_name);
-
-    auto & ef = m_open_files[new_file_name];
-    if (ef.m_content != new_content) {
-        ef.m_content = new_content;
-        ef.m_mtime = mtime;
-        needs_invalidation = true;
+    optional<pos_info> first_change;
+
+    if (req.m_payload.count("edits")) {
+        /* Incremental update: the client only sends the modified ranges. */
+        if (needs_invalidation)
+            throw exception(sstream() << "file '" << new_file_name << "' is not open, its content must be sent");
+        auto & ef = m_open_files[new_file_name];
+        /* The edits are applied to a copy, so that the buffer is left untouched if one of them is invalid. */
+        std::string new_content = ef.m_content;
+        first_change = apply_edits(new_content, req.m_payload.at("edits"));
+        if (first_change) {
+            ef.m_content = std::move(new_content);
+            ef.m_mtime = mtime;
+            needs_invalidation = true;
+        }
+    } else {
+        std::string new_content = req.m_payload.at("content");
+        auto & ef = m_open_files[new_file_name];
+        if (ef.m_content != new_content) {
+            ef.m_content = std::move(new_content);
+            ef.m_mtime = mtime;
+            needs_invalidation = true;
+        }
     }
 
     json res;
     if (needs_invalidation) {
-        m_mod_mgr->invalidate(new_file_name);
+        if (first_change)
+            m_mod_mgr->invalidate(new_file_name, *first_change);
+        else
+            m_mod_mgr->invalidate(new_file_name);
         try { m_mod_mgr->get_module(new_file_name); } catch (...) {}
         res["message"] = "file invalidated";
     } else {
@@ -326,8 +387,10 @@ public:
     unit execute() override {
         try {
             std::vector<json> completions;
-            if (auto snap = get_closest_snapshot(m_mod_info, m_line))
-                completions = get_completions(m_pattern, snap->m_env, snap->m_options);
+            if (auto snap = get_closest_snapshot(m_mod_info, m_line)) {
+                auto idx = m_server->get_completion_index(m_mod_info->m_result.get().m_snapshots, snap);
+                completions = get_completions(m_pattern, snap->m_env, snap->m_options, *idx);
+            }
 
             json j;
             j["completions"] = completions;
@@ -339,6 +402,50 @@ public:
     }
 };
 
+#ifndef LEAN_COMPLETION_INDEX_CACHE_SIZE
+#define LEAN_COMPLETION_INDEX_CACHE_SIZE 16
+#endif
+
+/* Return the completion index for the given snapshot. The index is computed incrementally from the index
+   of a previous snapshot of the same module when available. The index is built without holding
+   m_completion_mutex, so concurrent requests may build it twice, but they do not wait for each other. */
+completion_index_ref server::get_completion_index(snapshot_vector const & snapshots,
+                                                  std::shared_ptr<snapshot const> const & snap) {
+    auto find = [&](std::shared_ptr<snapshot const> const & s) {
+        for (auto & p : m_completion_indices)
+            if (p.first.lock() == s) return p.second;
+        return completion_index_ref();
+    };
+    completion_index_ref base;
+    {
+        unique_lock<mutex> _(m_completion_mutex);
+        if (auto idx = find(snap))
+            return idx;
+        if (snap->m_imports_parsed) {
+            /* The environments of snapshots after the imports only differ in the declarations of the module. */
+            for (auto & s : snapshots) {
+                if (s->m_pos >= snap->m_pos) break;
+                if (!s->m_imports_parsed) continue;
+                if (auto idx = find(s)) base = idx;
+            }
+        }
+    }
+    auto idx = mk_completion_index(snap->m_env, base);
+    unique_lock<mutex> _(m_completion_mutex);
+    if (auto other = find(snap))
+        return other;
+    m_completion_indices.erase(
+        std::remove_if(m_completion_indices.begin(), m_completion_indices.end(),
+                       [](std::pair<std::weak_ptr<snapshot const>, completion_index_ref> const & p) {
+                           return p.first.expired();
+                       }),
+        m_completion_indices.end());
+    if (m_completion_indices.size() >= LEAN_COMPLETION_INDEX_CACHE_SIZE)
+        m_completion_indices.erase(m_completion_indices.begin());
+    m_completion_indices.emplace_back(snap, idx);
+    return idx;
+}
+
 void server::handle_complete(cmd_req const & req) {
     std::string fn = req.m_payload.at("file_name");
     std::string pattern = req.m_payload.at("pattern");
@@ -376,10 +483,10 @@ server::cmd_res server::handle_info(server::cmd_req const & req) {
     return { req.m_seq_num, res };
 }
 
-std::tuple<std::string, module_src, time_t> server::load_module(module_id const & id, bool can_use_olean) {
+std::tuple<mapped_file_ref, module_src, time_t> server::load_module(module_id const & id, bool can_use_olean) {
     if (m_open_files.count(id)) {
         auto & ef = m_open_files[id];
-        return std::make_tuple(ef.m_content, module_src::LEAN, ef.m_mtime);
+        return std::make_tuple(mk_mapped_file(id, ef.m_content), module_src::LEAN, ef.m_mtime);
     }
     return m_fs_vfs.load_module(id, can_use_olean);
 }
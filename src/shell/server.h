@@ -6,6 +6,8 @@ Authors: Gabriel Ebner, Sebastian Ullrich
 */
 #pragma once
 #include <string>
+#include <utility>
+#include <vector>
 #include "kernel/pos_info_provider.h"
 #include "kernel/environment.h"
 #include "library/io_state.h"
@@ -13,6 +15,7 @@ Authors: Gabriel Ebner, Sebastian Ullrich
 #include "library/module_mgr.h"
 #include "frontends/lean/json.h"
 #include "library/mt_task_queue.h"
+#include "shell/completion.h"
 
 namespace lean {
 
@@ -40,6 +43,10 @@ class server : public module_vfs {
     class msg_buf;
     std::unique_ptr<msg_buf> m_msg_buf;
 
+    /* Completion indices of recently used snapshots */
+    mutex m_completion_mutex;
+    std::vector<std::pair<std::weak_ptr<snapshot const>, completion_index_ref>> m_completion_indices;
+
     std::unique_ptr<module_mgr> m_mod_mgr;
     std::unique_ptr<task_queue> m_tq;
     fs_module_vfs m_fs_vfs;
@@ -54,6 +61,7 @@ class server : public module_vfs {
 
     cmd_res handle_sync(cmd_req const & req);
     class auto_complete_task;
+    completion_index_ref get_completion_index(snapshot_vector const & snapshots, std::shared_ptr<snapshot const> const & snap);
     void handle_complete(cmd_req const & req);
     cmd_res handle_info(cmd_req const & req);
 
@@ -61,7 +69,7 @@ public:
     server(unsigned num_threads, environment const & intial_env, io_state const & ios);
     ~server();
 
-    std::tuple<std::string, module_src, time_t> load_module(module_id const & id, bool can_use_olean) override;
+    std::tuple<mapped_file_ref, module_src, time_t> load_module(module_id const & id, bool can_use_olean) override;
 
     void run();
 };
@@ -376,6 +376,31 @@ static void tst18() {
     lean_assert(!has_local(mk_app(f, a0, a0, a0, a0)));
 }
 
+#if defined(LEAN_MULTI_THREAD)
+/* Structurally equal expressions created by different threads are pointer equal when the global table is used. */
+static void tst19() {
+    enable_global_expr_caching(true);
+    expr e1, e2;
+    thread t1([&]() { e1 = mk_dag(20); });
+    thread t2([&]() { e2 = mk_dag(20); });
+    t1.join();
+    t2.join();
+    lean_assert(is_eqp(e1, e2));
+    lean_assert(is_eqp(e1, mk_dag(20)));
+    lean_assert(is_cached(e1));
+    /* expressions that are only referenced by the table are swept when a shard reaches twice
+       the number of live expressions, each iteration creates two of them */
+    unsigned n = 300000;
+    for (unsigned i = 0; i < n; i++)
+        mk_app(Const("g"), mk_constant(name("c").append_after(i)));
+    lean_assert(get_global_expr_cache_size() < n);
+    lean_assert(is_cached(e1));
+    enable_global_expr_caching(false);
+}
+#else
+static void tst19() {}
+#endif
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -403,6 +428,7 @@ int main() {
     tst16();
     tst17();
     tst18();
+    tst19();
     std::cout << "sizeof(expr):            " << sizeof(expr) << "\n";
     std::cout << "sizeof(expr_cell):       " << sizeof(expr_cell) << "\n";
     std::cout << "sizeof(expr_app):        " << sizeof(expr_app) << "\n";
@@ -0,0 +1,131 @@
+/*
+Copyright (c) 2026 agent. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "util/test.h"
+#include "util/init_module.h"
+#include "util/sexpr/init_module.h"
+#include "kernel/init_module.h"
+#include "library/init_module.h"
+#include "library/mt_task_queue.h"
+#include "library/message_buffer.h"
+using namespace lean;
+
+#if defined(LEAN_MULTI_THREAD)
+/* Small task simulating a cheap elaboration step, it depends on (at most) two other tasks. */
+class bench_task : public task<unsigned> {
+    unsigned m_work;
+    task_result<unsigned> m_dep1, m_dep2;
+public:
+    bench_task(unsigned work, task_result<unsigned> const & dep1, task_result<unsigned> const & dep2):
+        m_work(work), m_dep1(dep1), m_dep2(dep2) {}
+
+    void description(std::ostream & out) const override { out << "benchmark task"; }
+
+    std::vector<generic_task_result> get_dependencies() override {
+        std::vector<generic_task_result> deps;
+        if (m_dep1) deps.push_back(m_dep1);
+        if (m_dep2) deps.push_back(m_dep2);
+        return deps;
+    }
+
+    unsigned execute() override {
+        unsigned r = 1;
+        for (unsigned i = 0; i < m_work; i++)
+            r = r * 31 + i;
+        unsigned d1 = m_dep1 ? m_dep1.get() : 0;
+        unsigned d2 = m_dep2 ? m_dep2.get() : 0;
+        return (r & 1) + (d1 > d2 ? d1 : d2);
+    }
+};
+
+/* Submit \c width independent chains of \c depth tasks, where each task also depends on the
+   previous task of the neighbouring chain, and return the number of tasks executed per second. */
+static double run_bench(unsigned num_workers, unsigned width, unsigned depth, unsigned work) {
+    mt_task_queue tq(num_workers);
+    scope_global_task_queue scope_tq(&tq);
+    auto start = chrono::steady_clock::now();
+    std::vector<task_result<unsigned>> layer(width);
+    for (unsigned d = 0; d < depth; d++) {
+        std::vector<task_result<unsigned>> new_layer;
+        for (unsigned i = 0; i < width; i++)
+            new_layer.push_back(get_global_task_queue().submit<bench_task>(work, layer[i], layer[(i + 1) % width]));
+        layer = new_layer;
+    }
+    for (auto & t : layer) {
+        unsigned r = t.get();
+        lean_assert(r <= depth);
+        (void)r;
+    }
+    tq.join();
+    lean_assert(tq.empty());
+    auto stop = chrono::steady_clock::now();
+    double secs = chrono::duration_cast<chrono::microseconds>(stop - start).count() / 1000000.0;
+    return (width * depth) / (secs > 0 ? secs : 1e-6);
+}
+
+static void tst1() {
+    unsigned max_workers = std::max(hardware_concurrency(), 1u);
+    for (unsigned num_workers = 1; ; num_workers *= 2) {
+        if (num_workers > max_workers) num_workers = max_workers;
+        double tiny  = run_bench(num_workers, 64, 64, 0);
+        double small = run_bench(num_workers, 64, 32, 2000);
+        std::cout << num_workers << " worker(s): " << static_cast<unsigned>(tiny) << " tiny tasks/s, "
+                  << static_cast<unsigned>(small) << " small tasks/s\n";
+        if (num_workers == max_workers) break;
+    }
+}
+
+/* Cancelled tasks stay in the ready queues until a worker skips them. */
+static void tst2() {
+    mt_task_queue tq(2);
+    scope_global_task_queue scope_tq(&tq);
+    std::vector<task_result<unsigned>> ts;
+    task_result<unsigned> none;
+    for (unsigned i = 0; i < 200; i++)
+        ts.push_back(get_global_task_queue().submit<bench_task>(10000, none, none));
+    for (unsigned i = 0; i < ts.size(); i += 2)
+        tq.cancel(ts[i]);
+    unsigned num_ok = 0;
+    for (unsigned i = 0; i < ts.size(); i++) {
+        try {
+            ts[i].get();
+            num_ok++;
+        } catch (...) {}
+    }
+    lean_assert(num_ok >= ts.size() / 2);
+    tq.join();
+    lean_assert(tq.empty());
+}
+#else
+static void tst1() {}
+static void tst2() {}
+#endif
+
+int main() {
+    save_stack_info();
+    initialize_util_module();
+    initialize_sexpr_module();
+    initialize_kernel_module();
+    initialize_library_core_module();
+    initialize_library_module();
+    {
+        null_message_buffer msg_buf;
+        scoped_message_buffer scope_msg_buf(&msg_buf);
+        scope_message_context scope_msg_ctx(message_bucket_id { "_global", 1 });
+        scoped_task_context scope_task_ctx("mt_task_queue", {1, 0});
+        tst1();
+        tst2();
+    }
+    finalize_library_module();
+    finalize_library_core_module();
+    finalize_kernel_module();
+    finalize_sexpr_module();
+    finalize_util_module();
+    return has_violations() ? 1 : 0;
+}
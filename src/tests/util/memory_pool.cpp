@@ -0,0 +1,94 @@
+/*
+Copyright (c) 2026 agent. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#include <iostream>
+#include <vector>
+#include "util/test.h"
+#include "util/thread.h"
+#include "util/memory_pool.h"
+#include "util/init_module.h"
+using namespace lean;
+
+struct cell { void * m_data[4]; };
+
+DEF_THREAD_MEMORY_POOL(get_test_allocator, sizeof(cell));
+
+static memory_pool_stats get_test_stats() {
+    for (memory_pool_stats const & s : get_memory_pool_stats()) {
+        if (s.m_name == "get_test_allocator")
+            return s;
+    }
+    lean_unreachable();
+}
+
+static void tst1() {
+    std::vector<void *> blocks;
+    for (unsigned i = 0; i < 10000; i++)
+        blocks.push_back(get_test_allocator().allocate());
+    for (void * b : blocks)
+        get_test_allocator().recycle(b);
+    memory_pool_stats s = get_test_stats();
+    lean_assert(s.m_size == sizeof(cell));
+    lean_assert(s.m_num_allocated >= 10000);
+    /* most of the free blocks must have been returned to the depot */
+    lean_assert(s.m_num_depot >= 10000 - LEAN_MEMORY_POOL_BATCH_SIZE * (LEAN_MEMORY_POOL_MAX_CACHED_BATCHES + 1));
+    /* allocating again must not use malloc */
+    for (unsigned i = 0; i < 10000; i++)
+        blocks[i] = get_test_allocator().allocate();
+    lean_assert(get_test_stats().m_num_allocated == s.m_num_allocated);
+    for (void * b : blocks)
+        get_test_allocator().recycle(b);
+}
+
+#if defined(LEAN_MULTI_THREAD)
+/* Blocks allocated by one thread and freed by another one must be reused. */
+static void tst2() {
+    size_t num_allocated = get_test_stats().m_num_allocated;
+    for (unsigned round = 0; round < 20; round++) {
+        std::vector<void *> blocks;
+        thread producer([&]() {
+                for (unsigned i = 0; i < 5000; i++)
+                    blocks.push_back(get_test_allocator().allocate());
+                run_thread_finalizers();
+                run_post_thread_finalizers();
+            });
+        producer.join();
+        for (void * b : blocks)
+            get_test_allocator().recycle(b);
+    }
+    memory_pool_stats s = get_test_stats();
+    std::cout << s.m_num_allocated << " " << s.m_num_cached << " " << s.m_num_depot << "\n";
+    lean_assert(s.m_num_allocated <= num_allocated + 5000 + LEAN_MEMORY_POOL_BATCH_SIZE * LEAN_MEMORY_POOL_MAX_DEPOT_BATCHES);
+}
+#else
+static void tst2() {}
+#endif
+
+/* Requests that are rounded to the same block size share the depot and the statistics. */
+static void tst3() {
+    memory_pool p1(1, "small_pool");
+    memory_pool p2(2, "small_pool");
+    p2.recycle(p1.allocate());
+    unsigned n = 0;
+    for (memory_pool_stats const & s : get_memory_pool_stats()) {
+        if (s.m_name == "small_pool") {
+            lean_assert(s.m_size == sizeof(cell::m_data[0]));
+            n++;
+        }
+    }
+    lean_assert(n == 1);
+}
+
+int main() {
+    save_stack_info();
+    initialize_util_module();
+    tst1();
+    tst2();
+    tst3();
+    display_memory_pool_stats(std::cout);
+    finalize_util_module();
+    return has_violations() ? 1 : 0;
+}
@@ -4,9 +4,12 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <cstring>
 #include <iostream>
+#include <limits>
 #include <sstream>
 #include <string>
+#include <vector>
 #include "util/test.h"
 #include "util/serializer.h"
 #include "util/numerics/mpz.h"
@@ -63,8 +66,87 @@ static void tst2() {
     lean_assert(n4 == m4);
 }
 
+static bool is_eq(mpz const & a, mpz_t const & b) {
+    std::ostringstream out;
+    out << a;
+    char * s = mpz_get_str(nullptr, 10, b);
+    bool r = out.str() == s;
+    void (*freefunc)(void *, size_t);
+    mp_get_memory_functions(nullptr, nullptr, &freefunc);
+    freefunc(s, strlen(s) + 1);
+    return r;
+}
+
+/* Small values are stored inline, check the operations that cross the boundary using GMP directly. */
+static void tst3() {
+    std::vector<std::string> vals = {"0", "1", "-1", "2", "-2", "7", "-7", "1000", "-1000", "46341", "-46341",
+                                     "2147483647", "2147483648", "-2147483648", "-2147483649", "4294967296",
+                                     "3037000499", "3037000500", "-3037000500",
+                                     "9223372036854775807", "9223372036854775806", "-9223372036854775808",
+                                     "-9223372036854775807", "9223372036854775808", "-9223372036854775809",
+                                     "18446744073709551616", "-100000000000000000000000"};
+    mpz_t a, b, r;
+    mpz_init(a); mpz_init(b); mpz_init(r);
+    for (std::string const & s1 : vals) {
+        for (std::string const & s2 : vals) {
+            mpz x(s1.c_str()), y(s2.c_str());
+            mpz_set_str(a, s1.c_str(), 10); mpz_set_str(b, s2.c_str(), 10);
+            mpz_add(r, a, b); lean_assert(is_eq(x + y, r));
+            mpz_sub(r, a, b); lean_assert(is_eq(x - y, r));
+            mpz_mul(r, a, b); lean_assert(is_eq(x * y, r));
+            mpz_and(r, a, b); lean_assert(is_eq(x & y, r));
+            mpz_ior(r, a, b); lean_assert(is_eq(x | y, r));
+            mpz_xor(r, a, b); lean_assert(is_eq(x ^ y, r));
+            mpz_gcd(r, a, b); lean_assert(is_eq(gcd(x, y), r));
+            lean_assert_eq(cmp(x, y) < 0, mpz_cmp(a, b) < 0);
+            lean_assert_eq(cmp(x, y) == 0, mpz_cmp(a, b) == 0);
+            if (mpz_sgn(b) != 0) {
+                mpz_tdiv_q(r, a, b); lean_assert(is_eq(x / y, r));
+                mpz_tdiv_r(r, a, b); lean_assert(is_eq(rem(x, y), r));
+            }
+            mpz z(x);
+            z.addmul(x, y);
+            mpz_set(r, a); mpz_addmul(r, a, b); lean_assert(is_eq(z, r));
+            z = x;
+            z.submul(x, y);
+            mpz_set(r, a); mpz_submul(r, a, b); lean_assert(is_eq(z, r));
+            mpz_mul_2exp(r, b, 40); mul2k(z, y, 40); lean_assert(is_eq(z, r));
+            mpz_mul_2exp(r, b, 3); mul2k(z, y, 3); lean_assert(is_eq(z, r));
+            z = x; z += x;
+            mpz_add(r, a, a); lean_assert(is_eq(z, r));
+        }
+        mpz x(s1.c_str());
+        mpz_set_str(a, s1.c_str(), 10);
+        mpz_neg(r, a); lean_assert(is_eq(neg(x), r));
+        mpz_abs(r, a); lean_assert(is_eq(abs(x), r));
+        mpz_com(r, a); lean_assert(is_eq(~x, r));
+        mpz_add_ui(r, a, 4000000000u); lean_assert(is_eq(x + 4000000000u, r));
+        mpz_sub_ui(r, a, 4000000000u); lean_assert(is_eq(x - 4000000000u, r));
+        mpz_mul_si(r, a, -3); lean_assert(is_eq(x * -3, r));
+        lean_assert_eq(x.hash(), mpz(x - 1 + 1).hash());
+        lean_assert_eq(x.is_int(), mpz_fits_sint_p(a) != 0);
+        lean_assert_eq(x.is_unsigned_int(), mpz_fits_uint_p(a) != 0);
+        lean_assert_eq(x.is_long_int(), mpz_fits_slong_p(a) != 0);
+        lean_assert_eq(cmp(x, 4000000000u) < 0, mpz_cmp_ui(a, 4000000000u) < 0);
+        lean_assert_eq(x.log2(), (mpz_sgn(a) > 0 ? mpz_sizeinbase(a, 2) - 1 : 0));
+    }
+    mpz_clear(a); mpz_clear(b); mpz_clear(r);
+    /* values that become small again */
+    mpz big("100000000000000000000");
+    mpz small = big - mpz("99999999999999999999");
+    lean_assert(small.is_int());
+    lean_assert_eq(small.get_int(), 1);
+    lean_assert_eq(small.hash(), mpz(1).hash());
+    mpz m(std::numeric_limits<long int>::max());
+    m++;
+    lean_assert(!m.is_long_int());
+    m--;
+    lean_assert(m.is_long_int());
+}
+
 int main() {
     tst1();
     tst2();
+    tst3();
     return has_violations() ? 1 : 0;
 }
@@ -80,8 +80,30 @@ static void tst2() {
     sub(std::numeric_limits<int>::min() + 1, 1);
 }
 
+static void tst3() {
+    long max = std::numeric_limits<long>::max();
+    long min = std::numeric_limits<long>::min();
+    long r;
+    lean_assert(!checked_add(max, 1, r));
+    lean_assert(!checked_add(min, -1, r));
+    lean_assert(checked_add(max, -1, r) && r == max - 1);
+    lean_assert(checked_add(min, max, r) && r == -1);
+    lean_assert(!checked_sub(min, 1, r));
+    lean_assert(!checked_sub(0, min, r));
+    lean_assert(checked_sub(-1, min, r) && r == max);
+    lean_assert(!checked_mul(max, 2, r));
+    lean_assert(!checked_mul(min, -1, r));
+    lean_assert(!checked_mul(max / 2 + 2, -2, r));
+    lean_assert(checked_mul(max / 2 + 1, -2, r) && r == min);
+    lean_assert(checked_mul(max / 2, -2, r) && r == -(max - 1));
+    lean_assert(checked_mul(min / 2, 2, r) && r == min);
+    lean_assert(checked_mul(min, 1, r) && r == min);
+    lean_assert(checked_mul(0, min, r) && r == 0);
+}
+
 int main() {
     tst1();
     tst2();
+    tst3();
     return has_violations() ? 1 : 0;
 }
@@ -171,6 +171,29 @@ static void tst4() {
     lean_assert_eq(d5, o5);
 }
 
+static void tst5() {
+    std::ostringstream out;
+    serializer s(out);
+    name n1{"foo", "bla"};
+    s.write_int(10); s.write_unsigned(100000); s.write_string("hello"); s << n1 << n1; s.write_string(""); s.write_bool(true);
+    std::string buf = out.str();
+    deserializer d(buf.data(), buf.data() + buf.size(), optional<std::string>());
+    name m1, m2;
+    lean_assert(d.read_int() == 10);
+    lean_assert(d.read_unsigned() == 100000);
+    lean_assert(d.read_string() == "hello");
+    d >> m1 >> m2;
+    lean_assert(n1 == m1);
+    lean_assert(n1 == m2);
+    lean_assert(d.read_string() == "");
+    lean_assert(d.read_bool());
+    try {
+        d.read_string();
+        lean_unreachable();
+    } catch (corrupted_stream_exception &) {
+    }
+}
+
 int main() {
     save_stack_info();
     initialize_util_module();
@@ -179,6 +202,7 @@ int main() {
     tst2();
     tst3();
     tst4();
+    tst5();
     finalize_util_module();
     return has_violations() ? 1 : 0;
 }
@@ -9,6 +9,7 @@ Author: Leonardo de Moura
 #endif
 #include <string>
 #include <cstdlib>
+#include <cstdio>
 #include <fstream>
 #include <vector>
 #include <sys/types.h>
@@ -343,6 +344,15 @@ time_t get_mtime(std::string const &fname) {
     return st.st_mtime;
 }
 
+bool rename_file(std::string const & from, std::string const & to) {
+#if defined(LEAN_WINDOWS) && !defined(LEAN_CYGWIN)
+    /* std::rename fails on Windows when the target already exists */
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
 optional<bool> is_dir(std::string const & fn) {
     struct stat st;
     if (stat(fn.c_str(), &st) == 0)
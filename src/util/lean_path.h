@@ -68,6 +68,10 @@ void recursive_list_files(std::string const & dirname, std::vector<std::string>
 
 time_t get_mtime(std::string const & fname);
 
+/** \brief Rename \c from to \c to, replacing \c to if it already exists.
+    Return false if the operation failed. */
+bool rename_file(std::string const & from, std::string const & to);
+
 void initialize_lean_path();
 void finalize_lean_path();
 }
@@ -37,7 +37,7 @@ private:
     static memory_pool & get_allocator() {
         LEAN_THREAD_PTR(memory_pool, g_allocator);
         if (!g_allocator)
-            g_allocator = allocate_thread_memory_pool(sizeof(cell));
+            g_allocator = allocate_thread_memory_pool(sizeof(cell), "list");
         return *g_allocator;
     }
 
@@ -0,0 +1,71 @@
+/*
+Copyright (c) 2026 agent. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#include <string>
+#include <fstream>
+#include <sstream>
+#include "util/lean_path.h"
+#include "util/mapped_file.h"
+
+#if !defined(LEAN_WINDOWS) && !defined(LEAN_EMSCRIPTEN)
+#define LEAN_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+namespace lean {
+static std::string read_contents(std::string const & fname) {
+    std::ifstream in(fname, std::ios_base::binary);
+    if (!in.good()) throw file_not_found_exception(fname);
+    std::stringstream buf;
+    buf << in.rdbuf();
+    return buf.str();
+}
+
+mapped_file::mapped_file(std::string const & fname):
+    m_fname(fname), m_data(nullptr), m_size(0), m_mapped(false) {
+#if defined(LEAN_MMAP)
+    int fd = open(fname.c_str(), O_RDONLY);
+    if (fd == -1) throw file_not_found_exception(fname);
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        void * addr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr != MAP_FAILED) {
+            m_data   = static_cast<char const *>(addr);
+            m_size   = st.st_size;
+            m_mapped = true;
+        }
+    }
+    close(fd);
+    if (m_mapped)
+        return;
+#endif
+    m_buffer = read_contents(fname);
+    m_data   = m_buffer.data();
+    m_size   = m_buffer.size();
+}
+
+mapped_file::mapped_file(std::string const & fname, std::string const & contents):
+    m_fname(fname), m_buffer(contents), m_data(m_buffer.data()), m_size(m_buffer.size()), m_mapped(false) {
+}
+
+mapped_file::~mapped_file() {
+#if defined(LEAN_MMAP)
+    if (m_mapped)
+        munmap(const_cast<char *>(m_data), m_size);
+#endif
+}
+
+mapped_file_ref map_file(std::string const & fname) {
+    return std::make_shared<mapped_file>(fname);
+}
+
+mapped_file_ref mk_mapped_file(std::string const & fname, std::string const & contents) {
+    return std::make_shared<mapped_file>(fname, contents);
+}
+}
@@ -0,0 +1,51 @@
+/*
+Copyright (c) 2026 agent. All rights reserved.
+Released under Apache 2.0 license as described in the file LICENSE.
+
+Author: agent
+*/
+#pragma once
+#include <string>
+#include <memory>
+
+namespace lean {
+/** \brief Immutable contents of a file.
+
+    When the platform supports it, the file is mapped into memory, and its contents
+    are never copied. Otherwise, the file is read into a buffer.
+    The contents may also be provided directly, e.g., object code produced by the
+    current process or the contents of an editor buffer.
+
+    \remark Files that are mapped must not be modified in place while they are in use,
+    they should be replaced using a rename. */
+class mapped_file {
+    std::string  m_fname;
+    std::string  m_buffer;
+    char const * m_data;
+    size_t       m_size;
+    bool         m_mapped;
+public:
+    /** \brief Map the file \c fname. Throws \c file_not_found_exception if it cannot be opened. */
+    explicit mapped_file(std::string const & fname);
+    /** \brief Wrap the given contents, \c fname is only used for error messages. */
+    mapped_file(std::string const & fname, std::string const & contents);
+    mapped_file(mapped_file const &) = delete;
+    mapped_file & operator=(mapped_file const &) = delete;
+    ~mapped_file();
+
+    std::string const & get_fname() const { return m_fname; }
+    char const * data() const { return m_data; }
+    size_t size() const { return m_size; }
+    char const * begin() const { return m_data; }
+    char const * end() const { return m_data + m_size; }
+    bool is_mapped() const { return m_mapped; }
+    std::string to_string() const { return std::string(m_data, m_size); }
+};
+
+typedef std::shared_ptr<mapped_file const> mapped_file_ref;
+
+/** \brief Map the file \c fname into memory (see mapped_file). */
+mapped_file_ref map_file(std::string const & fname);
+/** \brief Wrap contents that are already in memory into a mapped_file. */
+mapped_file_ref mk_mapped_file(std::string const & fname, std::string const & contents);
+}
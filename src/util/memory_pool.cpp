@@ -4,27 +4,148 @@ Released under Apache 2.0 license as described in the file LICENSE.
 
 Author: Leonardo de Moura
 */
+#include <algorithm>
+#include <iostream>
+#include <string>
 #include <vector>
+#include "util/debug.h"
 #include "util/thread.h"
 #include "util/memory_pool.h"
 
+/* Number of blocks allocated at once using malloc when the depot is empty */
+#ifndef LEAN_MEMORY_POOL_MALLOC_CHUNK
+#define LEAN_MEMORY_POOL_MALLOC_CHUNK 32
+#endif
+
 namespace lean {
+/** \brief Data shared by all thread local memory pools with the same name and block size. */
+class memory_pool_kind {
+public:
+    std::string        m_name;
+    unsigned           m_size;
+    mutex              m_mutex;
+    /* Each batch is a list of LEAN_MEMORY_POOL_BATCH_SIZE free blocks */
+    std::vector<void*> m_batches;
+    /* Number of free blocks cached by the thread local pools, only updated when they access the depot */
+    size_t             m_num_cached = 0;
+    atomic<size_t>     m_num_allocated;
+    memory_pool_kind(std::string const & n, unsigned sz):m_name(n), m_size(sz), m_num_allocated(0) {}
+};
+
+/* The kinds are never deleted, since memory pools may be created before the util module is
+   initialized, and the memory pools of the main thread are only finalized at exit. */
+static mutex & get_memory_pool_kinds_mutex() {
+    static mutex * g_mutex = new mutex();
+    return *g_mutex;
+}
+
+static std::vector<memory_pool_kind*> & get_memory_pool_kinds() {
+    static std::vector<memory_pool_kind*> * g_kinds = new std::vector<memory_pool_kind*>();
+    return *g_kinds;
+}
+
+static memory_pool_kind * get_memory_pool_kind(char const * name, unsigned sz) {
+    std::string n(name ? name : "unnamed");
+    lock_guard<mutex> lock(get_memory_pool_kinds_mutex());
+    for (memory_pool_kind * k : get_memory_pool_kinds()) {
+        if (k->m_size == sz && k->m_name == n)
+            return k;
+    }
+    memory_pool_kind * k = new memory_pool_kind(n, sz);
+    get_memory_pool_kinds().push_back(k);
+    return k;
+}
+
+static void * next_block(void * b) {
+    return *(reinterpret_cast<void **>(b));
+}
+
+/* Remove the first \c n blocks from \c free_list, and return them. */
+static void * split_blocks(void * & free_list, unsigned n) {
+    lean_assert(n > 0);
+    void * r    = free_list;
+    void * last = r;
+    for (unsigned i = 1; i < n; i++)
+        last = next_block(last);
+    free_list = next_block(last);
+    *(reinterpret_cast<void **>(last)) = nullptr;
+    return r;
+}
+
+static size_t free_blocks(void * b) {
+    size_t n = 0;
+    while (b != nullptr) {
+        void * next = next_block(b);
+        free(b);
+        b = next;
+        n++;
+    }
+    return n;
+}
+
+memory_pool::memory_pool(unsigned size, char const * name):
+    m_size(std::max(size, static_cast<unsigned>(sizeof(m_free_list)))), m_free_list(nullptr), m_num_free(0),
+    m_num_published(0), m_kind(get_memory_pool_kind(name, m_size)) {
+}
+
 memory_pool::~memory_pool() {
-    while (m_free_list != nullptr) {
-        void * r = m_free_list;
-        m_free_list = *(reinterpret_cast<void **>(r));
-        free(r);
+    {
+        lock_guard<mutex> lock(m_kind->m_mutex);
+        while (m_num_free >= LEAN_MEMORY_POOL_BATCH_SIZE &&
+               m_kind->m_batches.size() < LEAN_MEMORY_POOL_MAX_DEPOT_BATCHES) {
+            m_kind->m_batches.push_back(split_blocks(m_free_list, LEAN_MEMORY_POOL_BATCH_SIZE));
+            m_num_free -= LEAN_MEMORY_POOL_BATCH_SIZE;
+        }
+        m_kind->m_num_cached -= m_num_published;
+    }
+    m_kind->m_num_allocated -= free_blocks(m_free_list);
+}
+
+/* Update the number of blocks cached by this pool in m_kind, the lock must be held */
+void memory_pool::publish() {
+    m_kind->m_num_cached = m_kind->m_num_cached + m_num_free - m_num_published;
+    m_num_published = m_num_free;
+}
+
+void * memory_pool::refill() {
+    lean_assert(m_free_list == nullptr);
+    {
+        lock_guard<mutex> lock(m_kind->m_mutex);
+        if (!m_kind->m_batches.empty()) {
+            m_free_list = m_kind->m_batches.back();
+            m_kind->m_batches.pop_back();
+            m_num_free  = LEAN_MEMORY_POOL_BATCH_SIZE;
+        }
+        publish();
     }
+    if (m_free_list == nullptr) {
+        unsigned n = 0;
+        for (; n < LEAN_MEMORY_POOL_MALLOC_CHUNK; n++) {
+            void * b = malloc(m_size);
+            if (b == nullptr) break;
+            *(reinterpret_cast<void **>(b)) = m_free_list;
+            m_free_list = b;
+        }
+        if (n == 0) return nullptr;
+        m_num_free += n;
+        m_kind->m_num_allocated += n;
+    }
+    return allocate();
 }
 
-void * memory_pool::allocate() {
-    if (m_free_list != nullptr) {
-        void * r = m_free_list;
-        m_free_list = *(reinterpret_cast<void **>(r));
-        return r;
-    } else {
-        return malloc(m_size);
+void memory_pool::return_surplus() {
+    void * batch = split_blocks(m_free_list, LEAN_MEMORY_POOL_BATCH_SIZE);
+    m_num_free -= LEAN_MEMORY_POOL_BATCH_SIZE;
+    {
+        lock_guard<mutex> lock(m_kind->m_mutex);
+        publish();
+        if (m_kind->m_batches.size() < LEAN_MEMORY_POOL_MAX_DEPOT_BATCHES) {
+            m_kind->m_batches.push_back(batch);
+            return;
+        }
     }
+    /* the depot is full, give the memory back to the system */
+    m_kind->m_num_allocated -= free_blocks(batch);
 }
 
 typedef std::vector<memory_pool*> memory_pools;
@@ -41,13 +162,41 @@ static void thread_finalize_memory_pool(void * p) {
     g_thread_pools = nullptr;
 }
 
-memory_pool * allocate_thread_memory_pool(unsigned sz) {
+memory_pool * allocate_thread_memory_pool(unsigned sz, char const * name) {
     if (!g_thread_pools) {
         g_thread_pools = new std::vector<memory_pool*>();
         register_post_thread_finalizer(thread_finalize_memory_pool, g_thread_pools);
     }
-    memory_pool * r = new memory_pool(sz);
+    memory_pool * r = new memory_pool(sz, name);
     g_thread_pools->push_back(r);
     return r;
 }
+
+std::vector<memory_pool_stats> get_memory_pool_stats() {
+    std::vector<memory_pool_stats> r;
+    lock_guard<mutex> lock(get_memory_pool_kinds_mutex());
+    for (memory_pool_kind * k : get_memory_pool_kinds()) {
+        lock_guard<mutex> k_lock(k->m_mutex);
+        memory_pool_stats s;
+        s.m_name          = k->m_name;
+        s.m_size          = k->m_size;
+        s.m_num_allocated = k->m_num_allocated.load();
+        s.m_num_cached    = k->m_num_cached;
+        s.m_num_depot     = k->m_batches.size() * LEAN_MEMORY_POOL_BATCH_SIZE;
+        r.push_back(s);
+    }
+    std::sort(r.begin(), r.end(), [](memory_pool_stats const & s1, memory_pool_stats const & s2) {
+            return s1.m_num_allocated * s1.m_size > s2.m_num_allocated * s2.m_size;
+        });
+    return r;
+}
+
+void display_memory_pool_stats(std::ostream & out) {
+    out << "memory pools (name, block size, allocated, cached, depot):\n";
+    for (memory_pool_stats const & s : get_memory_pool_stats()) {
+        if (s.m_num_allocated == 0) continue;
+        out << "  " << s.m_name << " " << s.m_size << " " << s.m_num_allocated << " "
+            << s.m_num_cached << " " << s.m_num_depot << "\n";
+    }
+}
 }
@@ -5,30 +5,88 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include <iosfwd>
+#include <string>
+#include <vector>
 #include "util/memory.h"
 
+#ifndef LEAN_MEMORY_POOL_BATCH_SIZE
+#define LEAN_MEMORY_POOL_BATCH_SIZE 256
+#endif
+
+#ifndef LEAN_MEMORY_POOL_MAX_CACHED_BATCHES
+#define LEAN_MEMORY_POOL_MAX_CACHED_BATCHES 4
+#endif
+
+#ifndef LEAN_MEMORY_POOL_MAX_DEPOT_BATCHES
+#define LEAN_MEMORY_POOL_MAX_DEPOT_BATCHES 64
+#endif
+
 namespace lean {
-/** \brief Auxiliary object for "recycling" allocated memory of fixed size */
+class memory_pool_kind;
+
+/** \brief Auxiliary object for "recycling" allocated memory of fixed size.
+
+    Memory pools are thread local, but objects are often deallocated by a different thread than the one
+    that allocated them (e.g., expressions created by a task are freed by the thread that consumes the result).
+    To prevent memory from accumulating in the free list of the deallocating thread, each pool keeps at most
+    LEAN_MEMORY_POOL_MAX_CACHED_BATCHES batches of free blocks, and returns the surplus to a depot shared
+    by all pools with the same name and block size. Pools refill from the depot before using malloc. */
 class memory_pool {
-    unsigned m_size;
-    void *   m_free_list;
+    unsigned           m_size;
+    void *             m_free_list;
+    unsigned           m_num_free;
+    unsigned           m_num_published;
+    memory_pool_kind * m_kind;
+    void publish();
+    void * refill();
+    void return_surplus();
 public:
-    memory_pool(unsigned size):m_size(size), m_free_list(nullptr) {}
+    memory_pool(unsigned size, char const * name = nullptr);
     ~memory_pool();
-    void * allocate();
+    void * allocate() {
+        if (m_free_list != nullptr) {
+            void * r = m_free_list;
+            m_free_list = *(reinterpret_cast<void **>(r));
+            m_num_free--;
+            return r;
+        } else {
+            return refill();
+        }
+    }
     void recycle(void * ptr) {
         *(reinterpret_cast<void**>(ptr)) = m_free_list;
         m_free_list = ptr;
+        m_num_free++;
+        if (m_num_free > LEAN_MEMORY_POOL_BATCH_SIZE * LEAN_MEMORY_POOL_MAX_CACHED_BATCHES)
+            return_surplus();
     }
 };
 
-memory_pool * allocate_thread_memory_pool(unsigned sz);
+memory_pool * allocate_thread_memory_pool(unsigned sz, char const * name = nullptr);
+
+/** \brief Statistics for all memory pools with the same name and block size.
+    The number of blocks cached by each thread is only updated when the thread
+    exchanges blocks with the depot, so \c m_num_cached is an approximation. */
+struct memory_pool_stats {
+    std::string m_name;
+    unsigned    m_size;
+    /* blocks obtained using malloc, and not freed yet */
+    size_t      m_num_allocated;
+    /* free blocks cached by thread local pools */
+    size_t      m_num_cached;
+    /* free blocks in the shared depot */
+    size_t      m_num_depot;
+};
+
+std::vector<memory_pool_stats> get_memory_pool_stats();
+void display_memory_pool_stats(std::ostream & out);
 
-#define DEF_THREAD_MEMORY_POOL(NAME, SZ)                        \
-LEAN_THREAD_PTR(memory_pool, NAME ## _tlocal);                  \
-memory_pool & NAME() {                                          \
-    if (!NAME ## _tlocal)                                       \
-        NAME ## _tlocal = allocate_thread_memory_pool(SZ);      \
-    return *(NAME ## _tlocal);                                  \
+#define DEF_THREAD_MEMORY_POOL(NAME, SZ)                                \
+LEAN_THREAD_PTR(memory_pool, NAME ## _tlocal);                          \
+memory_pool & NAME() {                                                  \
+    if (!NAME ## _tlocal)                                               \
+        NAME ## _tlocal = allocate_thread_memory_pool(SZ, #NAME);       \
+    return *(NAME ## _tlocal);                                          \
 }
 }
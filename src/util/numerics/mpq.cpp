@@ -70,6 +70,7 @@ mpz floor(mpq const & a) {
         return a.get_numerator();
     mpz r;
     mpz_tdiv_q(mpq::zval(r), mpq_numref(a.m_val), mpq_denref(a.m_val));
+    mpq::znormalize(r);
     if (a.is_neg())
         --r;
     return r;
@@ -80,6 +81,7 @@ mpz ceil(mpq const & a) {
         return a.get_numerator();
     mpz r;
     mpz_tdiv_q(mpq::zval(r), mpq_numref(a.m_val), mpq_denref(a.m_val));
+    mpq::znormalize(r);
     if (a.is_pos())
         ++r;
     return r;
@@ -16,14 +16,16 @@ class mpbq;
 class mpq {
     friend class mpfp;
     mpq_t m_val;
-    static mpz_t const & zval(mpz const & v) { return v.m_val; }
-    static mpz_t & zval(mpz & v) { return v.m_val; }
+    static mpz::view zval(mpz const & v) { return mpz::view(v); }
+    static __mpz_struct * zval(mpz & v) { return v.big_val(); }
+    /* Must be used after updating \c v using zval(v). */
+    static void znormalize(mpz & v) { v.normalize(); }
 public:
     friend void swap(mpq & a, mpq & b) { mpq_swap(a.m_val, b.m_val); }
-    friend void swap_numerator(mpq & a, mpz & b) { mpz_swap(mpq_numref(a.m_val), zval(b)); mpq_canonicalize(a.m_val); }
-    friend void swap_denominator(mpq & a, mpz & b) { mpz_swap(mpq_denref(a.m_val), zval(b)); mpq_canonicalize(a.m_val); }
+    friend void swap_numerator(mpq & a, mpz & b) { mpz_swap(mpq_numref(a.m_val), zval(b)); znormalize(b); mpq_canonicalize(a.m_val); }
+    friend void swap_denominator(mpq & a, mpz & b) { mpz_swap(mpq_denref(a.m_val), zval(b)); znormalize(b); mpq_canonicalize(a.m_val); }
 
-    mpq & operator=(mpz const & v) { mpq_set_z(m_val, v.m_val); return *this; }
+    mpq & operator=(mpz const & v) { mpq_set_z(m_val, zval(v)); return *this; }
     mpq & operator=(mpq const & v) { mpq_set(m_val, v.m_val); return *this; }
     mpq & operator=(mpq && v) { swap(*this, v); return *this; }
     mpq & operator=(mpbq const & b);
@@ -130,22 +132,22 @@ public:
     friend bool operator!=(int a, mpq const & b) { return !operator==(a, b); }
 
     mpq & operator+=(mpq const & o) { mpq_add(m_val, m_val, o.m_val); return *this; }
-    mpq & operator+=(mpz const & o) { mpz_addmul(mpq_numref(m_val), mpq_denref(m_val), o.m_val); mpq_canonicalize(m_val); return *this; }
+    mpq & operator+=(mpz const & o) { mpz_addmul(mpq_numref(m_val), mpq_denref(m_val), zval(o)); mpq_canonicalize(m_val); return *this; }
     mpq & operator+=(unsigned int k) { mpz_addmul_ui(mpq_numref(m_val), mpq_denref(m_val), k); mpq_canonicalize(m_val); return *this; }
     mpq & operator+=(int k) { if (k >= 0) return operator+=(static_cast<unsigned int>(k)); else return operator-=(static_cast<unsigned int>(-k)); }
 
     mpq & operator-=(mpq const & o) { mpq_sub(m_val, m_val, o.m_val); return *this; }
-    mpq & operator-=(mpz const & o) { mpz_submul(mpq_numref(m_val), mpq_denref(m_val), o.m_val); mpq_canonicalize(m_val); return *this; }
+    mpq & operator-=(mpz const & o) { mpz_submul(mpq_numref(m_val), mpq_denref(m_val), zval(o)); mpq_canonicalize(m_val); return *this; }
     mpq & operator-=(unsigned int k) { mpz_submul_ui(mpq_numref(m_val), mpq_denref(m_val), k); mpq_canonicalize(m_val); return *this; }
     mpq & operator-=(int k) { if (k >= 0) return operator-=(static_cast<unsigned int>(k)); else return operator+=(static_cast<unsigned int>(-k)); }
 
     mpq & operator*=(mpq const & o) { mpq_mul(m_val, m_val, o.m_val); return *this; }
-    mpq & operator*=(mpz const & o) { mpz_mul(mpq_numref(m_val), mpq_numref(m_val), o.m_val); mpq_canonicalize(m_val); return *this; }
+    mpq & operator*=(mpz const & o) { mpz_mul(mpq_numref(m_val), mpq_numref(m_val), zval(o)); mpq_canonicalize(m_val); return *this; }
     mpq & operator*=(unsigned int k) { mpz_mul_ui(mpq_numref(m_val), mpq_numref(m_val), k); mpq_canonicalize(m_val); return *this; }
     mpq & operator*=(int k) { mpz_mul_si(mpq_numref(m_val), mpq_numref(m_val), k); mpq_canonicalize(m_val); return *this; }
 
     mpq & operator/=(mpq const & o) { mpq_div(m_val, m_val, o.m_val); return *this; }
-    mpq & operator/=(mpz const & o) { mpz_mul(mpq_denref(m_val), mpq_denref(m_val), o.m_val); mpq_canonicalize(m_val); return *this; }
+    mpq & operator/=(mpz const & o) { mpz_mul(mpq_denref(m_val), mpq_denref(m_val), zval(o)); mpq_canonicalize(m_val); return *this; }
     mpq & operator/=(unsigned int k) { mpz_mul_ui(mpq_denref(m_val), mpq_denref(m_val), k); mpq_canonicalize(m_val); return *this; }
     mpq & operator/=(int k) { mpz_mul_si(mpq_denref(m_val), mpq_denref(m_val), k); mpq_canonicalize(m_val); return *this; }
 
@@ -190,9 +192,9 @@ public:
     mpq operator-() const { mpq t = *this; t.neg(); return t; }
 
     // a <- numerator(b)
-    friend void numerator(mpz & a, mpq const & b) { mpz_set(zval(a), mpq_numref(b.m_val)); }
+    friend void numerator(mpz & a, mpq const & b) { mpz_set(zval(a), mpq_numref(b.m_val)); znormalize(a); }
     // a <- denominator(b)
-    friend void denominator(mpz & a, mpq const & b) { mpz_set(zval(a), mpq_denref(b.m_val)); }
+    friend void denominator(mpz & a, mpq const & b) { mpz_set(zval(a), mpq_denref(b.m_val)); znormalize(a); }
 
     mpz get_numerator() const { mpz r; numerator(r, *this); return r; }
     mpz get_denominator() const { mpz r; denominator(r, *this); return r; }
@@ -10,11 +10,10 @@ Author: Leonardo de Moura
 #include "util/numerics/mpz.h"
 
 namespace lean {
-
 unsigned mpz::log2() const {
     if (is_nonpos())
         return 0;
-    unsigned r = mpz_sizeinbase(m_val, 2);
+    unsigned r = mpz_sizeinbase(view(*this), 2);
     lean_assert(r > 0);
     return r - 1;
 }
@@ -22,19 +21,16 @@ unsigned mpz::log2() const {
 unsigned mpz::mlog2() const {
     if (is_nonneg())
         return 0;
-    mpz * _this = const_cast<mpz*>(this);
-    _this->neg();
-    lean_assert(is_pos());
-    unsigned r = mpz_sizeinbase(m_val, 2);
-    _this->neg();
-    lean_assert(is_neg());
+    /* mpz_sizeinbase ignores the sign */
+    unsigned r = mpz_sizeinbase(view(*this), 2);
+    lean_assert(r > 0);
     return r - 1;
 }
 
 bool mpz::is_power_of_two(unsigned & shift) const {
     if (is_nonpos())
         return false;
-    if (mpz_popcount(m_val) == 1) {
+    if (mpz_popcount(view(*this)) == 1) {
         shift = log2();
         return true;
     } else {
@@ -55,10 +51,27 @@ mpz operator%(mpz const & a, mpz const & b) {
 
 bool root(mpz & root, mpz const & a, unsigned k) {
     mpz rem;
-    mpz_rootrem(root.m_val, rem.m_val, a.m_val, k);
+    rootrem(root, rem, a, k);
     return rem.is_zero();
 }
 
+void gcd(mpz & g, mpz const & a, mpz const & b) {
+    if (!a.m_big && !b.m_big) {
+        unsigned long int x = mpz::abs_value(a.m_small);
+        unsigned long int y = mpz::abs_value(b.m_small);
+        while (y != 0) {
+            unsigned long int t = x % y;
+            x = y;
+            y = t;
+        }
+        g = x;
+    } else {
+        mpz::view va(a), vb(b);
+        mpz_gcd(g.big_val(), va, vb);
+        g.normalize();
+    }
+}
+
 void display(std::ostream & out, __mpz_struct const * v) {
     size_t sz = mpz_sizeinbase(v, 10) + 2;
     if (sz < 1024) {
@@ -73,7 +86,7 @@ void display(std::ostream & out, __mpz_struct const * v) {
 }
 
 std::ostream & operator<<(std::ostream & out, mpz const & v) {
-    display(out, v.m_val);
+    display(out, mpz::view(v));
     return out;
 }
 
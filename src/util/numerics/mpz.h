@@ -5,11 +5,15 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include <algorithm>
 #include <cstddef>
 #include <gmp.h>
 #include <iostream>
+#include <limits>
+#include <utility>
 #include "util/debug.h"
 #include "util/serializer.h"
+#include "util/safe_arith.h"
 #include "util/numerics/numeric_traits.h"
 
 namespace lean {
@@ -17,28 +21,88 @@ class mpq;
 
 /**
    \brief Wrapper for GMP integers
+
+   Values that fit in a long int are stored inline, and the GMP number is only
+   used when the result of an operation does not fit. The GMP number is lazily
+   initialized, so operations on small values do not allocate memory.
 */
 class mpz {
     friend class mpq;
     friend class mpfp;
-    mpz_t m_val;
-    mpz(__mpz_struct const * v) { mpz_init_set(m_val, v); }
+    /* If m_big is false, then the value is m_small, and m_val must not be used. */
+    bool     m_big;
+    /* m_val is only initialized when needed, and then reused until the object is destroyed. */
+    bool     m_init;
+    long int m_small;
+    mpz_t    m_val;
+
+    /** \brief Read-only GMP representation of a mpz value. It does not allocate memory for small values. */
+    class view {
+        __mpz_struct const *  m_ptr;
+        mp_size_t             m_size;
+        mutable mp_limb_t     m_limb;
+        mutable __mpz_struct  m_tmp;
+    public:
+        explicit view(mpz const & v):m_ptr(v.m_big ? v.m_val : nullptr) {
+            if (!v.m_big) {
+                m_size = v.m_small == 0 ? 0 : (v.m_small > 0 ? 1 : -1);
+                m_limb = abs_value(v.m_small);
+            }
+        }
+        operator __mpz_struct const *() const { return m_ptr ? m_ptr : mpz_roinit_n(&m_tmp, &m_limb, m_size); }
+    };
+
+    static unsigned long int abs_value(long int v) {
+        return v < 0 ? 0ul - static_cast<unsigned long int>(v) : static_cast<unsigned long int>(v);
+    }
+    static int sign(int r) { return r < 0 ? -1 : (r > 0 ? 1 : 0); }
+    void init_val() { if (!m_init) { mpz_init(m_val); m_init = true; } }
+    void set_small(long int v) { m_big = false; m_small = v; }
+    /** \brief Store the value in m_val, and return it. It is used to update the value using GMP functions. */
+    __mpz_struct * big_val() {
+        init_val();
+        if (!m_big) {
+            mpz_set_si(m_val, m_small);
+            m_big = true;
+        }
+        return m_val;
+    }
+    /** \brief Move the value back to m_small if it fits. */
+    void normalize() { if (m_big && mpz_fits_slong_p(m_val)) set_small(mpz_get_si(m_val)); }
+    mpz(__mpz_struct const * v):m_big(true), m_init(true), m_small(0) { mpz_init_set(m_val, v); normalize(); }
 public:
-    mpz() { mpz_init(m_val); }
-    explicit mpz(char const * v) { mpz_init_set_str(m_val, const_cast<char*>(v), 10); }
-    explicit mpz(unsigned long int v) { mpz_init_set_ui(m_val, v); }
-    explicit mpz(long int v) { mpz_init_set_si(m_val, v); }
-    explicit mpz(unsigned int v) { mpz_init_set_ui(m_val, v); }
-    explicit mpz(int v) { mpz_init_set_si(m_val, v); }
-    mpz(mpz const & s) { mpz_init_set(m_val, s.m_val); }
-    mpz(mpz && s):mpz() { mpz_swap(m_val, s.m_val); }
-    ~mpz() { mpz_clear(m_val); }
-
-    friend void swap(mpz & a, mpz & b) { mpz_swap(a.m_val, b.m_val); }
-
-    unsigned hash() const { return static_cast<unsigned>(mpz_get_si(m_val)); }
-
-    int sgn() const { return mpz_sgn(m_val); }
+    mpz():m_big(false), m_init(false), m_small(0) {}
+    explicit mpz(char const * v):mpz() { *this = v; }
+    explicit mpz(unsigned long int v):mpz() { *this = v; }
+    explicit mpz(long int v):m_big(false), m_init(false), m_small(v) {}
+    explicit mpz(unsigned int v):mpz() { *this = v; }
+    explicit mpz(int v):m_big(false), m_init(false), m_small(v) {}
+    mpz(mpz const & s):mpz() { *this = s; }
+    mpz(mpz && s):m_big(s.m_big), m_init(s.m_init), m_small(s.m_small) {
+        if (m_init) {
+            m_val[0] = s.m_val[0];
+            s.m_init = false;
+            s.set_small(0);
+        }
+    }
+    ~mpz() { if (m_init) mpz_clear(m_val); }
+
+    friend void swap(mpz & a, mpz & b) {
+        std::swap(a.m_big, b.m_big);
+        std::swap(a.m_small, b.m_small);
+        /* m_val is only read when it has been initialized */
+        if (a.m_init && b.m_init)
+            std::swap(a.m_val[0], b.m_val[0]);
+        else if (a.m_init)
+            b.m_val[0] = a.m_val[0];
+        else if (b.m_init)
+            a.m_val[0] = b.m_val[0];
+        std::swap(a.m_init, b.m_init);
+    }
+
+    unsigned hash() const { return static_cast<unsigned>(m_big ? mpz_get_si(m_val) : m_small); }
+
+    int sgn() const { return m_big ? mpz_sgn(m_val) : (m_small < 0 ? -1 : (m_small > 0 ? 1 : 0)); }
     friend int sgn(mpz const & a) { return a.sgn(); }
     bool is_pos() const { return sgn() > 0; }
     bool is_neg() const { return sgn() < 0; }
@@ -46,36 +110,83 @@ public:
     bool is_nonpos() const { return !is_pos(); }
     bool is_nonneg() const { return !is_neg(); }
 
-    void neg() { mpz_neg(m_val, m_val); }
+    void neg() {
+        if (!m_big && m_small != std::numeric_limits<long int>::min()) { m_small = -m_small; return; }
+        mpz_neg(big_val(), m_val); normalize();
+    }
     friend mpz neg(mpz a) { a.neg(); return a; }
 
-    void abs() { mpz_abs(m_val, m_val); }
+    void abs() { if (is_neg()) neg(); }
     friend mpz abs(mpz a) { a.abs(); return a; }
 
-    bool even() const { return mpz_even_p(m_val) != 0; }
+    bool even() const { return m_big ? mpz_even_p(m_val) != 0 : (m_small & 1) == 0; }
     bool odd() const { return !even(); }
 
-    bool is_int() const { return mpz_fits_sint_p(m_val) != 0; }
-    bool is_unsigned_int() const { return mpz_fits_uint_p(m_val) != 0; }
-    bool is_long_int() const { return mpz_fits_slong_p(m_val) != 0; }
-    bool is_unsigned_long_int() const { return mpz_fits_ulong_p(m_val) != 0; }
-
-    long int get_long_int() const { lean_assert(is_long_int()); return mpz_get_si(m_val); }
+    bool is_int() const {
+        if (m_big) return mpz_fits_sint_p(m_val) != 0;
+        return std::numeric_limits<int>::min() <= m_small && m_small <= std::numeric_limits<int>::max();
+    }
+    bool is_unsigned_int() const {
+        if (m_big) return mpz_fits_uint_p(m_val) != 0;
+        return 0 <= m_small && static_cast<unsigned long int>(m_small) <= std::numeric_limits<unsigned>::max();
+    }
+    bool is_long_int() const { return !m_big || mpz_fits_slong_p(m_val) != 0; }
+    bool is_unsigned_long_int() const { return m_big ? mpz_fits_ulong_p(m_val) != 0 : m_small >= 0; }
+
+    long int get_long_int() const { lean_assert(is_long_int()); return m_big ? mpz_get_si(m_val) : m_small; }
     int get_int() const { lean_assert(is_int()); return static_cast<int>(get_long_int()); }
-    unsigned long int get_unsigned_long_int() const { lean_assert(is_unsigned_long_int()); return mpz_get_ui(m_val); }
+    unsigned long int get_unsigned_long_int() const {
+        lean_assert(is_unsigned_long_int());
+        return m_big ? mpz_get_ui(m_val) : static_cast<unsigned long int>(m_small);
+    }
     unsigned int get_unsigned_int() const { lean_assert(is_unsigned_int()); return static_cast<unsigned>(get_unsigned_long_int()); }
 
-    mpz & operator=(mpz const & v) { mpz_set(m_val, v.m_val); return *this; }
+    mpz & operator=(mpz const & v) {
+        if (!v.m_big) {
+            set_small(v.m_small);
+        } else if (this != &v) {
+            init_val();
+            mpz_set(m_val, v.m_val);
+            m_big = true;
+        }
+        return *this;
+    }
     mpz & operator=(mpz && v) { swap(*this, v); return *this; }
-    mpz & operator=(char const * v) { mpz_set_str(m_val, v, 10); return *this; }
-    mpz & operator=(unsigned long int v) { mpz_set_ui(m_val, v); return *this; }
-    mpz & operator=(long int v) { mpz_set_si(m_val, v); return *this; }
+    mpz & operator=(char const * v) { mpz_set_str(big_val(), v, 10); normalize(); return *this; }
+    mpz & operator=(unsigned long int v) {
+        if (v <= static_cast<unsigned long int>(std::numeric_limits<long int>::max()))
+            set_small(static_cast<long int>(v));
+        else
+            mpz_set_ui(big_val(), v);
+        return *this;
+    }
+    mpz & operator=(long int v) { set_small(v); return *this; }
     mpz & operator=(unsigned int v) { return operator=(static_cast<unsigned long int>(v)); }
-    mpz & operator=(int v) { return operator=(static_cast<long int>(v)); }
-
-    friend int cmp(mpz const & a, mpz const & b) { return mpz_cmp(a.m_val, b.m_val); }
-    friend int cmp(mpz const & a, unsigned b) { return mpz_cmp_ui(a.m_val, b); }
-    friend int cmp(mpz const & a, int b) { return mpz_cmp_si(a.m_val, b); }
+    mpz & operator=(int v) { set_small(v); return *this; }
+
+    friend int cmp(mpz const & a, mpz const & b) {
+        if (!a.m_big && !b.m_big)
+            return a.m_small < b.m_small ? -1 : (a.m_small == b.m_small ? 0 : 1);
+        else if (!b.m_big)
+            return mpz_cmp_si(a.m_val, b.m_small);
+        else if (!a.m_big)
+            return -sign(mpz_cmp_si(b.m_val, a.m_small));
+        else
+            return mpz_cmp(a.m_val, b.m_val);
+    }
+    friend int cmp(mpz const & a, unsigned b) {
+        if (a.m_big)
+            return mpz_cmp_ui(a.m_val, b);
+        if (a.m_small < 0)
+            return -1;
+        unsigned long int v = a.m_small;
+        return v < b ? -1 : (v == b ? 0 : 1);
+    }
+    friend int cmp(mpz const & a, int b) {
+        if (a.m_big)
+            return mpz_cmp_si(a.m_val, b);
+        return a.m_small < b ? -1 : (a.m_small == b ? 0 : 1);
+    }
 
     friend bool operator<(mpz const & a, mpz const & b) { return cmp(a, b) < 0; }
     friend bool operator<(mpz const & a, unsigned b) { return cmp(a, b) < 0; }
@@ -113,23 +224,45 @@ public:
     friend bool operator!=(unsigned a, mpz const & b) { return cmp(b, a) != 0; }
     friend bool operator!=(int a, mpz const & b) { return cmp(b, a) != 0; }
 
-    mpz & operator+=(mpz const & o) { mpz_add(m_val, m_val, o.m_val); return *this; }
-    mpz & operator+=(unsigned u) { mpz_add_ui(m_val, m_val, u); return *this; }
-    mpz & operator+=(int u) { if (u >= 0) mpz_add_ui(m_val, m_val, u); else mpz_sub_ui(m_val, m_val, -u); return *this; }
-
-    mpz & operator-=(mpz const & o) { mpz_sub(m_val, m_val, o.m_val); return *this; }
-    mpz & operator-=(unsigned u) { mpz_sub_ui(m_val, m_val, u); return *this; }
-    mpz & operator-=(int u) { if (u >= 0) mpz_sub_ui(m_val, m_val, u); else mpz_add_ui(m_val, m_val, -u); return *this; }
-
-    mpz & operator*=(mpz const & o) { mpz_mul(m_val, m_val, o.m_val); return *this; }
-    mpz & operator*=(unsigned u) { mpz_mul_ui(m_val, m_val, u); return *this; }
-    mpz & operator*=(int u) { mpz_mul_si(m_val, m_val, u); return *this; }
-
-    mpz & operator/=(mpz const & o) { mpz_tdiv_q(m_val, m_val, o.m_val); return *this; }
-    mpz & operator/=(unsigned u) { mpz_tdiv_q_ui(m_val, m_val, u); return *this; }
-
-    friend mpz rem(mpz const & a, mpz const & b) { mpz r; mpz_tdiv_r(r.m_val, a.m_val, b.m_val); return r; }
-    mpz & operator%=(mpz const & o) { mpz r(*this % o); mpz_swap(m_val, r.m_val); return *this; }
+    mpz & operator+=(mpz const & o) {
+        if (!m_big && !o.m_big && checked_add(m_small, o.m_small, m_small)) return *this;
+        mpz_add(big_val(), m_val, view(o)); normalize(); return *this;
+    }
+    mpz & operator+=(unsigned u) { return operator+=(mpz(u)); }
+    mpz & operator+=(int u) { return operator+=(mpz(u)); }
+
+    mpz & operator-=(mpz const & o) {
+        if (!m_big && !o.m_big && checked_sub(m_small, o.m_small, m_small)) return *this;
+        mpz_sub(big_val(), m_val, view(o)); normalize(); return *this;
+    }
+    mpz & operator-=(unsigned u) { return operator-=(mpz(u)); }
+    mpz & operator-=(int u) { return operator-=(mpz(u)); }
+
+    mpz & operator*=(mpz const & o) {
+        if (!m_big && !o.m_big && checked_mul(m_small, o.m_small, m_small)) return *this;
+        mpz_mul(big_val(), m_val, view(o)); normalize(); return *this;
+    }
+    mpz & operator*=(unsigned u) { return operator*=(mpz(u)); }
+    mpz & operator*=(int u) { return operator*=(mpz(u)); }
+
+    mpz & operator/=(mpz const & o) {
+        if (!m_big && !o.m_big && o.m_small != -1) { m_small /= o.m_small; return *this; }
+        mpz_tdiv_q(big_val(), m_val, view(o)); normalize(); return *this;
+    }
+    mpz & operator/=(unsigned u) { return operator/=(mpz(u)); }
+
+    friend mpz rem(mpz const & a, mpz const & b) {
+        mpz r;
+        if (!a.m_big && !b.m_big) {
+            if (b.m_small != -1)
+                r.m_small = a.m_small % b.m_small;
+        } else {
+            mpz_tdiv_r(r.big_val(), view(a), view(b));
+            r.normalize();
+        }
+        return r;
+    }
+    mpz & operator%=(mpz const & o) { mpz r(*this % o); swap(*this, r); return *this; }
 
     friend mpz operator+(mpz a, mpz const & b) { return a += b; }
     friend mpz operator+(mpz a, unsigned b)  { return a += b; }
@@ -151,7 +284,7 @@ public:
 
     friend mpz operator/(mpz a, mpz const & b) { return a /= b; }
     friend mpz operator/(mpz a, unsigned b) { return a /= b; }
-    friend mpz operator/(mpz a, int b) { return a /= b; }
+    friend mpz operator/(mpz a, int b) { return a /= mpz(b); }
     friend mpz operator/(unsigned a, mpz const & b) { mpz r(a); return r /= b; }
     friend mpz operator/(int a, mpz const & b) { mpz r(a); return r /= b; }
 
@@ -163,10 +296,20 @@ public:
     mpz & operator--() { return operator-=(1); }
     mpz operator--(int) { mpz r(*this); --(*this); return r; }
 
-    mpz & operator&=(mpz const & o) { mpz_and(m_val, m_val, o.m_val); return *this; }
-    mpz & operator|=(mpz const & o) { mpz_ior(m_val, m_val, o.m_val); return *this; }
-    mpz & operator^=(mpz const & o) { mpz_xor(m_val, m_val, o.m_val); return *this; }
-    void comp() { mpz_com(m_val, m_val); }
+    /* The bitwise operations use the two's complement representation for negative numbers, as GMP does. */
+    mpz & operator&=(mpz const & o) {
+        if (!m_big && !o.m_big) { m_small &= o.m_small; return *this; }
+        mpz_and(big_val(), m_val, view(o)); normalize(); return *this;
+    }
+    mpz & operator|=(mpz const & o) {
+        if (!m_big && !o.m_big) { m_small |= o.m_small; return *this; }
+        mpz_ior(big_val(), m_val, view(o)); normalize(); return *this;
+    }
+    mpz & operator^=(mpz const & o) {
+        if (!m_big && !o.m_big) { m_small ^= o.m_small; return *this; }
+        mpz_xor(big_val(), m_val, view(o)); normalize(); return *this;
+    }
+    void comp() { if (m_big) { mpz_com(m_val, m_val); normalize(); } else { m_small = ~m_small; } }
 
     friend mpz operator&(mpz a, mpz const & b) { return a &= b; }
     friend mpz operator|(mpz a, mpz const & b) { return a |= b; }
@@ -174,14 +317,38 @@ public:
     friend mpz operator~(mpz a) { a.comp(); return a; }
 
     // this <- this + a*b
-    void addmul(mpz const & a, mpz const & b) { mpz_addmul(m_val, a.m_val, b.m_val); }
+    void addmul(mpz const & a, mpz const & b) {
+        long int t;
+        if (!m_big && !a.m_big && !b.m_big && checked_mul(a.m_small, b.m_small, t) && checked_add(m_small, t, t)) {
+            m_small = t;
+            return;
+        }
+        view va(a), vb(b);
+        mpz_addmul(big_val(), va, vb); normalize();
+    }
     // this <- this - a*b
-    void submul(mpz const & a, mpz const & b) { mpz_submul(m_val, a.m_val, b.m_val); }
+    void submul(mpz const & a, mpz const & b) {
+        long int t;
+        if (!m_big && !a.m_big && !b.m_big && checked_mul(a.m_small, b.m_small, t) && checked_sub(m_small, t, t)) {
+            m_small = t;
+            return;
+        }
+        view va(a), vb(b);
+        mpz_submul(big_val(), va, vb); normalize();
+    }
 
     // a <- b * 2^k
-    friend void mul2k(mpz & a, mpz const & b, unsigned k) { mpz_mul_2exp(a.m_val, b.m_val, k); }
+    friend void mul2k(mpz & a, mpz const & b, unsigned k) {
+        long int t;
+        if (!b.m_big && k + 1 < sizeof(long int) * 8 && checked_mul(b.m_small, 1l << k, t)) {
+            a.set_small(t);
+            return;
+        }
+        view vb(b);
+        mpz_mul_2exp(a.big_val(), vb, k); a.normalize();
+    }
     // a <- b / 2^k
-    friend void div2k(mpz & a, mpz const & b, unsigned k) { mpz_tdiv_q_2exp(a.m_val, b.m_val, k); }
+    friend void div2k(mpz & a, mpz const & b, unsigned k) { view vb(b); mpz_tdiv_q_2exp(a.big_val(), vb, k); a.normalize(); }
 
     /**
        \brief Return the position of the most significant bit.
@@ -195,28 +362,36 @@ public:
     */
     unsigned mlog2() const;
 
-    bool perfect_square() const { return mpz_perfect_square_p(m_val); }
+    bool perfect_square() const { return mpz_perfect_square_p(view(*this)); }
 
-    bool is_power_of_two() const { return is_pos() && mpz_popcount(m_val) == 1; }
+    bool is_power_of_two() const { return is_pos() && mpz_popcount(view(*this)) == 1; }
     bool is_power_of_two(unsigned & shift) const;
     /**
        \brief Return largest k s.t. n is a multiple of 2^k
     */
-    unsigned power_of_two_multiple() const { return mpz_scan1(m_val, 0); }
+    unsigned power_of_two_multiple() const { return mpz_scan1(view(*this), 0); }
 
-    friend void power(mpz & a, mpz const & b, unsigned k) { mpz_pow_ui(a.m_val, b.m_val, k); }
+    friend void power(mpz & a, mpz const & b, unsigned k) { view vb(b); mpz_pow_ui(a.big_val(), vb, k); a.normalize(); }
     friend void _power(mpz & a, mpz const & b, unsigned k) { power(a, b, k); }
     friend mpz pow(mpz a, unsigned k) { power(a, a, k); return a; }
 
-    friend void rootrem(mpz & root, mpz & rem, mpz const & a, unsigned k) { mpz_rootrem(root.m_val, rem.m_val, a.m_val, k); }
+    friend void rootrem(mpz & root, mpz & rem, mpz const & a, unsigned k) {
+        view va(a);
+        mpz_rootrem(root.big_val(), rem.big_val(), va, k);
+        root.normalize(); rem.normalize();
+    }
     // root <- a^{1/k}, return true iff the result is an integer
     friend bool root(mpz & root, mpz const & a, unsigned k);
     friend mpz root(mpz const & a, unsigned k) { mpz r; root(r, a, k); return r; }
 
-    friend void gcd(mpz & g, mpz const & a, mpz const & b) { mpz_gcd(g.m_val, a.m_val, b.m_val); }
+    friend void gcd(mpz & g, mpz const & a, mpz const & b);
     friend mpz gcd(mpz const & a, mpz const & b) { mpz r; gcd(r, a, b); return r; }
-    friend void gcdext(mpz & g, mpz & s, mpz & t, mpz const & a, mpz const & b) { mpz_gcdext(g.m_val, s.m_val, t.m_val, a.m_val, b.m_val); }
-    friend void lcm(mpz & l, mpz const & a, mpz const & b) { mpz_lcm(l.m_val, a.m_val, b.m_val); }
+    friend void gcdext(mpz & g, mpz & s, mpz & t, mpz const & a, mpz const & b) {
+        view va(a), vb(b);
+        mpz_gcdext(g.big_val(), s.big_val(), t.big_val(), va, vb);
+        g.normalize(); s.normalize(); t.normalize();
+    }
+    friend void lcm(mpz & l, mpz const & a, mpz const & b) { view va(a), vb(b); mpz_lcm(l.big_val(), va, vb); l.normalize(); }
     friend mpz lcm(mpz const & a, mpz const & b) { mpz l; lcm(l, a, b); return l; }
 
     friend std::ostream & operator<<(std::ostream & out, mpz const & v);
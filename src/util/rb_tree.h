@@ -66,7 +66,7 @@ class rb_tree : private CMP {
     static memory_pool & get_allocator() {
         LEAN_THREAD_PTR(memory_pool, g_allocator);
         if (!g_allocator)
-            g_allocator = allocate_thread_memory_pool(sizeof(node_cell));
+            g_allocator = allocate_thread_memory_pool(sizeof(node_cell), "rb_tree");
         return *g_allocator;
     }
 
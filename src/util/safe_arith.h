@@ -5,6 +5,7 @@ Released under Apache 2.0 license as described in the file LICENSE.
 Author: Leonardo de Moura
 */
 #pragma once
+#include <limits>
 
 namespace lean {
 /** \brief Return v - k. It throws an exception if there is a underflow. */
@@ -15,4 +16,40 @@ int safe_sub(int v, unsigned k);
 int safe_add(int v, int k);
 int safe_add(int v, unsigned k);
 unsigned safe_add(unsigned v, unsigned k);
+
+/** \brief Store v + k in r, and return false if there is an overflow. */
+inline bool checked_add(long v, long k, long & r) {
+    if ((k > 0 && v > std::numeric_limits<long>::max() - k) ||
+        (k < 0 && v < std::numeric_limits<long>::min() - k))
+        return false;
+    r = v + k;
+    return true;
+}
+
+/** \brief Store v - k in r, and return false if there is an overflow. */
+inline bool checked_sub(long v, long k, long & r) {
+    if ((k < 0 && v > std::numeric_limits<long>::max() + k) ||
+        (k > 0 && v < std::numeric_limits<long>::min() + k))
+        return false;
+    r = v - k;
+    return true;
+}
+
+/** \brief Store v * k in r, and return false if there is an overflow. */
+inline bool checked_mul(long v, long k, long & r) {
+    if (v == 0 || k == 0) {
+        r = 0;
+        return true;
+    }
+    unsigned long av  = v < 0 ? 0ul - static_cast<unsigned long>(v) : static_cast<unsigned long>(v);
+    unsigned long ak  = k < 0 ? 0ul - static_cast<unsigned long>(k) : static_cast<unsigned long>(k);
+    bool neg          = (v < 0) != (k < 0);
+    /* the absolute value of the minimum is max + 1 */
+    unsigned long lim = static_cast<unsigned long>(std::numeric_limits<long>::max()) + (neg ? 1ul : 0ul);
+    if (av > lim / ak)
+        return false;
+    unsigned long p   = av * ak;
+    r = neg ? static_cast<long>(0ul - p) : static_cast<long>(p);
+    return true;
+}
 }
@@ -51,14 +51,14 @@ class sequence {
     static memory_pool & get_elem_cell_allocator() {
         LEAN_THREAD_PTR(memory_pool, g_allocator);
         if (!g_allocator)
-            g_allocator = allocate_thread_memory_pool(sizeof(elem_cell));
+            g_allocator = allocate_thread_memory_pool(sizeof(elem_cell), "sequence");
         return *g_allocator;
     }
 
     static memory_pool & get_join_cell_allocator() {
         LEAN_THREAD_PTR(memory_pool, g_allocator);
         if (!g_allocator)
-            g_allocator = allocate_thread_memory_pool(sizeof(join_cell));
+            g_allocator = allocate_thread_memory_pool(sizeof(join_cell), "sequence_join");
         return *g_allocator;
     }
 
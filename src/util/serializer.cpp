@@ -7,10 +7,12 @@ Author: Leonardo de Moura
 #include <vector>
 #include <string>
 #include <limits>
+#include <cstring>
 #include <stdio.h>
 #include <ios>
 #include "util/serializer.h"
 #include "util/exception.h"
+#include "util/debug.h"
 
 namespace lean {
 void initialize_serializer() {
@@ -64,9 +66,17 @@ void serializer_core::write_double(double d) {
 }
 
 std::string deserializer_core::read_string() {
+    if (!m_in) {
+        char const * e = static_cast<char const *>(memchr(m_curr, 0, m_end - m_curr));
+        if (!e)
+            throw corrupted_stream_exception();
+        std::string r(m_curr, e);
+        m_curr = e + 1;
+        return r;
+    }
     std::string r;
     while (true) {
-        char c = m_in.get();
+        char c = get();
         if (c == 0)
             break;
         if (c == EOF)
@@ -79,10 +89,10 @@ std::string deserializer_core::read_string() {
 unsigned deserializer_core::read_unsigned_ext() {
     unsigned r;
     static_assert(sizeof(r) == 4, "unexpected unsigned size");
-    r  = static_cast<unsigned>(m_in.get()) << 24;
-    r |= static_cast<unsigned>(m_in.get()) << 16;
-    r |= static_cast<unsigned>(m_in.get()) << 8;
-    r |= static_cast<unsigned>(m_in.get());
+    r  = static_cast<unsigned>(get()) << 24;
+    r |= static_cast<unsigned>(get()) << 16;
+    r |= static_cast<unsigned>(get()) << 8;
+    r |= static_cast<unsigned>(get());
     return r;
 }
 
@@ -104,6 +114,19 @@ double deserializer_core::read_double() {
 
 void deserializer_core::read(std::vector<char> & data) {
     unsigned sz = data.size();
-    m_in.read(data.data(), sz);
+    if (m_in) {
+        m_in->read(data.data(), sz);
+    } else {
+        memcpy(data.data(), read_view(sz), sz);
+    }
+}
+
+char const * deserializer_core::read_view(size_t sz) {
+    lean_assert(!m_in);
+    if (static_cast<size_t>(m_end - m_curr) < sz)
+        throw corrupted_stream_exception();
+    char const * r = m_curr;
+    m_curr += sz;
+    return r;
 }
 }
@@ -34,6 +34,9 @@ public:
     void write_char(char c) { m_out.put(c); }
     void write_bool(bool b) { m_out.put(b ? 1 : 0); }
     void write_double(double b);
+    /** \brief Write the size of \c data followed by its bytes. It can be read back using
+        read_unsigned and read_view. */
+    void write_blob(std::string const & data) { write_unsigned(data.size()); m_out.write(data.data(), data.size()); }
 };
 
 typedef extensible_object<serializer_core> serializer;
@@ -54,24 +57,40 @@ inline serializer & operator<<(serializer & s, pair<T1, T2> const & p) { s << p.
    The actual functionality is implemented using extensions.
 */
 class deserializer_core {
-    std::istream &        m_in;
+    /* The input is either a stream or an in-memory buffer [m_curr, m_end).
+       When reading from a stream, m_curr == m_end == nullptr. */
+    std::istream *        m_in;
+    char const *          m_curr;
+    char const *          m_end;
     optional<std::string> m_fname;
     unsigned read_unsigned_ext();
+    int get() {
+        if (m_curr != m_end)
+            return static_cast<unsigned char>(*m_curr++);
+        return m_in ? m_in->get() : EOF;
+    }
 public:
-    deserializer_core(std::istream & in):m_in(in) {}
-    deserializer_core(std::istream & in, optional<std::string> const & fname):m_in(in), m_fname(fname) {}
+    deserializer_core(std::istream & in):m_in(&in), m_curr(nullptr), m_end(nullptr) {}
+    deserializer_core(std::istream & in, optional<std::string> const & fname):
+        m_in(&in), m_curr(nullptr), m_end(nullptr), m_fname(fname) {}
+    /** \brief Read directly from the buffer [begin, end), the buffer must outlive the deserializer. */
+    deserializer_core(char const * begin, char const * end, optional<std::string> const & fname):
+        m_in(nullptr), m_curr(begin), m_end(end), m_fname(fname) {}
     std::string read_string();
     unsigned read_unsigned() {
-        unsigned r = static_cast<unsigned>(m_in.get());
+        unsigned r = static_cast<unsigned>(get());
         return r < 255 ? r : read_unsigned_ext();
     }
     uint64 read_uint64();
     int read_int() { return read_unsigned(); }
-    char read_char() { return m_in.get(); }
-    bool read_bool() { return m_in.get() != 0; }
+    char read_char() { return get(); }
+    bool read_bool() { return get() != 0; }
     double read_double();
     // read data.size() bytes from input stream and store it at data
     void read(std::vector<char> & data);
+    /** \brief Skip the next \c sz bytes of an in-memory buffer, and return a pointer to them.
+        \remark This method can only be used when reading from a buffer. */
+    char const * read_view(size_t sz);
     optional<std::string> get_fname() const { return m_fname; }
 };
 
@@ -0,0 +1,12 @@
+class foo (α : Type) (β : Type) := (val : nat)
+
+instance foo_nat_bool : foo nat bool := foo.mk nat bool 1
+
+def my_bool := bool
+
+/- my_bool is not reducible, so foo_nat_bool must not be used. -/
+example : foo nat my_bool := by apply_instance
+example : foo nat bool := by apply_instance
+
+set_option class.instance_index false
+example : foo nat my_bool := by apply_instance
@@ -0,0 +1,21 @@
+set_option class.tabled_resolution true
+
+class foo (α : Type) := (val : nat)
+class bar (α : Type) := (val : nat)
+
+instance bar_of_foo {α} [foo α] : bar α := bar.mk α 2
+instance foo_of_bar {α} [bar α] : foo α := foo.mk α 3
+
+/- foo and bar depend on each other, tabled resolution fails without looping. -/
+example : foo bool := by apply_instance
+
+class baz := (val : nat)
+class qux (α : Type) := (val : nat)
+
+instance foo_nat : foo nat := foo.mk nat 1
+instance foo_list {α} [foo α] : foo (list α) := foo.mk (list α) 4
+instance baz_of_foo {α} [foo α] [qux α] : baz := baz.mk 5
+
+/- `foo ?α` has infinitely many answers, and there are no qux instances to stop the search.
+   The answers are counted against class.instance_max_depth. -/
+example : baz := by apply_instance
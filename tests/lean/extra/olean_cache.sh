@@ -0,0 +1,53 @@
+#!/bin/bash
+set -e
+if [ $# -ne 1 ]; then
+    echo "Usage: olean_cache.sh [lean-executable-path]"
+    exit 1
+fi
+LEAN=$1
+LIB=$(cd ../../../library && pwd)
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+mkdir "$DIR/src" "$DIR/cache"
+cd "$DIR/src"
+export LEAN_PATH=$LIB:.
+
+# Each module prints a message when it is elaborated, and nothing when its .olean file is used.
+echo 'def f : nat := 1
+vm_eval "elaborating a"' > a.lean
+echo 'import .a
+def g : nat := f + 1
+vm_eval "elaborating b"' > b.lean
+
+check() {
+    "$LEAN" --make --cache-dir=../cache b.lean > out.txt 2>&1
+    if [ "$(grep -c elaborating out.txt || true)" -ne "$1" ]; then
+        echo "ERROR: expected $1 modules to be elaborated"
+        cat out.txt
+        exit 1
+    fi
+}
+
+check 2
+test -f a.olean && test -f b.olean
+test "$(ls ../cache | wc -l)" -eq 2
+
+# The .olean files are copied from the cache.
+rm a.olean b.olean
+check 0
+test -f a.olean && test -f b.olean
+
+# Changing a module invalidates the cached .olean files of the modules that import it.
+rm a.olean b.olean
+echo 'def f : nat := 2
+vm_eval "elaborating a"' > a.lean
+check 2
+test "$(ls ../cache | wc -l)" -eq 4
+
+# Restoring the original source reuses the first cached .olean files.
+rm a.olean b.olean
+echo 'def f : nat := 1
+vm_eval "elaborating a"' > a.lean
+check 0
+test "$(ls ../cache | wc -l)" -eq 4
+echo "-- checked"
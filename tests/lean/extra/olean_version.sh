@@ -0,0 +1,36 @@
+#!/bin/bash
+set -e
+if [ $# -ne 1 ]; then
+    echo "Usage: olean_version.sh [lean-executable-path]"
+    exit 1
+fi
+LEAN=$1
+LIB=$(cd ../../../library && pwd)
+DIR=$(mktemp -d)
+trap 'rm -rf "$DIR"' EXIT
+cd "$DIR"
+export LEAN_PATH=$LIB:.
+
+echo 'def f : nat := 1
+vm_eval "elaborating a"' > a.lean
+echo 'import .a
+vm_eval f' > b.lean
+"$LEAN" --make a.lean > /dev/null
+
+# Overwrite the format version stored after the "oleanfile" header.
+printf '\x01' | dd of=a.olean bs=1 seek=10 conv=notrunc 2> /dev/null
+
+# An .olean file with another format version is not read, the module is elaborated again.
+"$LEAN" b.lean > out.txt 2>&1
+grep -q "elaborating a" out.txt
+grep -qx 1 out.txt
+"$LEAN" --make b.lean > out.txt 2>&1
+grep -q "elaborating a" out.txt
+
+# --make replaced it with an up-to-date file.
+"$LEAN" b.lean > out.txt 2>&1
+if grep -q "elaborating a" out.txt; then
+    echo "ERROR: a.olean has not been recompiled"
+    exit 1
+fi
+echo "-- checked"
@@ -0,0 +1,10 @@
+structure foo := (x : nat)
+
+/- The failure is cached, but it must not be used after a new instance is declared. -/
+example : has_zero foo := by apply_instance
+example : foo.x 0 = 0 := rfl
+
+instance foo.has_zero : has_zero foo := ⟨⟨0⟩⟩
+
+example : has_zero foo := by apply_instance
+example : foo.x 0 = 0 := rfl
@@ -0,0 +1,11 @@
+set_option parser.parallel_definitions true
+
+/- When the elaboration of a delayed definition fails, the error is reported once,
+   and the value is replaced with 'sorry' as for the other definitions. -/
+def foo : nat := tt
+def bar : nat := foo + 1
+def baz (n : nat) : nat := n + tt
+print foo
+print baz
+vm_eval bar
+example : baz 1 = baz 1 := rfl
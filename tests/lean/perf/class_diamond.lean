@@ -0,0 +1,82 @@
+/- Each class has two instances that depend on the previous class.
+   The depth-first search derives `c0 nat` 2^12 times, tabled resolution derives it only once.
+   Remove the option below to compare. -/
+set_option class.tabled_resolution true
+
+class c0 (α : Type) := (val : nat)
+class a0 (α : Type) := (val : nat)
+class b0 (α : Type) := (val : nat)
+class c1 (α : Type) := (val : nat)
+class a1 (α : Type) := (val : nat)
+class b1 (α : Type) := (val : nat)
+class c2 (α : Type) := (val : nat)
+class a2 (α : Type) := (val : nat)
+class b2 (α : Type) := (val : nat)
+class c3 (α : Type) := (val : nat)
+class a3 (α : Type) := (val : nat)
+class b3 (α : Type) := (val : nat)
+class c4 (α : Type) := (val : nat)
+class a4 (α : Type) := (val : nat)
+class b4 (α : Type) := (val : nat)
+class c5 (α : Type) := (val : nat)
+class a5 (α : Type) := (val : nat)
+class b5 (α : Type) := (val : nat)
+class c6 (α : Type) := (val : nat)
+class a6 (α : Type) := (val : nat)
+class b6 (α : Type) := (val : nat)
+class c7 (α : Type) := (val : nat)
+class a7 (α : Type) := (val : nat)
+class b7 (α : Type) := (val : nat)
+class c8 (α : Type) := (val : nat)
+class a8 (α : Type) := (val : nat)
+class b8 (α : Type) := (val : nat)
+class c9 (α : Type) := (val : nat)
+class a9 (α : Type) := (val : nat)
+class b9 (α : Type) := (val : nat)
+class c10 (α : Type) := (val : nat)
+class a10 (α : Type) := (val : nat)
+class b10 (α : Type) := (val : nat)
+class c11 (α : Type) := (val : nat)
+class a11 (α : Type) := (val : nat)
+class b11 (α : Type) := (val : nat)
+class c12 (α : Type) := (val : nat)
+
+instance c0_nat : c0 nat := c0.mk nat 0
+instance a0_of_c0 {α} [c0 α] : a0 α := a0.mk α 0
+instance b0_of_c0 {α} [c0 α] : b0 α := b0.mk α 0
+instance c1_of_a0_b0 {α} [a0 α] [b0 α] : c1 α := c1.mk α 0
+instance a1_of_c1 {α} [c1 α] : a1 α := a1.mk α 0
+instance b1_of_c1 {α} [c1 α] : b1 α := b1.mk α 0
+instance c2_of_a1_b1 {α} [a1 α] [b1 α] : c2 α := c2.mk α 0
+instance a2_of_c2 {α} [c2 α] : a2 α := a2.mk α 0
+instance b2_of_c2 {α} [c2 α] : b2 α := b2.mk α 0
+instance c3_of_a2_b2 {α} [a2 α] [b2 α] : c3 α := c3.mk α 0
+instance a3_of_c3 {α} [c3 α] : a3 α := a3.mk α 0
+instance b3_of_c3 {α} [c3 α] : b3 α := b3.mk α 0
+instance c4_of_a3_b3 {α} [a3 α] [b3 α] : c4 α := c4.mk α 0
+instance a4_of_c4 {α} [c4 α] : a4 α := a4.mk α 0
+instance b4_of_c4 {α} [c4 α] : b4 α := b4.mk α 0
+instance c5_of_a4_b4 {α} [a4 α] [b4 α] : c5 α := c5.mk α 0
+instance a5_of_c5 {α} [c5 α] : a5 α := a5.mk α 0
+instance b5_of_c5 {α} [c5 α] : b5 α := b5.mk α 0
+instance c6_of_a5_b5 {α} [a5 α] [b5 α] : c6 α := c6.mk α 0
+instance a6_of_c6 {α} [c6 α] : a6 α := a6.mk α 0
+instance b6_of_c6 {α} [c6 α] : b6 α := b6.mk α 0
+instance c7_of_a6_b6 {α} [a6 α] [b6 α] : c7 α := c7.mk α 0
+instance a7_of_c7 {α} [c7 α] : a7 α := a7.mk α 0
+instance b7_of_c7 {α} [c7 α] : b7 α := b7.mk α 0
+instance c8_of_a7_b7 {α} [a7 α] [b7 α] : c8 α := c8.mk α 0
+instance a8_of_c8 {α} [c8 α] : a8 α := a8.mk α 0
+instance b8_of_c8 {α} [c8 α] : b8 α := b8.mk α 0
+instance c9_of_a8_b8 {α} [a8 α] [b8 α] : c9 α := c9.mk α 0
+instance a9_of_c9 {α} [c9 α] : a9 α := a9.mk α 0
+instance b9_of_c9 {α} [c9 α] : b9 α := b9.mk α 0
+instance c10_of_a9_b9 {α} [a9 α] [b9 α] : c10 α := c10.mk α 0
+instance a10_of_c10 {α} [c10 α] : a10 α := a10.mk α 0
+instance b10_of_c10 {α} [c10 α] : b10 α := b10.mk α 0
+instance c11_of_a10_b10 {α} [a10 α] [b10 α] : c11 α := c11.mk α 0
+instance a11_of_c11 {α} [c11 α] : a11 α := a11.mk α 0
+instance b11_of_c11 {α} [c11 α] : b11 α := b11.mk α 0
+instance c12_of_a11_b11 {α} [a11 α] [b11 α] : c12 α := c12.mk α 0
+
+example : c12 nat := by apply_instance
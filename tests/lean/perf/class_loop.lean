@@ -0,0 +1,25 @@
+/- The symmetric instance makes the depth-first search loop until the maximum depth is reached,
+   and it explores every path of each length before failing.
+   Tabled resolution detects that `equiv β α` and `equiv α β` are subgoals that are already being
+   solved, and fails without reaching the maximum depth. -/
+set_option class.tabled_resolution true
+set_option class.instance_max_depth 128
+
+class equiv (α : Type) (β : Type) := (val : nat)
+
+instance equiv_symm {α β} [equiv β α] : equiv α β := equiv.mk α β 0
+instance equiv_list {α β} [equiv α β] : equiv (list α) (list β) := equiv.mk (list α) (list β) 0
+instance equiv_option {α β} [equiv α β] : equiv (option α) (option β) := equiv.mk (option α) (option β) 0
+instance equiv_prod {α₁ α₂ β₁ β₂} [equiv α₁ β₁] [equiv α₂ β₂] : equiv (α₁ × α₂) (β₁ × β₂) := equiv.mk (α₁ × α₂) (β₁ × β₂) 0
+
+open tactic
+
+/- There are no instances for `nat` and `bool` yet, so this search fails. -/
+run_command do
+  t ← to_expr `(equiv (list (option (nat × bool))) (list (option (nat × nat)))),
+  r ← (mk_instance t >> return tt) <|> return ff,
+  guard (r = ff)
+
+instance equiv_bool_nat : equiv bool nat := equiv.mk bool nat 1
+
+example : equiv (list (option nat)) (list (option bool)) := by apply_instance
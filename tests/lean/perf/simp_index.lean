@@ -0,0 +1,497 @@
+/- All simp lemmas below have the same head symbol `f`, and they are distinguished by the head
+   of their argument. The simp lemma index skips the lemmas whose argument head cannot match
+   without calling the unifier.
+   Set the option below to false to compare. -/
+set_option simp_lemmas.index true
+
+constant f : nat → nat
+constants g0 g1 g2 g3 g4 g5 g6 g7 g8 g9 g10 g11 g12 g13 g14 g15 g16 g17 g18 g19 g20 g21 g22 g23 g24
+  g25 g26 g27 g28 g29 g30 g31 g32 g33 g34 g35 g36 g37 g38 g39 g40 g41 g42 g43 g44 g45 g46 g47 g48
+  g49 g50 g51 g52 g53 g54 g55 g56 g57 g58 g59 g60 g61 g62 g63 g64 g65 g66 g67 g68 g69 g70 g71 g72
+  g73 g74 g75 g76 g77 g78 g79 g80 g81 g82 g83 g84 g85 g86 g87 g88 g89 g90 g91 g92 g93 g94 g95 g96
+  g97 g98 g99 g100 g101 g102 g103 g104 g105 g106 g107 g108 g109 g110 g111 g112 g113 g114 g115 g116
+  g117 g118 g119 g120 g121 g122 g123 g124 g125 g126 g127 g128 g129 g130 g131 g132 g133 g134 g135
+  g136 g137 g138 g139 g140 g141 g142 g143 g144 g145 g146 g147 g148 g149 g150 g151 g152 g153 g154
+  g155 g156 g157 g158 g159 g160 g161 g162 g163 g164 g165 g166 g167 g168 g169 g170 g171 g172 g173
+  g174 g175 g176 g177 g178 g179 g180 g181 g182 g183 g184 g185 g186 g187 g188 g189 g190 g191 g192
+  g193 g194 g195 g196 g197 g198 g199 g200 g201 g202 g203 g204 g205 g206 g207 g208 g209 g210 g211
+  g212 g213 g214 g215 g216 g217 g218 g219 g220 g221 g222 g223 g224 g225 g226 g227 g228 g229 g230
+  g231 g232 g233 g234 g235 g236 g237 g238 g239 g240 g241 g242 g243 g244 g245 g246 g247 g248 g249
+  g250 g251 g252 g253 g254 g255 g256 g257 g258 g259 g260 g261 g262 g263 g264 g265 g266 g267 g268
+  g269 g270 g271 g272 g273 g274 g275 g276 g277 g278 g279 g280 g281 g282 g283 g284 g285 g286 g287
+  g288 g289 g290 g291 g292 g293 g294 g295 g296 g297 g298 g299 g300 g301 g302 g303 g304 g305 g306
+  g307 g308 g309 g310 g311 g312 g313 g314 g315 g316 g317 g318 g319 g320 g321 g322 g323 g324 g325
+  g326 g327 g328 g329 g330 g331 g332 g333 g334 g335 g336 g337 g338 g339 g340 g341 g342 g343 g344
+  g345 g346 g347 g348 g349 g350 g351 g352 g353 g354 g355 g356 g357 g358 g359 g360 g361 g362 g363
+  g364 g365 g366 g367 g368 g369 g370 g371 g372 g373 g374 g375 g376 g377 g378 g379 g380 g381 g382
+  g383 g384 g385 g386 g387 g388 g389 g390 g391 g392 g393 g394 g395 g396 g397 g398 g399 : nat → nat
+
+axiom f_g0 (x : nat) : f (g0 x) = x
+axiom f_g1 (x : nat) : f (g1 x) = x
+axiom f_g2 (x : nat) : f (g2 x) = x
+axiom f_g3 (x : nat) : f (g3 x) = x
+axiom f_g4 (x : nat) : f (g4 x) = x
+axiom f_g5 (x : nat) : f (g5 x) = x
+axiom f_g6 (x : nat) : f (g6 x) = x
+axiom f_g7 (x : nat) : f (g7 x) = x
+axiom f_g8 (x : nat) : f (g8 x) = x
+axiom f_g9 (x : nat) : f (g9 x) = x
+axiom f_g10 (x : nat) : f (g10 x) = x
+axiom f_g11 (x : nat) : f (g11 x) = x
+axiom f_g12 (x : nat) : f (g12 x) = x
+axiom f_g13 (x : nat) : f (g13 x) = x
+axiom f_g14 (x : nat) : f (g14 x) = x
+axiom f_g15 (x : nat) : f (g15 x) = x
+axiom f_g16 (x : nat) : f (g16 x) = x
+axiom f_g17 (x : nat) : f (g17 x) = x
+axiom f_g18 (x : nat) : f (g18 x) = x
+axiom f_g19 (x : nat) : f (g19 x) = x
+axiom f_g20 (x : nat) : f (g20 x) = x
+axiom f_g21 (x : nat) : f (g21 x) = x
+axiom f_g22 (x : nat) : f (g22 x) = x
+axiom f_g23 (x : nat) : f (g23 x) = x
+axiom f_g24 (x : nat) : f (g24 x) = x
+axiom f_g25 (x : nat) : f (g25 x) = x
+axiom f_g26 (x : nat) : f (g26 x) = x
+axiom f_g27 (x : nat) : f (g27 x) = x
+axiom f_g28 (x : nat) : f (g28 x) = x
+axiom f_g29 (x : nat) : f (g29 x) = x
+axiom f_g30 (x : nat) : f (g30 x) = x
+axiom f_g31 (x : nat) : f (g31 x) = x
+axiom f_g32 (x : nat) : f (g32 x) = x
+axiom f_g33 (x : nat) : f (g33 x) = x
+axiom f_g34 (x : nat) : f (g34 x) = x
+axiom f_g35 (x : nat) : f (g35 x) = x
+axiom f_g36 (x : nat) : f (g36 x) = x
+axiom f_g37 (x : nat) : f (g37 x) = x
+axiom f_g38 (x : nat) : f (g38 x) = x
+axiom f_g39 (x : nat) : f (g39 x) = x
+axiom f_g40 (x : nat) : f (g40 x) = x
+axiom f_g41 (x : nat) : f (g41 x) = x
+axiom f_g42 (x : nat) : f (g42 x) = x
+axiom f_g43 (x : nat) : f (g43 x) = x
+axiom f_g44 (x : nat) : f (g44 x) = x
+axiom f_g45 (x : nat) : f (g45 x) = x
+axiom f_g46 (x : nat) : f (g46 x) = x
+axiom f_g47 (x : nat) : f (g47 x) = x
+axiom f_g48 (x : nat) : f (g48 x) = x
+axiom f_g49 (x : nat) : f (g49 x) = x
+axiom f_g50 (x : nat) : f (g50 x) = x
+axiom f_g51 (x : nat) : f (g51 x) = x
+axiom f_g52 (x : nat) : f (g52 x) = x
+axiom f_g53 (x : nat) : f (g53 x) = x
+axiom f_g54 (x : nat) : f (g54 x) = x
+axiom f_g55 (x : nat) : f (g55 x) = x
+axiom f_g56 (x : nat) : f (g56 x) = x
+axiom f_g57 (x : nat) : f (g57 x) = x
+axiom f_g58 (x : nat) : f (g58 x) = x
+axiom f_g59 (x : nat) : f (g59 x) = x
+axiom f_g60 (x : nat) : f (g60 x) = x
+axiom f_g61 (x : nat) : f (g61 x) = x
+axiom f_g62 (x : nat) : f (g62 x) = x
+axiom f_g63 (x : nat) : f (g63 x) = x
+axiom f_g64 (x : nat) : f (g64 x) = x
+axiom f_g65 (x : nat) : f (g65 x) = x
+axiom f_g66 (x : nat) : f (g66 x) = x
+axiom f_g67 (x : nat) : f (g67 x) = x
+axiom f_g68 (x : nat) : f (g68 x) = x
+axiom f_g69 (x : nat) : f (g69 x) = x
+axiom f_g70 (x : nat) : f (g70 x) = x
+axiom f_g71 (x : nat) : f (g71 x) = x
+axiom f_g72 (x : nat) : f (g72 x) = x
+axiom f_g73 (x : nat) : f (g73 x) = x
+axiom f_g74 (x : nat) : f (g74 x) = x
+axiom f_g75 (x : nat) : f (g75 x) = x
+axiom f_g76 (x : nat) : f (g76 x) = x
+axiom f_g77 (x : nat) : f (g77 x) = x
+axiom f_g78 (x : nat) : f (g78 x) = x
+axiom f_g79 (x : nat) : f (g79 x) = x
+axiom f_g80 (x : nat) : f (g80 x) = x
+axiom f_g81 (x : nat) : f (g81 x) = x
+axiom f_g82 (x : nat) : f (g82 x) = x
+axiom f_g83 (x : nat) : f (g83 x) = x
+axiom f_g84 (x : nat) : f (g84 x) = x
+axiom f_g85 (x : nat) : f (g85 x) = x
+axiom f_g86 (x : nat) : f (g86 x) = x
+axiom f_g87 (x : nat) : f (g87 x) = x
+axiom f_g88 (x : nat) : f (g88 x) = x
+axiom f_g89 (x : nat) : f (g89 x) = x
+axiom f_g90 (x : nat) : f (g90 x) = x
+axiom f_g91 (x : nat) : f (g91 x) = x
+axiom f_g92 (x : nat) : f (g92 x) = x
+axiom f_g93 (x : nat) : f (g93 x) = x
+axiom f_g94 (x : nat) : f (g94 x) = x
+axiom f_g95 (x : nat) : f (g95 x) = x
+axiom f_g96 (x : nat) : f (g96 x) = x
+axiom f_g97 (x : nat) : f (g97 x) = x
+axiom f_g98 (x : nat) : f (g98 x) = x
+axiom f_g99 (x : nat) : f (g99 x) = x
+axiom f_g100 (x : nat) : f (g100 x) = x
+axiom f_g101 (x : nat) : f (g101 x) = x
+axiom f_g102 (x : nat) : f (g102 x) = x
+axiom f_g103 (x : nat) : f (g103 x) = x
+axiom f_g104 (x : nat) : f (g104 x) = x
+axiom f_g105 (x : nat) : f (g105 x) = x
+axiom f_g106 (x : nat) : f (g106 x) = x
+axiom f_g107 (x : nat) : f (g107 x) = x
+axiom f_g108 (x : nat) : f (g108 x) = x
+axiom f_g109 (x : nat) : f (g109 x) = x
+axiom f_g110 (x : nat) : f (g110 x) = x
+axiom f_g111 (x : nat) : f (g111 x) = x
+axiom f_g112 (x : nat) : f (g112 x) = x
+axiom f_g113 (x : nat) : f (g113 x) = x
+axiom f_g114 (x : nat) : f (g114 x) = x
+axiom f_g115 (x : nat) : f (g115 x) = x
+axiom f_g116 (x : nat) : f (g116 x) = x
+axiom f_g117 (x : nat) : f (g117 x) = x
+axiom f_g118 (x : nat) : f (g118 x) = x
+axiom f_g119 (x : nat) : f (g119 x) = x
+axiom f_g120 (x : nat) : f (g120 x) = x
+axiom f_g121 (x : nat) : f (g121 x) = x
+axiom f_g122 (x : nat) : f (g122 x) = x
+axiom f_g123 (x : nat) : f (g123 x) = x
+axiom f_g124 (x : nat) : f (g124 x) = x
+axiom f_g125 (x : nat) : f (g125 x) = x
+axiom f_g126 (x : nat) : f (g126 x) = x
+axiom f_g127 (x : nat) : f (g127 x) = x
+axiom f_g128 (x : nat) : f (g128 x) = x
+axiom f_g129 (x : nat) : f (g129 x) = x
+axiom f_g130 (x : nat) : f (g130 x) = x
+axiom f_g131 (x : nat) : f (g131 x) = x
+axiom f_g132 (x : nat) : f (g132 x) = x
+axiom f_g133 (x : nat) : f (g133 x) = x
+axiom f_g134 (x : nat) : f (g134 x) = x
+axiom f_g135 (x : nat) : f (g135 x) = x
+axiom f_g136 (x : nat) : f (g136 x) = x
+axiom f_g137 (x : nat) : f (g137 x) = x
+axiom f_g138 (x : nat) : f (g138 x) = x
+axiom f_g139 (x : nat) : f (g139 x) = x
+axiom f_g140 (x : nat) : f (g140 x) = x
+axiom f_g141 (x : nat) : f (g141 x) = x
+axiom f_g142 (x : nat) : f (g142 x) = x
+axiom f_g143 (x : nat) : f (g143 x) = x
+axiom f_g144 (x : nat) : f (g144 x) = x
+axiom f_g145 (x : nat) : f (g145 x) = x
+axiom f_g146 (x : nat) : f (g146 x) = x
+axiom f_g147 (x : nat) : f (g147 x) = x
+axiom f_g148 (x : nat) : f (g148 x) = x
+axiom f_g149 (x : nat) : f (g149 x) = x
+axiom f_g150 (x : nat) : f (g150 x) = x
+axiom f_g151 (x : nat) : f (g151 x) = x
+axiom f_g152 (x : nat) : f (g152 x) = x
+axiom f_g153 (x : nat) : f (g153 x) = x
+axiom f_g154 (x : nat) : f (g154 x) = x
+axiom f_g155 (x : nat) : f (g155 x) = x
+axiom f_g156 (x : nat) : f (g156 x) = x
+axiom f_g157 (x : nat) : f (g157 x) = x
+axiom f_g158 (x : nat) : f (g158 x) = x
+axiom f_g159 (x : nat) : f (g159 x) = x
+axiom f_g160 (x : nat) : f (g160 x) = x
+axiom f_g161 (x : nat) : f (g161 x) = x
+axiom f_g162 (x : nat) : f (g162 x) = x
+axiom f_g163 (x : nat) : f (g163 x) = x
+axiom f_g164 (x : nat) : f (g164 x) = x
+axiom f_g165 (x : nat) : f (g165 x) = x
+axiom f_g166 (x : nat) : f (g166 x) = x
+axiom f_g167 (x : nat) : f (g167 x) = x
+axiom f_g168 (x : nat) : f (g168 x) = x
+axiom f_g169 (x : nat) : f (g169 x) = x
+axiom f_g170 (x : nat) : f (g170 x) = x
+axiom f_g171 (x : nat) : f (g171 x) = x
+axiom f_g172 (x : nat) : f (g172 x) = x
+axiom f_g173 (x : nat) : f (g173 x) = x
+axiom f_g174 (x : nat) : f (g174 x) = x
+axiom f_g175 (x : nat) : f (g175 x) = x
+axiom f_g176 (x : nat) : f (g176 x) = x
+axiom f_g177 (x : nat) : f (g177 x) = x
+axiom f_g178 (x : nat) : f (g178 x) = x
+axiom f_g179 (x : nat) : f (g179 x) = x
+axiom f_g180 (x : nat) : f (g180 x) = x
+axiom f_g181 (x : nat) : f (g181 x) = x
+axiom f_g182 (x : nat) : f (g182 x) = x
+axiom f_g183 (x : nat) : f (g183 x) = x
+axiom f_g184 (x : nat) : f (g184 x) = x
+axiom f_g185 (x : nat) : f (g185 x) = x
+axiom f_g186 (x : nat) : f (g186 x) = x
+axiom f_g187 (x : nat) : f (g187 x) = x
+axiom f_g188 (x : nat) : f (g188 x) = x
+axiom f_g189 (x : nat) : f (g189 x) = x
+axiom f_g190 (x : nat) : f (g190 x) = x
+axiom f_g191 (x : nat) : f (g191 x) = x
+axiom f_g192 (x : nat) : f (g192 x) = x
+axiom f_g193 (x : nat) : f (g193 x) = x
+axiom f_g194 (x : nat) : f (g194 x) = x
+axiom f_g195 (x : nat) : f (g195 x) = x
+axiom f_g196 (x : nat) : f (g196 x) = x
+axiom f_g197 (x : nat) : f (g197 x) = x
+axiom f_g198 (x : nat) : f (g198 x) = x
+axiom f_g199 (x : nat) : f (g199 x) = x
+axiom f_g200 (x : nat) : f (g200 x) = x
+axiom f_g201 (x : nat) : f (g201 x) = x
+axiom f_g202 (x : nat) : f (g202 x) = x
+axiom f_g203 (x : nat) : f (g203 x) = x
+axiom f_g204 (x : nat) : f (g204 x) = x
+axiom f_g205 (x : nat) : f (g205 x) = x
+axiom f_g206 (x : nat) : f (g206 x) = x
+axiom f_g207 (x : nat) : f (g207 x) = x
+axiom f_g208 (x : nat) : f (g208 x) = x
+axiom f_g209 (x : nat) : f (g209 x) = x
+axiom f_g210 (x : nat) : f (g210 x) = x
+axiom f_g211 (x : nat) : f (g211 x) = x
+axiom f_g212 (x : nat) : f (g212 x) = x
+axiom f_g213 (x : nat) : f (g213 x) = x
+axiom f_g214 (x : nat) : f (g214 x) = x
+axiom f_g215 (x : nat) : f (g215 x) = x
+axiom f_g216 (x : nat) : f (g216 x) = x
+axiom f_g217 (x : nat) : f (g217 x) = x
+axiom f_g218 (x : nat) : f (g218 x) = x
+axiom f_g219 (x : nat) : f (g219 x) = x
+axiom f_g220 (x : nat) : f (g220 x) = x
+axiom f_g221 (x : nat) : f (g221 x) = x
+axiom f_g222 (x : nat) : f (g222 x) = x
+axiom f_g223 (x : nat) : f (g223 x) = x
+axiom f_g224 (x : nat) : f (g224 x) = x
+axiom f_g225 (x : nat) : f (g225 x) = x
+axiom f_g226 (x : nat) : f (g226 x) = x
+axiom f_g227 (x : nat) : f (g227 x) = x
+axiom f_g228 (x : nat) : f (g228 x) = x
+axiom f_g229 (x : nat) : f (g229 x) = x
+axiom f_g230 (x : nat) : f (g230 x) = x
+axiom f_g231 (x : nat) : f (g231 x) = x
+axiom f_g232 (x : nat) : f (g232 x) = x
+axiom f_g233 (x : nat) : f (g233 x) = x
+axiom f_g234 (x : nat) : f (g234 x) = x
+axiom f_g235 (x : nat) : f (g235 x) = x
+axiom f_g236 (x : nat) : f (g236 x) = x
+axiom f_g237 (x : nat) : f (g237 x) = x
+axiom f_g238 (x : nat) : f (g238 x) = x
+axiom f_g239 (x : nat) : f (g239 x) = x
+axiom f_g240 (x : nat) : f (g240 x) = x
+axiom f_g241 (x : nat) : f (g241 x) = x
+axiom f_g242 (x : nat) : f (g242 x) = x
+axiom f_g243 (x : nat) : f (g243 x) = x
+axiom f_g244 (x : nat) : f (g244 x) = x
+axiom f_g245 (x : nat) : f (g245 x) = x
+axiom f_g246 (x : nat) : f (g246 x) = x
+axiom f_g247 (x : nat) : f (g247 x) = x
+axiom f_g248 (x : nat) : f (g248 x) = x
+axiom f_g249 (x : nat) : f (g249 x) = x
+axiom f_g250 (x : nat) : f (g250 x) = x
+axiom f_g251 (x : nat) : f (g251 x) = x
+axiom f_g252 (x : nat) : f (g252 x) = x
+axiom f_g253 (x : nat) : f (g253 x) = x
+axiom f_g254 (x : nat) : f (g254 x) = x
+axiom f_g255 (x : nat) : f (g255 x) = x
+axiom f_g256 (x : nat) : f (g256 x) = x
+axiom f_g257 (x : nat) : f (g257 x) = x
+axiom f_g258 (x : nat) : f (g258 x) = x
+axiom f_g259 (x : nat) : f (g259 x) = x
+axiom f_g260 (x : nat) : f (g260 x) = x
+axiom f_g261 (x : nat) : f (g261 x) = x
+axiom f_g262 (x : nat) : f (g262 x) = x
+axiom f_g263 (x : nat) : f (g263 x) = x
+axiom f_g264 (x : nat) : f (g264 x) = x
+axiom f_g265 (x : nat) : f (g265 x) = x
+axiom f_g266 (x : nat) : f (g266 x) = x
+axiom f_g267 (x : nat) : f (g267 x) = x
+axiom f_g268 (x : nat) : f (g268 x) = x
+axiom f_g269 (x : nat) : f (g269 x) = x
+axiom f_g270 (x : nat) : f (g270 x) = x
+axiom f_g271 (x : nat) : f (g271 x) = x
+axiom f_g272 (x : nat) : f (g272 x) = x
+axiom f_g273 (x : nat) : f (g273 x) = x
+axiom f_g274 (x : nat) : f (g274 x) = x
+axiom f_g275 (x : nat) : f (g275 x) = x
+axiom f_g276 (x : nat) : f (g276 x) = x
+axiom f_g277 (x : nat) : f (g277 x) = x
+axiom f_g278 (x : nat) : f (g278 x) = x
+axiom f_g279 (x : nat) : f (g279 x) = x
+axiom f_g280 (x : nat) : f (g280 x) = x
+axiom f_g281 (x : nat) : f (g281 x) = x
+axiom f_g282 (x : nat) : f (g282 x) = x
+axiom f_g283 (x : nat) : f (g283 x) = x
+axiom f_g284 (x : nat) : f (g284 x) = x
+axiom f_g285 (x : nat) : f (g285 x) = x
+axiom f_g286 (x : nat) : f (g286 x) = x
+axiom f_g287 (x : nat) : f (g287 x) = x
+axiom f_g288 (x : nat) : f (g288 x) = x
+axiom f_g289 (x : nat) : f (g289 x) = x
+axiom f_g290 (x : nat) : f (g290 x) = x
+axiom f_g291 (x : nat) : f (g291 x) = x
+axiom f_g292 (x : nat) : f (g292 x) = x
+axiom f_g293 (x : nat) : f (g293 x) = x
+axiom f_g294 (x : nat) : f (g294 x) = x
+axiom f_g295 (x : nat) : f (g295 x) = x
+axiom f_g296 (x : nat) : f (g296 x) = x
+axiom f_g297 (x : nat) : f (g297 x) = x
+axiom f_g298 (x : nat) : f (g298 x) = x
+axiom f_g299 (x : nat) : f (g299 x) = x
+axiom f_g300 (x : nat) : f (g300 x) = x
+axiom f_g301 (x : nat) : f (g301 x) = x
+axiom f_g302 (x : nat) : f (g302 x) = x
+axiom f_g303 (x : nat) : f (g303 x) = x
+axiom f_g304 (x : nat) : f (g304 x) = x
+axiom f_g305 (x : nat) : f (g305 x) = x
+axiom f_g306 (x : nat) : f (g306 x) = x
+axiom f_g307 (x : nat) : f (g307 x) = x
+axiom f_g308 (x : nat) : f (g308 x) = x
+axiom f_g309 (x : nat) : f (g309 x) = x
+axiom f_g310 (x : nat) : f (g310 x) = x
+axiom f_g311 (x : nat) : f (g311 x) = x
+axiom f_g312 (x : nat) : f (g312 x) = x
+axiom f_g313 (x : nat) : f (g313 x) = x
+axiom f_g314 (x : nat) : f (g314 x) = x
+axiom f_g315 (x : nat) : f (g315 x) = x
+axiom f_g316 (x : nat) : f (g316 x) = x
+axiom f_g317 (x : nat) : f (g317 x) = x
+axiom f_g318 (x : nat) : f (g318 x) = x
+axiom f_g319 (x : nat) : f (g319 x) = x
+axiom f_g320 (x : nat) : f (g320 x) = x
+axiom f_g321 (x : nat) : f (g321 x) = x
+axiom f_g322 (x : nat) : f (g322 x) = x
+axiom f_g323 (x : nat) : f (g323 x) = x
+axiom f_g324 (x : nat) : f (g324 x) = x
+axiom f_g325 (x : nat) : f (g325 x) = x
+axiom f_g326 (x : nat) : f (g326 x) = x
+axiom f_g327 (x : nat) : f (g327 x) = x
+axiom f_g328 (x : nat) : f (g328 x) = x
+axiom f_g329 (x : nat) : f (g329 x) = x
+axiom f_g330 (x : nat) : f (g330 x) = x
+axiom f_g331 (x : nat) : f (g331 x) = x
+axiom f_g332 (x : nat) : f (g332 x) = x
+axiom f_g333 (x : nat) : f (g333 x) = x
+axiom f_g334 (x : nat) : f (g334 x) = x
+axiom f_g335 (x : nat) : f (g335 x) = x
+axiom f_g336 (x : nat) : f (g336 x) = x
+axiom f_g337 (x : nat) : f (g337 x) = x
+axiom f_g338 (x : nat) : f (g338 x) = x
+axiom f_g339 (x : nat) : f (g339 x) = x
+axiom f_g340 (x : nat) : f (g340 x) = x
+axiom f_g341 (x : nat) : f (g341 x) = x
+axiom f_g342 (x : nat) : f (g342 x) = x
+axiom f_g343 (x : nat) : f (g343 x) = x
+axiom f_g344 (x : nat) : f (g344 x) = x
+axiom f_g345 (x : nat) : f (g345 x) = x
+axiom f_g346 (x : nat) : f (g346 x) = x
+axiom f_g347 (x : nat) : f (g347 x) = x
+axiom f_g348 (x : nat) : f (g348 x) = x
+axiom f_g349 (x : nat) : f (g349 x) = x
+axiom f_g350 (x : nat) : f (g350 x) = x
+axiom f_g351 (x : nat) : f (g351 x) = x
+axiom f_g352 (x : nat) : f (g352 x) = x
+axiom f_g353 (x : nat) : f (g353 x) = x
+axiom f_g354 (x : nat) : f (g354 x) = x
+axiom f_g355 (x : nat) : f (g355 x) = x
+axiom f_g356 (x : nat) : f (g356 x) = x
+axiom f_g357 (x : nat) : f (g357 x) = x
+axiom f_g358 (x : nat) : f (g358 x) = x
+axiom f_g359 (x : nat) : f (g359 x) = x
+axiom f_g360 (x : nat) : f (g360 x) = x
+axiom f_g361 (x : nat) : f (g361 x) = x
+axiom f_g362 (x : nat) : f (g362 x) = x
+axiom f_g363 (x : nat) : f (g363 x) = x
+axiom f_g364 (x : nat) : f (g364 x) = x
+axiom f_g365 (x : nat) : f (g365 x) = x
+axiom f_g366 (x : nat) : f (g366 x) = x
+axiom f_g367 (x : nat) : f (g367 x) = x
+axiom f_g368 (x : nat) : f (g368 x) = x
+axiom f_g369 (x : nat) : f (g369 x) = x
+axiom f_g370 (x : nat) : f (g370 x) = x
+axiom f_g371 (x : nat) : f (g371 x) = x
+axiom f_g372 (x : nat) : f (g372 x) = x
+axiom f_g373 (x : nat) : f (g373 x) = x
+axiom f_g374 (x : nat) : f (g374 x) = x
+axiom f_g375 (x : nat) : f (g375 x) = x
+axiom f_g376 (x : nat) : f (g376 x) = x
+axiom f_g377 (x : nat) : f (g377 x) = x
+axiom f_g378 (x : nat) : f (g378 x) = x
+axiom f_g379 (x : nat) : f (g379 x) = x
+axiom f_g380 (x : nat) : f (g380 x) = x
+axiom f_g381 (x : nat) : f (g381 x) = x
+axiom f_g382 (x : nat) : f (g382 x) = x
+axiom f_g383 (x : nat) : f (g383 x) = x
+axiom f_g384 (x : nat) : f (g384 x) = x
+axiom f_g385 (x : nat) : f (g385 x) = x
+axiom f_g386 (x : nat) : f (g386 x) = x
+axiom f_g387 (x : nat) : f (g387 x) = x
+axiom f_g388 (x : nat) : f (g388 x) = x
+axiom f_g389 (x : nat) : f (g389 x) = x
+axiom f_g390 (x : nat) : f (g390 x) = x
+axiom f_g391 (x : nat) : f (g391 x) = x
+axiom f_g392 (x : nat) : f (g392 x) = x
+axiom f_g393 (x : nat) : f (g393 x) = x
+axiom f_g394 (x : nat) : f (g394 x) = x
+axiom f_g395 (x : nat) : f (g395 x) = x
+axiom f_g396 (x : nat) : f (g396 x) = x
+axiom f_g397 (x : nat) : f (g397 x) = x
+axiom f_g398 (x : nat) : f (g398 x) = x
+axiom f_g399 (x : nat) : f (g399 x) = x
+
+attribute [simp] f_g0 f_g1 f_g2 f_g3 f_g4 f_g5 f_g6 f_g7 f_g8 f_g9 f_g10 f_g11 f_g12 f_g13 f_g14
+  f_g15 f_g16 f_g17 f_g18 f_g19 f_g20 f_g21 f_g22 f_g23 f_g24 f_g25 f_g26 f_g27 f_g28 f_g29 f_g30
+  f_g31 f_g32 f_g33 f_g34 f_g35 f_g36 f_g37 f_g38 f_g39 f_g40 f_g41 f_g42 f_g43 f_g44 f_g45 f_g46
+  f_g47 f_g48 f_g49 f_g50 f_g51 f_g52 f_g53 f_g54 f_g55 f_g56 f_g57 f_g58 f_g59 f_g60 f_g61 f_g62
+  f_g63 f_g64 f_g65 f_g66 f_g67 f_g68 f_g69 f_g70 f_g71 f_g72 f_g73 f_g74 f_g75 f_g76 f_g77 f_g78
+  f_g79 f_g80 f_g81 f_g82 f_g83 f_g84 f_g85 f_g86 f_g87 f_g88 f_g89 f_g90 f_g91 f_g92 f_g93 f_g94
+  f_g95 f_g96 f_g97 f_g98 f_g99 f_g100 f_g101 f_g102 f_g103 f_g104 f_g105 f_g106 f_g107 f_g108
+  f_g109 f_g110 f_g111 f_g112 f_g113 f_g114 f_g115 f_g116 f_g117 f_g118 f_g119 f_g120 f_g121 f_g122
+  f_g123 f_g124 f_g125 f_g126 f_g127 f_g128 f_g129 f_g130 f_g131 f_g132 f_g133 f_g134 f_g135 f_g136
+  f_g137 f_g138 f_g139 f_g140 f_g141 f_g142 f_g143 f_g144 f_g145 f_g146 f_g147 f_g148 f_g149 f_g150
+  f_g151 f_g152 f_g153 f_g154 f_g155 f_g156 f_g157 f_g158 f_g159 f_g160 f_g161 f_g162 f_g163 f_g164
+  f_g165 f_g166 f_g167 f_g168 f_g169 f_g170 f_g171 f_g172 f_g173 f_g174 f_g175 f_g176 f_g177 f_g178
+  f_g179 f_g180 f_g181 f_g182 f_g183 f_g184 f_g185 f_g186 f_g187 f_g188 f_g189 f_g190 f_g191 f_g192
+  f_g193 f_g194 f_g195 f_g196 f_g197 f_g198 f_g199 f_g200 f_g201 f_g202 f_g203 f_g204 f_g205 f_g206
+  f_g207 f_g208 f_g209 f_g210 f_g211 f_g212 f_g213 f_g214 f_g215 f_g216 f_g217 f_g218 f_g219 f_g220
+  f_g221 f_g222 f_g223 f_g224 f_g225 f_g226 f_g227 f_g228 f_g229 f_g230 f_g231 f_g232 f_g233 f_g234
+  f_g235 f_g236 f_g237 f_g238 f_g239 f_g240 f_g241 f_g242 f_g243 f_g244 f_g245 f_g246 f_g247 f_g248
+  f_g249 f_g250 f_g251 f_g252 f_g253 f_g254 f_g255 f_g256 f_g257 f_g258 f_g259 f_g260 f_g261 f_g262
+  f_g263 f_g264 f_g265 f_g266 f_g267 f_g268 f_g269 f_g270 f_g271 f_g272 f_g273 f_g274 f_g275 f_g276
+  f_g277 f_g278 f_g279 f_g280 f_g281 f_g282 f_g283 f_g284 f_g285 f_g286 f_g287 f_g288 f_g289 f_g290
+  f_g291 f_g292 f_g293 f_g294 f_g295 f_g296 f_g297 f_g298 f_g299 f_g300 f_g301 f_g302 f_g303 f_g304
+  f_g305 f_g306 f_g307 f_g308 f_g309 f_g310 f_g311 f_g312 f_g313 f_g314 f_g315 f_g316 f_g317 f_g318
+  f_g319 f_g320 f_g321 f_g322 f_g323 f_g324 f_g325 f_g326 f_g327 f_g328 f_g329 f_g330 f_g331 f_g332
+  f_g333 f_g334 f_g335 f_g336 f_g337 f_g338 f_g339 f_g340 f_g341 f_g342 f_g343 f_g344 f_g345 f_g346
+  f_g347 f_g348 f_g349 f_g350 f_g351 f_g352 f_g353 f_g354 f_g355 f_g356 f_g357 f_g358 f_g359 f_g360
+  f_g361 f_g362 f_g363 f_g364 f_g365 f_g366 f_g367 f_g368 f_g369 f_g370 f_g371 f_g372 f_g373 f_g374
+  f_g375 f_g376 f_g377 f_g378 f_g379 f_g380 f_g381 f_g382 f_g383 f_g384 f_g385 f_g386 f_g387 f_g388
+  f_g389 f_g390 f_g391 f_g392 f_g393 f_g394 f_g395 f_g396 f_g397 f_g398 f_g399
+
+example (x : nat) :
+  f (g0 x) + f (g2 x) + f (g4 x) + f (g6 x) + f (g8 x) + f (g10 x) + f (g12 x) + f (g14 x) +
+  f (g16 x) + f (g18 x) + f (g20 x) + f (g22 x) + f (g24 x) + f (g26 x) + f (g28 x) + f (g30 x) +
+  f (g32 x) + f (g34 x) + f (g36 x) + f (g38 x) + f (g40 x) + f (g42 x) + f (g44 x) + f (g46 x) +
+  f (g48 x) + f (g50 x) + f (g52 x) + f (g54 x) + f (g56 x) + f (g58 x) + f (g60 x) + f (g62 x) +
+  f (g64 x) + f (g66 x) + f (g68 x) + f (g70 x) + f (g72 x) + f (g74 x) + f (g76 x) + f (g78 x) +
+  f (g80 x) + f (g82 x) + f (g84 x) + f (g86 x) + f (g88 x) + f (g90 x) + f (g92 x) + f (g94 x) +
+  f (g96 x) + f (g98 x) + f (g100 x) + f (g102 x) + f (g104 x) + f (g106 x) + f (g108 x) +
+  f (g110 x) + f (g112 x) + f (g114 x) + f (g116 x) + f (g118 x) + f (g120 x) + f (g122 x) +
+  f (g124 x) + f (g126 x) + f (g128 x) + f (g130 x) + f (g132 x) + f (g134 x) + f (g136 x) +
+  f (g138 x) + f (g140 x) + f (g142 x) + f (g144 x) + f (g146 x) + f (g148 x) + f (g150 x) +
+  f (g152 x) + f (g154 x) + f (g156 x) + f (g158 x) + f (g160 x) + f (g162 x) + f (g164 x) +
+  f (g166 x) + f (g168 x) + f (g170 x) + f (g172 x) + f (g174 x) + f (g176 x) + f (g178 x) +
+  f (g180 x) + f (g182 x) + f (g184 x) + f (g186 x) + f (g188 x) + f (g190 x) + f (g192 x) +
+  f (g194 x) + f (g196 x) + f (g198 x) + f (g200 x) + f (g202 x) + f (g204 x) + f (g206 x) +
+  f (g208 x) + f (g210 x) + f (g212 x) + f (g214 x) + f (g216 x) + f (g218 x) + f (g220 x) +
+  f (g222 x) + f (g224 x) + f (g226 x) + f (g228 x) + f (g230 x) + f (g232 x) + f (g234 x) +
+  f (g236 x) + f (g238 x) + f (g240 x) + f (g242 x) + f (g244 x) + f (g246 x) + f (g248 x) +
+  f (g250 x) + f (g252 x) + f (g254 x) + f (g256 x) + f (g258 x) + f (g260 x) + f (g262 x) +
+  f (g264 x) + f (g266 x) + f (g268 x) + f (g270 x) + f (g272 x) + f (g274 x) + f (g276 x) +
+  f (g278 x) + f (g280 x) + f (g282 x) + f (g284 x) + f (g286 x) + f (g288 x) + f (g290 x) +
+  f (g292 x) + f (g294 x) + f (g296 x) + f (g298 x) + f (g300 x) + f (g302 x) + f (g304 x) +
+  f (g306 x) + f (g308 x) + f (g310 x) + f (g312 x) + f (g314 x) + f (g316 x) + f (g318 x) +
+  f (g320 x) + f (g322 x) + f (g324 x) + f (g326 x) + f (g328 x) + f (g330 x) + f (g332 x) +
+  f (g334 x) + f (g336 x) + f (g338 x) + f (g340 x) + f (g342 x) + f (g344 x) + f (g346 x) +
+  f (g348 x) + f (g350 x) + f (g352 x) + f (g354 x) + f (g356 x) + f (g358 x) + f (g360 x) +
+  f (g362 x) + f (g364 x) + f (g366 x) + f (g368 x) + f (g370 x) + f (g372 x) + f (g374 x) +
+  f (g376 x) + f (g378 x) + f (g380 x) + f (g382 x) + f (g384 x) + f (g386 x) + f (g388 x) +
+  f (g390 x) + f (g392 x) + f (g394 x) + f (g396 x) + f (g398 x) =
+  x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x +
+  x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x +
+  x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x +
+  x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x +
+  x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x +
+  x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x +
+  x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x +
+  x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x + x +
+  x + x + x + x + x + x + x + x :=
+by simp
@@ -0,0 +1,26 @@
+class foo (α : Type) (β : Type) := (val : nat)
+
+instance foo_nat_bool : foo nat bool := foo.mk nat bool 1
+instance foo_nat_nat  : foo nat nat := foo.mk nat nat 2
+instance foo_list {α} [foo α α] : foo (list α) bool := foo.mk (list α) bool 3
+
+@[reducible] def my_nat := nat
+def my_bool := bool
+
+/- Instances whose class arguments have different rigid heads are skipped,
+   but reducible definitions must still be unfolded. -/
+example : @foo.val nat bool _ = 1 := rfl
+example : @foo.val nat nat _ = 2 := rfl
+example : @foo.val my_nat bool _ = 1 := rfl
+example : @foo.val (list my_nat) bool _ = 3 := rfl
+
+instance foo_my_bool : foo nat my_bool := foo.mk nat my_bool 4
+example : @foo.val nat my_bool _ = 4 := rfl
+
+/- The same holds for reducible definitions in the instances. -/
+instance foo_my_nat_unit : foo my_nat unit := foo.mk my_nat unit 5
+example : @foo.val nat unit _ = 5 := rfl
+example : @foo.val my_nat unit _ = 5 := rfl
+
+set_option class.instance_index false
+example : @foo.val nat bool _ = 1 := rfl
@@ -0,0 +1,18 @@
+set_option class.tabled_resolution true
+
+example : decidable_eq (list (nat × bool)) := by apply_instance
+example : has_add nat := by apply_instance
+example : inhabited (list (option nat)) := by apply_instance
+example (α : Type) [decidable_eq α] : decidable_eq (list α) := by apply_instance
+
+class foo (α : Type) := (val : nat)
+class bar (α : Type) := (val : nat)
+
+instance foo_nat : foo nat := foo.mk nat 1
+instance bar_of_foo {α} [foo α] : bar α := bar.mk α 2
+instance foo_of_bar {α} [bar α] : foo α := foo.mk α 3
+instance foo_list {α} [foo α] [bar α] : foo (list α) := foo.mk (list α) 4
+
+/- foo and bar depend on each other, tabled resolution does not loop. -/
+example : @foo.val nat _ = 1 := rfl
+example : @bar.val (list nat) _ = 2 := rfl
@@ -0,0 +1,21 @@
+structure foo := (x : nat)
+
+instance foo.has_zero : has_zero foo := ⟨⟨0⟩⟩
+
+example : has_zero foo := by apply_instance
+example : foo.x 0 = 0 := rfl
+example : foo.x 0 = 0 := rfl
+
+/- Local instances take precedence over cached results. -/
+def bar [inst : has_zero foo] : foo := 0
+
+example : @bar ⟨⟨1⟩⟩ = ⟨1⟩ := rfl
+
+def f₁ (a b : nat) : bool := to_bool (a = b)
+def f₂ (a b : nat) : bool := to_bool (a = b)
+
+example : f₁ 1 1 = tt := rfl
+example : f₂ 1 2 = ff := rfl
+
+set_option class.global_instance_cache false
+example : foo.x 0 = 0 := rfl
@@ -0,0 +1,31 @@
+open tactic
+
+/- rb_maps keyed by nat, name and expr use native comparison functions. -/
+run_command guard ((((rb_map.mk nat nat)^.insert 2 20)^.insert 1 10)^.find 1 = some 10)
+run_command guard ((rb_map.of_list [(`b, 2), (`a, 1)] : name_map nat)^.find `b = some 2)
+run_command guard ((((rb_map.mk expr nat)^.insert (expr.const `a []) 1)^.insert (expr.const `b []) 2)^.find (expr.const `b []) = some 2)
+run_command guard (((rb_map.mk nat nat)^.insert 100000000000000000000 1)^.contains 100000000000000000000)
+
+meta def m₁ : hash_map nat string :=
+(((hash_map.mk nat string (λ n, n % 3))^.insert 1 "one")^.insert 4 "four")^.insert 7 "seven"
+
+run_command guard (m₁^.size = 3)
+run_command guard (m₁^.find 4 = some "four")
+run_command guard (m₁^.find 2 = none)
+run_command guard ((m₁^.insert 4 "FOUR")^.find 4 = some "FOUR")
+run_command guard ((m₁^.insert 4 "FOUR")^.size = 3)
+run_command guard ((m₁^.erase 4)^.size = 2)
+run_command guard (¬ (m₁^.erase 4)^.contains 4)
+run_command guard ((m₁^.erase 5)^.size = 3)
+run_command guard (m₁^.fold 0 (λ k d r, k + r) = 12)
+
+vm_eval m₁^.find 7
+
+run_command do
+  t ← to_expr `(λ x : nat, x + 1),
+  z ← to_expr `((0:nat)),
+  o ← to_expr `((1:nat)),
+  m ← return (((expr_map.mk nat)^.insert t 1)^.insert z 0),
+  guard (m^.find t = some 1),
+  guard (m^.find z = some 0),
+  guard (m^.find o = none)
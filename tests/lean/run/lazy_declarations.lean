@@ -0,0 +1,16 @@
+open tactic
+
+/- Imported declarations are only decoded when their type or value is needed.
+   Decode all of them, they must be closed terms. -/
+meta def is_closed : declaration → bool
+| (declaration.defn n ls t v h tr) := bnot (t^.has_var || v^.has_var)
+| d                                := bnot d^.type^.has_var
+
+run_command do
+  env ← get_env,
+  guard (env^.fold tt (λ d r, r && is_closed d)),
+  guard (env^.fold 0 (λ d n, n + 1) > 1000),
+  d ← get_decl `nat.add_comm,
+  guard (d^.type^.is_pi),
+  d ← get_decl `list.append,
+  guard (d^.to_name = `list.append)
@@ -0,0 +1,44 @@
+set_option parser.parallel_definitions true
+open tactic
+
+def f (n : nat) : nat := n + 1
+def g (n : nat) : nat := f (f n)
+private def h : nat := g 2
+
+/- The values are only needed when the definitions are unfolded. -/
+example : g 1 = 3 := rfl
+theorem h_eq : h = 4 := rfl
+
+/- Delayed definitions are compiled before they can be executed. -/
+vm_eval g 10
+run_command guard (g 10 = 12)
+
+def k (n : nat) : nat := g n * 2
+
+/- Tactic blocks are executed while the declaration is elaborated,
+   so the delayed definitions they use must be compiled first. -/
+example : k 1 = 6 := by do guard (k 1 = 6), reflexivity
+meta def k_tac : tactic unit := guard (k 2 = 8) >> reflexivity
+example : k 2 = 8 := by k_tac
+
+/- Theorems and definitions do not finalize the pending definitions by themselves. -/
+def k3 (n : nat) : nat := k n + 1
+theorem k3_eq : k3 1 = 7 := by do guard (k3 1 = 7), reflexivity
+def k4 (n : nat) : nat := k3 n * 2
+def k5 : by do guard (k4 1 = 14), exact (expr.const `nat []) := k4 2
+theorem k5_eq : k5 = 18 := rfl
+
+noncomputable def c : nat := classical.some (⟨0, rfl⟩ : ∃ x : nat, x = 0)
+def d (n : nat) : nat := n * 2
+
+example : d 2 = 4 := rfl
+
+/- Definitions using pattern matching or attributes are not delayed. -/
+def p : nat → nat
+| 0     := 1
+| (n+1) := d (p n)
+
+@[reducible] def q (n : nat) : nat := p n + f n
+
+example : q 1 = 4 := rfl
+run_command guard (q 3 = 12)
@@ -0,0 +1,17 @@
+constants (A : Type.{1}) (f : A → A → A) (g : A → A) (h k : A → A) (a b c : A)
+attribute [simp]
+lemma f_h : ∀ x, f (h x) a = x := sorry
+attribute [simp]
+lemma f_k : ∀ x, f (k x) a = b := sorry
+
+@[reducible] def h' (x : A) : A := h x
+
+open tactic
+
+/- The index must not skip lemmas whose arguments have different heads when one of them can be unfolded. -/
+example : f (h c) a = c := by simp
+example : f (k c) a = b := by simp
+example : f (h' c) a = c := by simp
+
+set_option simp_lemmas.index false
+example : f (h c) a = c := by simp
@@ -0,0 +1,16 @@
+constants (A : Type.{1}) (f g : A → A) (a b c : A)
+constants (fa : f a = b) (fa' : f a = c) (gb : g b = c)
+
+/- The cached simp lemmas are updated after each attribute change -/
+attribute [simp] fa
+example : f a = b := by simp
+
+attribute [simp] gb
+example : g (f a) = c := by simp
+
+/- fa' has higher priority than fa -/
+attribute [simp, priority 2000] fa'
+example : f a = c := by simp
+
+local attribute [-simp] fa'
+example : f a = b := by simp
@@ -0,0 +1,34 @@
+open tactic
+
+meta def a₁ : array nat := array.of_list [1, 2, 3]
+
+run_command guard (a₁^.size = 3)
+run_command guard (a₁^.read 1 = 2)
+run_command guard ((a₁^.write 1 10)^.to_list = [1, 10, 3])
+/- a₁ is shared, so it must not be modified by write -/
+run_command guard (a₁^.to_list = [1, 2, 3])
+run_command guard ((a₁^.push_back 4)^.to_list = [1, 2, 3, 4])
+run_command guard (a₁^.pop_back^.to_list = [1, 2])
+run_command guard ((array.map (λ x, x + 1) a₁)^.to_list = [2, 3, 4])
+run_command guard (a₁^.foldl 0 (λ x r, x + r) = 6)
+run_command guard ((array.mk 3 tt)^.to_list = [tt, tt, tt])
+run_command guard (to_string a₁ = "#[1, 2, 3]")
+
+vm_eval a₁
+vm_eval (a₁^.write 0 5)^.to_list
+
+meta def fill : nat → array nat → array nat
+| 0     a := a
+| (n+1) a := fill n (a^.write n n)
+
+run_command guard ((fill 1000 (array.mk 1000 0))^.foldl 0 (λ x r, x + r) = 499500)
+
+/- The array is not shared in fill and push_all, so the updates are performed in place.
+   These loops would take hours if each update copied the array. -/
+run_command guard ((fill 1000000 (array.mk 1000000 0))^.read 999999 = 999999)
+
+meta def push_all : nat → array nat → array nat
+| 0     a := a
+| (n+1) a := push_all n (a^.push_back n)
+
+run_command guard ((push_all 1000000 array.empty)^.size = 1000000)
@@ -0,0 +1,25 @@
+open tactic
+
+/- Strings produced by C++ code are packed, and they are unpacked on demand by `cases`. -/
+meta def s₁ : string := to_string (to_fmt "hello")
+
+meta def last : string → option char
+| []      := none
+| (c::cs) := some c
+
+run_command guard (last s₁ = some #"o")
+run_command guard (s₁ = "hello")
+run_command guard (s₁ ++ " world" = "hello world")
+run_command guard ("hello" ++ s₁ = "hellohello")
+run_command guard (list.length s₁ = 5)
+run_command guard (utf8_length (s₁ ++ "αβ") = 7)
+run_command guard (s₁ ≠ "hellO")
+
+vm_eval s₁ ++ " world"
+
+meta def repeat_append : nat → string → string
+| 0     s := s
+| (n+1) s := repeat_append n (s ++ "a")
+
+run_command guard (list.length (repeat_append 1000 s₁) = 1005)
+run_command guard (repeat_append 1000 s₁ = repeat_append 1000 "hello")
@@ -0,0 +1,34 @@
+set_option compiler.register_encoding true
+
+def my_map {α β : Type} (f : α → β) : list α → list β
+| []     := []
+| (a::l) := f a :: my_map l
+
+def adder (n : nat) : nat → nat := λ x, x + n
+
+/- The same local is used twice by a single instruction, so only its last use is moved. -/
+def double (x : nat) : nat := x + x
+
+def mixed (a b c : nat) : list nat := [c, a + b, 100, b, a * c, 0]
+
+def swap_pair {α : Type} : α × α → α × α
+| (a, b) := (b, a)
+
+run_command guard (my_map (adder 3) [1, 2, 3] = [4, 5, 6])
+run_command guard (double 21 = 42)
+run_command guard (mixed 2 3 4 = [4, 5, 100, 3, 8, 0])
+run_command guard (swap_pair (1, 2) = (2, 1))
+
+meta def fill : nat → array nat → array nat
+| 0     a := a
+| (n+1) a := fill n (a^.write n n)
+
+/- The array is moved into array.write by the register-based instruction, so it is updated in place. -/
+run_command guard ((fill 1000000 (array.mk 1000000 0))^.read 999999 = 999999)
+
+set_option compiler.register_encoding false
+
+/- Declarations compiled with and without the register-based encoding call each other. -/
+def mixed_sum (a b c : nat) : nat := list.foldl (λ x y, x + y) 0 (mixed a b c) + double a
+
+run_command guard (mixed_sum 2 3 4 = 124)
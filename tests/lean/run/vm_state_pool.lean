@@ -0,0 +1,16 @@
+open tactic
+
+meta def cfg : nat := 10
+
+/- Each tactic block is compiled into a declaration with the same name and index,
+   the VM must not reuse the code or the cached value of the previous one. -/
+example : 1 = 1 := by do guard (cfg = 10), reflexivity
+example : true := by do guard (cfg = 10), triv
+example : 2 = 2 ∧ true := by do guard (cfg = 10), constructor, reflexivity, triv
+
+meta def cfg2 : nat := cfg + 1
+
+run_command guard (cfg2 = 11)
+example : true := by do guard (cfg2 = 11), triv
+
+vm_eval cfg2
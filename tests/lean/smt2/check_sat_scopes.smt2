@@ -0,0 +1,34 @@
+(declare-const p Bool)
+(declare-const q Bool)
+(assert p)
+(check-sat)
+(push 1)
+(assert (not p))
+(check-sat)
+(pop 1)
+(check-sat)
+
+(check-sat-assuming ((not p)))
+(check-sat)
+(check-sat-assuming (q (not q)))
+
+(push 2)
+(assert (not q))
+(push)
+(assert q)
+(check-sat)
+(pop 1)
+(check-sat)
+(check-sat-assuming (q))
+(pop 2)
+(check-sat-assuming (q))
+(check-sat)
+
+(push)
+(define-fun r () Bool (not p))
+(assert r)
+(check-sat)
+(pop)
+(define-fun r () Bool p)
+(assert (not r))
+(check-sat)
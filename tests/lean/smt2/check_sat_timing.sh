@@ -0,0 +1,28 @@
+#!/usr/bin/env bash
+if [ $# -ne 1 ]; then
+    echo "Usage: check_sat_timing.sh [lean-executable-path]"
+    exit 1
+fi
+LEAN=$1
+export LEAN_PATH=../../../library:.
+f=check_sat_scopes.smt2
+"$LEAN" --make smt.lean > /dev/null || exit 1
+
+# Every query, including the ones of check-sat-assuming, reports its time after its result.
+"$LEAN" --smt2 -D smt2.timing=true "$f" > "$f.timing.out" 2>&1
+if [ "$(grep -cE "^\[check-sat(-assuming)? #[0-9]+, $f:[0-9]+\] [0-9]+\.[0-9]{5} secs$" "$f.timing.out")" -ne 13 ] ||
+   [ "$(grep -c "^\[check-sat-assuming #4, $f:11\]" "$f.timing.out")" -ne 1 ] ||
+   [ "$(grep -c "^\[check-sat #13, $f:34\]" "$f.timing.out")" -ne 1 ]; then
+    echo "ERROR: unexpected timing output"
+    cat "$f.timing.out"
+    rm -f "$f.timing.out"
+    exit 1
+fi
+rm -f "$f.timing.out"
+
+# The timing is not displayed by default.
+if "$LEAN" --smt2 "$f" | grep -q secs; then
+    echo "ERROR: timing displayed without smt2.timing"
+    exit 1
+fi
+echo "-- checked"
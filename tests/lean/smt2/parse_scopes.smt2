@@ -0,0 +1,17 @@
+(set-option :verbose true)
+(set-option :use_locals)
+(declare-sort X)
+(declare-const x1 X)
+(push 1)
+(declare-const x2 X)
+(assert (= x1 x2))
+(pop 1)
+
+(push)
+(declare-const x2 X)
+(define-fun p ((a X) (b X)) Bool (= a b))
+(assert (p x1 x2))
+(pop)
+
+(define-fun q () Bool (not true))
+(assert q)
@@ -0,0 +1,12 @@
+open tactic
+
+/- A minimal `smt.prove` for testing the frontend. It proves `false` when the assertions
+   contain a proposition and its negation. The assertions are local hypotheses, or axioms
+   in the current file when :use_locals is false. -/
+meta def smt.prove : tactic unit :=
+do env ← get_env,
+   env^.fold skip (λ d t, match d with
+     | (declaration.ax n [] ty) := if env^.decl_olean n = none then t >> (mk_const n >>= note n) else t
+     | _                        := t
+     end),
+   contradiction
@@ -14,6 +14,8 @@ fi
 f=$2
 
 echo "-- testing $f"
+# The smt2 frontend imports the module smt, it is provided by smt.lean
+"$LEAN" --make smt.lean > /dev/null || exit 1
 "$LEAN" "--smt2" "$f" &> "$f.produced.out.1"
 sed "/warning: imported file uses 'sorry'/d" "$f.produced.out.1" | sed "/warning: using 'sorry'/d" > "$f.produced.out"
 rm -f "$f.produced.out.1"
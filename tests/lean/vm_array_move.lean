@@ -0,0 +1,17 @@
+set_option trace.compiler.optimize_bytecode true
+
+/- The array is not used after the write, so it is moved into array.write, which updates it in place. -/
+meta def set_first (a : array nat) : array nat :=
+a^.write 0 1
+
+/- The array is used after the write, so it is copied. -/
+meta def set_first_and_read (a : array nat) : array nat × nat :=
+(a^.write 0 1, a^.read 0)
+
+set_option trace.compiler.optimize_bytecode false
+
+meta def a₁ : array nat := array.of_list [5, 6]
+
+vm_eval (set_first a₁)^.to_list
+vm_eval let p := set_first_and_read (array.of_list [5, 6]) in (p.1^.to_list, p.2)
+vm_eval a₁^.to_list
@@ -0,0 +1,5 @@
+meta def a₁ : array nat := array.of_list [1, 2, 3]
+
+vm_eval a₁^.read 2
+vm_eval a₁^.read 3
+vm_eval (array.empty : array nat)^.pop_back
@@ -0,0 +1,25 @@
+structure point :=
+(x : nat) (y : nat)
+
+def step : nat → point → point
+| 0     p := p
+| (n+1) p := step n (point.mk (point.x p + 1) (point.y p + 2))
+
+vm_eval point.x (step 100 (point.mk 0 0))
+vm_eval point.y (step 100 (point.mk 0 0))
+
+/- p is shared, so it must not be updated in place -/
+def shared_step (p : point) : nat :=
+point.x (step 5 p) + point.x p
+
+vm_eval shared_step (point.mk 1 2)
+
+def rev_aux : list nat → list nat → list nat
+| []      acc := acc
+| (a::l)  acc := rev_aux l (a::acc)
+
+def sum_list : list nat → nat
+| []      := 0
+| (a::l)  := a + sum_list l
+
+vm_eval sum_list (rev_aux [1, 2, 3, 4] [])
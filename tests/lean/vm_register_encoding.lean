@@ -0,0 +1,24 @@
+set_option trace.compiler.optimize_bytecode true
+
+def f (a b : nat) : list nat := [a, b + 1, a]
+
+section
+set_option compiler.register_encoding true
+
+/- The arguments that are locals or simple objects are operands of rinvoke, rclosure and rcnstr,
+   and the other ones are computed on the stack. -/
+def g (a b : nat) : list nat := [a, b + 1, a]
+
+def h (a : nat) (l : list nat) : list nat := list.map (λ x, x + a) l
+
+/- These numerals are not simple objects, so they are Stack operands. -/
+def big (a : nat) : list nat := [4294967296, a, 2147483648]
+end
+
+def k (a b : nat) : list nat := [a, b + 1, a]
+
+set_option trace.compiler.optimize_bytecode false
+
+vm_eval g 1 2
+vm_eval h 3 [1, 2]
+vm_eval big 1
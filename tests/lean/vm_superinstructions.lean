@@ -0,0 +1,41 @@
+def add_all : list nat → nat → nat
+| []      acc := acc
+| (a::l) acc := add_all l (acc + a)
+
+def pair_sum : option (nat × nat) → nat
+| none          := 0
+| (some (a, b)) := a + b
+
+def first_some : option nat × nat → nat
+| (some a, b) := a
+| (none, b)   := b
+
+vm_eval add_all [1, 2, 3] 10
+vm_eval pair_sum (some (2, 3))
+vm_eval pair_sum none
+vm_eval first_some (some 4, 1)
+vm_eval first_some (none, 1)
+
+set_option compiler.superinstructions false
+
+def add_all' : list nat → nat → nat
+| []      acc := acc
+| (a::l) acc := add_all' l (acc + a)
+
+vm_eval add_all' [1, 2, 3] 10
+
+set_option compiler.superinstructions true
+set_option trace.compiler.optimize_bytecode true
+
+/- `push2_ginvoke` is used for the call to `add_all`, and `destruct_cases2` for the nested pattern. -/
+def add_all_from (acc : nat) (l : list nat) : nat := add_all l acc
+
+def second_some : nat × option nat → nat
+| (a, some b) := b
+| (a, none)   := a
+
+set_option trace.compiler.optimize_bytecode false
+
+vm_eval add_all_from 10 [1, 2]
+vm_eval second_some (1, some 2)
+vm_eval second_some (1, none)
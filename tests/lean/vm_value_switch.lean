@@ -0,0 +1,48 @@
+def classify : nat → nat
+| 0    := 10
+| 1    := 11
+| 2    := 12
+| 3    := 13
+| 5    := 15
+| 100  := 20
+| 200  := 21
+| 1000 := 22
+| _    := 0
+
+def char_class : char → nat
+| #"a" := 1
+| #"e" := 1
+| #"i" := 1
+| #"o" := 1
+| #"u" := 1
+| #" " := 2
+| _    := 0
+
+/- unsigned numerals -/
+instance : has_zero unsigned := has_zero.mk (unsigned.of_nat 0)
+instance : has_one unsigned := has_one.mk (unsigned.of_nat 1)
+instance : has_add unsigned := has_add.mk (λ a b, unsigned.of_nat (unsigned.to_nat a + unsigned.to_nat b))
+
+def opcode : unsigned → nat
+| 0 := 1
+| 1 := 2
+| 2 := 3
+| 3 := 4
+| 4 := 5
+| _ := 0
+
+vm_eval list.map classify [0, 1, 2, 3, 4, 5, 6, 99, 100, 200, 1000, 1001]
+vm_eval list.map char_class [#"a", #"b", #"u", #" ", #"z"]
+vm_eval list.map opcode [0, 3, 4, 5, 1000]
+
+set_option compiler.value_switch false
+
+def classify' : nat → nat
+| 0    := 10
+| 1    := 11
+| 2    := 12
+| 3    := 13
+| 5    := 15
+| _    := 0
+
+vm_eval list.map classify' [0, 4, 5, 6]